@@ -52,14 +52,104 @@ Allocator* get_default_allocator() {
     return &default_allocator;
 }
 
+static thread_local Allocator* thread_allocator = nullptr;
+
+Allocator* get_thread_allocator() {
+    return thread_allocator;
+}
+
+void set_thread_allocator(Allocator* allocator) {
+    thread_allocator = allocator;
+}
+
 Allocator* GetAllocator(Device device) {
     switch (device) {
-        case Device::CPU: return get_default_allocator(); break;
+        case Device::CPU: return (thread_allocator) ? thread_allocator : get_default_allocator(); break;
         default: return get_default_allocator();
     }
     return get_default_allocator();
 }
 
+struct WorkspaceAllocator::Block {
+    void* data;
+    size_t nbytes;
+    std::shared_ptr<const WorkspaceAllocator> owner;
+};
+
+std::shared_ptr<WorkspaceAllocator> WorkspaceAllocator::create() {
+    return std::shared_ptr<WorkspaceAllocator>(new WorkspaceAllocator());
+}
+
+WorkspaceAllocator::~WorkspaceAllocator() {
+    clear();
+}
+
+DataPtr WorkspaceAllocator::allocate(size_t nbytes) const {
+    void* data = nullptr;
+    size_t capacity = nbytes;
+    
+    if (nbytes > 0) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        // Reuse the smallest cached block which is not too large for the request
+        auto it = free_blocks_.lower_bound(nbytes);
+        if (it != free_blocks_.end() && it->first <= nbytes * 2) {
+            capacity = it->first;
+            data = it->second.data;
+            cached_bytes_ -= capacity;
+            free_blocks_.erase(it);
+        }
+    }
+    
+    if (nbytes > 0 && !data) {
+        data = alloc_cpu(nbytes);
+    }
+    
+    Block* block = new Block{data, capacity, shared_from_this()};
+    return {data, block, &WorkspaceAllocator::recycle, Device::CPU};
+}
+
+void WorkspaceAllocator::recycle(void* ctx) {
+    Block* block = static_cast<Block*>(ctx);
+    
+    if (block->data) {
+        const WorkspaceAllocator* owner = block->owner.get();
+        std::unique_lock<std::mutex> lock(owner->mutex_);
+        owner->free_blocks_.emplace(block->nbytes, CachedBlock{block->data, true});
+        owner->cached_bytes_ += block->nbytes;
+    }
+    
+    // The last block may release the workspace itself
+    delete block;
+}
+
+void WorkspaceAllocator::clear() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (auto& free_block : free_blocks_) {
+        free_cpu(free_block.second.data);
+    }
+    free_blocks_.clear();
+    cached_bytes_ = 0;
+}
+
+void WorkspaceAllocator::trim() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (auto it = free_blocks_.begin(); it != free_blocks_.end();) {
+        if (it->second.recent) {
+            it->second.recent = false;
+            ++it;
+        } else {
+            free_cpu(it->second.data);
+            cached_bytes_ -= it->first;
+            it = free_blocks_.erase(it);
+        }
+    }
+}
+
+size_t WorkspaceAllocator::cached_bytes() const {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return cached_bytes_;
+}
+
 static void deleteInefficientStdFunctionContext(void* ptr) {
     delete static_cast<InefficientStdFunctionContext*>(ptr);
 }
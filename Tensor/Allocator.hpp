@@ -12,6 +12,8 @@
 #include <memory>
 #include <cassert>
 #include <functional>
+#include <map>
+#include <mutex>
 
 #include "Config.hpp"
 #include "Device.hpp"
@@ -143,6 +145,58 @@ void free_cpu(void* data);
 Allocator* get_default_allocator();
 Allocator* GetAllocator(Device device);
 
+// The CPU allocation of current thread goes to allocator if it is set
+// Only the calling thread is affected, the worker threads of parallel_for still use the default one
+Allocator* get_thread_allocator();
+void set_thread_allocator(Allocator* allocator);
+
+class ThreadAllocatorGuard {
+public:
+    ThreadAllocatorGuard(Allocator* allocator) : old_allocator_(get_thread_allocator()) {
+        set_thread_allocator(allocator);
+    }
+    
+    ~ThreadAllocatorGuard() {
+        set_thread_allocator(old_allocator_);
+    }
+private:
+    Allocator* old_allocator_;
+};
+
+// Recycle the freed blocks for the next allocation, one workspace per Extractor
+// Every block keeps the workspace alive, so the tensors can outlive the owner safely
+class WorkspaceAllocator : public Allocator, public std::enable_shared_from_this<WorkspaceAllocator> {
+public:
+    static std::shared_ptr<WorkspaceAllocator> create();
+    
+    ~WorkspaceAllocator() override;
+    
+    DataPtr allocate(size_t nbytes) const override;
+    
+    // Release all the cached blocks
+    void clear();
+    
+    // Release the cached blocks which are not handed out since the last trim,
+    // called once per frame it keeps the cache within the working set of one frame
+    void trim();
+    
+    size_t cached_bytes() const;
+private:
+    WorkspaceAllocator() = default;
+    
+    struct Block;
+    static void recycle(void* ctx);
+    
+    struct CachedBlock {
+        void* data;
+        bool recent;    // recycled since the last trim
+    };
+    
+    mutable std::mutex mutex_;
+    mutable std::multimap<size_t, CachedBlock> free_blocks_;
+    mutable size_t cached_bytes_ = 0;
+};
+
 struct InefficientStdFunctionContext {
   std::unique_ptr<void, std::function<void(void*)>> ptr_;
   InefficientStdFunctionContext(
@@ -0,0 +1,411 @@
+//
+//  AvgPoolKernel.cpp
+//  Tensor
+//
+//  Created by 陳均豪 on 2022/3/22.
+//
+
+#include "Pool.hpp"
+#include "AvgPoolKernel.hpp"
+#include "Tensor.hpp"
+#include "Dispatch.hpp"
+#include "Parallel.hpp"
+#include "Utils.hpp"
+#include "Vec.hpp"
+
+namespace otter {
+
+// Number of the elements along one dimension of the window
+// pool_size counts the padding (clipped by ceil_mode), valid_size only counts the input
+struct PoolWindowSize {
+    int64_t pool_size;
+    int64_t valid_size;
+};
+
+static inline PoolWindowSize pool_window_size(int64_t o, int64_t stride, int64_t pad, int64_t kernel, int64_t input_size) {
+    int64_t i0 = o * stride - pad;
+    int64_t i1 = std::min(i0 + kernel, input_size + pad);
+    const int64_t pool_size = i1 - i0;
+    i0 = std::max(i0, (int64_t)0);
+    i1 = std::min(i1, input_size);
+
+    return {pool_size, i1 - i0};
+}
+
+template <typename scalar_t>
+void cpu_avg_pool_impl(
+    const Tensor& output_,
+    const Tensor& input_,
+    int64_t kW, int64_t kH,
+    int64_t dW, int64_t dH,
+    int64_t padW, int64_t padH,
+    bool count_include_pad,
+    int64_t divisor_override) {
+
+    using Vec = vec::Vectorized<scalar_t>;
+
+    auto input = input_.contiguous();
+    auto output = output_.contiguous();
+
+    auto input_data = input.data_ptr<scalar_t>();
+    auto output_data = output.data_ptr<scalar_t>();
+
+    int64_t ndim = input.dim();
+    // treat batch size and channels as one dimension
+    int64_t channels = ndim == 3 ? input.size(0) : input.size(0) * input.size(1);
+    int64_t input_height = input.size(-2);
+    int64_t input_width = input.size(-1);
+    int64_t output_height = output.size(-2);
+    int64_t output_width = output.size(-1);
+
+    // The width part of the divisor is the same for every output row
+    std::vector<scalar_t> width_divisor(output_width);
+    for (const auto ow : otter::irange(output_width)) {
+        PoolWindowSize size = pool_window_size(ow, dW, padW, kW, input_width);
+        width_divisor[ow] = scalar_t(count_include_pad ? size.pool_size : size.valid_size);
+    }
+
+    // The range of ow that reads a valid column for each kernel column
+    std::vector<int64_t> ow_begin(kW);
+    std::vector<int64_t> ow_end(kW);
+    for (const auto kw : otter::irange(kW)) {
+        // div_round_up is the floor division, ceil(x / d) = floor((x + d - 1) / d)
+        ow_begin[kw] = std::max(div_round_up<int64_t>(padW - kw + dW - 1, dW), (int64_t)0);
+        ow_end[kw] = std::min(std::max(div_round_up<int64_t>(input_width + padW - kw + dW - 1, dW), (int64_t)0), output_width);
+    }
+
+    // parallel on dim of N * C, H
+    otter::parallel_for(0, channels * output_height, 0, [&](int64_t begin, int64_t end) {
+        int64_t c = 0;
+        int64_t oh = 0;
+        data_index_init(begin, c, channels, oh, output_height);
+
+        for (const auto i : otter::irange(begin, end)) {
+            scalar_t* out = output_data + i * output_width;
+            const scalar_t* input_ptr = input_data + c * input_height * input_width;
+
+            int64_t ih0 = oh * dH - padH;
+            int64_t ih1 = std::min(ih0 + kH, input_height + padH);
+            const int64_t height_pool_size = ih1 - ih0;
+            ih0 = std::max(ih0, (int64_t)0);
+            ih1 = std::min(ih1, input_height);
+
+            std::fill(out, out + output_width, scalar_t(0));
+
+            // Accumulate the whole output row at once, contiguous when stride is 1
+            for (int64_t ih = ih0; ih < ih1; ++ih) {
+                const scalar_t* in_row = input_ptr + ih * input_width;
+                for (const auto kw : otter::irange(kW)) {
+                    const int64_t ow0 = ow_begin[kw];
+                    const int64_t ow1 = ow_end[kw];
+                    const scalar_t* in = in_row + kw - padW;
+
+                    int64_t ow = ow0;
+                    if (dW == 1) {
+                        for (; ow + Vec::size() <= ow1; ow += Vec::size()) {
+                            (Vec::loadu(out + ow) + Vec::loadu(in + ow)).store(out + ow);
+                        }
+                    }
+                    for (; ow < ow1; ++ow) {
+                        out[ow] += in[ow * dW];
+                    }
+                }
+            }
+
+            if (divisor_override != 0) {
+                const Vec divisor_vec = Vec(scalar_t(divisor_override));
+                int64_t ow = 0;
+                for (; ow + Vec::size() <= output_width; ow += Vec::size()) {
+                    (Vec::loadu(out + ow) / divisor_vec).store(out + ow);
+                }
+                for (; ow < output_width; ++ow) {
+                    out[ow] /= scalar_t(divisor_override);
+                }
+            } else {
+                const scalar_t height_divisor = scalar_t(count_include_pad ? height_pool_size : ih1 - ih0);
+                const Vec height_divisor_vec = Vec(height_divisor);
+                int64_t ow = 0;
+                for (; ow + Vec::size() <= output_width; ow += Vec::size()) {
+                    (Vec::loadu(out + ow) / (height_divisor_vec * Vec::loadu(width_divisor.data() + ow))).store(out + ow);
+                }
+                for (; ow < output_width; ++ow) {
+                    out[ow] /= height_divisor * width_divisor[ow];
+                }
+            }
+
+            // move on to next output row
+            data_index_step(c, channels, oh, output_height);
+        }
+    });
+
+    if (!output_.is_contiguous()) {
+        output_.copy_(output);
+    }
+}
+
+template <typename scalar_t>
+void cpu_avg_pool_channels_last_impl(
+    const Tensor& output_,
+    const Tensor& input_,
+    int64_t kW, int64_t kH,
+    int64_t dW, int64_t dH,
+    int64_t padW, int64_t padH,
+    bool count_include_pad,
+    int64_t divisor_override) {
+
+    OTTER_CHECK(input_.dim() == 4, "average pooling with channels last format supports tensors with 4 dims");
+    auto memory_format = MemoryFormat::ChannelsLast;
+    auto input = input_.contiguous(memory_format);
+    auto output = output_.contiguous(memory_format);
+
+    auto input_data = input.data_ptr<scalar_t>();
+    auto output_data = output.data_ptr<scalar_t>();
+
+    int64_t nbatch = input.size(0);
+    int64_t channels = input.size(1);
+    int64_t input_height = input.size(2);
+    int64_t input_width = input.size(3);
+    int64_t output_height = output.size(2);
+    int64_t output_width = output.size(3);
+
+    using Vec = vec::Vectorized<scalar_t>;
+
+    // parallel on dim N, H, W
+    otter::parallel_for(0, nbatch * output_height * output_width, 0, [&](int64_t begin, int64_t end) {
+        int64_t n = 0;
+        int64_t oh = 0;
+        int64_t ow = 0;
+        data_index_init(begin, n, nbatch, oh, output_height, ow, output_width);
+
+        int64_t size = channels;
+        int64_t len = size - (size % Vec::size());
+
+        for (const auto i : otter::irange(begin, end)) {
+            PoolWindowSize height_size = pool_window_size(oh, dH, padH, kH, input_height);
+            PoolWindowSize width_size = pool_window_size(ow, dW, padW, kW, input_width);
+
+            int64_t ih0 = std::max(oh * dH - padH, (int64_t)0);
+            int64_t iw0 = std::max(ow * dW - padW, (int64_t)0);
+            int64_t ih1 = ih0 + height_size.valid_size;
+            int64_t iw1 = iw0 + width_size.valid_size;
+
+            int64_t divide_factor;
+            if (divisor_override != 0) {
+                divide_factor = divisor_override;
+            } else if (count_include_pad) {
+                divide_factor = height_size.pool_size * width_size.pool_size;
+            } else {
+                divide_factor = height_size.valid_size * width_size.valid_size;
+            }
+
+            scalar_t* out = output_data + i * channels;
+
+            // Pass I: zero the out lane
+            int64_t d1 = 0;
+            for (; d1 < len; d1 += Vec::size()) {
+                Vec out_vec = Vec(scalar_t(0));
+                out_vec.store(out + d1);
+            }
+            for (; d1 < size; d1++) {
+                out[d1] = scalar_t(0);
+            }
+
+            if (ih0 >= ih1 || iw0 >= iw1) {
+                data_index_step(n, nbatch, oh, output_height, ow, output_width);
+                continue;
+            }
+
+            // Pass II: compute local sum
+            for (int64_t ih = ih0; ih < ih1; ++ih) {
+                for (int64_t iw = iw0; iw < iw1; ++iw) {
+                    scalar_t* in = input_data + n * input_height * input_width * channels + ih * input_width * channels + iw * channels;
+
+                    int64_t d2 = 0;
+                    for (; d2 < len; d2 += Vec::size()) {
+                        Vec out_vec = Vec::loadu(out + d2) + Vec::loadu(in + d2);
+                        out_vec.store(out + d2);
+                    }
+                    for (; d2 < size; d2++) {
+                        out[d2] += in[d2];
+                    }
+                }
+            }
+
+            // Pass III: compute local average
+            int64_t d3 = 0;
+            for (; d3 < len; d3 += Vec::size()) {
+                Vec out_vec = Vec::loadu(out + d3) / Vec(scalar_t(divide_factor));
+                out_vec.store(out + d3);
+            }
+            for (; d3 < size; d3++) {
+                out[d3] = out[d3] / divide_factor;
+            }
+
+            // move on to next output index
+            data_index_step(n, nbatch, oh, output_height, ow, output_width);
+        }
+    });
+
+    if (!output_.is_contiguous(memory_format)) {
+        output_.copy_(output);
+    }
+}
+
+void avg_pool2d_kernel(
+    const Tensor& output,
+    const Tensor& input,
+    int64_t kW, int64_t kH,
+    int64_t dW, int64_t dH,
+    int64_t padW, int64_t padH,
+    bool count_include_pad,
+    int64_t divisor_override) {
+
+    switch (input.suggest_memory_format()) {
+        case MemoryFormat::Contiguous:
+            OTTER_DISPATCH_FLOATING_TYPES(input.scalar_type(), "avg_pool2d_cpu", [&] {
+                cpu_avg_pool_impl<scalar_t>(output, input, kW, kH, dW, dH, padW, padH, count_include_pad, divisor_override);
+            });
+            break;
+        case MemoryFormat::ChannelsLast:
+            OTTER_DISPATCH_FLOATING_TYPES(input.scalar_type(), "avg_pool2d_cpu", [&] {
+                cpu_avg_pool_channels_last_impl<scalar_t>(output, input, kW, kH, dW, dH, padW, padH, count_include_pad, divisor_override);
+            });
+            break;
+        default:
+            break;
+    }
+}
+
+template <typename scalar_t>
+void cpu_global_avg_pool_impl(const Tensor& output_, const Tensor& input_) {
+    using Vec = vec::Vectorized<scalar_t>;
+
+    auto input = input_.contiguous();
+    auto output = output_.contiguous();
+
+    auto input_data = input.data_ptr<scalar_t>();
+    auto output_data = output.data_ptr<scalar_t>();
+
+    int64_t channels = input.dim() == 3 ? input.size(0) : input.size(0) * input.size(1);
+    int64_t image_size = input.size(-2) * input.size(-1);
+
+    // One reduction per plane, four accumulators to hide the add latency
+    otter::parallel_for(0, channels, 0, [&](int64_t begin, int64_t end) {
+        for (const auto c : otter::irange(begin, end)) {
+            const scalar_t* in = input_data + c * image_size;
+
+            Vec acc0 = Vec(scalar_t(0));
+            Vec acc1 = Vec(scalar_t(0));
+            Vec acc2 = Vec(scalar_t(0));
+            Vec acc3 = Vec(scalar_t(0));
+
+            int64_t d = 0;
+            for (; d + 4 * Vec::size() <= image_size; d += 4 * Vec::size()) {
+                acc0 = acc0 + Vec::loadu(in + d);
+                acc1 = acc1 + Vec::loadu(in + d + Vec::size());
+                acc2 = acc2 + Vec::loadu(in + d + 2 * Vec::size());
+                acc3 = acc3 + Vec::loadu(in + d + 3 * Vec::size());
+            }
+            for (; d + Vec::size() <= image_size; d += Vec::size()) {
+                acc0 = acc0 + Vec::loadu(in + d);
+            }
+
+            scalar_t partial[Vec::size()];
+            ((acc0 + acc1) + (acc2 + acc3)).store(partial);
+
+            scalar_t sum = 0;
+            for (const auto v : otter::irange(Vec::size())) {
+                sum += partial[v];
+            }
+            for (; d < image_size; ++d) {
+                sum += in[d];
+            }
+
+            output_data[c] = sum / scalar_t(image_size);
+        }
+    });
+
+    if (!output_.is_contiguous()) {
+        output_.copy_(output);
+    }
+}
+
+template <typename scalar_t>
+void cpu_global_avg_pool_channels_last_impl(const Tensor& output_, const Tensor& input_) {
+    using Vec = vec::Vectorized<scalar_t>;
+
+    auto memory_format = MemoryFormat::ChannelsLast;
+    auto input = input_.contiguous(memory_format);
+    auto output = output_.contiguous(memory_format);
+
+    auto input_data = input.data_ptr<scalar_t>();
+    auto output_data = output.data_ptr<scalar_t>();
+
+    int64_t nbatch = input.size(0);
+    int64_t channels = input.size(1);
+    int64_t image_size = input.size(2) * input.size(3);
+
+    // Split the channels into blocks to have enough parallelism for batch 1
+    const int64_t channel_block = divup(divup(channels, (int64_t)otter::get_num_threads()), Vec::size()) * Vec::size();
+    const int64_t channel_blocks = divup(channels, channel_block);
+
+    otter::parallel_for(0, nbatch * channel_blocks, 0, [&](int64_t begin, int64_t end) {
+        for (const auto index : otter::irange(begin, end)) {
+            const int64_t n = index / channel_blocks;
+            const int64_t c0 = (index % channel_blocks) * channel_block;
+            const int64_t c1 = std::min(c0 + channel_block, channels);
+            const int64_t size = c1 - c0;
+            const int64_t len = size - (size % Vec::size());
+
+            scalar_t* out = output_data + n * channels + c0;
+            std::fill(out, out + size, scalar_t(0));
+
+            for (const auto p : otter::irange(image_size)) {
+                const scalar_t* in = input_data + (n * image_size + p) * channels + c0;
+
+                int64_t d = 0;
+                for (; d < len; d += Vec::size()) {
+                    (Vec::loadu(out + d) + Vec::loadu(in + d)).store(out + d);
+                }
+                for (; d < size; ++d) {
+                    out[d] += in[d];
+                }
+            }
+
+            const Vec divisor_vec = Vec(scalar_t(image_size));
+            int64_t d = 0;
+            for (; d < len; d += Vec::size()) {
+                (Vec::loadu(out + d) / divisor_vec).store(out + d);
+            }
+            for (; d < size; ++d) {
+                out[d] /= scalar_t(image_size);
+            }
+        }
+    });
+
+    if (!output_.is_contiguous(memory_format)) {
+        output_.copy_(output);
+    }
+}
+
+void global_avg_pool2d_kernel(const Tensor& output, const Tensor& input) {
+    switch (input.suggest_memory_format()) {
+        case MemoryFormat::Contiguous:
+            OTTER_DISPATCH_FLOATING_TYPES(input.scalar_type(), "global_avg_pool2d_cpu", [&] {
+                cpu_global_avg_pool_impl<scalar_t>(output, input);
+            });
+            break;
+        case MemoryFormat::ChannelsLast:
+            OTTER_DISPATCH_FLOATING_TYPES(input.scalar_type(), "global_avg_pool2d_cpu", [&] {
+                cpu_global_avg_pool_channels_last_impl<scalar_t>(output, input);
+            });
+            break;
+        default:
+            break;
+    }
+}
+
+REGISTER_DISPATCH(avg_pool2d_stub, &avg_pool2d_kernel);
+REGISTER_DISPATCH(global_avg_pool2d_stub, &global_avg_pool2d_kernel);
+
+}   // end namespace otter
@@ -0,0 +1,17 @@
+//
+//  AvgPoolKernel.hpp
+//  Tensor
+//
+//  Created by 陳均豪 on 2022/3/22.
+//
+
+#ifndef AvgPoolKernel_hpp
+#define AvgPoolKernel_hpp
+
+namespace otter {
+
+
+
+}
+
+#endif /* AvgPoolKernel_hpp */
@@ -0,0 +1,35 @@
+//
+//  BFloat16.cpp
+//  Tensor
+//
+//  Created by 陳均豪 on 2022/3/22.
+//
+
+#include "BFloat16.hpp"
+#include "Vec.hpp"
+
+namespace otter {
+
+using Vec = vec::Vectorized<float>;
+
+void float_to_bfloat16(const float* src, BFloat16* dst, int64_t size) {
+    int64_t i = 0;
+    for (; i + Vec::size() <= size; i += Vec::size()) {
+        vec::store_bfloat16(dst + i, Vec::loadu(src + i));
+    }
+    for (; i < size; ++i) {
+        dst[i] = src[i];
+    }
+}
+
+void bfloat16_to_float(const BFloat16* src, float* dst, int64_t size) {
+    int64_t i = 0;
+    for (; i + Vec::size() <= size; i += Vec::size()) {
+        vec::load_bfloat16(src + i).store(dst + i);
+    }
+    for (; i < size; ++i) {
+        dst[i] = src[i];
+    }
+}
+
+}   // end namespace otter
@@ -0,0 +1,152 @@
+//
+//  BFloat16.hpp
+//  Tensor
+//
+//  Created by 陳均豪 on 2022/3/22.
+//
+
+#ifndef BFloat16_hpp
+#define BFloat16_hpp
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <ostream>
+
+namespace otter {
+
+namespace detail {
+
+// The upper half of the float, round to nearest even
+static inline uint16_t bf16_from_fp32_value(float f) {
+    uint32_t w;
+    std::memcpy(&w, &f, sizeof(w));
+    // Keep NaN a quiet NaN, the rounding could carry it into inf
+    if ((w & 0x7FFFFFFFu) > 0x7F800000u)
+        return static_cast<uint16_t>((w >> 16) | 0x0040u);
+    w += 0x7FFFu + ((w >> 16) & 1);
+    return static_cast<uint16_t>(w >> 16);
+}
+
+static inline float bf16_to_fp32_value(uint16_t h) {
+    const uint32_t w = static_cast<uint32_t>(h) << 16;
+    float f;
+    std::memcpy(&f, &w, sizeof(f));
+    return f;
+}
+
+}   // end namespace detail
+
+// Brain floating point, the exponent of float with 8 bit mantissa, the arithmetic is done in float
+struct alignas(2) BFloat16 {
+    uint16_t x;
+
+    struct from_bits_t {};
+    static constexpr from_bits_t from_bits() {
+        return from_bits_t();
+    }
+
+    BFloat16() = default;
+    constexpr BFloat16(uint16_t bits, from_bits_t) : x(bits) {}
+
+    BFloat16(float value) : x(detail::bf16_from_fp32_value(value)) {}
+
+    operator float() const {
+        return detail::bf16_to_fp32_value(x);
+    }
+};
+
+inline BFloat16 operator+(const BFloat16& a, const BFloat16& b) {
+    return static_cast<float>(a) + static_cast<float>(b);
+}
+
+inline BFloat16 operator-(const BFloat16& a, const BFloat16& b) {
+    return static_cast<float>(a) - static_cast<float>(b);
+}
+
+inline BFloat16 operator*(const BFloat16& a, const BFloat16& b) {
+    return static_cast<float>(a) * static_cast<float>(b);
+}
+
+inline BFloat16 operator/(const BFloat16& a, const BFloat16& b) {
+    return static_cast<float>(a) / static_cast<float>(b);
+}
+
+inline BFloat16 operator-(const BFloat16& a) {
+    return BFloat16(a.x ^ 0x8000, BFloat16::from_bits());
+}
+
+inline BFloat16& operator+=(BFloat16& a, const BFloat16& b) {
+    a = a + b;
+    return a;
+}
+
+inline BFloat16& operator-=(BFloat16& a, const BFloat16& b) {
+    a = a - b;
+    return a;
+}
+
+inline BFloat16& operator*=(BFloat16& a, const BFloat16& b) {
+    a = a * b;
+    return a;
+}
+
+inline BFloat16& operator/=(BFloat16& a, const BFloat16& b) {
+    a = a / b;
+    return a;
+}
+
+inline std::ostream& operator<<(std::ostream& out, const BFloat16& value) {
+    out << static_cast<float>(value);
+    return out;
+}
+
+// Contiguous conversion, vectorized with AVX2 (AVX512 BF16 when available)
+void float_to_bfloat16(const float* src, BFloat16* dst, int64_t size);
+void bfloat16_to_float(const BFloat16* src, float* dst, int64_t size);
+
+}   // end namespace otter
+
+namespace std {
+
+template <>
+class numeric_limits<otter::BFloat16> {
+public:
+    static constexpr bool is_specialized = true;
+    static constexpr bool is_signed = true;
+    static constexpr bool is_integer = false;
+    static constexpr bool is_exact = false;
+    static constexpr bool has_infinity = true;
+    static constexpr bool has_quiet_NaN = true;
+    static constexpr bool has_signaling_NaN = true;
+    static constexpr int digits = 8;
+    static constexpr int digits10 = 2;
+    static constexpr int max_digits10 = 4;
+    static constexpr int radix = 2;
+    static constexpr int min_exponent = -125;
+    static constexpr int min_exponent10 = -37;
+    static constexpr int max_exponent = 128;
+    static constexpr int max_exponent10 = 38;
+    static constexpr otter::BFloat16 min() {
+        return otter::BFloat16(0x0080, otter::BFloat16::from_bits());
+    }
+    static constexpr otter::BFloat16 lowest() {
+        return otter::BFloat16(0xFF7F, otter::BFloat16::from_bits());
+    }
+    static constexpr otter::BFloat16 max() {
+        return otter::BFloat16(0x7F7F, otter::BFloat16::from_bits());
+    }
+    static constexpr otter::BFloat16 epsilon() {
+        return otter::BFloat16(0x3C00, otter::BFloat16::from_bits());
+    }
+    static constexpr otter::BFloat16 infinity() {
+        return otter::BFloat16(0x7F80, otter::BFloat16::from_bits());
+    }
+    static constexpr otter::BFloat16 quiet_NaN() {
+        return otter::BFloat16(0x7FC0, otter::BFloat16::from_bits());
+    }
+};
+
+}   // end namespace std
+
+#endif /* BFloat16_hpp */
@@ -89,7 +89,7 @@ void batchnorm_cpu_contiguous_impl(Tensor& output, const Tensor& input, const Te
             }
         });
     } else {
-        const int64_t loop_size = image_size - (image_size % Vec::size());
+        const int64_t loop_size = n_channel - (n_channel % Vec::size());
         otter::parallel_for(0, n_batch, 1, [&](int64_t begin, int64_t end) {
             for (const auto n : otter::irange(begin, end)) {
                 int64_t offset = n * n_channel;
@@ -210,11 +210,11 @@ void batchnorm_cpu_alpha_beta_contiguous_impl(Tensor& output, const Tensor& inpu
                     Vec output_vec = data_vec * alpha_vec + beta_vec;
                     output_vec.store(output_data + offset + d, static_cast<int>(image_size - d));
                 }
+                data_index_step(n, n_batch, c, n_channel);
             }
-            data_index_step(n, n_batch, c, n_channel);
         });
     } else {
-        const int64_t loop_size = image_size - (image_size % Vec::size());
+        const int64_t loop_size = n_channel - (n_channel % Vec::size());
         otter::parallel_for(0, n_batch, 1, [&](int64_t begin, int64_t end) {
             for (const auto n : otter::irange(begin, end)) {
                 int64_t offset = n * n_channel;
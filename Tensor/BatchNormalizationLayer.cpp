@@ -10,12 +10,16 @@
 #include "BatchNormalizationLayer.hpp"
 #include "TensorFactory.hpp"
 #include "Formatting.hpp"
+#include "TensorOperator.hpp"
+#include "TensorPacking.hpp"
 
 namespace otter {
 
 BatchNormalizationLayer::BatchNormalizationLayer() {
     one_blob_only = true;
     support_inplace = true;
+    support_packing = true;
+    support_channels_last = true;
 }
 
 int BatchNormalizationLayer::parse_param(LayerOption& option, ParamDict &pd) {
@@ -40,7 +44,7 @@ int BatchNormalizationLayer::init_model() {
     mean_data = otter::rand({shape_a[1]}, ScalarType::Float);
     var_data = otter::rand({shape_a[1]}, ScalarType::Float);
     
-    return 0;
+    return fold_alpha_beta();
 }
 
 int BatchNormalizationLayer::load_model(const Initializer& initializer) {
@@ -50,13 +54,22 @@ int BatchNormalizationLayer::load_model(const Initializer& initializer) {
     mean_data = initializer.load({shape_a[1]});
     var_data = initializer.load({shape_a[1]});
     
+    return fold_alpha_beta();
+}
+
+int BatchNormalizationLayer::fold_alpha_beta() {
+    alpha = (scale_data / (var_data + 0.000001).sqrt()).contiguous();
+    beta = (bias_data - mean_data * alpha).contiguous();
+    
     return 0;
 }
 
 int BatchNormalizationLayer::forward_inplace(Tensor& bottom_blob, const NetOption& opt) const {
-    
-//    bottom_blob = otter::batchnorm_alpha_beta(bottom_blob, alpha, beta);
-    bottom_blob = otter::batchnorm(bottom_blob, scale_data, bias_data, mean_data, var_data, false, 0, 0.000001);
+    if (otter::is_packed(bottom_blob)) {
+        otter::batchnorm_alpha_beta_packed_(bottom_blob, alpha, beta);
+    } else {
+        otter::batchnorm_alpha_beta_(bottom_blob, alpha, beta);
+    }
     
     return 0;
 }
@@ -27,6 +27,9 @@ public:
     virtual int forward_inplace(Tensor& bottom_blob, const NetOption& opt) const;
     
     virtual std::string type() const { return "BatchNorm"; }
+    
+    // Fold the statistics into alpha = scale / sqrt(var + eps), beta = bias - mean * alpha
+    int fold_alpha_beta();
 public:
     float eps; 
     
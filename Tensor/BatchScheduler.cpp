@@ -0,0 +1,195 @@
+//
+//  BatchScheduler.cpp
+//  Tensor
+//
+//  Created by 陳均豪 on 2022/3/21.
+//
+
+#include "BatchScheduler.hpp"
+#include "Net.hpp"
+#include "TensorShape.hpp"
+
+namespace otter {
+
+BatchOption::BatchOption() {
+    max_batch_size = 8;
+    max_delay_us = 2000;
+    input_name = "data";
+}
+
+BatchScheduler::BatchScheduler(const Net& net, BatchOption option) : net_(net), option_(std::move(option)), extractor_pool_(net, 1), running_(true), busy_(false) {
+    OTTER_CHECK(option_.max_batch_size > 0, "Expect max_batch_size > 0 but get ", option_.max_batch_size);
+    OTTER_CHECK(option_.max_delay_us >= 0, "Expect max_delay_us >= 0 but get ", option_.max_delay_us);
+
+    input_blob_index_ = net_.find_blob_index_by_name(option_.input_name);
+    OTTER_CHECK(input_blob_index_ != -1, "[BatchScheduler] Input blob ", option_.input_name, " not found");
+
+    if (option_.output_names.empty()) {
+        for (const auto blob_name : net_.output_blob_names) {
+            option_.output_names.push_back(blob_name);
+        }
+    }
+
+    for (const auto& output_name : option_.output_names) {
+        int blob_index = net_.find_blob_index_by_name(output_name);
+        OTTER_CHECK(blob_index != -1, "[BatchScheduler] Output blob ", output_name, " not found");
+
+        const Layer* producer = net_.layers[net_.blobs[blob_index].producer];
+        output_blob_indexes_.push_back(blob_index);
+        output_is_detection_.push_back(producer->type() == "Yolov3");
+    }
+
+    worker_ = std::thread([this]() {
+        this->worker_loop();
+    });
+}
+
+BatchScheduler::~BatchScheduler() {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        running_ = false;
+        condition_.notify_all();
+    }
+
+    // The queued requests are still served before the worker exits
+    if (worker_.joinable())
+        worker_.join();
+}
+
+std::future<BatchResult> BatchScheduler::input(const Tensor& in) {
+    OTTER_CHECK(in.dim() == 3 || (in.dim() == 4 && in.size(0) == 1), "[BatchScheduler] Expect input {1, C, H, W} or {C, H, W} but get ", in.sizes());
+
+    Request request;
+    request.input = (in.dim() == 3) ? in.unsqueeze(0) : in;
+    request.arrival = std::chrono::steady_clock::now();
+    std::future<BatchResult> future = request.promise.get_future();
+
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        OTTER_CHECK(running_, "[BatchScheduler] Scheduler is stopped");
+        queue_.push_back(std::move(request));
+    }
+    condition_.notify_one();
+
+    return future;
+}
+
+void BatchScheduler::flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    completed_.wait(lock, [this]() {
+        return queue_.empty() && !busy_;
+    });
+}
+
+void BatchScheduler::worker_loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (true) {
+        condition_.wait(lock, [this]() {
+            return !running_ || !queue_.empty();
+        });
+
+        if (queue_.empty()) {
+            if (!running_)
+                break;
+            continue;
+        }
+
+        // Wait for more requests until the batch is full or the oldest one reaches the deadline
+        auto deadline = queue_.front().arrival + std::chrono::microseconds(option_.max_delay_us);
+        condition_.wait_until(lock, deadline, [this]() {
+            return !running_ || (int)queue_.size() >= option_.max_batch_size;
+        });
+
+        // Only the requests with the same shape can be stacked
+        std::vector<Request> batch;
+        const std::vector<int64_t> shape = queue_.front().input.sizes().vec();
+        for (auto it = queue_.begin(); it != queue_.end() && (int)batch.size() < option_.max_batch_size;) {
+            if (it->input.sizes() == shape) {
+                batch.push_back(std::move(*it));
+                it = queue_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        busy_ = true;
+        lock.unlock();
+
+        run_batch(batch);
+
+        lock.lock();
+        busy_ = false;
+        completed_.notify_all();
+    }
+}
+
+void BatchScheduler::run_batch(std::vector<Request>& batch) {
+    const int64_t batch_size = static_cast<int64_t>(batch.size());
+
+    std::vector<BatchResult> results(batch_size);
+
+    try {
+        Tensor stacked;
+        if (batch_size == 1) {
+            stacked = batch[0].input;
+        } else {
+            std::vector<Tensor> inputs;
+            inputs.reserve(batch_size);
+            for (const auto& request : batch) {
+                inputs.push_back(request.input);
+            }
+            stacked = otter::native::cat(inputs, 0);
+        }
+
+        PooledExtractor extractor(extractor_pool_);
+        extractor->set_option(option_.net_option);
+
+        int status = extractor->input(input_blob_index_, stacked);
+
+        const size_t output_count = output_blob_indexes_.size();
+        std::vector<Tensor> outputs(output_count);
+        for (const auto j : otter::irange(output_count)) {
+            if (status == 0)
+                status = extractor->extract(output_blob_indexes_[j], outputs[j], 0);
+        }
+
+        // Split the outputs back to each request, the feature maps are views of the batch output
+        for (const auto i : otter::irange(batch_size)) {
+            BatchResult& result = results[i];
+            result.status = status;
+            result.outputs.resize(output_count);
+
+            for (const auto j : otter::irange(output_count)) {
+                const Tensor& output = outputs[j];
+
+                if (!output.defined() || batch_size == 1) {
+                    result.outputs[j] = output;
+                } else if (output_is_detection_[j]) {
+                    // {batch, max_detected, 6} padded with label 0
+                    Tensor detection = output[i];
+                    const float* detection_ptr = detection.data_ptr<float>();
+                    int64_t num_detected = 0;
+                    while (num_detected < detection.size(0) && detection_ptr[num_detected * 6] > 0)
+                        ++num_detected;
+
+                    if (num_detected > 0)
+                        result.outputs[j] = detection.slice(0, 0, num_detected);
+                } else {
+                    result.outputs[j] = output.slice(0, i, i + 1);
+                }
+            }
+        }
+    } catch (...) {
+        for (auto& request : batch) {
+            request.promise.set_exception(std::current_exception());
+        }
+        return;
+    }
+
+    for (const auto i : otter::irange(batch_size)) {
+        batch[i].promise.set_value(std::move(results[i]));
+    }
+}
+
+}   // end namespace otter
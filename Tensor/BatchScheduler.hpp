@@ -0,0 +1,94 @@
+//
+//  BatchScheduler.hpp
+//  Tensor
+//
+//  Created by 陳均豪 on 2022/3/21.
+//
+
+#ifndef BatchScheduler_hpp
+#define BatchScheduler_hpp
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Tensor.hpp"
+#include "Net.hpp"
+#include "NetOption.hpp"
+
+namespace otter {
+
+class BatchOption {
+public:
+    BatchOption();
+
+public:
+    // Run the batch as soon as it is full
+    int max_batch_size;
+    // Otherwise run it when the oldest request has waited for this long
+    int max_delay_us;
+
+    std::string input_name;
+    std::vector<std::string> output_names;
+
+    NetOption net_option;
+};
+
+// The outputs are in the order of BatchOption::output_names
+// Feature map is {1, C, H, W}, detection is {num_detected, 6}
+// Undefined tensor means nothing detected
+struct BatchResult {
+    int status;
+    std::vector<Tensor> outputs;
+};
+
+// Collect the concurrent single image requests into one N-batch forward
+class BatchScheduler {
+public:
+    BatchScheduler(const Net& net, BatchOption option = BatchOption());
+    ~BatchScheduler();
+
+    BatchScheduler(const BatchScheduler&) = delete;
+    BatchScheduler& operator=(const BatchScheduler&) = delete;
+
+    // Thread safe, in should be {1, C, H, W} or {C, H, W}
+    std::future<BatchResult> input(const Tensor& in);
+
+    // Block until all the queued requests are done
+    void flush();
+
+private:
+    struct Request {
+        Tensor input;
+        std::promise<BatchResult> promise;
+        std::chrono::steady_clock::time_point arrival;
+    };
+
+    void worker_loop();
+    void run_batch(std::vector<Request>& batch);
+
+    const Net& net_;
+    BatchOption option_;
+    ExtractorPool extractor_pool_;
+
+    std::vector<int> output_blob_indexes_;
+    std::vector<bool> output_is_detection_;
+    int input_blob_index_;
+
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::condition_variable completed_;
+    std::deque<Request> queue_;
+    bool running_;
+    bool busy_;
+    std::thread worker_;
+};
+
+}   // end namespace otter
+
+#endif /* BatchScheduler_hpp */
@@ -88,9 +88,10 @@ void bitwise_and_kernel(TensorIterator& iter) {
         });
     } else {
         OTTER_DISPATCH_INTEGRAL_TYPES(iter.dtype(), "bitwise_and_cpu", [&]() {
-            cpu_kernel(iter, [=](scalar_t a, scalar_t b) -> scalar_t {
-                return a & b;
-            });
+            cpu_kernel_vec(iter,
+                [=](scalar_t a, scalar_t b) -> scalar_t { return a & b; },
+                [=](Vectorized<scalar_t> a, Vectorized<scalar_t> b) { return a & b; }
+            );
         });
     }
 }
@@ -102,9 +103,10 @@ void bitwise_or_kernel(TensorIterator& iter) {
         });
     } else {
         OTTER_DISPATCH_INTEGRAL_TYPES(iter.dtype(), "bitwise_and_cpu", [&]() {
-            cpu_kernel(iter, [=](scalar_t a, scalar_t b) -> scalar_t {
-                return a | b;
-            });
+            cpu_kernel_vec(iter,
+                [=](scalar_t a, scalar_t b) -> scalar_t { return a | b; },
+                [=](Vectorized<scalar_t> a, Vectorized<scalar_t> b) { return a | b; }
+            );
         });
     }
 }
@@ -116,9 +118,10 @@ void bitwise_xor_kernel(TensorIterator& iter) {
         });
     } else {
         OTTER_DISPATCH_INTEGRAL_TYPES(iter.dtype(), "bitwise_and_cpu", [&]() {
-            cpu_kernel(iter, [=](scalar_t a, scalar_t b) -> scalar_t {
-                return a ^ b;
-            });
+            cpu_kernel_vec(iter,
+                [=](scalar_t a, scalar_t b) -> scalar_t { return a ^ b; },
+                [=](Vectorized<scalar_t> a, Vectorized<scalar_t> b) { return a ^ b; }
+            );
         });
     }
 }
@@ -3,7 +3,7 @@
 namespace otter {
 namespace cv {
 
-Point Center(otter::Tensor& t1, otter::Tensor& t2, int N) {
+Point2f Center(otter::Tensor& t1, otter::Tensor& t2, int N) {
     auto centerX_t = otter::empty({N}, otter::ScalarType::Float);
     auto centerY_t = otter::empty({N}, otter::ScalarType::Float);
     auto centerX = centerX_t.accessor<float, 1>();
@@ -43,7 +43,7 @@ Point Center(otter::Tensor& t1, otter::Tensor& t2, int N) {
     weightY = weightY / tot_weight;
     
     
-    Point point;
+    Point2f point;
     point.x = weightX;
     point.y = weightY;
     
@@ -3,6 +3,7 @@
 
 #include "Tensor.hpp"
 #include "TensorFactory.hpp"
+#include "GraphicAPI.hpp"
 
 namespace otter {
 namespace cv {
@@ -18,12 +19,7 @@ struct BBox {
     int y_low;
 };
 
-struct Point {
-    float x;
-    float y;
-};
-
-Point Center(otter::Tensor& t1, otter::Tensor& t2, int N);
+Point2f Center(otter::Tensor& t1, otter::Tensor& t2, int N);
 
 
 
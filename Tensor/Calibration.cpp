@@ -0,0 +1,225 @@
+//
+//  Calibration.cpp
+//  Tensor
+//
+//  Created by 陳均豪 on 2022/3/22.
+//
+
+#include "Calibration.hpp"
+#include "Net.hpp"
+#include "ConvolutionLayer.hpp"
+#include "Quantize.hpp"
+
+#include <cfloat>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+namespace otter {
+
+// Bins of the |x| histogram, the KL search keeps at least INT8_TARGET_BINS of them
+static constexpr int HISTOGRAM_BINS = 2048;
+static constexpr int INT8_TARGET_BINS = 128;
+
+void Int8Calibrator::BlobStatistics::update(const Tensor& blob) {
+    Tensor blob_contiguous = blob.to(ScalarType::Float).contiguous();
+    const float* data = blob_contiguous.data_ptr<float>();
+    const int64_t size = blob_contiguous.numel();
+
+    float blob_absmax = 0.f;
+    for (const auto i : otter::irange(size)) {
+        blob_absmax = std::max(blob_absmax, std::fabs(data[i]));
+    }
+    if (blob_absmax == 0.f)
+        return;
+
+    if (histogram.empty()) {
+        histogram.assign(HISTOGRAM_BINS, 0);
+        range = blob_absmax;
+    } else if (blob_absmax > range) {
+        // Widen the bins by the power of 2, the old bins are merged without splitting
+        int64_t factor = 1;
+        while (range * factor < blob_absmax)
+            factor *= 2;
+
+        std::vector<int64_t> merged(HISTOGRAM_BINS, 0);
+        for (const auto i : otter::irange(HISTOGRAM_BINS)) {
+            merged[i / factor] += histogram[i];
+        }
+        histogram.swap(merged);
+        range *= factor;
+    }
+    absmax = std::max(absmax, blob_absmax);
+
+    const float bins_per_unit = HISTOGRAM_BINS / range;
+    for (const auto i : otter::irange(size)) {
+        // The zeros come from relu and the padding, they tell nothing about the distribution
+        if (data[i] == 0.f)
+            continue;
+        const int bin = std::min(HISTOGRAM_BINS - 1, static_cast<int>(std::fabs(data[i]) * bins_per_unit));
+        histogram[bin]++;
+    }
+}
+
+static double kl_divergence(const std::vector<double>& p, const std::vector<double>& q) {
+    double p_sum = 0, q_sum = 0;
+    for (const auto i : otter::irange(p.size())) {
+        p_sum += p[i];
+        q_sum += q[i];
+    }
+
+    double divergence = 0;
+    for (const auto i : otter::irange(p.size())) {
+        if (p[i] == 0)
+            continue;
+        const double p_i = p[i] / p_sum;
+        // Q is empty where P is not, keep it finite
+        const double q_i = (q[i] == 0) ? 1e-12 : q[i] / q_sum;
+        divergence += p_i * std::log(p_i / q_i);
+    }
+
+    return divergence;
+}
+
+float Int8Calibrator::BlobStatistics::threshold(CalibrationMethod method) const {
+    if (method == CalibrationMethod::MinMax || histogram.empty())
+        return absmax;
+
+    int best_bins = HISTOGRAM_BINS;
+    double best_divergence = DBL_MAX;
+
+    for (int bins = INT8_TARGET_BINS; bins <= HISTOGRAM_BINS; ++bins) {
+        // P clips the histogram at the threshold, the outliers go into the last bin
+        std::vector<double> p(histogram.begin(), histogram.begin() + bins);
+        for (int i = bins; i < HISTOGRAM_BINS; ++i) {
+            p[bins - 1] += histogram[i];
+        }
+
+        // Q merges the clipped P into the int8 bins then expands it back over the non empty bins,
+        // so the outliers folded into the last bin are quantized as well
+        std::vector<double> merged(INT8_TARGET_BINS, 0);
+        std::vector<int> nonzeros(INT8_TARGET_BINS, 0);
+        for (const auto i : otter::irange(bins)) {
+            const int target = static_cast<int>(static_cast<int64_t>(i) * INT8_TARGET_BINS / bins);
+            merged[target] += p[i];
+            nonzeros[target] += (p[i] != 0);
+        }
+
+        std::vector<double> q(bins, 0);
+        for (const auto i : otter::irange(bins)) {
+            const int target = static_cast<int>(static_cast<int64_t>(i) * INT8_TARGET_BINS / bins);
+            if (p[i] != 0)
+                q[i] = merged[target] / nonzeros[target];
+        }
+
+        const double divergence = kl_divergence(p, q);
+        if (divergence < best_divergence) {
+            best_divergence = divergence;
+            best_bins = bins;
+        }
+    }
+
+    return std::min(absmax, (best_bins + 0.5f) * range / HISTOGRAM_BINS);
+}
+
+Int8Calibrator::Int8Calibrator(const Net& net, CalibrationMethod method) : net_(net), method_(method) {
+    for (const auto i : otter::irange(net_.layers.size())) {
+        auto type = net_.layer_options[i].find("type");
+        if (type == net_.layer_options[i].end() || type->second != "Convolution")
+            continue;
+
+        const ConvolutionLayer* conv = static_cast<const ConvolutionLayer*>(net_.layers[i]);
+        bool supported = conv->dilation_height == 1 && conv->dilation_width == 1 && (conv->groups == 1 || (conv->groups == conv->in_channels && conv->groups == conv->out_channels));
+        if (!supported || conv->int8_scale_term)
+            continue;
+
+        BlobStatistics statistics;
+        statistics.layer = (int)i;
+        statistics.blob = conv->bottoms[0];
+        statistics_.push_back(statistics);
+    }
+}
+
+int Int8Calibrator::feed(const std::string& input_name, const Tensor& input) {
+    Extractor extractor = net_.create_extractor();
+    // Keep the intermediate blobs, every bottom blob is computed once
+    extractor.set_lightmode(false);
+
+    int ret = extractor.input(input_name, input);
+    if (ret != 0)
+        return ret;
+
+    for (auto& statistics : statistics_) {
+        Tensor blob;
+        ret = extractor.extract(statistics.blob, blob, 0);
+        if (ret != 0)
+            return ret;
+
+        statistics.update(blob);
+    }
+
+    return 0;
+}
+
+std::map<std::string, float> Int8Calibrator::blob_scales() const {
+    std::map<std::string, float> scales;
+    for (const auto& statistics : statistics_) {
+        const float threshold = statistics.threshold(method_);
+        scales[net_.layers[statistics.layer]->name] = (threshold > 0.f) ? threshold / 127.f : 1.f;
+    }
+
+    return scales;
+}
+
+int Int8Calibrator::write_table(const char* path) const {
+    FILE* fp = fopen(path, "w");
+    if (!fp) {
+        fprintf(stderr, "[Int8Calibrator] Open %s fail!\n", path);
+        return -1;
+    }
+
+    const auto scales = blob_scales();
+    for (const auto& statistics : statistics_) {
+        const ConvolutionLayer* conv = static_cast<const ConvolutionLayer*>(net_.layers[statistics.layer]);
+        const std::string& name = conv->name;
+
+        Tensor weight_scale = otter::int8_weight_scale(conv->weight_data);
+        fprintf(fp, "%s_param_0", name.c_str());
+        for (const auto o : otter::irange(weight_scale.numel())) {
+            fprintf(fp, " %.9g", weight_scale.data_ptr<float>()[o]);
+        }
+        fprintf(fp, "\n");
+        fprintf(fp, "%s %.9g\n", name.c_str(), scales.at(name));
+    }
+
+    fclose(fp);
+    return 0;
+}
+
+int read_int8_scale_table(const char* path, std::map<std::string, std::vector<float>>& table) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        fprintf(stderr, "[Int8Calibrator] Open %s fail!\n", path);
+        return -1;
+    }
+
+    table.clear();
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        std::string name;
+        if (!(fields >> name))
+            continue;
+
+        std::vector<float> scales;
+        float scale;
+        while (fields >> scale) {
+            scales.push_back(scale);
+        }
+        table[name] = scales;
+    }
+
+    return 0;
+}
+
+}   // end namespace otter
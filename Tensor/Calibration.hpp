@@ -0,0 +1,68 @@
+//
+//  Calibration.hpp
+//  Tensor
+//
+//  Created by 陳均豪 on 2022/3/22.
+//
+
+#ifndef Calibration_hpp
+#define Calibration_hpp
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Tensor.hpp"
+
+namespace otter {
+
+class Net;
+
+enum class CalibrationMethod {
+    MinMax,     // threshold = absmax
+    KL          // threshold minimizes the KL divergence between the fp32 and the int8 histogram
+};
+
+// Post training quantization, collect the bottom blobs of the convolutions over the calibration images
+// then write the scale table for Net::load_int8_scales
+//
+// Table, one line per convolution
+//   <layer name>_param_0 <weight scale of each output channel>
+//   <layer name> <bottom blob scale>
+// The scale follows Quantize.hpp, real = q * scale
+// The calibrated net is read-only as any net with Extractor, load the table into another one
+class Int8Calibrator {
+public:
+    Int8Calibrator(const Net& net, CalibrationMethod method = CalibrationMethod::KL);
+
+    // Run the float network on one calibration image
+    int feed(const std::string& input_name, const Tensor& input);
+
+    int write_table(const char* path) const;
+
+    // The bottom blob scale of each convolution, indexed by layer name
+    std::map<std::string, float> blob_scales() const;
+
+private:
+    struct BlobStatistics {
+        int layer;
+        int blob;
+        float absmax = 0.f;
+        float range = 0.f;              // the upper bound of the histogram
+        std::vector<int64_t> histogram;
+
+        void update(const Tensor& blob);
+        float threshold(CalibrationMethod method) const;
+    };
+
+    const Net& net_;
+    CalibrationMethod method_;
+    std::vector<BlobStatistics> statistics_;
+};
+
+// Read the table written by Int8Calibrator, the value is the list of the scales on the line
+int read_int8_scale_table(const char* path, std::map<std::string, std::vector<float>>& table);
+
+}   // end namespace otter
+
+#endif /* Calibration_hpp */
@@ -14,6 +14,8 @@ namespace otter {
 ConcatLayer::ConcatLayer() {
     one_blob_only = false;
     support_inplace = false;
+    support_view_output = true;
+    support_channels_last = true;
 }
 
 int ConcatLayer::parse_param(LayerOption& option, ParamDict& pd) {
@@ -41,6 +43,8 @@ int ConcatLayer::compute_output_shape(ParamDict& pd) {
 
 int ConcatLayer::load_param(const ParamDict &pd) {
     axis = pd.get((int)ConcatParam::Axis, axis);
+    // The channel blocks of the packed bottoms can be concatenated directly
+    support_packing = (axis == 1);
     
     return 0;
 }
@@ -55,6 +59,37 @@ int ConcatLayer::forward(const std::vector<Tensor>& bottom_blobs, std::vector<Te
     return 0;
 }
 
+int ConcatLayer::forward_into(const std::vector<Tensor>& bottom_blobs, std::vector<Tensor>& top_blobs, const NetOption& opt) const {
+    Tensor& top_blob = top_blobs[0];
+    
+    int64_t concat_size = 0;
+    for (const auto& bottom_blob : bottom_blobs) {
+        if (bottom_blob.dim() != top_blob.dim() || bottom_blob.scalar_type() != top_blob.scalar_type())
+            return -1;
+        for (const auto d : otter::irange(top_blob.dim())) {
+            if (d != axis && bottom_blob.size(d) != top_blob.size(d))
+                return -1;
+        }
+        concat_size += bottom_blob.size(axis);
+    }
+    if (concat_size != top_blob.size(axis))
+        return -1;
+    
+    int64_t offset = 0;
+    for (const auto& bottom_blob : bottom_blobs) {
+        const int64_t size = bottom_blob.size(axis);
+        Tensor top_slice = top_blob.slice(axis, offset, offset + size);
+        
+        // Skip the bottom which is already written into the slice by the producer
+        if (bottom_blob.data_ptr() != top_slice.data_ptr() || bottom_blob.strides() != top_slice.strides()) {
+            top_slice.copy_(bottom_blob);
+        }
+        offset += size;
+    }
+    
+    return 0;
+}
+
 REGISTER_LAYER_CLASS(Concat);
 
 }
@@ -24,6 +24,8 @@ public:
     
     virtual int forward(const std::vector<Tensor>& bottom_blobs, std::vector<Tensor>& top_blobs, const NetOption& opt) const;
     
+    virtual int forward_into(const std::vector<Tensor>& bottom_blobs, std::vector<Tensor>& top_blobs, const NetOption& opt) const;
+    
     virtual std::string type() const { return "Concat"; }
 private:
     int axis;
@@ -101,6 +101,8 @@ ConvBackend select_proper_conv_backend(
         
     } else if (!need_backward && params.use_cpu_depthwise3x3_winograd(input, weight)) {
         return ConvBackend::Winograd3x3Depthwise;
+    } else if (!need_backward && params.use_cpu_depthwise(input, weight)) {
+        return ConvBackend::Slow2dDepthwise;
     } else if (input.device() == Device::CPU) { // or input.is_cuda()
         if (params.transposed) {
             // unsupported
@@ -204,6 +206,9 @@ Tensor convolution(
         case ConvBackend::Winograd3x3Depthwise:
             output = convolution_depthwise3x3_winograd_stub(Device::CPU, input, weight, bias, params.stride, params.padding, params.groups);
             break;
+        case ConvBackend::Slow2dDepthwise:
+            output = otter::slow_conv2d_depthwise(input.contiguous(), weight, bias, weight.sizes().slice(2), params.stride, params.padding);
+            break;
         case ConvBackend::Slow2d:
         case ConvBackend::Slow2dNeon:
         case ConvBackend::Slow2dNeon_1x1s1:
@@ -0,0 +1,393 @@
+//
+//  ConvolutionBF16.cpp
+//  Tensor
+//
+//  Created by 陳均豪 on 2022/3/22.
+//
+
+#include "ConvolutionBF16.hpp"
+#include "Tensor.hpp"
+#include "TensorFactory.hpp"
+#include "Parallel.hpp"
+#include "Vec.hpp"
+#include "VecIntrinsic.hpp"
+#include "Config.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace otter {
+
+using Vec = vec::Vectorized<float>;
+
+// Output channels of the micro kernel, the packed weight is interleaved by this
+static constexpr int64_t BF16_MR = 4;
+// Output pixels of the micro kernel, one zmm of float or two ymm
+static constexpr int64_t BF16_NR = 16;
+// Bytes of the bf16 input panel of one tile, the panel stays in L2
+static constexpr int64_t BF16_PANEL_BYTES = 128 * 1024;
+static constexpr int64_t BF16_MAX_TILE = 128;
+#if defined(__AVX512BF16__)
+static constexpr int64_t BF16_BLOCKS_PER_CALL = 2;
+#else
+static constexpr int64_t BF16_BLOCKS_PER_CALL = 1;
+#endif
+
+struct BF16Geometry {
+    int64_t in_channels;
+    int64_t input_height;
+    int64_t input_width;
+    int64_t output_height;
+    int64_t output_width;
+    int64_t kernel_height;
+    int64_t kernel_width;
+    int64_t stride_height;
+    int64_t stride_width;
+    int64_t pad_height;
+    int64_t pad_width;
+    int64_t depth;      // in_channels * kh * kw
+    int64_t pairs;      // ceil(depth / 2)
+};
+
+Tensor convolution_bf16_pack_weight(const Tensor& weight) {
+    OTTER_CHECK(weight.dim() == 4, "convolution_bf16_pack_weight: Expect weight {out_channels, in_channels, kh, kw} but get ", weight.sizes());
+
+    const int64_t out_channels = weight.size(0);
+    const int64_t depth = weight.size(1) * weight.size(2) * weight.size(3);
+    const int64_t pairs = divup(depth, 2);
+
+    Tensor weight_bf16 = weight.to(ScalarType::BFloat16).contiguous();
+    Tensor packed = otter::zeros({divup(out_channels, BF16_MR), pairs, BF16_MR, 2}, ScalarType::BFloat16);
+
+    const uint16_t* src = reinterpret_cast<const uint16_t*>(weight_bf16.data_ptr<BFloat16>());
+    uint16_t* dst = reinterpret_cast<uint16_t*>(packed.data_ptr<BFloat16>());
+
+    for (const auto o : otter::irange(out_channels)) {
+        uint16_t* block = dst + (o / BF16_MR) * pairs * BF16_MR * 2 + (o % BF16_MR) * 2;
+        for (const auto k : otter::irange(depth)) {
+            block[(k / 2) * BF16_MR * 2 + (k % 2)] = src[o * depth + k];
+        }
+    }
+
+    return packed;
+}
+
+// Interleave the bf16 rows {depth, pixels} (row_stride apart) into the panel {blocks, pairs, BF16_NR, 2},
+// every 32 bit lane holds two adjacent k of one pixel, zero filled past the depth and the pixels
+static void interleave_bf16_panel(uint16_t* panel, const uint16_t* rows, int64_t row_stride, int64_t depth, int64_t pairs, int64_t pixels) {
+    const int64_t blocks = divup(pixels, BF16_NR);
+
+    for (const auto b : otter::irange(blocks)) {
+        const int64_t count = std::min(BF16_NR, pixels - b * BF16_NR);
+        uint16_t* dst = panel + b * pairs * BF16_NR * 2;
+
+        for (const auto kp : otter::irange(pairs)) {
+            const uint16_t* row0 = rows + (2 * kp) * row_stride + b * BF16_NR;
+            const uint16_t* row1 = (2 * kp + 1 < depth) ? row0 + row_stride : nullptr;
+            uint16_t* out = dst + kp * BF16_NR * 2;
+#if CPU_CAPABILITY_AVX2
+            if (count == BF16_NR) {
+                const __m256i x0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row0));
+                const __m256i x1 = row1 ? _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row1)) : _mm256_setzero_si256();
+                // unpack interleaves inside the 128 bit lanes, put pixels 0 - 7 and 8 - 15 back together
+                const __m256i lo = _mm256_unpacklo_epi16(x0, x1);
+                const __m256i hi = _mm256_unpackhi_epi16(x0, x1);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_permute2x128_si256(lo, hi, 0x20));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 16), _mm256_permute2x128_si256(lo, hi, 0x31));
+                continue;
+            }
+#endif
+            for (const auto i : otter::irange(BF16_NR)) {
+                out[i * 2] = (i < count) ? row0[i] : 0;
+                out[i * 2 + 1] = (i < count && row1) ? row1[i] : 0;
+            }
+        }
+    }
+}
+
+// im2col of the output pixels [p_begin, p_end) into the bf16 rows {depth, p_end - p_begin}
+// The pixels of one output row read one input row, copy the segment inside the input and zero the padding
+static void im2col_bf16(uint16_t* columns, const uint16_t* input, const BF16Geometry& g, int64_t p_begin, int64_t p_end) {
+    const int64_t pixels = p_end - p_begin;
+    const int64_t input_size = g.input_height * g.input_width;
+    const int64_t kernel_size = g.kernel_height * g.kernel_width;
+
+    for (const auto k : otter::irange(g.depth)) {
+        const int64_t c = k / kernel_size;
+        const int64_t ky = (k % kernel_size) / g.kernel_width;
+        const int64_t kx = k % g.kernel_width;
+        const uint16_t* plane = input + c * input_size;
+        uint16_t* dst = columns + k * pixels;
+
+        // [ox_lower, ox_upper) reads inside the input row
+        const int64_t ix_offset = kx - g.pad_width;
+        const int64_t ox_lower = (ix_offset < 0) ? divup(-ix_offset, g.stride_width) : 0;
+        const int64_t ox_upper = std::max(ox_lower, (g.input_width - ix_offset + g.stride_width - 1) / g.stride_width);
+
+        for (int64_t p = p_begin; p < p_end;) {
+            const int64_t oy = p / g.output_width;
+            const int64_t ox_begin = p % g.output_width;
+            const int64_t ox_end = std::min(g.output_width, ox_begin + p_end - p);
+            uint16_t* out = dst + (p - p_begin);
+            const int64_t iy = oy * g.stride_height - g.pad_height + ky;
+
+            if (iy < 0 || iy >= g.input_height) {
+                std::fill(out, out + ox_end - ox_begin, 0);
+            } else {
+                const uint16_t* row = plane + iy * g.input_width + ix_offset;
+                const int64_t lower = std::min(ox_end, std::max(ox_begin, ox_lower));
+                const int64_t upper = std::max(lower, std::min(ox_end, ox_upper));
+
+                std::fill(out, out + lower - ox_begin, 0);
+                if (g.stride_width == 1) {
+                    std::memcpy(out + lower - ox_begin, row + lower, (upper - lower) * sizeof(uint16_t));
+                } else {
+                    for (const auto ox : otter::irange(lower, upper)) {
+                        out[ox - ox_begin] = row[ox * g.stride_width];
+                    }
+                }
+                std::fill(out + upper - ox_begin, out + ox_end - ox_begin, 0);
+            }
+            p += ox_end - ox_begin;
+        }
+    }
+}
+
+static inline void bf16_store(float* out, Vec x, float bias, int64_t count) {
+    x = x + Vec(bias);
+    if (count == Vec::size()) {
+        x.store(out);
+    } else if (count > 0) {
+        x.store(out, static_cast<int>(count));
+    }
+}
+
+// output[rows channels, count pixels] = weight[BF16_MR channels, depth] * panel[depth, BF16_NR pixels] + bias
+// count covers the next panel block as well with AVX512 BF16 (see BF16_BLOCKS_PER_CALL)
+// panel is {pairs, BF16_NR, 2} bf16, weight is {pairs, BF16_MR, 2} bf16 zero padded past the channels
+// and weight_float is the same block widened to float for the kernel without bf16 instructions
+static inline void bf16_micro_kernel(float* output, int64_t ldo, int64_t rows, int64_t count, const uint16_t* weight, const float* weight_float, const uint16_t* panel, int64_t pairs, const float* bias) {
+#if defined(__AVX512BF16__)
+    (void)weight_float;
+    // Two blocks of pixels per call when available, vdpbf16ps needs the independent accumulators to hide its latency
+    __m512 c00 = _mm512_setzero_ps(), c01 = _mm512_setzero_ps();
+    __m512 c10 = _mm512_setzero_ps(), c11 = _mm512_setzero_ps();
+    __m512 c20 = _mm512_setzero_ps(), c21 = _mm512_setzero_ps();
+    __m512 c30 = _mm512_setzero_ps(), c31 = _mm512_setzero_ps();
+
+    auto broadcast = [](const uint16_t* pair) {
+        int32_t value;
+        std::memcpy(&value, pair, sizeof(value));
+        return (__m512bh)_mm512_set1_epi32(value);
+    };
+
+    if (count > BF16_NR) {
+        const uint16_t* panel_next = panel + pairs * BF16_NR * 2;
+        for (const auto kp : otter::irange(pairs)) {
+            const __m512bh b0 = (__m512bh)_mm512_loadu_si512(panel + kp * BF16_NR * 2);
+            const __m512bh b1 = (__m512bh)_mm512_loadu_si512(panel_next + kp * BF16_NR * 2);
+            const uint16_t* a = weight + kp * BF16_MR * 2;
+
+            __m512bh w = broadcast(a);
+            c00 = _mm512_dpbf16_ps(c00, b0, w);
+            c01 = _mm512_dpbf16_ps(c01, b1, w);
+            w = broadcast(a + 2);
+            c10 = _mm512_dpbf16_ps(c10, b0, w);
+            c11 = _mm512_dpbf16_ps(c11, b1, w);
+            w = broadcast(a + 4);
+            c20 = _mm512_dpbf16_ps(c20, b0, w);
+            c21 = _mm512_dpbf16_ps(c21, b1, w);
+            w = broadcast(a + 6);
+            c30 = _mm512_dpbf16_ps(c30, b0, w);
+            c31 = _mm512_dpbf16_ps(c31, b1, w);
+        }
+    } else {
+        for (const auto kp : otter::irange(pairs)) {
+            const __m512bh b0 = (__m512bh)_mm512_loadu_si512(panel + kp * BF16_NR * 2);
+            const uint16_t* a = weight + kp * BF16_MR * 2;
+
+            c00 = _mm512_dpbf16_ps(c00, b0, broadcast(a));
+            c10 = _mm512_dpbf16_ps(c10, b0, broadcast(a + 2));
+            c20 = _mm512_dpbf16_ps(c20, b0, broadcast(a + 4));
+            c30 = _mm512_dpbf16_ps(c30, b0, broadcast(a + 6));
+        }
+    }
+
+    auto mask_of = [](int64_t n) {
+        return (n >= BF16_NR) ? (__mmask16)0xFFFF : (n <= 0) ? (__mmask16)0 : (__mmask16)((1u << n) - 1);
+    };
+    const __m512 acc[BF16_MR][2] = {{c00, c01}, {c10, c11}, {c20, c21}, {c30, c31}};
+    for (const auto r : otter::irange(rows)) {
+        const __m512 bias_value = _mm512_set1_ps(bias[r]);
+        _mm512_mask_storeu_ps(output + r * ldo, mask_of(count), _mm512_add_ps(acc[r][0], bias_value));
+        _mm512_mask_storeu_ps(output + r * ldo + BF16_NR, mask_of(count - BF16_NR), _mm512_add_ps(acc[r][1], bias_value));
+    }
+#elif CPU_CAPABILITY_AVX2
+    (void)weight;
+    // Name the accumulators, the compiler spills an accumulator array on every iteration
+    __m256 c00 = _mm256_setzero_ps(), c01 = _mm256_setzero_ps();
+    __m256 c10 = _mm256_setzero_ps(), c11 = _mm256_setzero_ps();
+    __m256 c20 = _mm256_setzero_ps(), c21 = _mm256_setzero_ps();
+    __m256 c30 = _mm256_setzero_ps(), c31 = _mm256_setzero_ps();
+    const __m256i odd_mask = _mm256_set1_epi32(0xFFFF0000);
+
+    for (const auto kp : otter::irange(pairs)) {
+        // The even k is the low half of the lane, shift it into the float bits, the odd k is already there
+        const __m256i p0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(panel + kp * BF16_NR * 2));
+        const __m256i p1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(panel + kp * BF16_NR * 2 + 16));
+        const __m256 even0 = _mm256_castsi256_ps(_mm256_slli_epi32(p0, 16));
+        const __m256 odd0 = _mm256_castsi256_ps(_mm256_and_si256(p0, odd_mask));
+        const __m256 even1 = _mm256_castsi256_ps(_mm256_slli_epi32(p1, 16));
+        const __m256 odd1 = _mm256_castsi256_ps(_mm256_and_si256(p1, odd_mask));
+        const float* a = weight_float + kp * BF16_MR * 2;
+
+        __m256 w0 = _mm256_broadcast_ss(a), w1 = _mm256_broadcast_ss(a + 1);
+        c00 = _mm256_add_ps(c00, _mm256_add_ps(_mm256_mul_ps(even0, w0), _mm256_mul_ps(odd0, w1)));
+        c01 = _mm256_add_ps(c01, _mm256_add_ps(_mm256_mul_ps(even1, w0), _mm256_mul_ps(odd1, w1)));
+        w0 = _mm256_broadcast_ss(a + 2), w1 = _mm256_broadcast_ss(a + 3);
+        c10 = _mm256_add_ps(c10, _mm256_add_ps(_mm256_mul_ps(even0, w0), _mm256_mul_ps(odd0, w1)));
+        c11 = _mm256_add_ps(c11, _mm256_add_ps(_mm256_mul_ps(even1, w0), _mm256_mul_ps(odd1, w1)));
+        w0 = _mm256_broadcast_ss(a + 4), w1 = _mm256_broadcast_ss(a + 5);
+        c20 = _mm256_add_ps(c20, _mm256_add_ps(_mm256_mul_ps(even0, w0), _mm256_mul_ps(odd0, w1)));
+        c21 = _mm256_add_ps(c21, _mm256_add_ps(_mm256_mul_ps(even1, w0), _mm256_mul_ps(odd1, w1)));
+        w0 = _mm256_broadcast_ss(a + 6), w1 = _mm256_broadcast_ss(a + 7);
+        c30 = _mm256_add_ps(c30, _mm256_add_ps(_mm256_mul_ps(even0, w0), _mm256_mul_ps(odd0, w1)));
+        c31 = _mm256_add_ps(c31, _mm256_add_ps(_mm256_mul_ps(even1, w0), _mm256_mul_ps(odd1, w1)));
+    }
+
+    const __m256 acc[BF16_MR][2] = {{c00, c01}, {c10, c11}, {c20, c21}, {c30, c31}};
+    for (const auto r : otter::irange(rows)) {
+        bf16_store(output + r * ldo, acc[r][0], bias[r], std::min<int64_t>(count, Vec::size()));
+        bf16_store(output + r * ldo + Vec::size(), acc[r][1], bias[r], count - Vec::size());
+    }
+#else
+    (void)weight;
+    float acc[BF16_MR][BF16_NR] = {{0}};
+    for (const auto kp : otter::irange(pairs)) {
+        const uint16_t* b = panel + kp * BF16_NR * 2;
+        for (const auto r : otter::irange(BF16_MR)) {
+            const float* a = weight_float + (kp * BF16_MR + r) * 2;
+            for (const auto i : otter::irange(BF16_NR)) {
+                acc[r][i] += a[0] * detail::bf16_to_fp32_value(b[i * 2]) + a[1] * detail::bf16_to_fp32_value(b[i * 2 + 1]);
+            }
+        }
+    }
+
+    for (const auto r : otter::irange(rows)) {
+        for (const auto i : otter::irange(count)) {
+            output[r * ldo + i] = acc[r][i] + bias[r];
+        }
+    }
+#endif
+}
+
+static uint16_t* bf16_panel_workspace(int64_t size) {
+    static thread_local std::vector<uint16_t> panel;
+    if ((int64_t)panel.size() < size)
+        panel.resize(size);
+    return panel.data();
+}
+
+static uint16_t* bf16_column_workspace(int64_t size) {
+    static thread_local std::vector<uint16_t> columns;
+    if ((int64_t)columns.size() < size)
+        columns.resize(size);
+    return columns.data();
+}
+
+static float* bf16_weight_workspace(int64_t size) {
+    static thread_local std::vector<float> weight;
+    if ((int64_t)weight.size() < size)
+        weight.resize(size);
+    return weight.data();
+}
+
+Tensor convolution_bf16(const Tensor& self, const Tensor& weight_packed, const Tensor& bias, int64_t out_channels, IntArrayRef kernel_size, IntArrayRef stride, IntArrayRef padding) {
+    OTTER_CHECK(self.dim() == 4, "convolution_bf16: Expect 4D input but get ", self.sizes());
+    OTTER_CHECK(kernel_size.size() == 2 && stride.size() == 2 && padding.size() == 2, "convolution_bf16: Expect 2D kernel, stride and padding");
+    OTTER_CHECK(self.scalar_type() == ScalarType::Float || self.scalar_type() == ScalarType::BFloat16, "convolution_bf16: Expect float or BFloat16 input but get ", toString(self.scalar_type()));
+
+    BF16Geometry g;
+    g.in_channels = self.size(1);
+    g.input_height = self.size(2);
+    g.input_width = self.size(3);
+    g.kernel_height = kernel_size[0];
+    g.kernel_width = kernel_size[1];
+    g.stride_height = stride[0];
+    g.stride_width = stride[1];
+    g.pad_height = padding[0];
+    g.pad_width = padding[1];
+    g.output_height = (g.input_height + 2 * g.pad_height - g.kernel_height) / g.stride_height + 1;
+    g.output_width = (g.input_width + 2 * g.pad_width - g.kernel_width) / g.stride_width + 1;
+    g.depth = g.in_channels * g.kernel_height * g.kernel_width;
+    g.pairs = divup(g.depth, 2);
+
+    OTTER_CHECK(weight_packed.scalar_type() == ScalarType::BFloat16 && weight_packed.dim() == 4 && weight_packed.size(0) == divup(out_channels, BF16_MR) && weight_packed.size(1) == g.pairs, "convolution_bf16: Expect packed weight {", divup(out_channels, BF16_MR), ", ", g.pairs, ", ", BF16_MR, ", 2} but get ", weight_packed.sizes());
+    OTTER_CHECK(!bias.defined() || bias.numel() == out_channels, "convolution_bf16: Expect bias {", out_channels, "} but get ", bias.sizes());
+
+    std::vector<float> bias_data(divup(out_channels, BF16_MR) * BF16_MR, 0.f);
+    if (bias.defined()) {
+        Tensor bias_contiguous = bias.to(ScalarType::Float).contiguous();
+        std::copy(bias_contiguous.data_ptr<float>(), bias_contiguous.data_ptr<float>() + out_channels, bias_data.begin());
+    }
+
+    const Tensor input = self.to(ScalarType::BFloat16).contiguous();
+    const int64_t batch_size = input.size(0);
+    const int64_t output_size = g.output_height * g.output_width;
+    Tensor output = otter::empty({batch_size, out_channels, g.output_height, g.output_width}, ScalarType::Float);
+
+    // Shrink the tile for the deep reduction, the panel should stay in L2
+    const int64_t tile = std::max(BF16_NR, std::min(BF16_MAX_TILE, BF16_PANEL_BYTES / (g.pairs * 2 * (int64_t)sizeof(uint16_t)) / BF16_NR * BF16_NR));
+    const int64_t tiles = divup(output_size, tile);
+
+    const uint16_t* input_data = reinterpret_cast<const uint16_t*>(input.data_ptr<BFloat16>());
+    const BFloat16* weight_data = weight_packed.data_ptr<BFloat16>();
+    float* output_data = output.data_ptr<float>();
+    const int64_t input_batch_stride = g.in_channels * g.input_height * g.input_width;
+    const int64_t weight_block_size = g.pairs * BF16_MR * 2;
+    const int64_t input_size = g.input_height * g.input_width;
+    const bool pointwise = g.kernel_height == 1 && g.kernel_width == 1 && g.stride_height == 1 && g.stride_width == 1 && g.pad_height == 0 && g.pad_width == 0;
+
+    otter::parallel_for(0, batch_size * tiles, 0, [&](int64_t begin, int64_t end) {
+        uint16_t* panel = bf16_panel_workspace(divup(tile, BF16_NR) * g.pairs * BF16_NR * 2);
+        uint16_t* columns = pointwise ? nullptr : bf16_column_workspace(g.depth * tile);
+        float* weight_float = bf16_weight_workspace(weight_block_size);
+
+        for (const auto index : otter::irange(begin, end)) {
+            const int64_t n = index / tiles;
+            const int64_t p_begin = (index % tiles) * tile;
+            const int64_t p_end = std::min(p_begin + tile, output_size);
+            const int64_t blocks = divup(p_end - p_begin, BF16_NR);
+
+            const uint16_t* input_batch = input_data + n * input_batch_stride;
+            if (pointwise) {
+                // The im2col row is the input channel itself
+                interleave_bf16_panel(panel, input_batch + p_begin, input_size, g.depth, g.pairs, p_end - p_begin);
+            } else {
+                im2col_bf16(columns, input_batch, g, p_begin, p_end);
+                interleave_bf16_panel(panel, columns, p_end - p_begin, g.depth, g.pairs, p_end - p_begin);
+            }
+
+            for (int64_t o = 0; o < out_channels; o += BF16_MR) {
+                const int64_t rows = std::min(BF16_MR, out_channels - o);
+                const BFloat16* weight = weight_data + (o / BF16_MR) * weight_block_size;
+#if !defined(__AVX512BF16__)
+                otter::bfloat16_to_float(weight, weight_float, weight_block_size);
+#endif
+
+                for (int64_t b = 0; b < blocks; b += BF16_BLOCKS_PER_CALL) {
+                    const int64_t p = p_begin + b * BF16_NR;
+                    const int64_t count = std::min(BF16_BLOCKS_PER_CALL * BF16_NR, p_end - p);
+                    const uint16_t* panel_block = panel + b * g.pairs * BF16_NR * 2;
+
+                    bf16_micro_kernel(output_data + (n * out_channels + o) * output_size + p, output_size, rows, count, reinterpret_cast<const uint16_t*>(weight), weight_float, panel_block, g.pairs, bias_data.data() + o);
+                }
+            }
+        }
+    });
+
+    return output;
+}
+
+}   // end namespace otter
@@ -0,0 +1,28 @@
+//
+//  ConvolutionBF16.hpp
+//  Tensor
+//
+//  Created by 陳均豪 on 2022/3/22.
+//
+
+#ifndef ConvolutionBF16_hpp
+#define ConvolutionBF16_hpp
+
+#include "Tensor.hpp"
+
+namespace otter {
+
+// BFloat16 convolution without dilation, the products are accumulated in float
+// The input and the weight lose the mantissa past 8 bits, the output is float
+// Runs vdpbf16ps with AVX512 BF16, otherwise the pairs are widened to float
+
+// weight {out_channels, in_channels, kh, kw} -> {ceil(out_channels / 4), ceil(K / 2), 4, 2} BFloat16,
+// K = in_channels * kh * kw, the tail is zero padded
+Tensor convolution_bf16_pack_weight(const Tensor& weight);
+
+// input {N, in_channels, H, W} float or BFloat16
+Tensor convolution_bf16(const Tensor& input, const Tensor& weight_packed, const Tensor& bias, int64_t out_channels, IntArrayRef kernel_size, IntArrayRef stride, IntArrayRef padding);
+
+}   // end namespace otter
+
+#endif /* ConvolutionBF16_hpp */
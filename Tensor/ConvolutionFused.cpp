@@ -0,0 +1,412 @@
+//
+//  ConvolutionFused.cpp
+//  Tensor
+//
+//  Created by 陳均豪 on 2022/3/22.
+//
+
+#include "ConvolutionFused.hpp"
+#include "Tensor.hpp"
+#include "TensorFactory.hpp"
+#include "Parallel.hpp"
+#include "Utils.hpp"
+#include "Vec.hpp"
+
+#include <cstring>
+#include <vector>
+
+namespace otter {
+
+using Vec = vec::Vectorized<float>;
+
+// Output rows of the pointwise micro kernel
+static constexpr int64_t FUSED_MR = 4;
+// Output pixels of the pointwise micro kernel, two vectors
+static constexpr int64_t FUSED_NR = 2 * Vec::size();
+// Floats of the per-thread workspace, the expanded rows and the depthwise rows stay in L2
+static constexpr int64_t FUSED_WORKSPACE = 64 * 1024;
+// The columns are split only when a single output row does not fit the workspace
+static constexpr int64_t FUSED_MIN_TILE_WIDTH = 32;
+
+struct FusedGeometry {
+    int64_t in_channels;
+    int64_t mid_channels;
+    int64_t out_channels;
+    int64_t input_height;
+    int64_t input_width;
+    int64_t output_height;
+    int64_t output_width;
+    int64_t kernel_height;
+    int64_t kernel_width;
+    int64_t stride_height;
+    int64_t stride_width;
+    int64_t pad_height;
+    int64_t pad_width;
+};
+
+// The output tile [oy_begin, oy_end) x [ox_begin, ox_end) and the input window [iy_begin, iy_end) x [ix_begin, ix_end) it reads
+struct FusedTile {
+    int64_t oy_begin;
+    int64_t oy_end;
+    int64_t ox_begin;
+    int64_t ox_end;
+    int64_t iy_begin;
+    int64_t iy_end;
+    int64_t ix_begin;
+    int64_t ix_end;
+};
+
+struct FusedEpilogue {
+    const float* bias;      // nullptr for no bias
+    const float* alpha;     // nullptr for no batchnorm
+    const float* beta;
+    bool activation;
+    float neg_slope;
+};
+
+static float* fused_workspace(int64_t size) {
+    static thread_local std::vector<float> workspace;
+    if ((int64_t)workspace.size() < size)
+        workspace.resize(size);
+    return workspace.data();
+}
+
+// {depth, FUSED_NR} panel for the tail pixels, the lanes past the tail are never stored
+static float* fused_tail_panel(int64_t depth) {
+    static thread_local std::vector<float> panel;
+    if ((int64_t)panel.size() < depth * FUSED_NR)
+        panel.resize(depth * FUSED_NR, 0.f);
+    return panel.data();
+}
+
+static inline Vec fused_epilogue(Vec x, const FusedEpilogue& ep, int64_t c) {
+    if (ep.alpha) {
+        x = vec::fmadd(x, Vec(ep.alpha[c]), Vec(ep.beta[c]));
+    }
+    if (ep.activation) {
+        x = x * Vec::blendv(Vec(ep.neg_slope), Vec(1.f), x > Vec(0.f));
+    }
+    return x;
+}
+
+// output[MR rows, count pixels] = epilogue(weight[MR rows, depth] * input[depth, FUSED_NR pixels])
+template <int MR>
+static inline void fused_pointwise_micro_kernel(float* output, int64_t ldo, int64_t count, const float* weight, int64_t depth, const float* input, int64_t ldi, const FusedEpilogue& ep, int64_t row) {
+    Vec acc0[MR], acc1[MR];
+    for (const auto r : otter::irange(MR)) {
+        acc0[r] = Vec(ep.bias ? ep.bias[row + r] : 0.f);
+        acc1[r] = acc0[r];
+    }
+
+    for (const auto k : otter::irange(depth)) {
+        const Vec b0 = Vec::loadu(input + k * ldi);
+        const Vec b1 = Vec::loadu(input + k * ldi + Vec::size());
+        for (const auto r : otter::irange(MR)) {
+            const Vec a(weight[r * depth + k]);
+            acc0[r] = vec::fmadd(a, b0, acc0[r]);
+            acc1[r] = vec::fmadd(a, b1, acc1[r]);
+        }
+    }
+
+    for (const auto r : otter::irange(MR)) {
+        acc0[r] = fused_epilogue(acc0[r], ep, row + r);
+        acc1[r] = fused_epilogue(acc1[r], ep, row + r);
+        if (count == FUSED_NR) {
+            acc0[r].store(output + r * ldo);
+            acc1[r].store(output + r * ldo + Vec::size());
+        } else {
+            acc0[r].store(output + r * ldo, static_cast<int>(std::min<int64_t>(count, Vec::size())));
+            if (count > Vec::size()) {
+                acc1[r].store(output + r * ldo + Vec::size(), static_cast<int>(count - Vec::size()));
+            }
+        }
+    }
+}
+
+// output[channels, n] = epilogue(weight[channels, depth] * input[depth, n])
+// The rows of the input are ldi apart and the rows of the output are ldo apart,
+// every block of FUSED_NR input pixels stays in L1 while all the output channels consume it
+static void fused_pointwise(float* output, int64_t ldo, const float* input, int64_t ldi, int64_t n, const float* weight, int64_t channels, int64_t depth, const FusedEpilogue& ep) {
+    for (int64_t p = 0; p < n; p += FUSED_NR) {
+        const int64_t count = std::min(FUSED_NR, n - p);
+        const float* block = input + p;
+        int64_t block_stride = ldi;
+
+        // Copy the tail into the zero padded panel once, then the micro kernel always reads full vectors
+        if (count < FUSED_NR) {
+            float* panel = fused_tail_panel(depth);
+            for (const auto k : otter::irange(depth)) {
+                std::memcpy(panel + k * FUSED_NR, input + k * ldi + p, count * sizeof(float));
+            }
+            block = panel;
+            block_stride = FUSED_NR;
+        }
+
+        for (int64_t o = 0; o < channels; o += FUSED_MR) {
+            const int64_t rows = std::min(FUSED_MR, channels - o);
+            float* out = output + o * ldo + p;
+            const float* weight_rows = weight + o * depth;
+
+            switch (rows) {
+                case 4: fused_pointwise_micro_kernel<4>(out, ldo, count, weight_rows, depth, block, block_stride, ep, o); break;
+                case 3: fused_pointwise_micro_kernel<3>(out, ldo, count, weight_rows, depth, block, block_stride, ep, o); break;
+                case 2: fused_pointwise_micro_kernel<2>(out, ldo, count, weight_rows, depth, block, block_stride, ep, o); break;
+                default: fused_pointwise_micro_kernel<1>(out, ldo, count, weight_rows, depth, block, block_stride, ep, o); break;
+            }
+        }
+    }
+}
+
+// output {channels, tile height, tile width} from the expanded window mid {channels, iy_end - iy_begin, ix_end - ix_begin},
+// the planes of the window are mid_stride apart
+static void fused_depthwise_tile(float* output, const float* mid, int64_t mid_stride, const FusedTile& t, const FusedGeometry& g, const float* weight, const FusedEpilogue& ep) {
+    const int64_t window_width = t.ix_end - t.ix_begin;
+    const int64_t tile_height = t.oy_end - t.oy_begin;
+    const int64_t tile_width = t.ox_end - t.ox_begin;
+
+    for (const auto c : otter::irange(g.mid_channels)) {
+        const float* plane = mid + c * mid_stride;
+        const float* kernel = weight + c * g.kernel_height * g.kernel_width;
+
+        for (const auto r : otter::irange(tile_height)) {
+            const int64_t oy = t.oy_begin + r;
+            float* out = output + (c * tile_height + r) * tile_width;
+            const float bias = ep.bias ? ep.bias[c] : 0.f;
+            for (const auto i : otter::irange(tile_width)) {
+                out[i] = bias;
+            }
+
+            for (const auto kh : otter::irange(g.kernel_height)) {
+                const int64_t iy = oy * g.stride_height - g.pad_height + kh;
+                if (iy < 0 || iy >= g.input_height)
+                    continue;
+                const float* row = plane + (iy - t.iy_begin) * window_width;
+
+                for (const auto kw : otter::irange(g.kernel_width)) {
+                    const float w = kernel[kh * g.kernel_width + kw];
+                    // Input column of the first output in the tile
+                    const int64_t ix = t.ox_begin * g.stride_width - g.pad_width + kw;
+                    const int64_t offset = ix - t.ix_begin;
+                    // [i_begin, i_end) reads inside the input row
+                    const int64_t i_begin = std::min(tile_width, (ix < 0) ? divup(-ix, g.stride_width) : int64_t(0));
+                    const int64_t i_end = std::max(i_begin, std::min(tile_width, (g.input_width - ix + g.stride_width - 1) / g.stride_width));
+
+                    int64_t i = i_begin;
+                    if (g.stride_width == 1) {
+                        const Vec w_vec(w);
+                        for (; i + Vec::size() <= i_end; i += Vec::size()) {
+                            vec::fmadd(w_vec, Vec::loadu(row + offset + i), Vec::loadu(out + i)).store(out + i);
+                        }
+                    }
+                    for (; i < i_end; ++i) {
+                        out[i] += w * row[offset + i * g.stride_width];
+                    }
+                }
+            }
+
+            if (ep.alpha || ep.activation) {
+                int64_t i = 0;
+                for (; i + Vec::size() <= tile_width; i += Vec::size()) {
+                    fused_epilogue(Vec::loadu(out + i), ep, c).store(out + i);
+                }
+                if (i < tile_width) {
+                    const int count = static_cast<int>(tile_width - i);
+                    fused_epilogue(Vec::loadu(out + i, count), ep, c).store(out + i, count);
+                }
+            }
+        }
+    }
+}
+
+static FusedTile make_fused_tile(const FusedGeometry& g, int64_t oy_begin, int64_t oy_end, int64_t ox_begin, int64_t ox_end) {
+    FusedTile t;
+    t.oy_begin = oy_begin;
+    t.oy_end = oy_end;
+    t.ox_begin = ox_begin;
+    t.ox_end = ox_end;
+    t.iy_begin = std::max<int64_t>(0, oy_begin * g.stride_height - g.pad_height);
+    t.iy_end = std::max(t.iy_begin, std::min(g.input_height, (oy_end - 1) * g.stride_height - g.pad_height + g.kernel_height));
+    t.ix_begin = std::max<int64_t>(0, ox_begin * g.stride_width - g.pad_width);
+    t.ix_end = std::max(t.ix_begin, std::min(g.input_width, (ox_end - 1) * g.stride_width - g.pad_width + g.kernel_width));
+
+    return t;
+}
+
+// Floats of the workspace for the tile of the given size
+static int64_t fused_workspace_size(const FusedGeometry& g, int64_t tile_height, int64_t tile_width) {
+    const int64_t window_height = (tile_height - 1) * g.stride_height + g.kernel_height;
+    const int64_t window_width = (tile_width - 1) * g.stride_width + g.kernel_width;
+
+    return g.mid_channels * (window_height * window_width + tile_height * tile_width);
+}
+
+// The tile is the group of output rows computed at once, take as many full rows as the workspace holds,
+// narrow the tile only when a single row does not fit
+static void choose_fused_tile(const FusedGeometry& g, int64_t& tile_height, int64_t& tile_width) {
+    tile_width = g.output_width;
+    while (tile_width > FUSED_MIN_TILE_WIDTH && fused_workspace_size(g, 1, tile_width) > FUSED_WORKSPACE) {
+        tile_width = std::max(FUSED_MIN_TILE_WIDTH, divup(tile_width, 2));
+    }
+    // Even out the columns of the tiles
+    tile_width = divup(g.output_width, divup(g.output_width, tile_width));
+
+    tile_height = 1;
+    while (tile_height < g.output_height && fused_workspace_size(g, tile_height + 1, tile_width) <= FUSED_WORKSPACE) {
+        ++tile_height;
+    }
+}
+
+static FusedEpilogue make_fused_epilogue(const ConvolutionFusedStage& stage, Tensor& bias, Tensor& alpha, Tensor& beta) {
+    FusedEpilogue ep;
+    bias = stage.bias.defined() ? stage.bias.to(ScalarType::Float).contiguous() : Tensor();
+    alpha = stage.alpha.defined() ? stage.alpha.to(ScalarType::Float).contiguous() : Tensor();
+    beta = stage.beta.defined() ? stage.beta.to(ScalarType::Float).contiguous() : Tensor();
+
+    ep.bias = bias.defined() ? bias.data_ptr<float>() : nullptr;
+    ep.alpha = (alpha.defined() && beta.defined()) ? alpha.data_ptr<float>() : nullptr;
+    ep.beta = ep.alpha ? beta.data_ptr<float>() : nullptr;
+    ep.activation = stage.activation;
+    ep.neg_slope = stage.neg_slope;
+
+    return ep;
+}
+
+Tensor& depthwise_separable_convolution_fused_out(const Tensor& self, const ConvolutionFusedStage& expand, const ConvolutionFusedStage& depthwise, IntArrayRef kernel_size, IntArrayRef stride, IntArrayRef padding, const ConvolutionFusedStage& project, Tensor& output) {
+    OTTER_CHECK(self.dim() == 4 && self.scalar_type() == ScalarType::Float, "depthwise_separable_convolution_fused: Expect 4D float input but get ", self.sizes());
+    OTTER_CHECK(kernel_size.size() == 2 && stride.size() == 2 && padding.size() == 2, "depthwise_separable_convolution_fused: Expect 2D kernel, stride and padding");
+
+    FusedGeometry g;
+    g.in_channels = self.size(1);
+    g.mid_channels = expand.weight.size(0);
+    g.out_channels = project.weight.size(0);
+    g.input_height = self.size(2);
+    g.input_width = self.size(3);
+    g.kernel_height = kernel_size[0];
+    g.kernel_width = kernel_size[1];
+    g.stride_height = stride[0];
+    g.stride_width = stride[1];
+    g.pad_height = padding[0];
+    g.pad_width = padding[1];
+    g.output_height = (g.input_height + 2 * g.pad_height - g.kernel_height) / g.stride_height + 1;
+    g.output_width = (g.input_width + 2 * g.pad_width - g.kernel_width) / g.stride_width + 1;
+
+    OTTER_CHECK(expand.weight.dim() == 4 && expand.weight.size(1) == g.in_channels && expand.weight.size(2) == 1 && expand.weight.size(3) == 1, "depthwise_separable_convolution_fused: Expect expand weight {", g.mid_channels, ", ", g.in_channels, ", 1, 1} but get ", expand.weight.sizes());
+    OTTER_CHECK(depthwise.weight.dim() == 4 && depthwise.weight.size(0) == g.mid_channels && depthwise.weight.size(1) == 1 && depthwise.weight.size(2) == g.kernel_height && depthwise.weight.size(3) == g.kernel_width, "depthwise_separable_convolution_fused: Expect depthwise weight {", g.mid_channels, ", 1, ", g.kernel_height, ", ", g.kernel_width, "} but get ", depthwise.weight.sizes());
+    OTTER_CHECK(project.weight.dim() == 4 && project.weight.size(1) == g.mid_channels && project.weight.size(2) == 1 && project.weight.size(3) == 1, "depthwise_separable_convolution_fused: Expect project weight {", g.out_channels, ", ", g.mid_channels, ", 1, 1} but get ", project.weight.sizes());
+    OTTER_CHECK(g.output_height > 0 && g.output_width > 0, "depthwise_separable_convolution_fused: Output size is too small");
+
+    const int64_t batch_size = self.size(0);
+    OTTER_CHECK(output.dim() == 4 && output.scalar_type() == ScalarType::Float && output.size(0) == batch_size && output.size(1) == g.out_channels && output.size(2) == g.output_height && output.size(3) == g.output_width, "depthwise_separable_convolution_fused: Expect output {", batch_size, ", ", g.out_channels, ", ", g.output_height, ", ", g.output_width, "} but get ", output.sizes());
+    OTTER_CHECK(output.stride(3) == 1 && output.stride(2) == g.output_width, "depthwise_separable_convolution_fused: Expect output with contiguous planes");
+
+    const Tensor input = self.contiguous();
+    const Tensor expand_weight = expand.weight.to(ScalarType::Float).contiguous();
+    const Tensor depthwise_weight = depthwise.weight.to(ScalarType::Float).contiguous();
+    const Tensor project_weight = project.weight.to(ScalarType::Float).contiguous();
+
+    Tensor expand_bias, expand_alpha, expand_beta;
+    Tensor depthwise_bias, depthwise_alpha, depthwise_beta;
+    Tensor project_bias, project_alpha, project_beta;
+    const FusedEpilogue expand_ep = make_fused_epilogue(expand, expand_bias, expand_alpha, expand_beta);
+    const FusedEpilogue depthwise_ep = make_fused_epilogue(depthwise, depthwise_bias, depthwise_alpha, depthwise_beta);
+    const FusedEpilogue project_ep = make_fused_epilogue(project, project_bias, project_alpha, project_beta);
+
+    int64_t tile_height, tile_width;
+    choose_fused_tile(g, tile_height, tile_width);
+    const int64_t column_tiles = divup(g.output_width, tile_width);
+    // Every thread walks down its own strip, the halo rows are recomputed only at the strip boundaries
+    const int64_t strips = std::min(g.output_height, std::max<int64_t>(1, divup(otter::get_num_threads(), batch_size * column_tiles)));
+    const int64_t strip_height = divup(g.output_height, strips);
+    const int64_t tasks = strips * column_tiles;
+
+    const float* input_data = input.data_ptr<float>();
+    const float* expand_weight_data = expand_weight.data_ptr<float>();
+    const float* depthwise_weight_data = depthwise_weight.data_ptr<float>();
+    const float* project_weight_data = project_weight.data_ptr<float>();
+    float* output_data = output.data_ptr<float>();
+
+    const int64_t input_size = g.input_height * g.input_width;
+    const int64_t output_channel_stride = output.stride(1);
+    const int64_t output_batch_stride = output.stride(0);
+    // Planes of the expanded window in the workspace
+    const int64_t mid_stride = ((tile_height - 1) * g.stride_height + g.kernel_height) * ((tile_width - 1) * g.stride_width + g.kernel_width);
+
+    otter::parallel_for(0, batch_size * tasks, 0, [&](int64_t begin, int64_t end) {
+        float* mid = fused_workspace(fused_workspace_size(g, tile_height, tile_width));
+        float* depthwise_out = mid + g.mid_channels * mid_stride;
+
+        for (const auto index : otter::irange(begin, end)) {
+            const int64_t n = index / tasks;
+            const int64_t strip_begin = (index % tasks) / column_tiles * strip_height;
+            const int64_t strip_end = std::min(strip_begin + strip_height, g.output_height);
+            const int64_t ox_begin = (index % column_tiles) * tile_width;
+            const int64_t ox_end = std::min(ox_begin + tile_width, g.output_width);
+
+            const float* input_n = input_data + n * g.in_channels * input_size;
+            float* output_n = output_data + n * output_batch_stride;
+
+            // The input rows [window_begin, window_end) expanded by the previous tile
+            int64_t window_begin = 0;
+            int64_t window_end = 0;
+
+            for (int64_t oy_begin = strip_begin; oy_begin < strip_end; oy_begin += tile_height) {
+                const FusedTile t = make_fused_tile(g, oy_begin, std::min(oy_begin + tile_height, strip_end), ox_begin, ox_end);
+
+                const int64_t window_width = t.ix_end - t.ix_begin;
+                const int64_t tile_rows = t.oy_end - t.oy_begin;
+                const int64_t tile_columns = t.ox_end - t.ox_begin;
+                const int64_t tile_size = tile_rows * tile_columns;
+
+                // Slide the rows shared with the previous tile to the top of the window instead of expanding them again
+                int64_t expand_begin = t.iy_begin;
+                if (window_end > t.iy_begin && window_begin <= t.iy_begin) {
+                    const int64_t shared_rows = std::min(window_end, t.iy_end) - t.iy_begin;
+                    if (t.iy_begin != window_begin) {
+                        for (const auto c : otter::irange(g.mid_channels)) {
+                            float* plane = mid + c * mid_stride;
+                            std::memmove(plane, plane + (t.iy_begin - window_begin) * window_width, shared_rows * window_width * sizeof(float));
+                        }
+                    }
+                    expand_begin = t.iy_begin + shared_rows;
+                }
+                window_begin = t.iy_begin;
+                window_end = t.iy_end;
+
+                // Expand the new input rows, the full rows are one GEMM
+                float* expand_out = mid + (expand_begin - t.iy_begin) * window_width;
+                if (window_width == g.input_width) {
+                    fused_pointwise(expand_out, mid_stride, input_n + expand_begin * g.input_width, input_size, (t.iy_end - expand_begin) * g.input_width, expand_weight_data, g.mid_channels, g.in_channels, expand_ep);
+                } else {
+                    for (const auto iy : otter::irange(expand_begin, t.iy_end)) {
+                        fused_pointwise(expand_out + (iy - expand_begin) * window_width, mid_stride, input_n + iy * g.input_width + t.ix_begin, input_size, window_width, expand_weight_data, g.mid_channels, g.in_channels, expand_ep);
+                    }
+                }
+
+                fused_depthwise_tile(depthwise_out, mid, mid_stride, t, g, depthwise_weight_data, depthwise_ep);
+
+                // Project the tile straight into the output
+                if (tile_columns == g.output_width) {
+                    fused_pointwise(output_n + t.oy_begin * g.output_width, output_channel_stride, depthwise_out, tile_size, tile_size, project_weight_data, g.out_channels, g.mid_channels, project_ep);
+                } else {
+                    for (const auto r : otter::irange(tile_rows)) {
+                        fused_pointwise(output_n + (t.oy_begin + r) * g.output_width + t.ox_begin, output_channel_stride, depthwise_out + r * tile_columns, tile_size, tile_columns, project_weight_data, g.out_channels, g.mid_channels, project_ep);
+                    }
+                }
+            }
+        }
+    });
+
+    return output;
+}
+
+Tensor depthwise_separable_convolution_fused(const Tensor& self, const ConvolutionFusedStage& expand, const ConvolutionFusedStage& depthwise, IntArrayRef kernel_size, IntArrayRef stride, IntArrayRef padding, const ConvolutionFusedStage& project) {
+    OTTER_CHECK(self.dim() == 4 && kernel_size.size() == 2 && stride.size() == 2 && padding.size() == 2, "depthwise_separable_convolution_fused: Expect 4D input and 2D kernel, stride and padding");
+
+    const int64_t output_height = (self.size(2) + 2 * padding[0] - kernel_size[0]) / stride[0] + 1;
+    const int64_t output_width = (self.size(3) + 2 * padding[1] - kernel_size[1]) / stride[1] + 1;
+    Tensor output = otter::empty({self.size(0), project.weight.size(0), output_height, output_width}, ScalarType::Float);
+
+    return depthwise_separable_convolution_fused_out(self, expand, depthwise, kernel_size, stride, padding, project, output);
+}
+
+}   // end namespace otter
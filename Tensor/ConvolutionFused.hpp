@@ -0,0 +1,37 @@
+//
+//  ConvolutionFused.hpp
+//  Tensor
+//
+//  Created by 陳均豪 on 2022/3/22.
+//
+
+#ifndef ConvolutionFused_hpp
+#define ConvolutionFused_hpp
+
+#include "Tensor.hpp"
+
+namespace otter {
+
+// One convolution of the fused chain with its epilogue
+// output = leaky_relu((conv(input, weight) + bias) * alpha + beta)
+struct ConvolutionFusedStage {
+    Tensor weight;          // {out_channels, in_channels / groups, kh, kw}
+    Tensor bias;            // undefined for no bias
+    Tensor alpha;           // folded batchnorm, undefined for no batchnorm
+    Tensor beta;
+    bool activation = false;
+    float neg_slope = 0;
+};
+
+// 1x1 expand -> depthwise -> 1x1 project executed depth first
+// The output is computed tile by tile, every tile recomputes the halo of the depthwise input,
+// so the expanded and the depthwise feature maps only live in the per-thread workspace and never go to the memory
+// input {N, C, H, W} float in any layout, return the contiguous output
+Tensor depthwise_separable_convolution_fused(const Tensor& input, const ConvolutionFusedStage& expand, const ConvolutionFusedStage& depthwise, IntArrayRef kernel_size, IntArrayRef stride, IntArrayRef padding, const ConvolutionFusedStage& project);
+
+// Write into the given output {N, out_channels, OH, OW} whose planes are contiguous, e.g. the channel slice of the Concat output
+Tensor& depthwise_separable_convolution_fused_out(const Tensor& input, const ConvolutionFusedStage& expand, const ConvolutionFusedStage& depthwise, IntArrayRef kernel_size, IntArrayRef stride, IntArrayRef padding, const ConvolutionFusedStage& project, Tensor& output);
+
+}   // end namespace otter
+
+#endif /* ConvolutionFused_hpp */
@@ -0,0 +1,566 @@
+//
+//  ConvolutionInt8.cpp
+//  Tensor
+//
+//  Created by 陳均豪 on 2022/3/22.
+//
+
+#include "ConvolutionInt8.hpp"
+#include "Quantize.hpp"
+#include "Tensor.hpp"
+#include "TensorFactory.hpp"
+#include "Parallel.hpp"
+#include "Vec.hpp"
+#include "VecIntrinsic.hpp"
+#include "Config.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace otter {
+
+using Vec = vec::Vectorized<float>;
+
+// Output channels of the micro kernel, the packed weight is interleaved by this
+static constexpr int64_t INT8_MR = 4;
+// Output pixels of the micro kernel, two vectors of int32
+static constexpr int64_t INT8_NR = 16;
+// Bytes of the int16 input panel of one tile, the panel stays in L2
+static constexpr int64_t INT8_PANEL_BYTES = 128 * 1024;
+static constexpr int64_t INT8_MAX_TILE = 128;
+
+struct Int8Geometry {
+    int64_t in_channels;
+    int64_t input_height;
+    int64_t input_width;
+    int64_t output_height;
+    int64_t output_width;
+    int64_t kernel_height;
+    int64_t kernel_width;
+    int64_t stride_height;
+    int64_t stride_width;
+    int64_t pad_height;
+    int64_t pad_width;
+    int64_t depth;      // in_channels * kh * kw
+    int64_t pairs;      // ceil(depth / 2)
+};
+
+struct Int8Epilogue {
+    const float* scale;         // input_scale * weight_scale[o]
+    const float* bias;
+    bool activation;
+    float neg_slope;
+    float inv_output_scale;     // 0 for the float output
+};
+
+static inline int8_t requantize_value(float x, float inv_scale) {
+    float q = std::nearbyint(x * inv_scale);
+    q = std::min(127.f, std::max(-127.f, q));
+    return static_cast<int8_t>(q);
+}
+
+static inline Vec int8_epilogue(Vec x, const Int8Epilogue& ep, int64_t o) {
+    x = vec::fmadd(x, Vec(ep.scale[o]), Vec(ep.bias[o]));
+    if (ep.activation) {
+        x = x * Vec::blendv(Vec(ep.neg_slope), Vec(1.f), x > Vec(0.f));
+    }
+    return x;
+}
+
+// Store count values of x at output + offset, the output is Char when requantized otherwise float
+static inline void int8_epilogue_store(void* output, int64_t offset, Vec x, int64_t count, const Int8Epilogue& ep) {
+    if (ep.inv_output_scale > 0.f) {
+        int8_t* out = static_cast<int8_t*>(output) + offset;
+#if CPU_CAPABILITY_AVX2
+        if (count == Vec::size()) {
+            const __m256 q = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(x, _mm256_set1_ps(ep.inv_output_scale)), _mm256_set1_ps(-127.f)), _mm256_set1_ps(127.f));
+            const __m256i q32 = _mm256_cvtps_epi32(q);
+            const __m128i q16 = _mm_packs_epi32(_mm256_castsi256_si128(q32), _mm256_extracti128_si256(q32, 1));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_packs_epi16(q16, q16));
+            return;
+        }
+#endif
+        float buffer[Vec::size()];
+        x.store(buffer);
+        for (const auto i : otter::irange(count)) {
+            out[i] = requantize_value(buffer[i], ep.inv_output_scale);
+        }
+    } else {
+        float* out = static_cast<float*>(output) + offset;
+        if (count == Vec::size()) {
+            x.store(out);
+        } else {
+            x.store(out, static_cast<int>(count));
+        }
+    }
+}
+
+// Dequantize count int32 accumulators of the output channel o
+static void int8_epilogue_row(void* output, int64_t offset, const int32_t* acc, int64_t count, const Int8Epilogue& ep, int64_t o) {
+    for (int64_t i = 0; i < count; i += Vec::size()) {
+        const int64_t n = std::min<int64_t>(Vec::size(), count - i);
+#if CPU_CAPABILITY_AVX2
+        __m256i values = (n == Vec::size()) ? _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc + i)) : _mm256_setzero_si256();
+        if (n != Vec::size()) {
+            int32_t buffer[Vec::size()] = {0};
+            std::memcpy(buffer, acc + i, n * sizeof(int32_t));
+            values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(buffer));
+        }
+        const Vec x = _mm256_cvtepi32_ps(values);
+#else
+        float buffer[Vec::size()] = {0};
+        for (const auto j : otter::irange(n)) {
+            buffer[j] = static_cast<float>(acc[i + j]);
+        }
+        const Vec x = Vec::loadu(buffer);
+#endif
+        int8_epilogue_store(output, offset + i, int8_epilogue(x, ep, o), n, ep);
+    }
+}
+
+std::tuple<Tensor, Tensor> convolution_int8_pack_weight(const Tensor& weight, const Tensor& weight_scale) {
+    OTTER_CHECK(weight.dim() == 4, "convolution_int8_pack_weight: Expect weight {out_channels, in_channels, kh, kw} but get ", weight.sizes());
+
+    const int64_t out_channels = weight.size(0);
+    const int64_t depth = weight.size(1) * weight.size(2) * weight.size(3);
+    const int64_t pairs = divup(depth, 2);
+
+    Tensor scale = weight_scale.defined() ? weight_scale.to(ScalarType::Float).contiguous() : otter::int8_weight_scale(weight);
+    Tensor quantized = otter::quantize_int8_per_channel(weight, scale);
+    Tensor packed = otter::zeros({divup(out_channels, INT8_MR), pairs, INT8_MR, 2}, ScalarType::Char);
+
+    const int8_t* src = quantized.data_ptr<int8_t>();
+    int8_t* dst = packed.data_ptr<int8_t>();
+
+    for (const auto o : otter::irange(out_channels)) {
+        int8_t* block = dst + (o / INT8_MR) * pairs * INT8_MR * 2 + (o % INT8_MR) * 2;
+        for (const auto k : otter::irange(depth)) {
+            block[(k / 2) * INT8_MR * 2 + (k % 2)] = src[o * depth + k];
+        }
+    }
+
+    return std::make_tuple(packed, scale);
+}
+
+// Interleave the int8 rows {depth, pixels} (row_stride apart) into the panel {blocks, pairs, INT8_NR, 2} int16,
+// every int32 lane holds two adjacent k of one pixel for vpmaddwd, zero filled past the depth and the pixels
+static void interleave_int8_panel(int16_t* panel, const int8_t* rows, int64_t row_stride, int64_t depth, int64_t pairs, int64_t pixels) {
+    const int64_t blocks = divup(pixels, INT8_NR);
+
+    for (const auto b : otter::irange(blocks)) {
+        const int64_t count = std::min(INT8_NR, pixels - b * INT8_NR);
+        int16_t* dst = panel + b * pairs * INT8_NR * 2;
+
+        for (const auto kp : otter::irange(pairs)) {
+            const int8_t* row0 = rows + (2 * kp) * row_stride + b * INT8_NR;
+            const int8_t* row1 = (2 * kp + 1 < depth) ? row0 + row_stride : nullptr;
+            int16_t* out = dst + kp * INT8_NR * 2;
+#if CPU_CAPABILITY_AVX2
+            if (count == INT8_NR) {
+                const __m256i x0 = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row0)));
+                const __m256i x1 = row1 ? _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row1))) : _mm256_setzero_si256();
+                // unpack interleaves inside the 128 bit lanes, put pixels 0 - 7 and 8 - 15 back together
+                const __m256i lo = _mm256_unpacklo_epi16(x0, x1);
+                const __m256i hi = _mm256_unpackhi_epi16(x0, x1);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_permute2x128_si256(lo, hi, 0x20));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 16), _mm256_permute2x128_si256(lo, hi, 0x31));
+                continue;
+            }
+#endif
+            for (const auto i : otter::irange(INT8_NR)) {
+                out[i * 2] = (i < count) ? row0[i] : 0;
+                out[i * 2 + 1] = (i < count && row1) ? row1[i] : 0;
+            }
+        }
+    }
+}
+
+// im2col of the output pixels [p_begin, p_end) into the int8 rows {depth, p_end - p_begin}
+// The pixels of one output row read one input row, copy the segment inside the input and zero the padding
+static void im2col_int8(int8_t* columns, const int8_t* input, const Int8Geometry& g, int64_t p_begin, int64_t p_end) {
+    const int64_t pixels = p_end - p_begin;
+    const int64_t input_size = g.input_height * g.input_width;
+    const int64_t kernel_size = g.kernel_height * g.kernel_width;
+
+    for (const auto k : otter::irange(g.depth)) {
+        const int64_t c = k / kernel_size;
+        const int64_t ky = (k % kernel_size) / g.kernel_width;
+        const int64_t kx = k % g.kernel_width;
+        const int8_t* plane = input + c * input_size;
+        int8_t* dst = columns + k * pixels;
+
+        // [ox_lower, ox_upper) reads inside the input row
+        const int64_t ix_offset = kx - g.pad_width;
+        const int64_t ox_lower = (ix_offset < 0) ? divup(-ix_offset, g.stride_width) : 0;
+        const int64_t ox_upper = std::max(ox_lower, (g.input_width - ix_offset + g.stride_width - 1) / g.stride_width);
+
+        for (int64_t p = p_begin; p < p_end;) {
+            const int64_t oy = p / g.output_width;
+            const int64_t ox_begin = p % g.output_width;
+            const int64_t ox_end = std::min(g.output_width, ox_begin + p_end - p);
+            int8_t* out = dst + (p - p_begin);
+            const int64_t iy = oy * g.stride_height - g.pad_height + ky;
+
+            if (iy < 0 || iy >= g.input_height) {
+                std::memset(out, 0, ox_end - ox_begin);
+            } else {
+                const int8_t* row = plane + iy * g.input_width + ix_offset;
+                const int64_t lower = std::min(ox_end, std::max(ox_begin, ox_lower));
+                const int64_t upper = std::max(lower, std::min(ox_end, ox_upper));
+
+                std::memset(out, 0, lower - ox_begin);
+                if (g.stride_width == 1) {
+                    std::memcpy(out + lower - ox_begin, row + lower, upper - lower);
+                } else {
+                    for (const auto ox : otter::irange(lower, upper)) {
+                        out[ox - ox_begin] = row[ox * g.stride_width];
+                    }
+                }
+                std::memset(out + upper - ox_begin, 0, ox_end - upper);
+            }
+            p += ox_end - ox_begin;
+        }
+    }
+}
+
+// output[rows channels, count pixels] = epilogue(weight[INT8_MR channels, depth] * panel[depth, INT8_NR pixels])
+// weight is {pairs, INT8_MR, 2} int16 zero padded past the channels and panel is {pairs, INT8_NR, 2} int16
+static inline void int8_micro_kernel(void* output, int64_t ldo, int64_t offset, int64_t rows, int64_t count, const int16_t* weight, const int16_t* panel, int64_t pairs, const Int8Epilogue& ep, int64_t row) {
+#if CPU_CAPABILITY_AVX2
+    // Name the accumulators, the compiler spills an accumulator array on every iteration
+    __m256i c00 = _mm256_setzero_si256(), c01 = _mm256_setzero_si256();
+    __m256i c10 = _mm256_setzero_si256(), c11 = _mm256_setzero_si256();
+    __m256i c20 = _mm256_setzero_si256(), c21 = _mm256_setzero_si256();
+    __m256i c30 = _mm256_setzero_si256(), c31 = _mm256_setzero_si256();
+
+    auto broadcast = [](const int16_t* pair) {
+        int32_t value;
+        std::memcpy(&value, pair, sizeof(value));
+        return _mm256_set1_epi32(value);
+    };
+
+    for (const auto kp : otter::irange(pairs)) {
+        const __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(panel + kp * INT8_NR * 2));
+        const __m256i b1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(panel + kp * INT8_NR * 2 + 16));
+        const int16_t* a = weight + kp * INT8_MR * 2;
+
+        __m256i w = broadcast(a);
+        c00 = _mm256_add_epi32(c00, _mm256_madd_epi16(b0, w));
+        c01 = _mm256_add_epi32(c01, _mm256_madd_epi16(b1, w));
+        w = broadcast(a + 2);
+        c10 = _mm256_add_epi32(c10, _mm256_madd_epi16(b0, w));
+        c11 = _mm256_add_epi32(c11, _mm256_madd_epi16(b1, w));
+        w = broadcast(a + 4);
+        c20 = _mm256_add_epi32(c20, _mm256_madd_epi16(b0, w));
+        c21 = _mm256_add_epi32(c21, _mm256_madd_epi16(b1, w));
+        w = broadcast(a + 6);
+        c30 = _mm256_add_epi32(c30, _mm256_madd_epi16(b0, w));
+        c31 = _mm256_add_epi32(c31, _mm256_madd_epi16(b1, w));
+    }
+
+    const __m256i acc[INT8_MR][2] = {{c00, c01}, {c10, c11}, {c20, c21}, {c30, c31}};
+    const int64_t count0 = std::min<int64_t>(count, Vec::size());
+    for (const auto r : otter::irange(rows)) {
+        int8_epilogue_store(output, offset + r * ldo, int8_epilogue(_mm256_cvtepi32_ps(acc[r][0]), ep, row + r), count0, ep);
+        if (count > Vec::size()) {
+            int8_epilogue_store(output, offset + r * ldo + Vec::size(), int8_epilogue(_mm256_cvtepi32_ps(acc[r][1]), ep, row + r), count - Vec::size(), ep);
+        }
+    }
+#else
+    int32_t acc[INT8_MR][INT8_NR] = {{0}};
+    for (const auto kp : otter::irange(pairs)) {
+        const int16_t* b = panel + kp * INT8_NR * 2;
+        for (const auto r : otter::irange(INT8_MR)) {
+            const int16_t* a = weight + (kp * INT8_MR + r) * 2;
+            for (const auto i : otter::irange(INT8_NR)) {
+                acc[r][i] += a[0] * b[i * 2] + a[1] * b[i * 2 + 1];
+            }
+        }
+    }
+
+    for (const auto r : otter::irange(rows)) {
+        int8_epilogue_row(output, offset + r * ldo, acc[r], count, ep, row + r);
+    }
+#endif
+}
+
+static int16_t* int8_panel_workspace(int64_t size) {
+    static thread_local std::vector<int16_t> panel;
+    if ((int64_t)panel.size() < size)
+        panel.resize(size);
+    return panel.data();
+}
+
+static int8_t* int8_column_workspace(int64_t size) {
+    static thread_local std::vector<int8_t> columns;
+    if ((int64_t)columns.size() < size)
+        columns.resize(size);
+    return columns.data();
+}
+
+static int16_t* int8_weight_workspace(int64_t size) {
+    static thread_local std::vector<int16_t> weight;
+    if ((int64_t)weight.size() < size)
+        weight.resize(size);
+    return weight.data();
+}
+
+// Sign extend the int8 weight block once per tile, the micro kernel broadcasts int16 pairs
+static void widen_int8(int16_t* dst, const int8_t* src, int64_t size) {
+    int64_t i = 0;
+#if CPU_CAPABILITY_AVX2
+    for (; i + 16 <= size; i += 16) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i))));
+    }
+#endif
+    for (; i < size; ++i) {
+        dst[i] = src[i];
+    }
+}
+
+static Tensor quantize_input(const Tensor& self, float input_scale) {
+    if (self.scalar_type() == ScalarType::Char)
+        return self.contiguous();
+
+    OTTER_CHECK(self.scalar_type() == ScalarType::Float, "Int8 convolution: Expect float or Char input but get ", toString(self.scalar_type()));
+    return otter::quantize_int8(self, input_scale);
+}
+
+static void make_int8_epilogue(Int8Epilogue& ep, std::vector<float>& scale, std::vector<float>& bias, float input_scale, const Tensor& weight_scale, const Tensor& bias_tensor, int64_t channels, const ConvolutionInt8Epilogue& epilogue) {
+    OTTER_CHECK(weight_scale.numel() == channels, "Int8 convolution: Expect weight scale {", channels, "} but get ", weight_scale.sizes());
+    OTTER_CHECK(!bias_tensor.defined() || bias_tensor.numel() == channels, "Int8 convolution: Expect bias {", channels, "} but get ", bias_tensor.sizes());
+
+    OTTER_CHECK(epilogue.alpha.defined() == epilogue.beta.defined() && (!epilogue.alpha.defined() || (epilogue.alpha.numel() == channels && epilogue.beta.numel() == channels)), "Int8 convolution: Expect batchnorm alpha and beta {", channels, "}");
+
+    Tensor weight_scale_contiguous = weight_scale.to(ScalarType::Float).contiguous();
+    Tensor bias_contiguous = bias_tensor.defined() ? bias_tensor.to(ScalarType::Float).contiguous() : Tensor();
+    Tensor alpha = epilogue.alpha.defined() ? epilogue.alpha.to(ScalarType::Float).contiguous() : Tensor();
+    Tensor beta = epilogue.beta.defined() ? epilogue.beta.to(ScalarType::Float).contiguous() : Tensor();
+
+    // Fold the batchnorm into the dequantization
+    scale.resize(channels);
+    bias.assign(channels, 0.f);
+    for (const auto o : otter::irange(channels)) {
+        scale[o] = input_scale * weight_scale_contiguous.data_ptr<float>()[o];
+        if (bias_contiguous.defined())
+            bias[o] = bias_contiguous.data_ptr<float>()[o];
+        if (alpha.defined()) {
+            scale[o] *= alpha.data_ptr<float>()[o];
+            bias[o] = bias[o] * alpha.data_ptr<float>()[o] + beta.data_ptr<float>()[o];
+        }
+    }
+
+    ep.scale = scale.data();
+    ep.bias = bias.data();
+    ep.activation = epilogue.activation;
+    ep.neg_slope = epilogue.neg_slope;
+    ep.inv_output_scale = (epilogue.output_scale > 0.f) ? 1.f / epilogue.output_scale : 0.f;
+}
+
+static void* int8_output_data(Tensor& output) {
+    return (output.scalar_type() == ScalarType::Char) ? static_cast<void*>(output.data_ptr<int8_t>()) : static_cast<void*>(output.data_ptr<float>());
+}
+
+Tensor convolution_int8(const Tensor& self, float input_scale, const Tensor& weight_packed, const Tensor& weight_scale, const Tensor& bias, int64_t out_channels, IntArrayRef kernel_size, IntArrayRef stride, IntArrayRef padding, const ConvolutionInt8Epilogue& epilogue) {
+    OTTER_CHECK(self.dim() == 4, "convolution_int8: Expect 4D input but get ", self.sizes());
+    OTTER_CHECK(kernel_size.size() == 2 && stride.size() == 2 && padding.size() == 2, "convolution_int8: Expect 2D kernel, stride and padding");
+
+    Int8Geometry g;
+    g.in_channels = self.size(1);
+    g.input_height = self.size(2);
+    g.input_width = self.size(3);
+    g.kernel_height = kernel_size[0];
+    g.kernel_width = kernel_size[1];
+    g.stride_height = stride[0];
+    g.stride_width = stride[1];
+    g.pad_height = padding[0];
+    g.pad_width = padding[1];
+    g.output_height = (g.input_height + 2 * g.pad_height - g.kernel_height) / g.stride_height + 1;
+    g.output_width = (g.input_width + 2 * g.pad_width - g.kernel_width) / g.stride_width + 1;
+    g.depth = g.in_channels * g.kernel_height * g.kernel_width;
+    g.pairs = divup(g.depth, 2);
+
+    OTTER_CHECK(weight_packed.scalar_type() == ScalarType::Char && weight_packed.dim() == 4 && weight_packed.size(0) == divup(out_channels, INT8_MR) && weight_packed.size(1) == g.pairs, "convolution_int8: Expect packed weight {", divup(out_channels, INT8_MR), ", ", g.pairs, ", ", INT8_MR, ", 2} but get ", weight_packed.sizes());
+
+    Int8Epilogue ep;
+    std::vector<float> scale, bias_data;
+    make_int8_epilogue(ep, scale, bias_data, input_scale, weight_scale, bias, out_channels, epilogue);
+
+    const Tensor input = quantize_input(self, input_scale);
+    const int64_t batch_size = input.size(0);
+    const int64_t output_size = g.output_height * g.output_width;
+    Tensor output = otter::empty({batch_size, out_channels, g.output_height, g.output_width}, (ep.inv_output_scale > 0.f) ? ScalarType::Char : ScalarType::Float);
+
+    // Shrink the tile for the deep reduction, the panel should stay in L2
+    const int64_t tile = std::max(INT8_NR, std::min(INT8_MAX_TILE, INT8_PANEL_BYTES / (g.pairs * 2 * (int64_t)sizeof(int16_t)) / INT8_NR * INT8_NR));
+    const int64_t tiles = divup(output_size, tile);
+
+    const int8_t* input_data = input.data_ptr<int8_t>();
+    const int8_t* weight_data = weight_packed.data_ptr<int8_t>();
+    void* output_data = int8_output_data(output);
+    const int64_t input_batch_stride = g.in_channels * g.input_height * g.input_width;
+    const int64_t weight_block_size = g.pairs * INT8_MR * 2;
+    const int64_t input_size = g.input_height * g.input_width;
+    const bool pointwise = g.kernel_height == 1 && g.kernel_width == 1 && g.stride_height == 1 && g.stride_width == 1 && g.pad_height == 0 && g.pad_width == 0;
+
+    otter::parallel_for(0, batch_size * tiles, 0, [&](int64_t begin, int64_t end) {
+        int16_t* panel = int8_panel_workspace(divup(tile, INT8_NR) * g.pairs * INT8_NR * 2);
+        int8_t* columns = pointwise ? nullptr : int8_column_workspace(g.depth * tile);
+        int16_t* weight = int8_weight_workspace(weight_block_size);
+
+        for (const auto index : otter::irange(begin, end)) {
+            const int64_t n = index / tiles;
+            const int64_t p_begin = (index % tiles) * tile;
+            const int64_t p_end = std::min(p_begin + tile, output_size);
+            const int64_t blocks = divup(p_end - p_begin, INT8_NR);
+
+            const int8_t* input_batch = input_data + n * input_batch_stride;
+            if (pointwise) {
+                // The im2col row is the input channel itself
+                interleave_int8_panel(panel, input_batch + p_begin, input_size, g.depth, g.pairs, p_end - p_begin);
+            } else {
+                im2col_int8(columns, input_batch, g, p_begin, p_end);
+                interleave_int8_panel(panel, columns, p_end - p_begin, g.depth, g.pairs, p_end - p_begin);
+            }
+
+            for (int64_t o = 0; o < out_channels; o += INT8_MR) {
+                const int64_t rows = std::min(INT8_MR, out_channels - o);
+                widen_int8(weight, weight_data + (o / INT8_MR) * weight_block_size, weight_block_size);
+
+                for (const auto b : otter::irange(blocks)) {
+                    const int64_t p = p_begin + b * INT8_NR;
+                    const int64_t count = std::min(INT8_NR, p_end - p);
+                    const int64_t offset = (n * out_channels + o) * output_size + p;
+                    const int16_t* panel_block = panel + b * g.pairs * INT8_NR * 2;
+
+                    int8_micro_kernel(output_data, output_size, offset, rows, count, weight, panel_block, g.pairs, ep, o);
+                }
+            }
+        }
+    });
+
+    return output;
+}
+
+std::tuple<Tensor, Tensor> depthwise_convolution_int8_pack_weight(const Tensor& weight, const Tensor& weight_scale) {
+    OTTER_CHECK(weight.dim() == 4 && weight.size(1) == 1, "depthwise_convolution_int8_pack_weight: Expect weight {channels, 1, kh, kw} but get ", weight.sizes());
+
+    Tensor scale = weight_scale.defined() ? weight_scale.to(ScalarType::Float).contiguous() : otter::int8_weight_scale(weight);
+    Tensor quantized = otter::quantize_int8_per_channel(weight, scale);
+
+    return std::make_tuple(quantized.view({weight.size(0), weight.size(2) * weight.size(3)}), scale);
+}
+
+static int32_t* int8_row_workspace(int64_t size) {
+    static thread_local std::vector<int32_t> row;
+    if ((int64_t)row.size() < size)
+        row.resize(size);
+    return row.data();
+}
+
+Tensor depthwise_convolution_int8(const Tensor& self, float input_scale, const Tensor& weight_packed, const Tensor& weight_scale, const Tensor& bias, IntArrayRef kernel_size, IntArrayRef stride, IntArrayRef padding, const ConvolutionInt8Epilogue& epilogue) {
+    OTTER_CHECK(self.dim() == 4, "depthwise_convolution_int8: Expect 4D input but get ", self.sizes());
+    OTTER_CHECK(kernel_size.size() == 2 && stride.size() == 2 && padding.size() == 2, "depthwise_convolution_int8: Expect 2D kernel, stride and padding");
+
+    const int64_t channels = self.size(1);
+    const int64_t kernel_height = kernel_size[0];
+    const int64_t kernel_width = kernel_size[1];
+    const int64_t stride_height = stride[0];
+    const int64_t stride_width = stride[1];
+    const int64_t pad_height = padding[0];
+    const int64_t pad_width = padding[1];
+    const int64_t input_height = self.size(2);
+    const int64_t input_width = self.size(3);
+    const int64_t output_height = (input_height + 2 * pad_height - kernel_height) / stride_height + 1;
+    const int64_t output_width = (input_width + 2 * pad_width - kernel_width) / stride_width + 1;
+
+    OTTER_CHECK(weight_packed.scalar_type() == ScalarType::Char && weight_packed.dim() == 2 && weight_packed.size(0) == channels && weight_packed.size(1) == kernel_height * kernel_width, "depthwise_convolution_int8: Expect packed weight {", channels, ", ", kernel_height * kernel_width, "} but get ", weight_packed.sizes());
+
+    Int8Epilogue ep;
+    std::vector<float> scale, bias_data;
+    make_int8_epilogue(ep, scale, bias_data, input_scale, weight_scale, bias, channels, epilogue);
+
+    const Tensor input = quantize_input(self, input_scale);
+    const Tensor weight_contiguous = weight_packed.contiguous();
+    const int64_t batch_size = input.size(0);
+    Tensor output = otter::empty({batch_size, channels, output_height, output_width}, (ep.inv_output_scale > 0.f) ? ScalarType::Char : ScalarType::Float);
+
+    const int8_t* input_data = input.data_ptr<int8_t>();
+    const int8_t* weight_data = weight_contiguous.data_ptr<int8_t>();
+    void* output_data = int8_output_data(output);
+
+    otter::parallel_for(0, batch_size * channels, 0, [&](int64_t begin, int64_t end) {
+        // The accumulator row and the kernel widened to int32 for the broadcast
+        int32_t* acc = int8_row_workspace(output_width + kernel_height * kernel_width);
+        int32_t* kernel = acc + output_width;
+
+        for (const auto plane : otter::irange(begin, end)) {
+            const int64_t c = plane % channels;
+            const int8_t* input_plane = input_data + plane * input_height * input_width;
+            std::copy(weight_data + c * kernel_height * kernel_width, weight_data + (c + 1) * kernel_height * kernel_width, kernel);
+
+            for (const auto oh : otter::irange(output_height)) {
+                std::fill(acc, acc + output_width, 0);
+
+                // The rows of the kernel inside the input
+                const int64_t kh_begin = std::max<int64_t>(0, pad_height - oh * stride_height);
+                const int64_t kh_end = std::min(kernel_height, input_height + pad_height - oh * stride_height);
+                const int8_t* rows = input_plane + (oh * stride_height - pad_height) * input_width;
+
+                // [interior_begin, interior_end) reads the whole kernel row inside the input
+                int64_t interior_begin = output_width;
+                int64_t interior_end = output_width;
+#if CPU_CAPABILITY_AVX2
+                if (stride_width == 1) {
+                    interior_begin = std::min(output_width, pad_width);
+                    interior_end = std::max(interior_begin, std::min(output_width, input_width + pad_width - kernel_width + 1));
+                    interior_end = interior_begin + (interior_end - interior_begin) / 8 * 8;
+
+                    // Accumulate every tap in the register, the border goes through the row below
+                    const int64_t kw_size = kernel_width;
+                    const int64_t row_stride = input_width;
+                    for (int64_t ow = interior_begin; ow < interior_end; ow += 8) {
+                        __m256i sum = _mm256_setzero_si256();
+                        const int8_t* row = rows + kh_begin * row_stride + ow - pad_width;
+                        const int32_t* k = kernel + kh_begin * kw_size;
+                        for (int64_t kh = kh_begin; kh < kh_end; ++kh, row += row_stride, k += kw_size) {
+                            for (int64_t kw = 0; kw < kw_size; ++kw) {
+                                const __m256i x = _mm256_cvtepi8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(row + kw)));
+                                sum = _mm256_add_epi32(sum, _mm256_mullo_epi32(x, _mm256_set1_epi32(k[kw])));
+                            }
+                        }
+                        _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc + ow), sum);
+                    }
+                }
+#endif
+
+                for (const auto kh : otter::irange(kh_begin, kh_end)) {
+                    const int8_t* row = rows + kh * input_width;
+
+                    for (const auto kw : otter::irange(kernel_width)) {
+                        const int32_t w = kernel[kh * kernel_width + kw];
+                        const int64_t iw = kw - pad_width;
+                        // [ow_begin, ow_end) reads inside the input row
+                        const int64_t ow_begin = std::min(output_width, (iw < 0) ? divup(-iw, stride_width) : int64_t(0));
+                        const int64_t ow_end = std::max(ow_begin, std::min(output_width, (input_width - iw + stride_width - 1) / stride_width));
+
+                        for (const auto ow : otter::irange(ow_begin, std::min(ow_end, interior_begin))) {
+                            acc[ow] += w * row[iw + ow * stride_width];
+                        }
+                        for (const auto ow : otter::irange(std::max(ow_begin, interior_end), ow_end)) {
+                            acc[ow] += w * row[iw + ow * stride_width];
+                        }
+                    }
+                }
+
+                int8_epilogue_row(output_data, (plane * output_height + oh) * output_width, acc, output_width, ep, c);
+            }
+        }
+    });
+
+    return output;
+}
+
+}   // end namespace otter
@@ -0,0 +1,44 @@
+//
+//  ConvolutionInt8.hpp
+//  Tensor
+//
+//  Created by 陳均豪 on 2022/3/22.
+//
+
+#ifndef ConvolutionInt8_hpp
+#define ConvolutionInt8_hpp
+
+#include <tuple>
+
+#include "Tensor.hpp"
+
+namespace otter {
+
+// Int8 convolution with symmetric quantization (see Quantize.hpp), no dilation
+// The int32 accumulator goes through the epilogue
+// output = activation((acc * input_scale * weight_scale[o] + bias[o]) * alpha[o] + beta[o]),
+// then it is requantized to int8 with output_scale when output_scale is positive, otherwise the output is float
+struct ConvolutionInt8Epilogue {
+    Tensor alpha;               // batchnorm, undefined for none
+    Tensor beta;
+    bool activation = false;
+    float neg_slope = 0.f;      // 0 for relu
+    float output_scale = 0.f;
+};
+
+// weight {out_channels, in_channels, kh, kw} -> ({ceil(out_channels / 4), ceil(K / 2), 4, 2} Char, scale {out_channels}),
+// K = in_channels * kh * kw, the tail is zero padded
+// The per output channel scale is computed from the weight when weight_scale is undefined
+std::tuple<Tensor, Tensor> convolution_int8_pack_weight(const Tensor& weight, const Tensor& weight_scale);
+
+// input {N, in_channels, H, W}, the float input is quantized with input_scale, the Char input is used as it is
+Tensor convolution_int8(const Tensor& input, float input_scale, const Tensor& weight_packed, const Tensor& weight_scale, const Tensor& bias, int64_t out_channels, IntArrayRef kernel_size, IntArrayRef stride, IntArrayRef padding, const ConvolutionInt8Epilogue& epilogue);
+
+// weight {channels, 1, kh, kw} -> (Char {channels, kh * kw}, scale {channels})
+std::tuple<Tensor, Tensor> depthwise_convolution_int8_pack_weight(const Tensor& weight, const Tensor& weight_scale);
+
+Tensor depthwise_convolution_int8(const Tensor& input, float input_scale, const Tensor& weight_packed, const Tensor& weight_scale, const Tensor& bias, IntArrayRef kernel_size, IntArrayRef stride, IntArrayRef padding, const ConvolutionInt8Epilogue& epilogue);
+
+}   // end namespace otter
+
+#endif /* ConvolutionInt8_hpp */
@@ -8,6 +8,8 @@
 #include "ConvolutionLayer.hpp"
 #include "LayerRegistry.hpp"
 #include "Convolution.hpp"
+#include "ConvolutionPacked.hpp"
+#include "TensorPacking.hpp"
 
 #include "TensorFactory.hpp"
 #include "TensorMaker.hpp"
@@ -17,6 +19,15 @@ namespace otter {
 ConvolutionLayer::ConvolutionLayer() {
     one_blob_only = true;
     support_inplace = false;
+    support_packing = true;
+    support_channels_last = true;
+    
+    depthwise_packed = false;
+    int8_scale_term = 0;
+    bottom_blob_int8_scale = 0;
+    top_blob_int8_scale = 0;
+    depthwise_int8 = false;
+    bf16_term = 0;
 }
 
 int ConvolutionLayer::parse_param(LayerOption& option, ParamDict& pd) {
@@ -81,6 +92,7 @@ int ConvolutionLayer::parse_param(LayerOption& option, ParamDict& pd) {
     pd.set((int)ConvParam::Output_padding_height, output_padding_height);
     pd.set((int)ConvParam::Group, groups);
     pd.set((int)ConvParam::Bias_term, bias_term);
+    pd.set((int)ConvParam::Bf16_term, opt_find_int(option, "bf16", 0));
     
     return 0;
 }
@@ -128,6 +140,13 @@ int ConvolutionLayer::load_param(const ParamDict &pd) {
     groups = pd.get((int)ConvParam::Group, 1);
     bias_term = pd.get((int)ConvParam::Bias_term, 0);
     weight_data_size = pd.get((int)ConvParam::Weight_data_size, 0);
+    bf16_term = pd.get((int)ConvParam::Bf16_term, 0);
+    
+    // The bf16 layer only runs on the plain layout
+    if (bf16_term && groups == 1 && dilation_height == 1 && dilation_width == 1) {
+        support_packing = false;
+        support_channels_last = false;
+    }
     
     return 0;
 }
@@ -137,7 +156,7 @@ int ConvolutionLayer::init_model() {
     if (bias_term)
         bias_data = otter::rand({out_channels}, ScalarType::Float);
     
-    return 0;
+    return pack_weight();
 }
 
 int ConvolutionLayer::load_model(const Initializer& initializer) {
@@ -146,10 +165,106 @@ int ConvolutionLayer::load_model(const Initializer& initializer) {
     }
     weight_data = initializer.load({out_channels, in_channels / groups, kernel_height, kernel_width});
     
+    return pack_weight();
+}
+
+int ConvolutionLayer::pack_weight() {
+    weight_data_packed.reset();
+    depthwise_packed = false;
+    weight_data_bf16.reset();
+    
+    if (bf16_term && groups == 1 && dilation_height == 1 && dilation_width == 1) {
+        weight_data_bf16 = otter::convolution_bf16_pack_weight(weight_data);
+        return 0;
+    }
+    
+    int64_t elempack = otter::packing_elempack();
+    if (elempack == 1 || dilation_height != 1 || dilation_width != 1)
+        return 0;
+    
+    if (groups == 1) {
+        weight_data_packed = otter::convolution_packed_pack_weight(weight_data, elempack);
+    } else if (groups == in_channels && groups == out_channels) {
+        weight_data_packed = otter::depthwise_convolution_packed_pack_weight(weight_data, elempack);
+        depthwise_packed = true;
+    }
+    
+    return 0;
+}
+
+int ConvolutionLayer::quantize_int8(float bottom_scale, const Tensor& weight_scale) {
+    if (dilation_height != 1 || dilation_width != 1 || bottom_scale <= 0)
+        return -1;
+    
+    if (groups == 1) {
+        std::tie(weight_data_int8, weight_data_int8_scale) = otter::convolution_int8_pack_weight(weight_data, weight_scale);
+        depthwise_int8 = false;
+    } else if (groups == in_channels && groups == out_channels) {
+        std::tie(weight_data_int8, weight_data_int8_scale) = otter::depthwise_convolution_int8_pack_weight(weight_data, weight_scale);
+        depthwise_int8 = true;
+    } else {
+        return -1;
+    }
+    
+    int8_scale_term = 1;
+    bottom_blob_int8_scale = bottom_scale;
+    top_blob_int8_scale = 0;
+    
+    // The int8 layer only runs on the plain layout
+    weight_data.reset();
+    weight_data_packed.reset();
+    support_packing = false;
+    support_channels_last = false;
+    
+    return 0;
+}
+
+int ConvolutionLayer::forward_int8(const Tensor& bottom_blob, Tensor& top_blob, const ConvolutionInt8Epilogue& epilogue) const {
+    const Tensor bottom = otter::is_packed(bottom_blob) ? otter::from_packed(bottom_blob) : bottom_blob;
+    
+    if (depthwise_int8) {
+        top_blob = otter::depthwise_convolution_int8(bottom, bottom_blob_int8_scale, weight_data_int8, weight_data_int8_scale, bias_data, {kernel_height, kernel_width}, {stride_height, stride_width}, {padding_height, padding_width}, epilogue);
+    } else {
+        top_blob = otter::convolution_int8(bottom, bottom_blob_int8_scale, weight_data_int8, weight_data_int8_scale, bias_data, out_channels, {kernel_height, kernel_width}, {stride_height, stride_width}, {padding_height, padding_width}, epilogue);
+    }
+    
     return 0;
 }
 
 int ConvolutionLayer::forward(const Tensor &bottom_blob, Tensor &top_blob, const NetOption &opt) const {
+    if (int8_scale_term) {
+        return forward_int8(bottom_blob, top_blob, ConvolutionInt8Epilogue());
+    }
+    
+    if (weight_data_bf16.defined()) {
+        top_blob = otter::convolution_bf16(bottom_blob, weight_data_bf16, bias_data, out_channels, {kernel_height, kernel_width}, {stride_height, stride_width}, {padding_height, padding_width});
+        
+        return 0;
+    }
+    
+    if (otter::is_packed(bottom_blob)) {
+        if (weight_data_packed.defined()) {
+            if (depthwise_packed) {
+                top_blob = otter::depthwise_convolution_packed(bottom_blob, weight_data_packed, bias_data, {kernel_height, kernel_width}, {stride_height, stride_width}, {padding_height, padding_width});
+            } else {
+                top_blob = otter::convolution_packed(bottom_blob, weight_data_packed, bias_data, out_channels, {kernel_height, kernel_width}, {stride_height, stride_width}, {padding_height, padding_width});
+            }
+            
+            return 0;
+        }
+        
+        return forward(otter::from_packed(bottom_blob), top_blob, opt);
+    }
+    
+    if (opt.use_channels_last && weight_data_packed.defined()) {
+        if (depthwise_packed) {
+            top_blob = otter::depthwise_convolution_channels_last(bottom_blob, weight_data_packed, bias_data, {kernel_height, kernel_width}, {stride_height, stride_width}, {padding_height, padding_width});
+        } else {
+            top_blob = otter::convolution_channels_last(bottom_blob, weight_data_packed, bias_data, out_channels, {kernel_height, kernel_width}, {stride_height, stride_width}, {padding_height, padding_width});
+        }
+        
+        return 0;
+    }
     
     top_blob = otter::convolution(
         bottom_blob, weight_data, bias_data,
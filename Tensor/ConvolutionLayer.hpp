@@ -9,6 +9,8 @@
 #define ConvolutionLayer_hpp
 
 #include "Layer.hpp"
+#include "ConvolutionInt8.hpp"
+#include "ConvolutionBF16.hpp"
 
 namespace otter {
 
@@ -29,6 +31,17 @@ public:
     virtual int forward(const Tensor& bottom_blob, Tensor& top_blob, const NetOption& opt) const;
     
     virtual std::string type() const { return "Convoltuion"; }
+    
+    // Prepare the weight for the channel blocked and the channels last input, undefined when the layer is not supported
+    int pack_weight();
+    
+    // Switch to the int8 inference, the float bottom is quantized with bottom_scale
+    // The per output channel weight_scale is computed from the weight when undefined
+    // Return -1 when the layer is neither the plain nor the depthwise convolution without dilation
+    int quantize_int8(float bottom_scale, const Tensor& weight_scale);
+    
+    // The bottom is either float or already quantized with bottom_blob_int8_scale
+    int forward_int8(const Tensor& bottom_blob, Tensor& top_blob, const ConvolutionInt8Epilogue& epilogue) const;
 public:
     int in_channels;
     int out_channels;
@@ -51,6 +64,21 @@ public:
     
     Tensor weight_data;
     Tensor bias_data;
+    
+    Tensor weight_data_packed;
+    bool depthwise_packed;
+    
+    int int8_scale_term;
+    float bottom_blob_int8_scale;
+    // Requantize the top blob for the next int8 layer, 0 for the float top blob
+    float top_blob_int8_scale;
+    bool depthwise_int8;
+    Tensor weight_data_int8;
+    Tensor weight_data_int8_scale;
+    
+    // Run on bfloat16 with the float accumulation (the "bf16" option), only the plain convolution without dilation
+    int bf16_term;
+    Tensor weight_data_bf16;
 };
 
 enum class ConvParam : int {
@@ -68,7 +96,8 @@ enum class ConvParam : int {
     Output_padding_width,
     Group,
     Bias_term,
-    Weight_data_size
+    Weight_data_size,
+    Bf16_term
 };
 
 }
@@ -14,6 +14,9 @@
 #include "Parallel.hpp"
 #include "Unfold2D.hpp"
 #include "TensorBlas.hpp"
+#include "Vec.hpp"
+
+#include <vector>
 
 namespace otter {
 
@@ -202,6 +205,227 @@ static void slow_conv2d_update_output_frame(
 
 }
 
+using Vec = vec::Vectorized<float>;
+
+// Output channels per micro kernel
+static constexpr int64_t CONV_MR = 4;
+// Output pixels per micro kernel
+static constexpr int64_t CONV_NR = 2 * Vec::size();
+// Reduction depth per panel, CONV_MR rows of the weight slice stay in L1
+static constexpr int64_t CONV_KC = 256;
+// Output pixels per tile, the {CONV_KC, CONV_TILE} panel is about half of L2
+static constexpr int64_t CONV_TILE = 128;
+
+// The im2col panel of one tile, reused by every layer and every call on this thread
+// so the workspace is bounded by the tile size instead of the feature map size
+static float* conv2d_panel_workspace() {
+    static thread_local std::vector<float> panel(CONV_KC * CONV_TILE);
+    return panel.data();
+}
+
+struct Conv2dGeometry {
+    int64_t input_channels, input_height, input_width;
+    int64_t output_height, output_width;
+    int64_t kernel_height, kernel_width;
+    int64_t stride_height, stride_width;
+    int64_t pad_height, pad_width;
+};
+
+// The output pixels of one block which share the same output row
+struct Conv2dPanelSegment {
+    int64_t offset;     // in the block
+    int64_t length;
+    int64_t ih;         // the top left input coordinate of the first pixel
+    int64_t iw;
+};
+
+// Gather the rows [k_begin, k_end) of the virtual column matrix for the output pixels [p_begin, p_end)
+// straight from the input, laid out as {pixel blocks, k, CONV_NR} and zero filled past the tail
+// The row segments of every block are computed once, the interior blocks of the stride 1
+// convolution are copied with two vector loads
+static void pack_conv2d_panel(float* panel, const float* input, const Conv2dGeometry& g, int64_t k_begin, int64_t k_end, int64_t p_begin, int64_t p_end) {
+    using Vec = vec::Vectorized<float>;
+    
+    const int64_t kernel_area = g.kernel_height * g.kernel_width;
+    const int64_t depth = k_end - k_begin;
+    const int64_t blocks = divup(p_end - p_begin, CONV_NR);
+    
+    Conv2dPanelSegment segments[CONV_TILE];
+    int64_t block_segments[CONV_TILE / CONV_NR + 1];
+    int64_t block_counts[CONV_TILE / CONV_NR];
+    int64_t num_segments = 0;
+    
+    for (const auto b : otter::irange(blocks)) {
+        const int64_t block_begin = p_begin + b * CONV_NR;
+        const int64_t count = std::min(CONV_NR, p_end - block_begin);
+        block_segments[b] = num_segments;
+        block_counts[b] = count;
+        
+        int64_t j = 0;
+        while (j < count) {
+            const int64_t oh = (block_begin + j) / g.output_width;
+            const int64_t ow = (block_begin + j) % g.output_width;
+            const int64_t length = std::min(count - j, g.output_width - ow);
+            segments[num_segments++] = {j, length, oh * g.stride_height - g.pad_height, ow * g.stride_width - g.pad_width};
+            j += length;
+        }
+    }
+    block_segments[blocks] = num_segments;
+    
+    for (int64_t k = k_begin; k < k_end; ++k) {
+        const int64_t c = k / kernel_area;
+        const int64_t kh = (k % kernel_area) / g.kernel_width;
+        const int64_t kw = k % g.kernel_width;
+        const float* plane = input + c * g.input_height * g.input_width;
+        
+        for (const auto b : otter::irange(blocks)) {
+            float* dst = panel + (b * depth + k - k_begin) * CONV_NR;
+            const int64_t count = block_counts[b];
+            
+            for (int64_t s = block_segments[b]; s < block_segments[b + 1]; ++s) {
+                const Conv2dPanelSegment& segment = segments[s];
+                const int64_t ih = segment.ih + kh;
+                const int64_t iw = segment.iw + kw;
+                float* out = dst + segment.offset;
+                
+                if (ih < 0 || ih >= g.input_height) {
+                    for (const auto t : otter::irange(segment.length)) {
+                        out[t] = 0.f;
+                    }
+                    continue;
+                }
+                
+                const float* row = plane + ih * g.input_width;
+                if (g.stride_width == 1 && iw >= 0 && iw + segment.length <= g.input_width) {
+                    if (segment.length == CONV_NR) {
+                        Vec::loadu(row + iw).store(out);
+                        Vec::loadu(row + iw + Vec::size()).store(out + Vec::size());
+                    } else {
+                        for (const auto t : otter::irange(segment.length)) {
+                            out[t] = row[iw + t];
+                        }
+                    }
+                } else {
+                    // [t_begin, t_end) of the segment lands inside the input row
+                    const int64_t t_begin = std::min(segment.length, (iw < 0) ? divup(-iw, g.stride_width) : int64_t(0));
+                    const int64_t t_end = std::max(t_begin, std::min(segment.length, (g.input_width - iw + g.stride_width - 1) / g.stride_width));
+                    for (int64_t t = 0; t < t_begin; ++t) {
+                        out[t] = 0.f;
+                    }
+                    for (int64_t t = t_begin; t < t_end; ++t) {
+                        out[t] = row[iw + t * g.stride_width];
+                    }
+                    for (int64_t t = t_end; t < segment.length; ++t) {
+                        out[t] = 0.f;
+                    }
+                }
+            }
+            for (int64_t t = count; t < CONV_NR; ++t) {
+                dst[t] = 0.f;
+            }
+        }
+    }
+}
+
+// output[MR rows, CONV_NR pixels] (+)= weight[MR rows, depth] * panel[depth, CONV_NR]
+template <int MR>
+static inline void conv2d_micro_kernel(float* output, int64_t ldo, int64_t count, const float* weight, int64_t ldw, const float* panel, int64_t depth, const float* init) {
+    Vec acc0[MR], acc1[MR];
+    for (const auto r : otter::irange(MR)) {
+        if (init) {
+            acc0[r] = Vec(init[r]);
+            acc1[r] = Vec(init[r]);
+        } else {
+            acc0[r] = Vec::loadu(output + r * ldo, static_cast<int>(std::min<int64_t>(count, Vec::size())));
+            acc1[r] = (count > Vec::size()) ? Vec::loadu(output + r * ldo + Vec::size(), static_cast<int>(count - Vec::size())) : Vec(0.f);
+        }
+    }
+    
+    for (const auto k : otter::irange(depth)) {
+        const Vec b0 = Vec::loadu(panel);
+        const Vec b1 = Vec::loadu(panel + Vec::size());
+        for (const auto r : otter::irange(MR)) {
+            const Vec a(weight[r * ldw + k]);
+            acc0[r] = vec::fmadd(a, b0, acc0[r]);
+            acc1[r] = vec::fmadd(a, b1, acc1[r]);
+        }
+        panel += CONV_NR;
+    }
+    
+    for (const auto r : otter::irange(MR)) {
+        if (count == CONV_NR) {
+            acc0[r].store(output + r * ldo);
+            acc1[r].store(output + r * ldo + Vec::size());
+        } else {
+            acc0[r].store(output + r * ldo, static_cast<int>(std::min<int64_t>(count, Vec::size())));
+            if (count > Vec::size()) {
+                acc1[r].store(output + r * ldo + Vec::size(), static_cast<int>(count - Vec::size()));
+            }
+        }
+    }
+}
+
+// Convolution as im2col + GEMM without the columns tensor, the output pixels are processed in tiles
+// and every tile packs its column panel into the thread workspace right before the GEMM
+static void slow_conv2d_tiled_float(const Tensor& input, const Tensor& weight_2d, const Tensor& bias, Tensor& output, const Conv2dGeometry& g) {
+    const int64_t batch_size = input.size(0);
+    const int64_t output_channels = weight_2d.size(0);
+    const int64_t depth_total = weight_2d.size(1);
+    const int64_t output_size = g.output_height * g.output_width;
+    const int64_t tiles = divup(output_size, CONV_TILE);
+    
+    Tensor bias_contiguous = bias.defined() ? bias.contiguous() : otter::zeros({output_channels}, ScalarType::Float);
+    
+    const float* input_data = input.data_ptr<float>();
+    const float* weight_data = weight_2d.data_ptr<float>();
+    const float* bias_data = bias_contiguous.data_ptr<float>();
+    float* output_data = output.data_ptr<float>();
+    
+    const int64_t input_batch_stride = g.input_channels * g.input_height * g.input_width;
+    const int64_t output_batch_stride = output_channels * output_size;
+    
+    otter::parallel_for(0, batch_size * tiles, 0, [&](int64_t begin, int64_t end) {
+        float* panel = conv2d_panel_workspace();
+        
+        for (const auto index : otter::irange(begin, end)) {
+            const int64_t n = index / tiles;
+            const int64_t p_begin = (index % tiles) * CONV_TILE;
+            const int64_t p_end = std::min(p_begin + CONV_TILE, output_size);
+            const int64_t blocks = divup(p_end - p_begin, CONV_NR);
+            
+            const float* input_n = input_data + n * input_batch_stride;
+            float* output_n = output_data + n * output_batch_stride;
+            
+            for (int64_t k_begin = 0; k_begin < depth_total; k_begin += CONV_KC) {
+                const int64_t k_end = std::min(k_begin + CONV_KC, depth_total);
+                const int64_t depth = k_end - k_begin;
+                
+                pack_conv2d_panel(panel, input_n, g, k_begin, k_end, p_begin, p_end);
+                
+                for (int64_t o = 0; o < output_channels; o += CONV_MR) {
+                    const int64_t rows = std::min(CONV_MR, output_channels - o);
+                    const float* weight_rows = weight_data + o * depth_total + k_begin;
+                    const float* init = (k_begin == 0) ? bias_data + o : nullptr;
+                    
+                    for (const auto b : otter::irange(blocks)) {
+                        const int64_t p = p_begin + b * CONV_NR;
+                        const int64_t count = std::min(CONV_NR, p_end - p);
+                        float* out = output_n + o * output_size + p;
+                        const float* panel_block = panel + b * depth * CONV_NR;
+                        
+                        switch (rows) {
+                            case 4: conv2d_micro_kernel<4>(out, output_size, count, weight_rows, depth_total, panel_block, depth, init); break;
+                            case 3: conv2d_micro_kernel<3>(out, output_size, count, weight_rows, depth_total, panel_block, depth, init); break;
+                            case 2: conv2d_micro_kernel<2>(out, output_size, count, weight_rows, depth_total, panel_block, depth, init); break;
+                            default: conv2d_micro_kernel<1>(out, output_size, count, weight_rows, depth_total, panel_block, depth, init); break;
+                        }
+                    }
+                }
+            }
+        }
+    });
+}
+
 Tensor& slow_conv2d_forward_out_cpu(
     const Tensor& self,
     const Tensor& weight_,
@@ -245,6 +469,20 @@ Tensor& slow_conv2d_forward_out_cpu(
     
     const int64_t batch_size      = input.size(dim_batch);
     
+    if (input.scalar_type() == ScalarType::Float) {
+        output.resize_({batch_size, output_channels, output_height, output_width});
+        
+        Conv2dGeometry geometry = {
+            input_channels, input_height, input_width,
+            output_height, output_width,
+            kernel_height, kernel_width,
+            stride_height, stride_width,
+            pad_height, pad_width};
+        slow_conv2d_tiled_float(input, weight_2d, bias_, output, geometry);
+        
+        return output;
+    }
+    
     Tensor finput = compute_columns2d(input, padding, stride, kernel_size);
     output.resize_({batch_size, output_channels, output_height, output_width});
     if (bias_.defined()) {
@@ -309,4 +547,85 @@ Tensor& slow_conv2d_out(
     return otter::slow_conv2d_forward_out_cpu(self, weight, bias, kernel_size, stride, padding, output);
 }
 
+Tensor slow_conv2d_depthwise(
+    const Tensor& self,
+    const Tensor& weight,
+    const Tensor& bias,
+    IntArrayRef kernel_size,
+    IntArrayRef stride,
+    IntArrayRef padding) {
+    
+    OTTER_CHECK(self.dim() == 4 && self.scalar_type() == ScalarType::Float, "slow_conv2d_depthwise: Expect 4D float input but get ", self.sizes());
+    OTTER_CHECK(weight.dim() == 4 && weight.size(0) == self.size(1) && weight.size(1) == 1, "slow_conv2d_depthwise: Expect weight {", self.size(1), ", 1, kh, kw} but get ", weight.sizes());
+    
+    const int64_t kernel_height = kernel_size[0];
+    const int64_t kernel_width  = kernel_size[1];
+    const int64_t pad_height    = padding[0];
+    const int64_t pad_width     = padding[1];
+    const int64_t stride_height = stride[0];
+    const int64_t stride_width  = stride[1];
+    
+    const Tensor input = self.contiguous();
+    const Tensor weight_contiguous = weight.contiguous();
+    const Tensor bias_contiguous = bias.defined() ? bias.contiguous() : otter::zeros({self.size(1)}, ScalarType::Float);
+    
+    const int64_t batch_size     = input.size(0);
+    const int64_t channels       = input.size(1);
+    const int64_t input_height   = input.size(2);
+    const int64_t input_width    = input.size(3);
+    const int64_t output_height  = (input_height + 2 * pad_height - kernel_height) / stride_height + 1;
+    const int64_t output_width   = (input_width  + 2 * pad_width  - kernel_width ) / stride_width  + 1;
+    
+    Tensor output = otter::empty({batch_size, channels, output_height, output_width}, ScalarType::Float);
+    
+    const float* input_data = input.data_ptr<float>();
+    const float* weight_data = weight_contiguous.data_ptr<float>();
+    const float* bias_data = bias_contiguous.data_ptr<float>();
+    float* output_data = output.data_ptr<float>();
+    
+    otter::parallel_for(0, batch_size * channels, 0, [&](int64_t begin, int64_t end) {
+        for (const auto plane : otter::irange(begin, end)) {
+            const int64_t c = plane % channels;
+            const float* input_plane = input_data + plane * input_height * input_width;
+            const float* kernel = weight_data + c * kernel_height * kernel_width;
+            float* output_plane = output_data + plane * output_height * output_width;
+            
+            for (const auto oh : otter::irange(output_height)) {
+                float* out = output_plane + oh * output_width;
+                for (const auto ow : otter::irange(output_width)) {
+                    out[ow] = bias_data[c];
+                }
+                
+                for (const auto kh : otter::irange(kernel_height)) {
+                    const int64_t ih = oh * stride_height - pad_height + kh;
+                    if (ih < 0 || ih >= input_height)
+                        continue;
+                    const float* row = input_plane + ih * input_width;
+                    
+                    for (const auto kw : otter::irange(kernel_width)) {
+                        const float w = kernel[kh * kernel_width + kw];
+                        const int64_t iw = kw - pad_width;
+                        // [ow_begin, ow_end) reads inside the input row
+                        const int64_t ow_begin = std::min(output_width, (iw < 0) ? divup(-iw, stride_width) : int64_t(0));
+                        const int64_t ow_end = std::max(ow_begin, std::min(output_width, (input_width - iw + stride_width - 1) / stride_width));
+                        
+                        int64_t ow = ow_begin;
+                        if (stride_width == 1) {
+                            const Vec w_vec(w);
+                            for (; ow + Vec::size() <= ow_end; ow += Vec::size()) {
+                                vec::fmadd(w_vec, Vec::loadu(row + iw + ow), Vec::loadu(out + ow)).store(out + ow);
+                            }
+                        }
+                        for (; ow < ow_end; ++ow) {
+                            out[ow] += w * row[iw + ow * stride_width];
+                        }
+                    }
+                }
+            }
+        }
+    });
+    
+    return output;
+}
+
 }   // end namespace otter
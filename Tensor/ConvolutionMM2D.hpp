@@ -40,6 +40,14 @@ Tensor slow_conv2d(
     IntArrayRef stride,
     IntArrayRef padding);
 
+// Direct depthwise convolution, weight {channels, 1, kh, kw}
+Tensor slow_conv2d_depthwise(
+    const Tensor& self,
+    const Tensor& weight,
+    const Tensor& bias,
+    IntArrayRef kernel_size,
+    IntArrayRef stride,
+    IntArrayRef padding);
 
 }   // end namespace otter
 
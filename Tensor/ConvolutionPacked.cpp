@@ -0,0 +1,446 @@
+//
+//  ConvolutionPacked.cpp
+//  Tensor
+//
+//  Created by 陳均豪 on 2022/3/22.
+//
+
+#include "ConvolutionPacked.hpp"
+#include "TensorPacking.hpp"
+#include "Tensor.hpp"
+#include "TensorFactory.hpp"
+#include "EmptyTensor.hpp"
+#include "Parallel.hpp"
+#include "Utils.hpp"
+#include "Vec.hpp"
+
+#include <cstring>
+
+namespace otter {
+
+using Vec = vec::Vectorized<float>;
+
+static constexpr int64_t PACK = Vec::size();
+
+// Zero pad the spatial dimensions, then the kernels need no bound check
+static Tensor pad_packed(const Tensor& input, int64_t pad_h, int64_t pad_w) {
+    if (pad_h == 0 && pad_w == 0)
+        return input.contiguous();
+
+    const int64_t planes = input.size(0) * input.size(1);
+    const int64_t height = input.size(2);
+    const int64_t width = input.size(3);
+    const int64_t padded_height = height + 2 * pad_h;
+    const int64_t padded_width = width + 2 * pad_w;
+
+    Tensor input_contiguous = input.contiguous();
+    Tensor output = otter::zeros({input.size(0), input.size(1), padded_height, padded_width, PACK}, ScalarType::Float);
+
+    const float* src = input_contiguous.data_ptr<float>();
+    float* dst = output.data_ptr<float>();
+
+    otter::parallel_for(0, planes, 0, [&](int64_t begin, int64_t end) {
+        for (const auto p : otter::irange(begin, end)) {
+            for (const auto h : otter::irange(height)) {
+                const float* src_row = src + (p * height + h) * width * PACK;
+                float* dst_row = dst + ((p * padded_height + h + pad_h) * padded_width + pad_w) * PACK;
+                std::memcpy(dst_row, src_row, width * PACK * sizeof(float));
+            }
+        }
+    });
+
+    return output;
+}
+
+Tensor convolution_packed_pack_weight(const Tensor& weight, int64_t elempack) {
+    OTTER_CHECK(weight.dim() == 4, "Expect weight {out_channels, in_channels, kh, kw} but get ", weight.sizes());
+    OTTER_CHECK(elempack == PACK, "Unsupported elempack ", elempack);
+
+    const int64_t out_channels = weight.size(0);
+    const int64_t in_channels = weight.size(1);
+    const int64_t kernel_size = weight.size(2) * weight.size(3);
+    const int64_t out_blocks = divup(out_channels, elempack);
+
+    Tensor weight_contiguous = weight.to(ScalarType::Float).contiguous();
+    Tensor packed = otter::zeros({out_blocks, weight.size(2), weight.size(3), in_channels, elempack}, ScalarType::Float);
+
+    const float* src = weight_contiguous.data_ptr<float>();
+    float* dst = packed.data_ptr<float>();
+
+    for (const auto o : otter::irange(out_channels)) {
+        const int64_t ob = o / elempack;
+        const int64_t ol = o % elempack;
+        for (const auto i : otter::irange(in_channels)) {
+            for (const auto k : otter::irange(kernel_size)) {
+                dst[((ob * kernel_size + k) * in_channels + i) * elempack + ol] = src[(o * in_channels + i) * kernel_size + k];
+            }
+        }
+    }
+
+    return packed;
+}
+
+// TILE output pixels of one output block, the weight vector is loaded once for all pixels
+// input points to the first input pixel of the tile in the padded input block
+template <int TILE>
+static inline void conv_packed_tile(
+    float* output,
+    const float* input,
+    const float* weight,
+    const Vec& bias,
+    int64_t in_blocks,
+    int64_t kernel_h, int64_t kernel_w,
+    int64_t stride_w,
+    int64_t input_block_stride,
+    int64_t input_row_stride) {
+
+    Vec acc[TILE];
+    for (const auto t : otter::irange(TILE)) {
+        acc[t] = bias;
+    }
+
+    for (const auto kh : otter::irange(kernel_h)) {
+        for (const auto kw : otter::irange(kernel_w)) {
+            const float* input_pixel = input + kh * input_row_stride + kw * PACK;
+            for (const auto ib : otter::irange(in_blocks)) {
+                const float* input_block = input_pixel + ib * input_block_stride;
+                for (const auto l : otter::irange(PACK)) {
+                    const Vec w = Vec::loadu(weight + l * PACK);
+                    for (const auto t : otter::irange(TILE)) {
+                        acc[t] = vec::fmadd(Vec(input_block[t * stride_w * PACK + l]), w, acc[t]);
+                    }
+                }
+                weight += PACK * PACK;
+            }
+        }
+    }
+
+    for (const auto t : otter::irange(TILE)) {
+        acc[t].store(output + t * PACK);
+    }
+}
+
+Tensor convolution_packed(const Tensor& input, const Tensor& weight_packed, const Tensor& bias, int64_t out_channels, IntArrayRef kernel_size, IntArrayRef stride, IntArrayRef padding) {
+    OTTER_CHECK(is_packed(input) && input.size(4) == PACK && input.scalar_type() == ScalarType::Float, "convolution_packed: Expect packed float input but get ", input.sizes());
+    OTTER_CHECK(weight_packed.dim() == 5 && weight_packed.size(3) == input.size(1) * PACK, "convolution_packed: Weight ", weight_packed.sizes(), " does not match input ", input.sizes());
+
+    const int64_t batch = input.size(0);
+    const int64_t in_blocks = input.size(1);
+    const int64_t out_blocks = weight_packed.size(0);
+    const int64_t kernel_h = kernel_size[0];
+    const int64_t kernel_w = kernel_size[1];
+    const int64_t stride_h = stride[0];
+    const int64_t stride_w = stride[1];
+
+    Tensor input_padded = pad_packed(input, padding[0], padding[1]);
+    const int64_t padded_height = input_padded.size(2);
+    const int64_t padded_width = input_padded.size(3);
+    const int64_t output_height = (padded_height - kernel_h) / stride_h + 1;
+    const int64_t output_width = (padded_width - kernel_w) / stride_w + 1;
+
+    Tensor output = otter::empty({batch, out_blocks, output_height, output_width, PACK}, ScalarType::Float);
+
+    std::vector<float> bias_padded(out_blocks * PACK, 0.f);
+    if (bias.defined()) {
+        Tensor bias_contiguous = bias.to(ScalarType::Float).contiguous();
+        std::memcpy(bias_padded.data(), bias_contiguous.data_ptr<float>(), out_channels * sizeof(float));
+    }
+
+    const float* input_data = input_padded.data_ptr<float>();
+    const float* weight_data = weight_packed.data_ptr<float>();
+    float* output_data = output.data_ptr<float>();
+
+    const int64_t input_row_stride = padded_width * PACK;
+    const int64_t input_block_stride = padded_height * input_row_stride;
+    const int64_t weight_block_stride = kernel_h * kernel_w * in_blocks * PACK * PACK;
+
+    otter::parallel_for(0, batch * out_blocks * output_height, 0, [&](int64_t begin, int64_t end) {
+        int64_t n = 0, ob = 0, oh = 0;
+        data_index_init(begin, n, batch, ob, out_blocks, oh, output_height);
+
+        for (const auto i : otter::irange(begin, end)) {
+            (void)i;
+            const Vec bias_vec = Vec::loadu(bias_padded.data() + ob * PACK);
+            const float* weight_block = weight_data + ob * weight_block_stride;
+            const float* input_row = input_data + n * in_blocks * input_block_stride + oh * stride_h * input_row_stride;
+            float* output_row = output_data + ((n * out_blocks + ob) * output_height + oh) * output_width * PACK;
+
+            int64_t ow = 0;
+            for (; ow + 8 <= output_width; ow += 8) {
+                conv_packed_tile<8>(output_row + ow * PACK, input_row + ow * stride_w * PACK, weight_block, bias_vec, in_blocks, kernel_h, kernel_w, stride_w, input_block_stride, input_row_stride);
+            }
+            for (; ow + 4 <= output_width; ow += 4) {
+                conv_packed_tile<4>(output_row + ow * PACK, input_row + ow * stride_w * PACK, weight_block, bias_vec, in_blocks, kernel_h, kernel_w, stride_w, input_block_stride, input_row_stride);
+            }
+            for (; ow < output_width; ++ow) {
+                conv_packed_tile<1>(output_row + ow * PACK, input_row + ow * stride_w * PACK, weight_block, bias_vec, in_blocks, kernel_h, kernel_w, stride_w, input_block_stride, input_row_stride);
+            }
+
+            data_index_step(n, batch, ob, out_blocks, oh, output_height);
+        }
+    });
+
+    if (out_channels % PACK != 0) {
+        return from_packed(output).narrow(1, 0, out_channels).contiguous();
+    }
+
+    return output;
+}
+
+Tensor depthwise_convolution_packed_pack_weight(const Tensor& weight, int64_t elempack) {
+    OTTER_CHECK(weight.dim() == 4 && weight.size(1) == 1, "Expect depthwise weight {channels, 1, kh, kw} but get ", weight.sizes());
+    OTTER_CHECK(elempack == PACK, "Unsupported elempack ", elempack);
+
+    // The channels are innermost, which is already a whole number of blocks when channels is divisible by elempack
+    return weight.to(ScalarType::Float).contiguous().view({weight.size(0), weight.size(2), weight.size(3)}).permute({1, 2, 0}).contiguous();
+}
+
+Tensor depthwise_convolution_packed(const Tensor& input, const Tensor& weight_packed, const Tensor& bias, IntArrayRef kernel_size, IntArrayRef stride, IntArrayRef padding) {
+    OTTER_CHECK(is_packed(input) && input.size(4) == PACK && input.scalar_type() == ScalarType::Float, "depthwise_convolution_packed: Expect packed float input but get ", input.sizes());
+    OTTER_CHECK(weight_packed.dim() == 3 && weight_packed.size(2) == input.size(1) * PACK, "depthwise_convolution_packed: Weight ", weight_packed.sizes(), " does not match input ", input.sizes());
+
+    const int64_t batch = input.size(0);
+    const int64_t channel_blocks = input.size(1);
+    const int64_t kernel_h = kernel_size[0];
+    const int64_t kernel_w = kernel_size[1];
+    const int64_t stride_h = stride[0];
+    const int64_t stride_w = stride[1];
+
+    Tensor input_padded = pad_packed(input, padding[0], padding[1]);
+    const int64_t padded_height = input_padded.size(2);
+    const int64_t padded_width = input_padded.size(3);
+    const int64_t output_height = (padded_height - kernel_h) / stride_h + 1;
+    const int64_t output_width = (padded_width - kernel_w) / stride_w + 1;
+
+    Tensor output = otter::empty({batch, channel_blocks, output_height, output_width, PACK}, ScalarType::Float);
+
+    Tensor bias_contiguous = bias.defined() ? bias.to(ScalarType::Float).contiguous() : Tensor();
+    const float* bias_data = bias_contiguous.defined() ? bias_contiguous.data_ptr<float>() : nullptr;
+    const float* input_data = input_padded.data_ptr<float>();
+    const float* weight_data = weight_packed.data_ptr<float>();
+    float* output_data = output.data_ptr<float>();
+
+    const int64_t input_row_stride = padded_width * PACK;
+    const int64_t channels = channel_blocks * PACK;
+
+    otter::parallel_for(0, batch * channel_blocks, 0, [&](int64_t begin, int64_t end) {
+        for (const auto plane : otter::irange(begin, end)) {
+            const int64_t cb = plane % channel_blocks;
+            const Vec bias_vec = bias_data ? Vec::loadu(bias_data + cb * PACK) : Vec(0.f);
+            const float* weight_block = weight_data + cb * PACK;
+            const float* input_plane = input_data + plane * padded_height * input_row_stride;
+            float* output_plane = output_data + plane * output_height * output_width * PACK;
+
+            for (const auto oh : otter::irange(output_height)) {
+                const float* input_row = input_plane + oh * stride_h * input_row_stride;
+                float* output_row = output_plane + oh * output_width * PACK;
+
+                for (const auto ow : otter::irange(output_width)) {
+                    const float* input_pixel = input_row + ow * stride_w * PACK;
+                    Vec acc = bias_vec;
+                    for (const auto kh : otter::irange(kernel_h)) {
+                        for (const auto kw : otter::irange(kernel_w)) {
+                            acc = vec::fmadd(Vec::loadu(input_pixel + kh * input_row_stride + kw * PACK), Vec::loadu(weight_block + (kh * kernel_w + kw) * channels), acc);
+                        }
+                    }
+                    acc.store(output_row + ow * PACK);
+                }
+            }
+        }
+    });
+
+    return output;
+}
+
+// TILE output pixels of one output block on the channels last input
+// Every tap reads the in_channels vector of TILE input pixels, the taps in the padding
+// point to a zero vector so the inner loop needs no bound check
+template <int TILE>
+static inline void conv_channels_last_tile(
+    float* output,
+    const float* input,
+    const float* zero,
+    const float* weight,
+    const Vec& bias,
+    int64_t ih0, int64_t iw0,
+    int64_t input_height, int64_t input_width,
+    int64_t in_channels, int64_t out_channels, int64_t out_count,
+    int64_t kernel_h, int64_t kernel_w,
+    int64_t stride_w) {
+
+    Vec acc[TILE];
+    for (const auto t : otter::irange(TILE)) {
+        acc[t] = bias;
+    }
+
+    const float* pixel[TILE];
+    for (const auto kh : otter::irange(kernel_h)) {
+        const int64_t ih = ih0 + kh;
+        const bool row_inside = ih >= 0 && ih < input_height;
+        for (const auto kw : otter::irange(kernel_w)) {
+            for (const auto t : otter::irange(TILE)) {
+                const int64_t iw = iw0 + t * stride_w + kw;
+                pixel[t] = (row_inside && iw >= 0 && iw < input_width) ? input + (ih * input_width + iw) * in_channels : zero;
+            }
+            for (const auto c : otter::irange(in_channels)) {
+                const Vec w = Vec::loadu(weight + c * PACK);
+                for (const auto t : otter::irange(TILE)) {
+                    acc[t] = vec::fmadd(Vec(pixel[t][c]), w, acc[t]);
+                }
+            }
+            weight += in_channels * PACK;
+        }
+    }
+
+    for (const auto t : otter::irange(TILE)) {
+        if (out_count == PACK) {
+            acc[t].store(output + t * out_channels);
+        } else {
+            acc[t].store(output + t * out_channels, static_cast<int>(out_count));
+        }
+    }
+}
+
+Tensor convolution_channels_last(const Tensor& input, const Tensor& weight_packed, const Tensor& bias, int64_t out_channels, IntArrayRef kernel_size, IntArrayRef stride, IntArrayRef padding) {
+    OTTER_CHECK(input.dim() == 4 && input.scalar_type() == ScalarType::Float, "convolution_channels_last: Expect 4D float input but get ", input.sizes());
+    OTTER_CHECK(weight_packed.dim() == 5 && weight_packed.size(3) == input.size(1) && weight_packed.size(4) == PACK, "convolution_channels_last: Weight ", weight_packed.sizes(), " does not match input ", input.sizes());
+
+    Tensor input_contiguous = input.contiguous(MemoryFormat::ChannelsLast);
+
+    const int64_t batch = input.size(0);
+    const int64_t in_channels = input.size(1);
+    const int64_t out_blocks = weight_packed.size(0);
+    const int64_t kernel_h = kernel_size[0];
+    const int64_t kernel_w = kernel_size[1];
+    const int64_t stride_h = stride[0];
+    const int64_t stride_w = stride[1];
+    const int64_t pad_h = padding[0];
+    const int64_t pad_w = padding[1];
+    const int64_t output_height = (input.size(2) + 2 * pad_h - kernel_h) / stride_h + 1;
+    const int64_t output_width = (input.size(3) + 2 * pad_w - kernel_w) / stride_w + 1;
+
+    Tensor output = otter::empty_cpu({batch, out_channels, output_height, output_width}, input.options(), MemoryFormat::ChannelsLast);
+
+    // The pointwise convolution is a plain GEMM, view every image as one long row
+    // then the pixel tiles can cross the rows
+    const bool pointwise = kernel_h == 1 && kernel_w == 1 && stride_h == 1 && stride_w == 1 && pad_h == 0 && pad_w == 0;
+    const int64_t input_height = pointwise ? 1 : input.size(2);
+    const int64_t input_width = pointwise ? input.size(2) * input.size(3) : input.size(3);
+    const int64_t tile_height = pointwise ? 1 : output_height;
+    const int64_t tile_width = pointwise ? output_height * output_width : output_width;
+
+    std::vector<float> bias_padded(out_blocks * PACK, 0.f);
+    if (bias.defined()) {
+        Tensor bias_contiguous = bias.to(ScalarType::Float).contiguous();
+        std::memcpy(bias_padded.data(), bias_contiguous.data_ptr<float>(), out_channels * sizeof(float));
+    }
+    std::vector<float> zero(in_channels, 0.f);
+
+    const float* input_data = input_contiguous.data_ptr<float>();
+    const float* weight_data = weight_packed.data_ptr<float>();
+    float* output_data = output.data_ptr<float>();
+
+    const int64_t input_image_stride = input_height * input_width * in_channels;
+    const int64_t weight_block_stride = kernel_h * kernel_w * in_channels * PACK;
+
+    otter::parallel_for(0, batch * tile_height * out_blocks, 0, [&](int64_t begin, int64_t end) {
+        int64_t n = 0, oh = 0, ob = 0;
+        data_index_init(begin, n, batch, oh, tile_height, ob, out_blocks);
+
+        for (const auto i : otter::irange(begin, end)) {
+            (void)i;
+            const Vec bias_vec = Vec::loadu(bias_padded.data() + ob * PACK);
+            const float* weight_block = weight_data + ob * weight_block_stride;
+            const float* input_image = input_data + n * input_image_stride;
+            float* output_row = output_data + ((n * tile_height + oh) * tile_width) * out_channels + ob * PACK;
+            const int64_t out_count = std::min(PACK, out_channels - ob * PACK);
+            const int64_t ih0 = oh * stride_h - pad_h;
+
+            int64_t ow = 0;
+            for (; ow + 8 <= tile_width; ow += 8) {
+                conv_channels_last_tile<8>(output_row + ow * out_channels, input_image, zero.data(), weight_block, bias_vec, ih0, ow * stride_w - pad_w, input_height, input_width, in_channels, out_channels, out_count, kernel_h, kernel_w, stride_w);
+            }
+            for (; ow + 4 <= tile_width; ow += 4) {
+                conv_channels_last_tile<4>(output_row + ow * out_channels, input_image, zero.data(), weight_block, bias_vec, ih0, ow * stride_w - pad_w, input_height, input_width, in_channels, out_channels, out_count, kernel_h, kernel_w, stride_w);
+            }
+            for (; ow < tile_width; ++ow) {
+                conv_channels_last_tile<1>(output_row + ow * out_channels, input_image, zero.data(), weight_block, bias_vec, ih0, ow * stride_w - pad_w, input_height, input_width, in_channels, out_channels, out_count, kernel_h, kernel_w, stride_w);
+            }
+
+            data_index_step(n, batch, oh, tile_height, ob, out_blocks);
+        }
+    });
+
+    return output;
+}
+
+Tensor depthwise_convolution_channels_last(const Tensor& input, const Tensor& weight_packed, const Tensor& bias, IntArrayRef kernel_size, IntArrayRef stride, IntArrayRef padding) {
+    OTTER_CHECK(input.dim() == 4 && input.scalar_type() == ScalarType::Float, "depthwise_convolution_channels_last: Expect 4D float input but get ", input.sizes());
+    OTTER_CHECK(weight_packed.dim() == 3 && weight_packed.size(2) == input.size(1), "depthwise_convolution_channels_last: Weight ", weight_packed.sizes(), " does not match input ", input.sizes());
+
+    Tensor input_contiguous = input.contiguous(MemoryFormat::ChannelsLast);
+
+    const int64_t batch = input.size(0);
+    const int64_t channels = input.size(1);
+    const int64_t input_height = input.size(2);
+    const int64_t input_width = input.size(3);
+    const int64_t kernel_h = kernel_size[0];
+    const int64_t kernel_w = kernel_size[1];
+    const int64_t stride_h = stride[0];
+    const int64_t stride_w = stride[1];
+    const int64_t pad_h = padding[0];
+    const int64_t pad_w = padding[1];
+    const int64_t output_height = (input_height + 2 * pad_h - kernel_h) / stride_h + 1;
+    const int64_t output_width = (input_width + 2 * pad_w - kernel_w) / stride_w + 1;
+
+    Tensor output = otter::empty_cpu({batch, channels, output_height, output_width}, input.options(), MemoryFormat::ChannelsLast);
+
+    std::vector<float> bias_data(channels, 0.f);
+    if (bias.defined()) {
+        Tensor bias_contiguous = bias.to(ScalarType::Float).contiguous();
+        std::memcpy(bias_data.data(), bias_contiguous.data_ptr<float>(), channels * sizeof(float));
+    }
+
+    const float* input_data = input_contiguous.data_ptr<float>();
+    const float* weight_data = weight_packed.data_ptr<float>();
+    float* output_data = output.data_ptr<float>();
+
+    otter::parallel_for(0, batch * output_height, 0, [&](int64_t begin, int64_t end) {
+        for (const auto index : otter::irange(begin, end)) {
+            const int64_t n = index / output_height;
+            const int64_t oh = index % output_height;
+            const float* input_image = input_data + n * input_height * input_width * channels;
+            float* output_row = output_data + index * output_width * channels;
+
+            // The taps inside the input
+            const int64_t ih0 = oh * stride_h - pad_h;
+            const int64_t kh_begin = std::max<int64_t>(0, -ih0);
+            const int64_t kh_end = std::min(kernel_h, input_height - ih0);
+
+            for (const auto ow : otter::irange(output_width)) {
+                const int64_t iw0 = ow * stride_w - pad_w;
+                const int64_t kw_begin = std::max<int64_t>(0, -iw0);
+                const int64_t kw_end = std::min(kernel_w, input_width - iw0);
+                float* out = output_row + ow * channels;
+
+                for (int64_t c = 0; c < channels; c += PACK) {
+                    const int count = static_cast<int>(std::min(PACK, channels - c));
+                    Vec acc = Vec::loadu(bias_data.data() + c, count);
+                    for (int64_t kh = kh_begin; kh < kh_end; ++kh) {
+                        const float* input_row = input_image + (ih0 + kh) * input_width * channels;
+                        for (int64_t kw = kw_begin; kw < kw_end; ++kw) {
+                            const Vec x = Vec::loadu(input_row + (iw0 + kw) * channels + c, count);
+                            const Vec w = Vec::loadu(weight_data + (kh * kernel_w + kw) * channels + c, count);
+                            acc = vec::fmadd(x, w, acc);
+                        }
+                    }
+                    acc.store(out + c, count);
+                }
+            }
+        }
+    });
+
+    return output;
+}
+
+}   // end namespace otter
@@ -0,0 +1,44 @@
+//
+//  ConvolutionPacked.hpp
+//  Tensor
+//
+//  Created by 陳均豪 on 2022/3/22.
+//
+
+#ifndef ConvolutionPacked_hpp
+#define ConvolutionPacked_hpp
+
+#include "ArrayRef.hpp"
+
+namespace otter {
+
+class Tensor;
+
+// Convolution with the prepacked weight on the channel blocked layout (see TensorPacking.hpp)
+// and on the channels last layout, no dilation
+
+// weight {out_channels, in_channels, kh, kw} -> {ceil(out_channels / elempack), kh, kw, in_channels, elempack}
+// The tail output block is zero padded
+Tensor convolution_packed_pack_weight(const Tensor& weight, int64_t elempack);
+
+// input {N, in_channels / elempack, H, W, elempack}
+// Return the packed output {N, out_channels / elempack, OH, OW, elempack} when out_channels is divisible by elempack,
+// otherwise the plain {N, out_channels, OH, OW}
+Tensor convolution_packed(const Tensor& input, const Tensor& weight_packed, const Tensor& bias, int64_t out_channels, IntArrayRef kernel_size, IntArrayRef stride, IntArrayRef padding);
+
+// weight {channels, 1, kh, kw} -> {kh, kw, channels}
+Tensor depthwise_convolution_packed_pack_weight(const Tensor& weight, int64_t elempack);
+
+// input and output {N, channels / elempack, H, W, elempack}
+Tensor depthwise_convolution_packed(const Tensor& input, const Tensor& weight_packed, const Tensor& bias, IntArrayRef kernel_size, IntArrayRef stride, IntArrayRef padding);
+
+// input {N, in_channels, H, W} in any layout, computed as the implicit GEMM without im2col
+// Return the channels last output {N, out_channels, OH, OW}
+Tensor convolution_channels_last(const Tensor& input, const Tensor& weight_packed, const Tensor& bias, int64_t out_channels, IntArrayRef kernel_size, IntArrayRef stride, IntArrayRef padding);
+
+// input {N, channels, H, W} in any layout, return the channels last output
+Tensor depthwise_convolution_channels_last(const Tensor& input, const Tensor& weight_packed, const Tensor& bias, IntArrayRef kernel_size, IntArrayRef stride, IntArrayRef padding);
+
+}   // end namespace otter
+
+#endif /* ConvolutionPacked_hpp */
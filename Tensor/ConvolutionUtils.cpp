@@ -91,6 +91,19 @@ bool ConvParams::use_cpu_depthwise3x3_winograd(const Tensor& input, const Tensor
 #endif
 }
 
+bool ConvParams::use_cpu_depthwise(const Tensor& input, const Tensor& weight) const {
+    return (input.dim() == 4) &&
+        (input.size(1) == groups) &&
+        (weight.dim() == 4) &&
+        (weight.size(0) == groups) &&
+        (weight.size(1) == 1) &&
+        (input.device() == Device::CPU) &&
+        (input.scalar_type() == ScalarType::Float) &&
+        (weight.scalar_type() == ScalarType::Float) &&
+        !is_dilated() &&
+        !transposed;
+}
+
 bool ConvParams::use_cpu_neon(const Tensor& input, const Tensor& weight) const {
 #if defined(__ARM_NEON__)
     return (input.scalar_type() == ScalarType::Float) &&
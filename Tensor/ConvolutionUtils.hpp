@@ -32,11 +32,13 @@ struct ConvParams {
     bool is_output_padding_neg() const;
     bool is_stride_nonpos() const;
     bool use_cpu_depthwise3x3_winograd(const Tensor& input, const Tensor& weight) const;
+    bool use_cpu_depthwise(const Tensor& input, const Tensor& weight) const;
     bool use_cpu_neon(const Tensor& input, const Tensor& weight) const;
 };
 
 enum class ConvBackend {
     Winograd3x3Depthwise,
+    Slow2dDepthwise,
     SlowDilated2d,
     SlowDilated3d,
     Slow2d,
@@ -46,6 +46,43 @@ inline ScalarType scalar_type(ScalarType s) {
     }                                                           \
     }()
 
+#define OTTER_DISPATCH_ALL_TYPES_AND(SCALARTYPE, TYPE, NAME, ...)               \
+    [&] {                                                       \
+    const auto& the_type = TYPE;                                \
+    ScalarType _st = otter::detail::scalar_type(the_type);           \
+    switch(_st) {                                               \
+        OTTER_CASE_TYPE(ScalarType::Byte, uint8_t, __VA_ARGS__)      \
+        OTTER_CASE_TYPE(ScalarType::Char, int8_t, __VA_ARGS__)       \
+        OTTER_CASE_TYPE(ScalarType::Short, int16_t, __VA_ARGS__)     \
+        OTTER_CASE_TYPE(ScalarType::Int, int, __VA_ARGS__)           \
+        OTTER_CASE_TYPE(ScalarType::Long, int64_t, __VA_ARGS__)      \
+        OTTER_CASE_TYPE(ScalarType::Float, float, __VA_ARGS__)       \
+        OTTER_CASE_TYPE(ScalarType::Double, double, __VA_ARGS__)     \
+        OTTER_CASE_TYPE(SCALARTYPE, decltype(ScalarTypeToCPPType<SCALARTYPE>::t), __VA_ARGS__)  \
+        default:                                                \
+            assert(false);                                      \
+    }                                                           \
+    }()
+
+#define OTTER_DISPATCH_ALL_TYPES_AND2(SCALARTYPE1, SCALARTYPE2, TYPE, NAME, ...)               \
+    [&] {                                                       \
+    const auto& the_type = TYPE;                                \
+    ScalarType _st = otter::detail::scalar_type(the_type);           \
+    switch(_st) {                                               \
+        OTTER_CASE_TYPE(ScalarType::Byte, uint8_t, __VA_ARGS__)      \
+        OTTER_CASE_TYPE(ScalarType::Char, int8_t, __VA_ARGS__)       \
+        OTTER_CASE_TYPE(ScalarType::Short, int16_t, __VA_ARGS__)     \
+        OTTER_CASE_TYPE(ScalarType::Int, int, __VA_ARGS__)           \
+        OTTER_CASE_TYPE(ScalarType::Long, int64_t, __VA_ARGS__)      \
+        OTTER_CASE_TYPE(ScalarType::Float, float, __VA_ARGS__)       \
+        OTTER_CASE_TYPE(ScalarType::Double, double, __VA_ARGS__)     \
+        OTTER_CASE_TYPE(SCALARTYPE1, decltype(ScalarTypeToCPPType<SCALARTYPE1>::t), __VA_ARGS__)  \
+        OTTER_CASE_TYPE(SCALARTYPE2, decltype(ScalarTypeToCPPType<SCALARTYPE2>::t), __VA_ARGS__)  \
+        default:                                                \
+            assert(false);                                      \
+    }                                                           \
+    }()
+
 #define OTTER_DISPATCH_INTEGRAL_TYPES(TYPE, NAME, ...)               \
     [&] {                                                       \
     const auto& the_type = TYPE;                                \
@@ -86,6 +123,20 @@ inline ScalarType scalar_type(ScalarType s) {
     }                                                           \
     }()
 
+#define OTTER_DISPATCH_FLOATING_TYPES_AND2(SCALARTYPE1, SCALARTYPE2, TYPE, NAME, ...)               \
+    [&] {                                                       \
+    const auto& the_type = TYPE;                                \
+    ScalarType _st = otter::detail::scalar_type(the_type);           \
+    switch(_st) {                                               \
+        OTTER_CASE_TYPE(ScalarType::Float, float, __VA_ARGS__)       \
+        OTTER_CASE_TYPE(ScalarType::Double, double, __VA_ARGS__)     \
+        OTTER_CASE_TYPE(SCALARTYPE1, decltype(ScalarTypeToCPPType<SCALARTYPE1>::t), __VA_ARGS__)  \
+        OTTER_CASE_TYPE(SCALARTYPE2, decltype(ScalarTypeToCPPType<SCALARTYPE2>::t), __VA_ARGS__)  \
+        default:                                                \
+            assert(false);                         \
+    }                                                           \
+    }()
+
 #define OTTER_DISPATCH_ALL_TYPES_HINT(TYPE, HINT, NAME, ...)    \
     [&] {                                                       \
     const auto& the_type = TYPE;                                \
@@ -34,4 +34,12 @@ std::tuple<Tensor, Tensor> dropout(const Tensor& input, double p, bool train) {
     return std::make_tuple(output, mask);
 }
 
+Tensor& dropout_(Tensor& self, double p, bool train) {
+    // There is no random generator to draw the mask from, self is kept untouched in the training mode as well
+    (void)p;
+    (void)train;
+    
+    return self;
+}
+
 }
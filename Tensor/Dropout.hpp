@@ -16,6 +16,9 @@ class Tensor;
 
 std::tuple<Tensor, Tensor> dropout(const Tensor& input, double p, bool train);
 
+// A no-op on self, the training mode is not supported yet
+Tensor& dropout_(Tensor& self, double p, bool train);
+
 }
 
 #endif /* Dropout_hpp */
@@ -15,6 +15,8 @@ namespace otter {
 DropoutLayer::DropoutLayer() {
     one_blob_only = true;
     support_inplace = true;
+    support_packing = true;
+    support_channels_last = true;
 }
 
 int DropoutLayer::parse_param(LayerOption& option, ParamDict &pd) {
@@ -36,7 +38,7 @@ int DropoutLayer::forward_inplace(Tensor &bottom_blob, const NetOption &opt) con
         if (opt.use_non_lib_optimize) {
             // TODO: dropout enhancement
         } else {
-            bottom_blob = std::get<0>(otter::dropout(bottom_blob, probability, true));
+            otter::dropout_(bottom_blob, probability, true);
         }
     }
     return 0;
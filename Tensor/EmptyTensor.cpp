@@ -27,6 +27,10 @@ size_t computeStorageNbytes(
 Tensor empty_cpu(IntArrayRef size, TensorOptions option) {
     ScalarType dtype = typeMetaToScalarType(option.dtype());
     
+    if (option.has_memory_format() && option.memory_format() != MemoryFormat::Preserve) {
+        return empty_generic(size, GetAllocator(Device::CPU), dtype, option.memory_format());
+    }
+    
     return empty_cpu(size, dtype);
 }
 
@@ -30,7 +30,7 @@ Tensor& fill_(Tensor& self, const Scalar& value) {
 }
 
 Tensor& fill_(Tensor& self, const Tensor& value) {
-    OTTER_CHECK(value.dim() == 1, "Only support for 1D tensor");
+    OTTER_CHECK(value.dim() == 0 || (value.dim() == 1 && value.numel() == 1), "Only support for 0D or single element 1D tensor");
     return fill_out(self, value.item());
 }
 
@@ -0,0 +1,35 @@
+//
+//  Half.cpp
+//  Tensor
+//
+//  Created by 陳均豪 on 2022/3/22.
+//
+
+#include "Half.hpp"
+#include "Vec.hpp"
+
+namespace otter {
+
+using Vec = vec::Vectorized<float>;
+
+void float_to_half(const float* src, Half* dst, int64_t size) {
+    int64_t i = 0;
+    for (; i + Vec::size() <= size; i += Vec::size()) {
+        vec::store_half(dst + i, Vec::loadu(src + i));
+    }
+    for (; i < size; ++i) {
+        dst[i] = src[i];
+    }
+}
+
+void half_to_float(const Half* src, float* dst, int64_t size) {
+    int64_t i = 0;
+    for (; i + Vec::size() <= size; i += Vec::size()) {
+        vec::load_half(src + i).store(dst + i);
+    }
+    for (; i < size; ++i) {
+        dst[i] = src[i];
+    }
+}
+
+}   // end namespace otter
@@ -0,0 +1,219 @@
+//
+//  Half.hpp
+//  Tensor
+//
+//  Created by 陳均豪 on 2022/3/22.
+//
+
+#ifndef Half_hpp
+#define Half_hpp
+
+#include <cstdint>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <ostream>
+
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+namespace otter {
+
+namespace detail {
+
+static inline float fp32_from_bits(uint32_t w) {
+    float f;
+    std::memcpy(&f, &w, sizeof(f));
+    return f;
+}
+
+static inline uint32_t fp32_to_bits(float f) {
+    uint32_t w;
+    std::memcpy(&w, &f, sizeof(w));
+    return w;
+}
+
+// IEEE 754 binary16 -> binary32, exact
+static inline float fp16_ieee_to_fp32_value(uint16_t h) {
+#if defined(__F16C__)
+    return _cvtsh_ss(h);
+#else
+    const uint32_t sign = static_cast<uint32_t>(h & 0x8000u) << 16;
+    uint32_t exponent = (h >> 10) & 0x1Fu;
+    uint32_t mantissa = h & 0x3FFu;
+
+    if (exponent == 0x1F) {
+        // NaN is quieted as the hardware does
+        return fp32_from_bits(sign | 0x7F800000u | (mantissa << 13) | (mantissa ? 0x400000u : 0));
+    }
+    if (exponent == 0) {
+        if (mantissa == 0)
+            return fp32_from_bits(sign);
+        // Normalize the denormal number
+        exponent = 1;
+        while (!(mantissa & 0x400u)) {
+            mantissa <<= 1;
+            exponent--;
+        }
+        mantissa &= 0x3FFu;
+    }
+    return fp32_from_bits(sign | ((exponent + 112) << 23) | (mantissa << 13));
+#endif
+}
+
+// IEEE 754 binary32 -> binary16, round to nearest even, overflow to inf
+static inline uint16_t fp16_ieee_from_fp32_value(float f) {
+#if defined(__F16C__)
+    return _cvtss_sh(f, _MM_FROUND_TO_NEAREST_INT);
+#else
+    // Integer rounding, the float tricks do not survive -ffast-math
+    uint32_t w = fp32_to_bits(f);
+    const uint16_t sign = static_cast<uint16_t>((w >> 16) & 0x8000u);
+    w &= 0x7FFFFFFFu;
+
+    if (w >= 0x7F800000u) {
+        return sign | ((w > 0x7F800000u) ? 0x7E00u : 0x7C00u);
+    }
+    // Round to inf from the half way above 65504
+    if (w >= 0x477FF000u) {
+        return sign | 0x7C00u;
+    }
+    if (w < 0x38800000u) {
+        // Denormal half, the unit is 2^-24
+        if (w < 0x33000000u)
+            return sign;
+        const uint32_t shift = 126 - (w >> 23);
+        const uint32_t mantissa = (w & 0x7FFFFFu) | 0x800000u;
+        uint32_t result = mantissa >> shift;
+        const uint32_t remainder = mantissa & ((1u << shift) - 1);
+        const uint32_t halfway = 1u << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (result & 1)))
+            result++;
+        return sign | static_cast<uint16_t>(result);
+    }
+
+    // Rebias the exponent, the carry of the rounding goes into the exponent
+    uint32_t result = (w - 0x38000000u) >> 13;
+    const uint32_t remainder = w & 0x1FFFu;
+    if (remainder > 0x1000u || (remainder == 0x1000u && (result & 1)))
+        result++;
+    return sign | static_cast<uint16_t>(result);
+#endif
+}
+
+}   // end namespace detail
+
+// 16 bit floating point for the storage, the arithmetic is done in float
+struct alignas(2) Half {
+    uint16_t x;
+
+    struct from_bits_t {};
+    static constexpr from_bits_t from_bits() {
+        return from_bits_t();
+    }
+
+    Half() = default;
+    constexpr Half(uint16_t bits, from_bits_t) : x(bits) {}
+
+    Half(float value) : x(detail::fp16_ieee_from_fp32_value(value)) {}
+
+    operator float() const {
+        return detail::fp16_ieee_to_fp32_value(x);
+    }
+};
+
+inline Half operator+(const Half& a, const Half& b) {
+    return static_cast<float>(a) + static_cast<float>(b);
+}
+
+inline Half operator-(const Half& a, const Half& b) {
+    return static_cast<float>(a) - static_cast<float>(b);
+}
+
+inline Half operator*(const Half& a, const Half& b) {
+    return static_cast<float>(a) * static_cast<float>(b);
+}
+
+inline Half operator/(const Half& a, const Half& b) {
+    return static_cast<float>(a) / static_cast<float>(b);
+}
+
+inline Half operator-(const Half& a) {
+    return Half(a.x ^ 0x8000, Half::from_bits());
+}
+
+inline Half& operator+=(Half& a, const Half& b) {
+    a = a + b;
+    return a;
+}
+
+inline Half& operator-=(Half& a, const Half& b) {
+    a = a - b;
+    return a;
+}
+
+inline Half& operator*=(Half& a, const Half& b) {
+    a = a * b;
+    return a;
+}
+
+inline Half& operator/=(Half& a, const Half& b) {
+    a = a / b;
+    return a;
+}
+
+inline std::ostream& operator<<(std::ostream& out, const Half& value) {
+    out << static_cast<float>(value);
+    return out;
+}
+
+// Contiguous conversion, vectorized with F16C on x86 and the fp16 instructions on ARMv8
+void float_to_half(const float* src, Half* dst, int64_t size);
+void half_to_float(const Half* src, float* dst, int64_t size);
+
+}   // end namespace otter
+
+namespace std {
+
+template <>
+class numeric_limits<otter::Half> {
+public:
+    static constexpr bool is_specialized = true;
+    static constexpr bool is_signed = true;
+    static constexpr bool is_integer = false;
+    static constexpr bool is_exact = false;
+    static constexpr bool has_infinity = true;
+    static constexpr bool has_quiet_NaN = true;
+    static constexpr bool has_signaling_NaN = true;
+    static constexpr int digits = 11;
+    static constexpr int digits10 = 3;
+    static constexpr int max_digits10 = 5;
+    static constexpr int radix = 2;
+    static constexpr int min_exponent = -13;
+    static constexpr int min_exponent10 = -4;
+    static constexpr int max_exponent = 16;
+    static constexpr int max_exponent10 = 4;
+    static constexpr otter::Half min() {
+        return otter::Half(0x0400, otter::Half::from_bits());
+    }
+    static constexpr otter::Half lowest() {
+        return otter::Half(0xFBFF, otter::Half::from_bits());
+    }
+    static constexpr otter::Half max() {
+        return otter::Half(0x7BFF, otter::Half::from_bits());
+    }
+    static constexpr otter::Half epsilon() {
+        return otter::Half(0x1400, otter::Half::from_bits());
+    }
+    static constexpr otter::Half infinity() {
+        return otter::Half(0x7C00, otter::Half::from_bits());
+    }
+    static constexpr otter::Half quiet_NaN() {
+        return otter::Half(0x7E00, otter::Half::from_bits());
+    }
+};
+
+}   // end namespace std
+
+#endif /* Half_hpp */
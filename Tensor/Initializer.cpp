@@ -9,6 +9,10 @@
 #include "TensorMaker.hpp"
 #include "TensorFactory.hpp"
 #include "Accumulator.hpp"
+#include "Exception.hpp"
+#include "Half.hpp"
+
+#include <vector>
 
 namespace otter {
 
@@ -18,7 +22,8 @@ Initializer::Initializer() {
 Initializer::~Initializer() {
 }
 
-InitializerFromDataReader::InitializerFromDataReader(const DataReader& dr) : Initializer(), dr_(dr) {
+InitializerFromDataReader::InitializerFromDataReader(const DataReader& dr, ScalarType storage_type) : Initializer(), dr_(dr), storage_type_(storage_type) {
+    OTTER_CHECK(storage_type == ScalarType::Float || storage_type == ScalarType::Half, "Unsupported weight storage type ", toString(storage_type));
 }
 
 InitializerFromDataReader::~InitializerFromDataReader() {
@@ -30,23 +35,74 @@ Tensor InitializerFromDataReader::load(IntArrayRef shape) const {
     Tensor result;
     
     const int64_t size = otter::multiply_integers(shape);
+    const int64_t nbytes = size * (int64_t)elementSize(storage_type_);
     
-    nread = dr_.reference(size * sizeof(float), &refbuf);
+    nread = dr_.reference(nbytes, &refbuf);
     
-    if (nread == size * sizeof(float)) {
-        result = otter::from_blob(refbuf, shape, otter::ScalarType::Float);
+    if (nread == nbytes) {
+        result = otter::from_blob(refbuf, shape, storage_type_);
     } else {
-        result = otter::empty(shape, otter::ScalarType::Float);
-        nread = dr_.read(result.raw_data(), size * sizeof(float));
+        result = otter::empty(shape, storage_type_);
+        nread = dr_.read(result.raw_data(), nbytes);
         
-        if (nread != size * sizeof(float)) {
+        if (nread != nbytes) {
             fprintf(stderr, "Load weight fail!\n");
             
             return Tensor();
         }
     }
     
+    // The layers compute in float
+    if (storage_type_ == ScalarType::Half) {
+        result = result.to(ScalarType::Float);
+    }
+    
     return result;
 }
 
+int convert_weight_to_fp16(const char* src_path, const char* dst_path) {
+    FILE* src = fopen(src_path, "rb");
+    if (!src) {
+        fprintf(stderr, "Open weight file %s fail!\n", src_path);
+        return -1;
+    }
+    
+    int version[2];
+    if (fread(version, sizeof(int), 2, src) != 2 || version[0] == WEIGHT_FP16_MAJOR) {
+        fprintf(stderr, "Weight file %s is not a float weight file!\n", src_path);
+        fclose(src);
+        return -1;
+    }
+    
+    FILE* dst = fopen(dst_path, "wb");
+    if (!dst) {
+        fprintf(stderr, "Open weight file %s fail!\n", dst_path);
+        fclose(src);
+        return -1;
+    }
+    
+    version[0] = WEIGHT_FP16_MAJOR;
+    fwrite(version, sizeof(int), 2, dst);
+    
+    // The weights are a plain stream of float after the version
+    constexpr size_t CHUNK = 65536;
+    std::vector<float> buffer(CHUNK);
+    std::vector<Half> buffer_half(CHUNK);
+    
+    int status = 0;
+    size_t nread;
+    while ((nread = fread(buffer.data(), sizeof(float), CHUNK, src)) > 0) {
+        otter::float_to_half(buffer.data(), buffer_half.data(), (int64_t)nread);
+        if (fwrite(buffer_half.data(), sizeof(Half), nread, dst) != nread) {
+            fprintf(stderr, "Write weight file %s fail!\n", dst_path);
+            status = -1;
+            break;
+        }
+    }
+    
+    fclose(src);
+    fclose(dst);
+    return status;
+}
+
 }
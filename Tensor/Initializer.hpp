@@ -22,16 +22,25 @@ public:
     virtual Tensor load(IntArrayRef shape) const = 0;
 };
 
+// The weight file starts with int major and int minor version, then the weights of the layers in order
+// The weights are stored in half when the major version is WEIGHT_FP16_MAJOR, otherwise in float
+static constexpr int WEIGHT_FP16_MAJOR = 16;
+
+// Load the weights stored in storage_type (Float or Half), the loaded tensor is always float
 class InitializerFromDataReader : public Initializer {
 public:
-    InitializerFromDataReader(const DataReader& dr);
+    InitializerFromDataReader(const DataReader& dr, ScalarType storage_type = ScalarType::Float);
     virtual ~InitializerFromDataReader();
     
     virtual Tensor load(IntArrayRef shape) const;
 private:
     const DataReader& dr_;
+    ScalarType storage_type_;
 };
 
+// Rewrite the float weight file with the weights stored in half, return 0 for success
+int convert_weight_to_fp16(const char* src_path, const char* dst_path);
+
 }
 
 #endif /* Initializer_hpp */
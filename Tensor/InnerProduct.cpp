@@ -0,0 +1,281 @@
+//
+//  InnerProduct.cpp
+//  Tensor
+//
+//  Created by 陳均豪 on 2022/3/22.
+//
+
+#include "InnerProduct.hpp"
+#include "Tensor.hpp"
+#include "TensorFactory.hpp"
+#include "TensorResize.hpp"
+#include "Parallel.hpp"
+#include "Vec.hpp"
+#include "VecIntrinsic.hpp"
+#include "Config.hpp"
+
+#include <cmath>
+
+namespace otter {
+
+using Vec = vec::Vectorized<float>;
+
+// Output channels per packed block
+static constexpr int64_t IP_NR = Vec::size();
+// Batch rows per GEMM tile
+static constexpr int64_t IP_MR = 4;
+
+Tensor inner_product_pack_weight(const Tensor& weight) {
+    OTTER_CHECK(weight.dim() == 2, "Expect weight {out_features, in_features} but get ", weight.sizes());
+
+    const int64_t out_features = weight.size(0);
+    const int64_t in_features  = weight.size(1);
+    const int64_t out_blocks   = divup(out_features, IP_NR);
+
+    Tensor weight_contiguous = weight.to(ScalarType::Float).contiguous();
+    Tensor packed = otter::zeros({out_blocks, in_features, IP_NR}, ScalarType::Float);
+
+    const float* weight_ptr = weight_contiguous.data_ptr<float>();
+    float* packed_ptr = packed.data_ptr<float>();
+
+    otter::parallel_for(0, out_blocks, 0, [&](int64_t begin, int64_t end) {
+        for (const auto ob : otter::irange(begin, end)) {
+            const int64_t rows = std::min(IP_NR, out_features - ob * IP_NR);
+            float* dst = packed_ptr + ob * in_features * IP_NR;
+            for (const auto r : otter::irange(rows)) {
+                const float* src = weight_ptr + (ob * IP_NR + r) * in_features;
+                for (const auto k : otter::irange(in_features)) {
+                    dst[k * IP_NR + r] = src[k];
+                }
+            }
+        }
+    });
+
+    return packed;
+}
+
+std::tuple<Tensor, Tensor> inner_product_pack_weight_int8(const Tensor& weight) {
+    OTTER_CHECK(weight.dim() == 2, "Expect weight {out_features, in_features} but get ", weight.sizes());
+
+    const int64_t out_features = weight.size(0);
+    const int64_t in_features  = weight.size(1);
+    const int64_t out_blocks   = divup(out_features, IP_NR);
+
+    Tensor weight_contiguous = weight.to(ScalarType::Float).contiguous();
+    Tensor packed = otter::zeros({out_blocks, in_features, IP_NR}, ScalarType::Char);
+    Tensor scale = otter::zeros({out_blocks * IP_NR}, ScalarType::Float);
+
+    const float* weight_ptr = weight_contiguous.data_ptr<float>();
+    int8_t* packed_ptr = packed.data_ptr<int8_t>();
+    float* scale_ptr = scale.data_ptr<float>();
+
+    otter::parallel_for(0, out_features, 0, [&](int64_t begin, int64_t end) {
+        for (const auto o : otter::irange(begin, end)) {
+            const float* src = weight_ptr + o * in_features;
+
+            float absmax = 0.f;
+            for (const auto k : otter::irange(in_features)) {
+                absmax = std::max(absmax, std::fabs(src[k]));
+            }
+
+            const float channel_scale = (absmax == 0.f) ? 1.f : absmax / 127.f;
+            const float inv_scale = 1.f / channel_scale;
+            scale_ptr[o] = channel_scale;
+
+            int8_t* dst = packed_ptr + (o / IP_NR) * in_features * IP_NR + (o % IP_NR);
+            for (const auto k : otter::irange(in_features)) {
+                float q = std::round(src[k] * inv_scale);
+                q = std::min(127.f, std::max(-127.f, q));
+                dst[k * IP_NR] = static_cast<int8_t>(q);
+            }
+        }
+    });
+
+    return std::make_tuple(packed, scale);
+}
+
+template <typename weight_t>
+inline Vec ip_load_weight(const weight_t* ptr);
+
+template <>
+inline Vec ip_load_weight<float>(const float* ptr) {
+    return Vec::loadu(ptr);
+}
+
+template <>
+inline Vec ip_load_weight<int8_t>(const int8_t* ptr) {
+#if CPU_CAPABILITY_AVX2
+    return _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(ptr))));
+#else
+    float buffer[Vec::size()];
+    for (const auto i : otter::irange(Vec::size())) {
+        buffer[i] = static_cast<float>(ptr[i]);
+    }
+    return Vec::loadu(buffer);
+#endif
+}
+
+// One input row against one packed block, four accumulators to hide the fma latency
+template <typename weight_t>
+inline Vec ip_gemv_block(const float* input, const weight_t* weight, int64_t in_features) {
+    Vec acc0(0.f), acc1(0.f), acc2(0.f), acc3(0.f);
+
+    int64_t k = 0;
+    for (; k + 4 <= in_features; k += 4) {
+        acc0 = vec::fmadd(ip_load_weight(weight), Vec(input[k]), acc0);
+        acc1 = vec::fmadd(ip_load_weight(weight + IP_NR), Vec(input[k + 1]), acc1);
+        acc2 = vec::fmadd(ip_load_weight(weight + 2 * IP_NR), Vec(input[k + 2]), acc2);
+        acc3 = vec::fmadd(ip_load_weight(weight + 3 * IP_NR), Vec(input[k + 3]), acc3);
+        weight += 4 * IP_NR;
+    }
+    for (; k < in_features; ++k) {
+        acc0 = vec::fmadd(ip_load_weight(weight), Vec(input[k]), acc0);
+        weight += IP_NR;
+    }
+
+    return (acc0 + acc1) + (acc2 + acc3);
+}
+
+// ROWS input rows against one packed block, the weight vector is loaded once for all rows
+template <int ROWS, typename weight_t>
+inline void ip_gemm_tile(const float* input, int64_t in_features, const weight_t* weight, Vec* acc) {
+    for (const auto r : otter::irange(ROWS)) {
+        acc[r] = Vec(0.f);
+    }
+
+    for (const auto k : otter::irange(in_features)) {
+        const Vec w = ip_load_weight(weight + k * IP_NR);
+        for (const auto r : otter::irange(ROWS)) {
+            acc[r] = vec::fmadd(w, Vec(input[r * in_features + k]), acc[r]);
+        }
+    }
+}
+
+struct InnerProductEpilogue {
+    const float* scale;
+    const float* bias;
+    int64_t out_features;
+    InnerProductActivation activation;
+    float activation_param;
+
+    inline void apply(Vec acc, int64_t ob, float* output) const {
+        const int64_t offset = ob * IP_NR;
+        const int64_t count = std::min(IP_NR, out_features - offset);
+
+        if (scale) {
+            acc = acc * Vec::loadu(scale + offset);
+        }
+        if (bias) {
+            acc = acc + Vec::loadu(bias + offset, count);
+        }
+
+        switch (activation) {
+            case InnerProductActivation::Relu:
+                acc = vec::maximum(acc, Vec(0.f));
+                break;
+            case InnerProductActivation::LeakyRelu:
+                acc = acc * Vec::blendv(Vec(activation_param), Vec(1.f), acc > Vec(0.f));
+                break;
+            default:
+                break;
+        }
+
+        if (count == IP_NR) {
+            acc.store(output + offset);
+        } else {
+            acc.store(output + offset, static_cast<int>(count));
+        }
+    }
+};
+
+template <typename weight_t>
+void inner_product_kernel(float* output, const float* input, const weight_t* weight, const InnerProductEpilogue& epilogue, int64_t batch, int64_t in_features) {
+    const int64_t out_features = epilogue.out_features;
+    const int64_t out_blocks = divup(out_features, IP_NR);
+    const int64_t block_stride = in_features * IP_NR;
+
+    if (batch == 1) {
+        otter::parallel_for(0, out_blocks, 0, [&](int64_t begin, int64_t end) {
+            for (const auto ob : otter::irange(begin, end)) {
+                Vec acc = ip_gemv_block(input, weight + ob * block_stride, in_features);
+                epilogue.apply(acc, ob, output);
+            }
+        });
+        return;
+    }
+
+    const int64_t row_blocks = divup(batch, IP_MR);
+
+    otter::parallel_for(0, row_blocks * out_blocks, 0, [&](int64_t begin, int64_t end) {
+        Vec acc[IP_MR];
+        for (const auto index : otter::irange(begin, end)) {
+            const int64_t rb = index / out_blocks;
+            const int64_t ob = index % out_blocks;
+            const int64_t row_begin = rb * IP_MR;
+            const int64_t rows = std::min(IP_MR, batch - row_begin);
+
+            const float* input_tile = input + row_begin * in_features;
+            const weight_t* weight_block = weight + ob * block_stride;
+
+            switch (rows) {
+                case 4: ip_gemm_tile<4>(input_tile, in_features, weight_block, acc); break;
+                case 3: ip_gemm_tile<3>(input_tile, in_features, weight_block, acc); break;
+                case 2: ip_gemm_tile<2>(input_tile, in_features, weight_block, acc); break;
+                default: ip_gemm_tile<1>(input_tile, in_features, weight_block, acc); break;
+            }
+
+            for (const auto r : otter::irange(rows)) {
+                epilogue.apply(acc[r], ob, output + (row_begin + r) * out_features);
+            }
+        }
+    });
+}
+
+Tensor& inner_product_packed_out(Tensor& output, const Tensor& input, const Tensor& packed_weight, const Tensor& weight_scale, const Tensor& bias, int64_t out_features, InnerProductActivation activation, float activation_param) {
+    OTTER_CHECK(input.dim() == 2, "Expect input {N, in_features} but get ", input.sizes());
+    OTTER_CHECK(input.scalar_type() == ScalarType::Float, "Expect Float input but get ", toString(input.scalar_type()));
+    OTTER_CHECK(packed_weight.dim() == 3 && packed_weight.size(2) == IP_NR, "Expect packed weight {blocks, in_features, ", IP_NR, "} but get ", packed_weight.sizes());
+    OTTER_CHECK(packed_weight.size(0) == divup(out_features, IP_NR), "Packed weight does not match out_features ", out_features);
+
+    const int64_t batch = input.size(0);
+    const int64_t in_features = input.size(1);
+    OTTER_CHECK(packed_weight.size(1) == in_features, "Expect in_features ", packed_weight.size(1), " but get ", in_features);
+
+    const bool is_int8 = packed_weight.scalar_type() == ScalarType::Char;
+    OTTER_CHECK(is_int8 || packed_weight.scalar_type() == ScalarType::Float, "Unsupported packed weight type ", toString(packed_weight.scalar_type()));
+    OTTER_CHECK(!is_int8 || (weight_scale.defined() && weight_scale.numel() == packed_weight.size(0) * IP_NR), "Int8 packed weight needs the per channel scale");
+    OTTER_CHECK(!bias.defined() || bias.numel() == out_features, "Expect bias {", out_features, "} but get ", bias.sizes());
+
+    otter::native::resize_output(output, {batch, out_features});
+    if (batch == 0)
+        return output;
+
+    Tensor input_contiguous = input.contiguous();
+    Tensor bias_contiguous = bias.defined() ? bias.to(ScalarType::Float).contiguous() : Tensor();
+
+    InnerProductEpilogue epilogue;
+    epilogue.scale = is_int8 ? weight_scale.data_ptr<float>() : nullptr;
+    epilogue.bias = bias_contiguous.defined() ? bias_contiguous.data_ptr<float>() : nullptr;
+    epilogue.out_features = out_features;
+    epilogue.activation = activation;
+    epilogue.activation_param = activation_param;
+
+    float* output_ptr = output.data_ptr<float>();
+    const float* input_ptr = input_contiguous.data_ptr<float>();
+
+    if (is_int8) {
+        inner_product_kernel(output_ptr, input_ptr, packed_weight.data_ptr<int8_t>(), epilogue, batch, in_features);
+    } else {
+        inner_product_kernel(output_ptr, input_ptr, packed_weight.data_ptr<float>(), epilogue, batch, in_features);
+    }
+
+    return output;
+}
+
+Tensor inner_product_packed(const Tensor& input, const Tensor& packed_weight, const Tensor& weight_scale, const Tensor& bias, int64_t out_features, InnerProductActivation activation, float activation_param) {
+    Tensor output = otter::empty({input.size(0), out_features}, ScalarType::Float);
+
+    return inner_product_packed_out(output, input, packed_weight, weight_scale, bias, out_features, activation, activation_param);
+}
+
+}   // end namespace otter
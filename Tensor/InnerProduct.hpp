@@ -0,0 +1,42 @@
+//
+//  InnerProduct.hpp
+//  Tensor
+//
+//  Created by 陳均豪 on 2022/3/22.
+//
+
+#ifndef InnerProduct_hpp
+#define InnerProduct_hpp
+
+#include <cstdint>
+#include <tuple>
+
+namespace otter {
+
+class Tensor;
+
+enum class InnerProductActivation : int {
+    None,
+    Relu,
+    LeakyRelu
+};
+
+// Pack the weight {out_features, in_features} for the vectorized kernel
+// Every Vectorized<float>::size() output rows are interleaved along in_features
+// packed {ceil(out_features / size), in_features, size}, the tail block is zero padded
+Tensor inner_product_pack_weight(const Tensor& weight);
+
+// Same layout with symmetric per output channel int8 quantization
+// Return (packed Char weight, Float scale {ceil(out_features / size) * size})
+std::tuple<Tensor, Tensor> inner_product_pack_weight_int8(const Tensor& weight);
+
+// output {N, out_features} = activation(input {N, in_features} x weight^T + bias)
+// weight_scale should be undefined for the float packed weight
+// bias can be undefined
+Tensor& inner_product_packed_out(Tensor& output, const Tensor& input, const Tensor& packed_weight, const Tensor& weight_scale, const Tensor& bias, int64_t out_features, InnerProductActivation activation, float activation_param);
+
+Tensor inner_product_packed(const Tensor& input, const Tensor& packed_weight, const Tensor& weight_scale, const Tensor& bias, int64_t out_features, InnerProductActivation activation, float activation_param);
+
+}   // end namespace otter
+
+#endif /* InnerProduct_hpp */
@@ -0,0 +1,128 @@
+//
+//  InnerProductLayer.cpp
+//  Tensor
+//
+//  Created by 陳均豪 on 2022/3/22.
+//
+
+#include "InnerProductLayer.hpp"
+#include "LayerRegistry.hpp"
+
+#include "TensorFactory.hpp"
+#include "TensorMaker.hpp"
+
+namespace otter {
+
+InnerProductLayer::InnerProductLayer() {
+    one_blob_only = true;
+    support_inplace = false;
+}
+
+int InnerProductLayer::parse_param(LayerOption& option, ParamDict& pd) {
+    pd.clear();
+    int out_features = opt_find_int(option, "out_features", 1);
+    int bias_term = (!opt_find(option, "batchnorm")) ? 1 : 0;
+    if (opt_find(option, "bias_term")) {
+        if (option["bias_term"] == "false")
+            bias_term = 0;
+        else
+            bias_term = 1;
+    }
+    
+    // The activation is fused only when there is no batchnorm in between, see Net::addLayer()
+    int activation_type = (int)InnerProductActivation::None;
+    float activation_param = 0.f;
+    if (opt_find(option, "activation") && !opt_find(option, "batchnorm")) {
+        if (option["activation"] == "Relu") {
+            activation_type = (int)InnerProductActivation::Relu;
+        } else if (option["activation"] == "LRelu") {
+            activation_type = (int)InnerProductActivation::LeakyRelu;
+            activation_param = opt_find_float(option, "alpha", 0.1f);
+        }
+    }
+    
+    int int8_weight = 0;
+    if (opt_find(option, "int8_weight")) {
+        int8_weight = (option["int8_weight"] == "true" || option["int8_weight"] == "1") ? 1 : 0;
+    }
+    
+    pd.set((int)InnerProductParam::Out_features, out_features);
+    pd.set((int)InnerProductParam::Bias_term, bias_term);
+    pd.set((int)InnerProductParam::Activation_type, activation_type);
+    pd.set((int)InnerProductParam::Activation_param, activation_param);
+    pd.set((int)InnerProductParam::Int8_weight, int8_weight);
+    
+    return 0;
+}
+
+int InnerProductLayer::compute_output_shape(ParamDict& pd) {
+    auto shape_a = bottom_shapes[0].accessor<int, 1>();
+    int input_batch = shape_a[0];
+    int in_features = 1;
+    for (const auto i : otter::irange(1, bottom_shapes[0].size(0))) {
+        in_features *= shape_a[i];
+    }
+    int out_features = pd.get((int)InnerProductParam::Out_features, 1);
+    
+    pd.set((int)InnerProductParam::In_features, in_features);
+    pd.set(OUTPUT_SHAPE_HINT, tensor({input_batch, out_features}, ScalarType::Int));
+    
+    return 0;
+}
+
+int InnerProductLayer::load_param(const ParamDict& pd) {
+    in_features      = pd.get((int)InnerProductParam::In_features, 1);
+    out_features     = pd.get((int)InnerProductParam::Out_features, 1);
+    bias_term        = pd.get((int)InnerProductParam::Bias_term, 0);
+    activation_type  = pd.get((int)InnerProductParam::Activation_type, 0);
+    activation_param = pd.get((int)InnerProductParam::Activation_param, 0.f);
+    int8_weight      = pd.get((int)InnerProductParam::Int8_weight, 0);
+    
+    return 0;
+}
+
+int InnerProductLayer::init_model() {
+    weight_data = otter::rand({out_features, in_features}, ScalarType::Float);
+    if (bias_term)
+        bias_data = otter::rand({out_features}, ScalarType::Float);
+    
+    return pack_weight();
+}
+
+int InnerProductLayer::load_model(const Initializer& initializer) {
+    if (bias_term) {
+        bias_data = initializer.load({out_features});
+    }
+    weight_data = initializer.load({out_features, in_features});
+    
+    return pack_weight();
+}
+
+int InnerProductLayer::pack_weight() {
+    if (int8_weight) {
+        std::tie(weight_packed, weight_scale) = otter::inner_product_pack_weight_int8(weight_data);
+    } else {
+        weight_packed = otter::inner_product_pack_weight(weight_data);
+    }
+    weight_data.reset();
+    
+    return 0;
+}
+
+int InnerProductLayer::forward(const Tensor& bottom_blob, Tensor& top_blob, const NetOption& opt) const {
+    const int64_t batch = bottom_blob.size(0);
+    Tensor input = bottom_blob.reshape({batch, -1});
+    
+    top_blob = otter::inner_product_packed(
+        input, weight_packed, weight_scale, bias_data,
+        out_features,
+        (InnerProductActivation)activation_type,
+        activation_param
+    );
+    
+    return 0;
+}
+
+REGISTER_LAYER_CLASS(InnerProduct);
+
+}   // end namespace otter
@@ -0,0 +1,68 @@
+//
+//  InnerProductLayer.hpp
+//  Tensor
+//
+//  Created by 陳均豪 on 2022/3/22.
+//
+
+#ifndef InnerProductLayer_hpp
+#define InnerProductLayer_hpp
+
+#include "Layer.hpp"
+#include "InnerProduct.hpp"
+
+namespace otter {
+
+class InnerProductLayer : public Layer {
+public:
+    InnerProductLayer();
+    
+    virtual int parse_param(LayerOption& option, ParamDict& pd);
+    
+    virtual int compute_output_shape(ParamDict& pd);
+    
+    virtual int load_param(const ParamDict& pd);
+    
+    virtual int init_model();
+    
+    virtual int load_model(const Initializer& initializer);
+    
+    virtual int forward(const Tensor& bottom_blob, Tensor& top_blob, const NetOption& opt) const;
+    
+    virtual std::string type() const { return "InnerProduct"; }
+private:
+    int pack_weight();
+    
+public:
+    int in_features;
+    int out_features;
+    
+    int bias_term;
+    
+    // Fused epilogue, see InnerProductActivation
+    int activation_type;
+    float activation_param;
+    
+    // Quantize the weight to int8 with per output channel scale at load time
+    int int8_weight;
+    
+    Tensor weight_data;
+    Tensor bias_data;
+    
+    // Packed for the vectorized kernel, weight_data is released after packing
+    Tensor weight_packed;
+    Tensor weight_scale;
+};
+
+enum class InnerProductParam : int {
+    In_features,
+    Out_features,
+    Bias_term,
+    Activation_type,
+    Activation_param,
+    Int8_weight
+};
+
+}   // end namespace otter
+
+#endif /* InnerProductLayer_hpp */
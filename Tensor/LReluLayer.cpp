@@ -8,12 +8,16 @@
 #include "LReluLayer.hpp"
 #include "LayerRegistry.hpp"
 #include "TensorFunction.hpp"
+#include "TensorIterator.hpp"
+#include "Activation.hpp"
 
 namespace otter {
 
 LReluLayer::LReluLayer() {
     one_blob_only = true;
     support_inplace = true;
+    support_packing = true;
+    support_channels_last = true;
 }
 
 int LReluLayer::parse_param(LayerOption& option, ParamDict &pd) {
@@ -36,7 +40,18 @@ int LReluLayer::forward_inplace(Tensor &bottom_blob, const NetOption &opt) const
     if (opt.use_non_lib_optimize) {
         // TODO: leaky relu enhancement
     } else {
-        bottom_blob = otter::native::leaky_relu(bottom_blob, neg_slope);
+        // The iterator of the Extractor is rebound to the blob of the next frame
+        TensorIterator* iter = nullptr;
+        if (opt.prepared_iterator) {
+            iter = opt.prepared_iterator->prepare({bottom_blob, bottom_blob}, [&](TensorIterator& iter) {
+                iter.build_borrowing_unary_op(bottom_blob, bottom_blob);
+            });
+        }
+        if (iter) {
+            leaky_relu_stub(Device::CPU, *iter, neg_slope);
+        } else {
+            otter::native::leaky_relu_(bottom_blob, neg_slope);
+        }
     }
     
     return 0;
@@ -23,7 +23,7 @@ public:
     virtual int forward_inplace(Tensor& bottom_blob, const NetOption& opt) const;
     
     virtual std::string type() const { return "LRelu"; }
-private:
+public:
     float neg_slope;
 };
 
@@ -12,6 +12,9 @@ namespace otter {
 Layer::Layer() {
     one_blob_only = false;
     support_inplace = false;
+    support_view_output = false;
+    support_packing = false;
+    support_channels_last = false;
 }
 
 Layer::~Layer() {
@@ -75,6 +78,14 @@ int Layer::forward_inplace(std::vector<Tensor>& bottom_blobs, const NetOption& o
     return -1;
 }
 
+int Layer::forward_into(const Tensor& bottom_blob, Tensor& top_blob, const NetOption& opt) const {
+    return -1;
+}
+
+int Layer::forward_into(const std::vector<Tensor>& bottom_blobs, std::vector<Tensor>& top_blobs, const NetOption& opt) const {
+    return -1;
+}
+
 
 
 }   // end namespace otter
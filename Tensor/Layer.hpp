@@ -45,8 +45,18 @@ public:
     virtual int forward_inplace(Tensor& bottom_blob, const NetOption& opt) const;
     virtual int forward_inplace(std::vector<Tensor>& bottom_blobs, const NetOption& opt) const;
     
+    // Write the result into the preallocated top_blob (e.g. the channel slice of the Concat output)
+    // Return -1 if the top_blob can not be used, then forward() will be called instead
+    virtual int forward_into(const Tensor& bottom_blob, Tensor& top_blob, const NetOption& opt) const;
+    virtual int forward_into(const std::vector<Tensor>& bottom_blobs, std::vector<Tensor>& top_blobs, const NetOption& opt) const;
+    
 public:
     bool support_inplace;
+    bool support_view_output;
+    // Accept the channel blocked bottom blob (see TensorPacking.hpp)
+    bool support_packing;
+    // Accept the channels last bottom blob
+    bool support_channels_last;
     bool one_blob_only;
     
 public:
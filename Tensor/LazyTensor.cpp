@@ -0,0 +1,328 @@
+//
+//  LazyTensor.cpp
+//  Tensor
+//
+//  Created by 陳均豪 on 2022/3/22.
+//
+
+#include "LazyTensor.hpp"
+#include "TensorIterator.hpp"
+#include "TensorFactory.hpp"
+#include "ExpandUtils.hpp"
+#include "Exception.hpp"
+#include "Parallel.hpp"
+#include "Vec.hpp"
+
+#include <cstring>
+#include <unordered_map>
+
+namespace otter {
+
+using Vec = vec::Vectorized<float>;
+
+// Elements per register, an instruction runs over the whole block to amortize the dispatch
+static constexpr int64_t EXPR_BLOCK = 64;
+static constexpr int EXPR_MAX_REGISTERS = 32;
+
+LazyTensor::LazyTensor(const Tensor& tensor) {
+    OTTER_CHECK(tensor.defined(), "[LazyTensor] Expect a defined tensor");
+    auto node = std::make_shared<ExprNode>();
+    node->op = ExprOp::Leaf;
+    node->tensor = tensor;
+    node_ = std::move(node);
+}
+
+LazyTensor::LazyTensor(float value) {
+    auto node = std::make_shared<ExprNode>();
+    node->op = ExprOp::Constant;
+    node->value = value;
+    node_ = std::move(node);
+}
+
+LazyTensor LazyTensor::make(ExprOp op, const LazyTensor& lhs) {
+    auto node = std::make_shared<ExprNode>();
+    node->op = op;
+    node->lhs = lhs.node_;
+    return LazyTensor(std::shared_ptr<const ExprNode>(std::move(node)));
+}
+
+LazyTensor LazyTensor::make(ExprOp op, const LazyTensor& lhs, const LazyTensor& rhs) {
+    auto node = std::make_shared<ExprNode>();
+    node->op = op;
+    node->lhs = lhs.node_;
+    node->rhs = rhs.node_;
+    return LazyTensor(std::shared_ptr<const ExprNode>(std::move(node)));
+}
+
+LazyTensor LazyTensor::neg() const { return make(ExprOp::Neg, *this); }
+LazyTensor LazyTensor::abs() const { return make(ExprOp::Abs, *this); }
+LazyTensor LazyTensor::sqrt() const { return make(ExprOp::Sqrt, *this); }
+LazyTensor LazyTensor::rsqrt() const { return make(ExprOp::Rsqrt, *this); }
+LazyTensor LazyTensor::reciprocal() const { return make(ExprOp::Reciprocal, *this); }
+LazyTensor LazyTensor::exp() const { return make(ExprOp::Exp, *this); }
+LazyTensor LazyTensor::log() const { return make(ExprOp::Log, *this); }
+LazyTensor LazyTensor::tanh() const { return make(ExprOp::Tanh, *this); }
+LazyTensor LazyTensor::sigmoid() const { return make(ExprOp::Sigmoid, *this); }
+LazyTensor LazyTensor::relu() const { return make(ExprOp::Relu, *this); }
+
+LazyTensor LazyTensor::maximum(const LazyTensor& other) const {
+    return make(ExprOp::Maximum, *this, other);
+}
+
+LazyTensor LazyTensor::minimum(const LazyTensor& other) const {
+    return make(ExprOp::Minimum, *this, other);
+}
+
+LazyTensor LazyTensor::clamp(float min, float max) const {
+    return maximum(LazyTensor(min)).minimum(LazyTensor(max));
+}
+
+namespace {
+
+struct ExprInstruction {
+    ExprOp op;
+    int dst;
+    int a;      // Leaf: the index of the input
+    int b;
+};
+
+// Straight line code over the registers, the shared sub-expressions are computed once
+struct ExprProgram {
+    std::vector<ExprInstruction> code;
+    std::vector<std::pair<int, float>> constants;
+    std::vector<Tensor> leaves;
+    int registers = 0;
+    int result = -1;
+};
+
+class ExprCompiler {
+public:
+    ExprProgram compile(const std::shared_ptr<const ExprNode>& root) {
+        count_uses(root.get());
+        program_.result = emit(root.get());
+        return std::move(program_);
+    }
+
+private:
+    void count_uses(const ExprNode* node) {
+        if (uses_[node]++ > 0)
+            return;
+        if (node->lhs)
+            count_uses(node->lhs.get());
+        if (node->rhs)
+            count_uses(node->rhs.get());
+    }
+
+    // The constants are filled before the program runs, they never share a register
+    int allocate(bool constant = false) {
+        if (!constant && !free_.empty()) {
+            int reg = free_.back();
+            free_.pop_back();
+            return reg;
+        }
+        OTTER_CHECK(program_.registers < EXPR_MAX_REGISTERS, "[LazyTensor] Expression is too large, expect at most ", EXPR_MAX_REGISTERS, " live values");
+        return program_.registers++;
+    }
+
+    // Release the register of the operand after its last use
+    void release(const ExprNode* node) {
+        if (--uses_[node] == 0 && node->op != ExprOp::Constant)
+            free_.push_back(registers_[node]);
+    }
+
+    int leaf_index(const Tensor& tensor) {
+        for (const auto i : otter::irange(program_.leaves.size())) {
+            if (program_.leaves[i].is_same(tensor))
+                return static_cast<int>(i);
+        }
+        // The block loads read float and byte, the other types are converted up front
+        const bool loadable = tensor.scalar_type() == ScalarType::Float || tensor.scalar_type() == ScalarType::Byte;
+        program_.leaves.push_back(loadable ? tensor : tensor.to(ScalarType::Float));
+        return static_cast<int>(program_.leaves.size() - 1);
+    }
+
+    int emit(const ExprNode* node) {
+        auto it = registers_.find(node);
+        if (it != registers_.end())
+            return it->second;
+
+        int reg;
+        if (node->op == ExprOp::Leaf) {
+            reg = allocate();
+            program_.code.push_back({ExprOp::Leaf, reg, leaf_index(node->tensor), -1});
+        } else if (node->op == ExprOp::Constant) {
+            reg = allocate(/*constant=*/true);
+            program_.constants.push_back({reg, node->value});
+        } else {
+            int a = emit(node->lhs.get());
+            int b = node->rhs ? emit(node->rhs.get()) : -1;
+            release(node->lhs.get());
+            if (node->rhs)
+                release(node->rhs.get());
+            reg = allocate();
+            program_.code.push_back({node->op, reg, a, b});
+        }
+        registers_[node] = reg;
+
+        return reg;
+    }
+
+    ExprProgram program_;
+    std::unordered_map<const ExprNode*, int> uses_;
+    std::unordered_map<const ExprNode*, int> registers_;
+    std::vector<int> free_;
+};
+
+// Fill count elements of the register from the input, the stride is in bytes
+static void load_block(float* reg, const char* data, int64_t stride, ScalarType dtype, int64_t count) {
+    if (stride == 0) {
+        const float value = (dtype == ScalarType::Float) ? *reinterpret_cast<const float*>(data) : static_cast<float>(*reinterpret_cast<const uint8_t*>(data));
+        std::fill_n(reg, count, value);
+    } else if (dtype == ScalarType::Float) {
+        if (stride == sizeof(float)) {
+            std::memcpy(reg, data, count * sizeof(float));
+        } else {
+            for (const auto i : otter::irange(count)) {
+                reg[i] = *reinterpret_cast<const float*>(data + i * stride);
+            }
+        }
+    } else {
+        if (stride == sizeof(uint8_t)) {
+            vec::convert(reinterpret_cast<const uint8_t*>(data), reg, count);
+        } else {
+            for (const auto i : otter::irange(count)) {
+                reg[i] = static_cast<float>(*reinterpret_cast<const uint8_t*>(data + i * stride));
+            }
+        }
+    }
+}
+
+template <typename op_t>
+static inline void unary_block(float* dst, const float* a, int64_t vectors, const op_t& op) {
+    for (int64_t v = 0; v < vectors; ++v) {
+        op(Vec::loadu(a + v * Vec::size())).store(dst + v * Vec::size());
+    }
+}
+
+template <typename op_t>
+static inline void binary_block(float* dst, const float* a, const float* b, int64_t vectors, const op_t& op) {
+    for (int64_t v = 0; v < vectors; ++v) {
+        op(Vec::loadu(a + v * Vec::size()), Vec::loadu(b + v * Vec::size())).store(dst + v * Vec::size());
+    }
+}
+
+static void run_block(const ExprProgram& program, float (*registers)[EXPR_BLOCK], char** data, const int64_t* strides, int64_t count) {
+    const int64_t vectors = divup(count, Vec::size());
+    const Vec zero(0.f);
+    const Vec one(1.f);
+
+    for (const auto& instruction : program.code) {
+        float* dst = registers[instruction.dst];
+        const float* a = (instruction.op == ExprOp::Leaf) ? nullptr : registers[instruction.a];
+        const float* b = (instruction.b < 0) ? nullptr : registers[instruction.b];
+
+        switch (instruction.op) {
+            case ExprOp::Leaf: {
+                const int input = 1 + instruction.a;
+                load_block(dst, data[input], strides[input], program.leaves[instruction.a].scalar_type(), count);
+                break;
+            }
+            case ExprOp::Neg: unary_block(dst, a, vectors, [](Vec x) { return x.neg(); }); break;
+            case ExprOp::Abs: unary_block(dst, a, vectors, [](Vec x) { return x.abs(); }); break;
+            case ExprOp::Sqrt: unary_block(dst, a, vectors, [](Vec x) { return x.sqrt(); }); break;
+            case ExprOp::Rsqrt: unary_block(dst, a, vectors, [](Vec x) { return x.rsqrt(); }); break;
+            case ExprOp::Reciprocal: unary_block(dst, a, vectors, [](Vec x) { return x.reciprocal(); }); break;
+            case ExprOp::Exp: unary_block(dst, a, vectors, [](Vec x) { return x.exp(); }); break;
+            case ExprOp::Log: unary_block(dst, a, vectors, [](Vec x) { return x.log(); }); break;
+            case ExprOp::Tanh: unary_block(dst, a, vectors, [](Vec x) { return x.tanh(); }); break;
+            case ExprOp::Sigmoid: unary_block(dst, a, vectors, [&](Vec x) { return one / (one + x.neg().exp()); }); break;
+            case ExprOp::Relu: unary_block(dst, a, vectors, [&](Vec x) { return vec::maximum(x, zero); }); break;
+            case ExprOp::Add: binary_block(dst, a, b, vectors, [](Vec x, Vec y) { return x + y; }); break;
+            case ExprOp::Sub: binary_block(dst, a, b, vectors, [](Vec x, Vec y) { return x - y; }); break;
+            case ExprOp::Mul: binary_block(dst, a, b, vectors, [](Vec x, Vec y) { return x * y; }); break;
+            case ExprOp::Div: binary_block(dst, a, b, vectors, [](Vec x, Vec y) { return x / y; }); break;
+            case ExprOp::Maximum: binary_block(dst, a, b, vectors, [](Vec x, Vec y) { return vec::maximum(x, y); }); break;
+            case ExprOp::Minimum: binary_block(dst, a, b, vectors, [](Vec x, Vec y) { return vec::minimum(x, y); }); break;
+            case ExprOp::Constant: break;
+        }
+    }
+}
+
+}   // end anonymous namespace
+
+static DimVector broadcast_shape(const ExprProgram& program) {
+    DimVector shape(program.leaves[0].sizes());
+    for (const auto i : otter::irange(1, program.leaves.size())) {
+        shape = infer_size_dimvector(shape, program.leaves[i].sizes());
+    }
+    return shape;
+}
+
+static void evaluate_program(const ExprProgram& program, Tensor& out) {
+    auto config = TensorIteratorConfig();
+    config.add_output(out).check_all_same_dtype(false).resize_outputs(false);
+    for (const auto& leaf : program.leaves) {
+        config.add_input(leaf);
+    }
+    auto iter = config.build();
+
+    iter.for_each([&](char** base, const int64_t* strides, int64_t size0, int64_t size1) {
+        const int ntensors = static_cast<int>(program.leaves.size()) + 1;
+        const int64_t* outer_strides = &strides[ntensors];
+
+        __otter_align__ float registers[EXPR_MAX_REGISTERS][EXPR_BLOCK];
+        std::memset(registers, 0, program.registers * sizeof(registers[0]));
+        for (const auto& constant : program.constants) {
+            std::fill_n(registers[constant.first], EXPR_BLOCK, constant.second);
+        }
+
+        SmallVector<char*, 4> data(base, base + ntensors);
+        SmallVector<char*, 4> block(ntensors);
+        for (const auto j : otter::irange(size1)) {
+            (void)j;
+            for (int64_t i0 = 0; i0 < size0; i0 += EXPR_BLOCK) {
+                const int64_t count = std::min(EXPR_BLOCK, size0 - i0);
+                for (const auto arg : otter::irange(ntensors)) {
+                    block[arg] = data[arg] + i0 * strides[arg];
+                }
+
+                run_block(program, registers, block.data(), strides, count);
+
+                const float* result = registers[program.result];
+                if (strides[0] == sizeof(float)) {
+                    std::memcpy(block[0], result, count * sizeof(float));
+                } else {
+                    for (const auto i : otter::irange(count)) {
+                        *reinterpret_cast<float*>(block[0] + i * strides[0]) = result[i];
+                    }
+                }
+            }
+            for (const auto arg : otter::irange(ntensors)) {
+                data[arg] += outer_strides[arg];
+            }
+        }
+    });
+}
+
+Tensor LazyTensor::evaluate() const {
+    ExprProgram program = ExprCompiler().compile(node_);
+    OTTER_CHECK(!program.leaves.empty(), "[LazyTensor] Expect at least one tensor in the expression");
+
+    Tensor out = otter::empty(broadcast_shape(program), ScalarType::Float);
+    evaluate_program(program, out);
+
+    return out;
+}
+
+Tensor& LazyTensor::evaluate_out(Tensor& out) const {
+    ExprProgram program = ExprCompiler().compile(node_);
+    OTTER_CHECK(!program.leaves.empty(), "[LazyTensor] Expect at least one tensor in the expression");
+    OTTER_CHECK(out.scalar_type() == ScalarType::Float, "[LazyTensor] Expect float output but get ", toString(out.scalar_type()));
+    OTTER_CHECK(out.sizes().equals(broadcast_shape(program)), "[LazyTensor] Output shape does not match the broadcast shape");
+
+    evaluate_program(program, out);
+
+    return out;
+}
+
+}   // end namespace otter
@@ -0,0 +1,123 @@
+//
+//  LazyTensor.hpp
+//  Tensor
+//
+//  Created by 陳均豪 on 2022/3/22.
+//
+
+#ifndef LazyTensor_hpp
+#define LazyTensor_hpp
+
+#include <memory>
+
+#include "Tensor.hpp"
+
+namespace otter {
+
+enum class ExprOp {
+    Leaf,
+    Constant,
+    Neg,
+    Abs,
+    Sqrt,
+    Rsqrt,
+    Reciprocal,
+    Exp,
+    Log,
+    Tanh,
+    Sigmoid,
+    Relu,
+    Add,
+    Sub,
+    Mul,
+    Div,
+    Maximum,
+    Minimum
+};
+
+struct ExprNode {
+    ExprOp op;
+    Tensor tensor;      // Leaf
+    float value = 0;    // Constant
+    std::shared_ptr<const ExprNode> lhs;
+    std::shared_ptr<const ExprNode> rhs;
+};
+
+// Opt-in lazy elementwise math, the operators only record the expression
+// evaluate() compiles it into a small register program run over Vectorized<float> in one pass of TensorIterator
+// The tensor operands broadcast as usual, the result is a contiguous float tensor
+//
+//   Tensor y = ((otter::lazy(x) - mean) * scale).sqrt().evaluate();
+//   Tensor swish = (otter::lazy(x) * otter::lazy(x).sigmoid()).evaluate();
+class LazyTensor {
+public:
+    explicit LazyTensor(const Tensor& tensor);
+    explicit LazyTensor(float value);
+
+    LazyTensor neg() const;
+    LazyTensor abs() const;
+    LazyTensor sqrt() const;
+    LazyTensor rsqrt() const;
+    LazyTensor reciprocal() const;
+    LazyTensor exp() const;
+    LazyTensor log() const;
+    LazyTensor tanh() const;
+    LazyTensor sigmoid() const;
+    LazyTensor relu() const;
+    LazyTensor maximum(const LazyTensor& other) const;
+    LazyTensor minimum(const LazyTensor& other) const;
+    LazyTensor clamp(float min, float max) const;
+
+    Tensor evaluate() const;
+    // out has the broadcast shape
+    Tensor& evaluate_out(Tensor& out) const;
+
+    const std::shared_ptr<const ExprNode>& node() const { return node_; }
+
+    static LazyTensor make(ExprOp op, const LazyTensor& lhs);
+    static LazyTensor make(ExprOp op, const LazyTensor& lhs, const LazyTensor& rhs);
+
+private:
+    explicit LazyTensor(std::shared_ptr<const ExprNode> node) : node_(std::move(node)) {}
+
+    std::shared_ptr<const ExprNode> node_;
+};
+
+static inline LazyTensor lazy(const Tensor& tensor) {
+    return LazyTensor(tensor);
+}
+
+#define AT_FORALL_LAZY_BINARY_OPS(_) \
+_(+, Add) \
+_(-, Sub) \
+_(*, Mul) \
+_(/, Div)
+
+#define DEFINE_LAZY_OPERATOR(op, expr_op) \
+static inline LazyTensor operator op(const LazyTensor& x, const LazyTensor& y) { \
+    return LazyTensor::make(ExprOp::expr_op, x, y); \
+} \
+static inline LazyTensor operator op(const LazyTensor& x, const Tensor& y) { \
+    return LazyTensor::make(ExprOp::expr_op, x, LazyTensor(y)); \
+} \
+static inline LazyTensor operator op(const Tensor& x, const LazyTensor& y) { \
+    return LazyTensor::make(ExprOp::expr_op, LazyTensor(x), y); \
+} \
+static inline LazyTensor operator op(const LazyTensor& x, float y) { \
+    return LazyTensor::make(ExprOp::expr_op, x, LazyTensor(y)); \
+} \
+static inline LazyTensor operator op(float x, const LazyTensor& y) { \
+    return LazyTensor::make(ExprOp::expr_op, LazyTensor(x), y); \
+}
+
+AT_FORALL_LAZY_BINARY_OPS(DEFINE_LAZY_OPERATOR)
+#undef DEFINE_LAZY_OPERATOR
+#undef AT_FORALL_LAZY_BINARY_OPS
+
+static inline LazyTensor operator-(const LazyTensor& x) {
+    return x.neg();
+}
+
+}   // end namespace otter
+
+#endif /* LazyTensor_hpp */
@@ -231,6 +231,297 @@ void max_pool2d_kernel(
     }
 }
 
+// Separable max pooling, the row pass reduces each input row to {output_width}
+// then the column pass reduces kH of them, both are vectorized across the width
+// The padding is implicit, the out of bound elements are just skipped
+template <typename scalar_t>
+void cpu_max_pool_implicit_pad_impl(
+    const Tensor& output_,
+    const Tensor& input_,
+    int kW, int kH,
+    int dW, int dH,
+    int padW, int padH) {
+    
+    using Vec = vec::Vectorized<scalar_t>;
+    
+    auto input = input_.contiguous();
+    auto output = output_.contiguous();
+    
+    auto input_data = input.data_ptr<scalar_t>();
+    auto output_data = output.data_ptr<scalar_t>();
+    
+    int64_t ndim = input.dim();
+    // treat batch size and channels as one dimension
+    int64_t channels = ndim == 3 ? input.size(0) : input.size(0) * input.size(1);
+    int64_t input_height = input.size(-2);
+    int64_t input_width = input.size(-1);
+    int64_t output_height = output.size(-2);
+    int64_t output_width = output.size(-1);
+    
+    // The output columns whose window is fully inside the input, i.e. ow * dW - padW + kW <= input_width
+    // The span is negative when the kernel is wider than the input, there is no inner column then
+    const int64_t ow_inner_begin = std::min(divup(padW, dW), output_width);
+    const int64_t ow_inner_span = input_width - kW + padW;
+    const int64_t ow_inner_end = (ow_inner_span < 0) ? ow_inner_begin : std::max(std::min(ow_inner_span / dW + 1, output_width), ow_inner_begin);
+    
+    otter::parallel_for(0, channels, 0, [&](int64_t begin, int64_t end) {
+        std::vector<scalar_t> row_buffer(input_height * output_width);
+        
+        for (const auto c : otter::irange(begin, end)) {
+            const scalar_t* input_ptr = input_data + c * input_height * input_width;
+            scalar_t* output_ptr = output_data + c * output_height * output_width;
+            
+            // Pass I: max along the width
+            for (const auto ih : otter::irange(input_height)) {
+                const scalar_t* in = input_ptr + ih * input_width;
+                scalar_t* row = row_buffer.data() + ih * output_width;
+                
+                auto clipped_max = [&](int64_t ow) {
+                    int64_t iw0 = ow * dW - padW;
+                    int64_t iw1 = std::min(iw0 + kW, input_width);
+                    iw0 = std::max(iw0, (int64_t)0);
+                    scalar_t maxval = -std::numeric_limits<scalar_t>::infinity();
+                    for (int64_t iw = iw0; iw < iw1; ++iw) {
+                        maxval = std::max(maxval, in[iw]);
+                    }
+                    row[ow] = maxval;
+                };
+                
+                for (int64_t ow = 0; ow < ow_inner_begin; ++ow) {
+                    clipped_max(ow);
+                }
+                
+                int64_t ow = ow_inner_begin;
+                if (dW == 1) {
+                    for (; ow + Vec::size() <= ow_inner_end; ow += Vec::size()) {
+                        const scalar_t* window = in + ow - padW;
+                        Vec maxval = Vec::loadu(window);
+                        for (int kw = 1; kw < kW; ++kw) {
+                            maxval = vec::maximum(maxval, Vec::loadu(window + kw));
+                        }
+                        maxval.store(row + ow);
+                    }
+                }
+                for (; ow < ow_inner_end; ++ow) {
+                    const scalar_t* window = in + ow * dW - padW;
+                    scalar_t maxval = window[0];
+                    for (int kw = 1; kw < kW; ++kw) {
+                        maxval = std::max(maxval, window[kw]);
+                    }
+                    row[ow] = maxval;
+                }
+                
+                for (ow = ow_inner_end; ow < output_width; ++ow) {
+                    clipped_max(ow);
+                }
+            }
+            
+            // Pass II: max along the height over the reduced rows
+            // The rows are clipped like the columns in clipped_max, the window is never empty
+            // since both the top and the bottom padding are smaller than kH
+            for (const auto oh : otter::irange(output_height)) {
+                int64_t ih0 = oh * dH - padH;
+                int64_t ih1 = std::min(ih0 + kH, input_height);
+                ih0 = std::max(ih0, (int64_t)0);
+                
+                scalar_t* out = output_ptr + oh * output_width;
+                const scalar_t* first = row_buffer.data() + ih0 * output_width;
+                
+                int64_t ow = 0;
+                for (; ow + Vec::size() <= output_width; ow += Vec::size()) {
+                    Vec maxval = Vec::loadu(first + ow);
+                    for (int64_t ih = ih0 + 1; ih < ih1; ++ih) {
+                        maxval = vec::maximum(maxval, Vec::loadu(row_buffer.data() + ih * output_width + ow));
+                    }
+                    maxval.store(out + ow);
+                }
+                for (; ow < output_width; ++ow) {
+                    scalar_t maxval = first[ow];
+                    for (int64_t ih = ih0 + 1; ih < ih1; ++ih) {
+                        maxval = std::max(maxval, row_buffer[ih * output_width + ow]);
+                    }
+                    out[ow] = maxval;
+                }
+            }
+        }
+    });
+    
+    if (!output_.is_contiguous()) {
+        output_.copy_(output);
+    }
+}
+
+// The channels last input is vectorized across the channels, the window is clipped to the input
+template <typename scalar_t>
+void cpu_max_pool_implicit_pad_channels_last_impl(
+    const Tensor& output_,
+    const Tensor& input_,
+    int kW, int kH,
+    int dW, int dH,
+    int padW, int padH) {
+    
+    using Vec = vec::Vectorized<scalar_t>;
+    
+    auto input = input_.contiguous(MemoryFormat::ChannelsLast);
+    auto output = output_.contiguous(MemoryFormat::ChannelsLast);
+    
+    auto input_data = input.data_ptr<scalar_t>();
+    auto output_data = output.data_ptr<scalar_t>();
+    
+    int64_t nbatch = input.size(0);
+    int64_t channels = input.size(1);
+    int64_t input_height = input.size(2);
+    int64_t input_width = input.size(3);
+    int64_t output_height = output.size(2);
+    int64_t output_width = output.size(3);
+    
+    otter::parallel_for(0, nbatch * output_height, 0, [&](int64_t begin, int64_t end) {
+        for (const auto index : otter::irange(begin, end)) {
+            const int64_t n = index / output_height;
+            const int64_t oh = index % output_height;
+            
+            int64_t ih0 = oh * dH - padH;
+            int64_t ih1 = std::min(ih0 + kH, input_height);
+            ih0 = std::max(ih0, (int64_t)0);
+            
+            const scalar_t* input_ptr = input_data + n * input_height * input_width * channels;
+            scalar_t* output_ptr = output_data + index * output_width * channels;
+            
+            for (const auto ow : otter::irange(output_width)) {
+                int64_t iw0 = ow * dW - padW;
+                int64_t iw1 = std::min(iw0 + kW, input_width);
+                iw0 = std::max(iw0, (int64_t)0);
+                
+                scalar_t* out = output_ptr + ow * channels;
+                const scalar_t* first = input_ptr + (ih0 * input_width + iw0) * channels;
+                
+                int64_t c = 0;
+                for (; c + Vec::size() <= channels; c += Vec::size()) {
+                    Vec maxval = Vec::loadu(first + c);
+                    for (int64_t ih = ih0; ih < ih1; ++ih) {
+                        for (int64_t iw = iw0; iw < iw1; ++iw) {
+                            maxval = vec::maximum(maxval, Vec::loadu(input_ptr + (ih * input_width + iw) * channels + c));
+                        }
+                    }
+                    maxval.store(out + c);
+                }
+                for (; c < channels; ++c) {
+                    scalar_t maxval = first[c];
+                    for (int64_t ih = ih0; ih < ih1; ++ih) {
+                        for (int64_t iw = iw0; iw < iw1; ++iw) {
+                            maxval = std::max(maxval, input_ptr[(ih * input_width + iw) * channels + c]);
+                        }
+                    }
+                    out[c] = maxval;
+                }
+            }
+        }
+    });
+    
+    if (!output_.is_contiguous(MemoryFormat::ChannelsLast)) {
+        output_.copy_(output);
+    }
+}
+
+// The same separable pooling on the channel blocked input {N, C / elempack, H, W, elempack}
+// where every pixel is one vector of elempack channels
+void cpu_max_pool_implicit_pad_packed_impl(
+    const Tensor& output_,
+    const Tensor& input_,
+    int kW, int kH,
+    int dW, int dH,
+    int padW, int padH) {
+    
+    using Vec = vec::Vectorized<float>;
+    
+    OTTER_CHECK(input_.scalar_type() == ScalarType::Float && input_.size(4) == Vec::size(), "max_pool2d_implicit_pad: Expect packed float input with elempack ", Vec::size(), " but get ", input_.sizes());
+    
+    auto input = input_.contiguous();
+    auto output = output_.contiguous();
+    
+    auto input_data = input.data_ptr<float>();
+    auto output_data = output.data_ptr<float>();
+    
+    int64_t planes = input.size(0) * input.size(1);
+    int64_t input_height = input.size(2);
+    int64_t input_width = input.size(3);
+    int64_t output_height = output.size(2);
+    int64_t output_width = output.size(3);
+    
+    otter::parallel_for(0, planes, 0, [&](int64_t begin, int64_t end) {
+        std::vector<float> row_buffer(input_height * output_width * Vec::size());
+        
+        for (const auto c : otter::irange(begin, end)) {
+            const float* input_ptr = input_data + c * input_height * input_width * Vec::size();
+            float* output_ptr = output_data + c * output_height * output_width * Vec::size();
+            
+            // Pass I: max along the width
+            for (const auto ih : otter::irange(input_height)) {
+                const float* in = input_ptr + ih * input_width * Vec::size();
+                float* row = row_buffer.data() + ih * output_width * Vec::size();
+                
+                for (const auto ow : otter::irange(output_width)) {
+                    int64_t iw0 = ow * dW - padW;
+                    int64_t iw1 = std::min(iw0 + kW, input_width);
+                    iw0 = std::max(iw0, (int64_t)0);
+                    
+                    Vec maxval = Vec::loadu(in + iw0 * Vec::size());
+                    for (int64_t iw = iw0 + 1; iw < iw1; ++iw) {
+                        maxval = vec::maximum(maxval, Vec::loadu(in + iw * Vec::size()));
+                    }
+                    maxval.store(row + ow * Vec::size());
+                }
+            }
+            
+            // Pass II: max along the height over the reduced rows
+            for (const auto oh : otter::irange(output_height)) {
+                int64_t ih0 = oh * dH - padH;
+                int64_t ih1 = std::min(ih0 + kH, input_height);
+                ih0 = std::max(ih0, (int64_t)0);
+                
+                float* out = output_ptr + oh * output_width * Vec::size();
+                
+                for (const auto ow : otter::irange(output_width)) {
+                    Vec maxval = Vec::loadu(row_buffer.data() + (ih0 * output_width + ow) * Vec::size());
+                    for (int64_t ih = ih0 + 1; ih < ih1; ++ih) {
+                        maxval = vec::maximum(maxval, Vec::loadu(row_buffer.data() + (ih * output_width + ow) * Vec::size()));
+                    }
+                    maxval.store(out + ow * Vec::size());
+                }
+            }
+        }
+    });
+    
+    if (!output_.is_contiguous()) {
+        output_.copy_(output);
+    }
+}
+
+void max_pool2d_implicit_pad_kernel(
+    const Tensor& output,
+    const Tensor& input,
+    int kW, int kH,
+    int dW, int dH,
+    int padW, int padH) {
+    
+    if (input.dim() == 5) {
+        cpu_max_pool_implicit_pad_packed_impl(output, input, kW, kH, dW, dH, padW, padH);
+        return;
+    }
+    
+    if (input.dim() == 4 && input.suggest_memory_format() == MemoryFormat::ChannelsLast) {
+        OTTER_DISPATCH_FLOATING_TYPES(input.scalar_type(), "max_pool2d_implicit_pad_channels_last", [&] {
+            cpu_max_pool_implicit_pad_channels_last_impl<scalar_t>(output, input, kW, kH, dW, dH, padW, padH);
+        });
+        return;
+    }
+    
+    OTTER_DISPATCH_FLOATING_TYPES(input.scalar_type(), "max_pool2d_implicit_pad_cpu", [&] {
+        cpu_max_pool_implicit_pad_impl<scalar_t>(output, input, kW, kH, dW, dH, padW, padH);
+    });
+}
+
 REGISTER_DISPATCH(max_pool2d_stub, &max_pool2d_kernel);
+REGISTER_DISPATCH(max_pool2d_implicit_pad_stub, &max_pool2d_implicit_pad_kernel);
 
 }   // end namespace otter
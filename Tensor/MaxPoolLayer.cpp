@@ -8,7 +8,9 @@
 #include "MaxPoolLayer.hpp"
 #include "LayerRegistry.hpp"
 #include "Pool.hpp"
-#include "Padding.hpp"
+#include "TensorFunction.hpp"
+#include "TensorFactory.hpp"
+#include "TensorPacking.hpp"
 
 #include "TensorMaker.hpp"
 
@@ -17,6 +19,9 @@ namespace otter {
 MaxPoolLayer::MaxPoolLayer() {
     one_blob_only = true;
     support_inplace = false;
+    support_packing = true;
+    support_channels_last = true;
+    support_view_output = true;
 }
 
 int MaxPoolLayer::parse_param(LayerOption& option, ParamDict& pd) {
@@ -89,7 +94,7 @@ int MaxPoolLayer::compute_output_shape(ParamDict &pd) {
     
     if (darknet_mode) {
         out_height = (input_height + padding_height - kernel_height) / stride_height + 1;
-        out_width = (input_width + padding_width - kernel_width) / stride_height + 1;
+        out_width = (input_width + padding_width - kernel_width) / stride_width + 1;
     } else {
         out_height = pooling_output_shape(input_height, kernel_height, padding_height, stride_height, dilation_height, ceil_mode);
         out_width = pooling_output_shape(input_width, kernel_width, padding_width, stride_width, dilation_width, ceil_mode);
@@ -116,15 +121,29 @@ int MaxPoolLayer::load_param(const ParamDict &pd) {
 }
 
 int MaxPoolLayer::forward(const Tensor& bottom_blob, Tensor& top_blob, const NetOption& opt) const {
+    if (otter::is_packed(bottom_blob)) {
+        if (darknet_mode) {
+            int height_offset = padding_height / 2;
+            int width_offset = padding_width / 2;
+            
+            top_blob = otter::max_pool2d_implicit_pad(bottom_blob, {kernel_height, kernel_width}, {stride_height, stride_width}, {height_offset, padding_height - height_offset, width_offset, padding_width - width_offset});
+        } else if (dilation_height == 1 && dilation_width == 1 && !ceil_mode) {
+            top_blob = otter::max_pool2d_implicit_pad(bottom_blob, {kernel_height, kernel_width}, {stride_height, stride_width}, {padding_height, padding_height, padding_width, padding_width});
+        } else {
+            return forward(otter::from_packed(bottom_blob), top_blob, opt);
+        }
+        return 0;
+    }
+    
     if (darknet_mode) {
         if (opt.use_non_lib_optimize) {
             // TODO: darknet version pooling
         } else {
-            int height_offset = (kernel_height - 1) / 2;
-            int width_offset = (kernel_width - 1) / 2;
+            // darknet offsets the window by -padding / 2, the padding is skipped instead of materialized
+            int height_offset = padding_height / 2;
+            int width_offset = padding_width / 2;
             
-            auto bottom_blob_pad = otter::constant_pad(bottom_blob, {height_offset, kernel_height - height_offset - 1, width_offset, kernel_width - width_offset - 1}, -10000000);
-            top_blob = otter::max_pool2d(bottom_blob_pad, {kernel_height, kernel_width}, {stride_height, stride_width}, {0, 0}, {1, 1}, false);
+            top_blob = otter::max_pool2d_implicit_pad(bottom_blob, {kernel_height, kernel_width}, {stride_height, stride_width}, {height_offset, padding_height - height_offset, width_offset, padding_width - width_offset});
         }
     } else {
         if (opt.use_non_lib_optimize) {
@@ -136,6 +155,21 @@ int MaxPoolLayer::forward(const Tensor& bottom_blob, Tensor& top_blob, const Net
     return 0;
 }
 
+int MaxPoolLayer::forward_into(const Tensor& bottom_blob, Tensor& top_blob, const NetOption& opt) const {
+    if (darknet_mode) {
+        int height_offset = padding_height / 2;
+        int width_offset = padding_width / 2;
+        
+        otter::max_pool2d_implicit_pad_out(top_blob, bottom_blob, {kernel_height, kernel_width}, {stride_height, stride_width}, {height_offset, padding_height - height_offset, width_offset, padding_width - width_offset});
+    } else {
+        Tensor indices = otter::empty({0}, ScalarType::Long);
+        
+        otter::native::max_pool2d_with_indices_out(top_blob, indices, bottom_blob, {kernel_height, kernel_width}, {stride_height, stride_width}, {padding_height, padding_width}, {dilation_height, dilation_width}, ceil_mode);
+    }
+    
+    return 0;
+}
+
 REGISTER_LAYER_CLASS(MaxPool);
 
 }   // end namespace otter
@@ -24,6 +24,8 @@ public:
     
     virtual int forward(const Tensor& bottom_blob, Tensor& top_blob, const NetOption& opt) const;
     
+    virtual int forward_into(const Tensor& bottom_blob, Tensor& top_blob, const NetOption& opt) const;
+    
     virtual std::string type() const { return "MaxPool"; }
 private:
     int kernel_height;
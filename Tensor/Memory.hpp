@@ -217,6 +217,10 @@ public:
         return Memory(make_otterptr<MemoryNucleus>(0, allocator->allocate(0), allocator));
     }
     
+    size_t use_count() const noexcept {
+        return memory_nucleus_.use_count();
+    }
+    
     bool is_alias_of(const Memory& other) const {
         return memory_nucleus_ == other.memory_nucleus_;
     }
@@ -10,6 +10,14 @@
 #include "Net.hpp"
 #include "LayerRegistry.hpp"
 #include "Initializer.hpp"
+#include "TensorFactory.hpp"
+#include "TensorPacking.hpp"
+#include "ConvolutionFused.hpp"
+#include "ConvolutionInt8.hpp"
+#include "Calibration.hpp"
+#include "ConvolutionLayer.hpp"
+#include "BatchNormalizationLayer.hpp"
+#include "LReluLayer.hpp"
 
 namespace otter {
 
@@ -23,11 +31,15 @@ Net::~Net() {
 }
 
 void Net::init_blobs_and_layers(size_t blob_count, size_t layer_count) {
+    OTTER_CHECK(!in_use(), "[Net] The network is read-only after the Extractor is created");
+    
     blobs.resize((size_t)blob_count);
     layers.resize((size_t)layer_count);
 }
 
 void Net::addLayer(LayerOption option) {
+    OTTER_CHECK(!in_use(), "[Net] The network is read-only after the Extractor is created");
+    
     std::string type = opt_find_string(option, "type", "Undefined");
     
     // Check Relu bias
@@ -58,7 +70,13 @@ void Net::addLayer(LayerOption option) {
         layer_options.push_back(auto_option);
     }
     
-    if (opt_check_string(option, "activation")) {
+    // InnerProduct and ShortCut fuse the activation into their epilogue when there is no batchnorm in between
+    bool fused_activation = false;
+    if ((type == "InnerProduct" || type == "ShortCut") && opt_check_string(option, "activation") && !opt_check_string(option, "batchnorm")) {
+        fused_activation = (option["activation"] == "Relu" || option["activation"] == "LRelu");
+    }
+    
+    if (opt_check_string(option, "activation") && !fused_activation) {
         LayerOption auto_option;
         std::string activation = option["activation"];
         auto_option["type"] = activation;
@@ -143,7 +161,7 @@ void Net::graph_construct() {
                 size_t target_index = target_change_layer["input"].find(target_name);
                 if (target_index == std::string::npos)
                     target_index = 0;
-                target_change_layer["input"].replace(target_index, std::max(split_name.length(), target_name.length()), split_name);
+                target_change_layer["input"].replace(target_index, target_name.length(), split_name);
             }
             layer_options.insert(layer_options.begin() + i + 1, auto_opt);
             MAP_UPDATE
@@ -156,7 +174,99 @@ void Net::graph_construct() {
     }
 }
 
+// Return the kernel size of a stride 1 same size square MaxPool, 0 if the pool is not cascadable
+// The defaulting follows MaxPoolLayer::parse_param
+static int spp_cascade_kernel(LayerOption& option) {
+    std::string type = opt_find_string(option, "type", "Undefined");
+    if (type != "MaxPool")
+        return 0;
+    
+    int stride = opt_find_int(option, "stride", 1);
+    int stride_height = opt_find_int(option, "stride_h", stride);
+    int stride_width  = opt_find_int(option, "stride_w", stride);
+    int kernel = opt_find_int(option, "kernel", stride);
+    int kernel_height = opt_find_int(option, "kernel_h", kernel);
+    int kernel_width  = opt_find_int(option, "kernel_w", kernel);
+    int padding = opt_find_int(option, "padding", 0);
+    int padding_height = opt_find_int(option, "padding_h", padding);
+    int padding_width  = opt_find_int(option, "padding_w", padding);
+    int dilation = opt_find_int(option, "dilation", 1);
+    int dilation_height = opt_find_int(option, "dilation_h", dilation);
+    int dilation_width  = opt_find_int(option, "dilation_w", dilation);
+    bool darknet_mode = opt_check_string(option, "darknet_mode");
+    
+    if (stride_height != 1 || stride_width != 1 || dilation_height != 1 || dilation_width != 1)
+        return 0;
+    // Only the centered windows compose, max_k1(max_k2(x)) = max_(k1 + k2 - 1)(x)
+    if (kernel_height != kernel_width || kernel_height % 2 == 0)
+        return 0;
+    int same_padding = darknet_mode ? kernel_height - 1 : (kernel_height - 1) / 2;
+    if (padding_height != same_padding || padding_width != same_padding)
+        return 0;
+    
+    return kernel_height;
+}
+
+// SPP block runs several same size max pools with growing kernel on the same input
+// Rewire each pool to read the previous one with a smaller kernel, e.g. 5, 9, 13 -> 5, 5(5), 5(5(5))
+// so the cost no longer grows with the kernel size, the result is exact
+void Net::fuse_spp_cascade() {
+    // input name -> (kernel, output name) of the last pool in the cascade
+    std::unordered_map<std::string, std::pair<int, std::string>> cascade_map;
+    
+    for (const auto i : otter::irange(layer_options.size())) {
+        LayerOption& option = layer_options[i];
+        
+        int kernel = spp_cascade_kernel(option);
+        if (kernel == 0)
+            continue;
+        
+        std::string input_name;
+        if (opt_check_string(option, "input")) {
+            input_name = option["input"];
+        } else if (i > 0) {
+            std::stringstream bottom_list(layer_options[i - 1]["output"]);
+            std::getline(bottom_list, input_name, ',');
+        }
+        EARSE_SPACE(input_name);
+        if (input_name.empty() || input_name.find(',') != std::string::npos)
+            continue;
+        
+        std::string output_name;
+        std::stringstream top_list(option["output"]);
+        std::getline(top_list, output_name, ',');
+        EARSE_SPACE(output_name);
+        
+        auto cascade = cascade_map.find(input_name);
+        if (cascade == cascade_map.end()) {
+            option["input"] = input_name;
+            cascade_map[input_name] = {kernel, output_name};
+            continue;
+        }
+        
+        int previous_kernel = cascade->second.first;
+        if (kernel <= previous_kernel)
+            continue;
+        
+        int residual_kernel = kernel - previous_kernel + 1;
+        bool darknet_mode = opt_check_string(option, "darknet_mode");
+        
+        option["input"] = cascade->second.second;
+        option["kernel"] = std::to_string(residual_kernel);
+        option["padding"] = std::to_string(darknet_mode ? residual_kernel - 1 : (residual_kernel - 1) / 2);
+        option.erase("kernel_h");
+        option.erase("kernel_w");
+        option.erase("padding_h");
+        option.erase("padding_w");
+        
+        cascade->second = {kernel, output_name};
+    }
+}
+
 void Net::compile(CompileMode comopile_mode) {
+    OTTER_CHECK(!in_use(), "[Net] The network is read-only after the Extractor is created");
+    
+    this->fuse_spp_cascade();
     
     if (option.lightmode) {
         graph_construct();
@@ -273,6 +383,327 @@ void Net::compile(CompileMode comopile_mode) {
     
     this->update_input_output_indexes();
     this->update_input_output_names();
+    this->plan_concat_views();
+    this->plan_fused_chains();
+    this->plan_int8_stages();
+    this->plan_fp16_storage();
+}
+
+void Net::plan_concat_views() {
+    concat_views.clear();
+    concat_views.resize(layers.size());
+    blob_is_view.assign(blobs.size(), false);
+    
+    std::vector<bool> planned(blobs.size(), false);
+    
+    // Visit the outer Concat first, then the nested one can be written into it as well
+    for (int i = (int)layers.size() - 1; i >= 0; --i) {
+        const Layer* layer = layers[i];
+        if (layer->type() != "Concat")
+            continue;
+        
+        int axis = opt_find_int(layer_options[i], "axis", 1);
+        const Tensor& top_shape = blobs[layer->tops[0]].shape;
+        // Only the channel slice of the single batch output is contiguous
+        if (axis != 1 || !top_shape.defined() || top_shape.numel() != 4 || top_shape.accessor<int, 1>()[0] != 1)
+            continue;
+        
+        int64_t offset = 0;
+        for (const auto bottom_blob_index : layer->bottoms) {
+            int source_blob_index = bottom_blob_index;
+            int producer_index = blobs[source_blob_index].producer;
+            
+            // See through the auto inserted Split, all its tops are the same tensor
+            if (producer_index != -1 && layers[producer_index]->type() == "Split") {
+                source_blob_index = layers[producer_index]->bottoms[0];
+                producer_index = blobs[source_blob_index].producer;
+            }
+            
+            if (producer_index != -1 && !planned[source_blob_index]) {
+                const Layer* producer = layers[producer_index];
+                // The multi input in-place layer prefers the view at runtime, see do_forward_layer()
+                if (producer->support_view_output && (!producer->support_inplace || !producer->one_blob_only) && producer->tops.size() == 1) {
+                    concat_views[i].push_back({source_blob_index, offset});
+                    planned[source_blob_index] = true;
+                }
+            }
+            
+            offset += blobs[bottom_blob_index].shape.accessor<int, 1>()[1];
+        }
+        
+        if (concat_views[i].empty())
+            continue;
+        
+        // The in-place layer should not write into the shared memory
+        blob_is_view[layer->tops[0]] = true;
+        for (const auto& view : concat_views[i]) {
+            blob_is_view[view.blob] = true;
+            
+            int consumer_index = blobs[view.blob].consumer;
+            if (consumer_index != -1 && layers[consumer_index]->type() == "Split") {
+                for (const auto top_blob_index : layers[consumer_index]->tops) {
+                    blob_is_view[top_blob_index] = true;
+                }
+            }
+        }
+    }
+}
+
+void Net::prepare_concat_views(int layer_end, const std::vector<Tensor>& blob_tensors, std::vector<Tensor>& blob_views) const {
+    // Only the Concat before the target layer can be its ancestor
+    for (int i = layer_end; i >= 0; --i) {
+        if (concat_views[i].empty())
+            continue;
+        
+        int top_blob_index = layers[i]->tops[0];
+        if (blob_tensors[top_blob_index].defined())
+            continue;
+        
+        Tensor& output = blob_views[top_blob_index];
+        if (!output.defined()) {
+            auto shape_a = blobs[top_blob_index].shape.accessor<int, 1>();
+            output = otter::empty({shape_a[0], shape_a[1], shape_a[2], shape_a[3]}, ScalarType::Float);
+        }
+        
+        for (const auto& view : concat_views[i]) {
+            if (blob_tensors[view.blob].defined() || blob_views[view.blob].defined())
+                continue;
+            
+            int64_t channels = blobs[view.blob].shape.accessor<int, 1>()[1];
+            blob_views[view.blob] = output.slice(1, view.offset, view.offset + channels);
+        }
+    }
+}
+
+std::vector<int> Net::count_consumers() const {
+    std::vector<int> consumer_count(blobs.size(), 0);
+    for (const Layer* layer : layers) {
+        for (const auto bottom_blob_index : layer->bottoms) {
+            consumer_count[bottom_blob_index]++;
+        }
+    }
+    
+    return consumer_count;
+}
+
+// The top blob can be hidden inside the fused layers only when the next layer is its only consumer
+int Net::next_layer(int layer_index, const std::vector<int>& consumer_count) const {
+    const Layer* layer = layers[layer_index];
+    if (layer->tops.size() != 1)
+        return -1;
+    
+    int top_blob_index = layer->tops[0];
+    if (consumer_count[top_blob_index] != 1 || blob_is_view[top_blob_index])
+        return -1;
+    
+    int consumer_index = blobs[top_blob_index].consumer;
+    return (consumer_index != -1 && layers[consumer_index]->one_blob_only) ? consumer_index : -1;
+}
+
+bool Net::is_layer_type(int layer_index, const char* type) const {
+    if (layer_index == -1)
+        return false;
+    
+    auto layer_type = layer_options[layer_index].find("type");
+    return layer_type != layer_options[layer_index].end() && layer_type->second == type;
+}
+
+// Take the convolution with its trailing batchnorm and activation, return the last layer of the stage
+int Net::match_stage(int layer_index, const std::vector<int>& consumer_count, FusedStage& stage) const {
+    stage.convolution = layer_index;
+    stage.batchnorm = -1;
+    stage.activation = -1;
+    
+    int last = layer_index;
+    int next = next_layer(last, consumer_count);
+    if (is_layer_type(next, "BatchNormalization")) {
+        stage.batchnorm = next;
+        last = next;
+        next = next_layer(last, consumer_count);
+    }
+    if (is_layer_type(next, "LRelu")) {
+        stage.activation = next;
+        last = next;
+    }
+    
+    return last;
+}
+
+void Net::plan_fused_chains() {
+    fused_chains.clear();
+    fused_chain_end.assign(layers.size(), -1);
+    
+    std::vector<int> consumer_count = count_consumers();
+    
+    auto is_float_convolution = [&](int layer_index) {
+        if (!is_layer_type(layer_index, "Convolution"))
+            return false;
+        const ConvolutionLayer* conv = static_cast<const ConvolutionLayer*>(layers[layer_index]);
+        
+        return !conv->int8_scale_term && !conv->bf16_term;
+    };
+    
+    auto is_pointwise = [&](int layer_index) {
+        if (!is_float_convolution(layer_index))
+            return false;
+        const ConvolutionLayer* conv = static_cast<const ConvolutionLayer*>(layers[layer_index]);
+        
+        return conv->groups == 1 && conv->kernel_height == 1 && conv->kernel_width == 1 && conv->stride_height == 1 && conv->stride_width == 1 && conv->padding_height == 0 && conv->padding_width == 0;
+    };
+    
+    auto is_depthwise = [&](int layer_index) {
+        if (!is_float_convolution(layer_index))
+            return false;
+        const ConvolutionLayer* conv = static_cast<const ConvolutionLayer*>(layers[layer_index]);
+        
+        return conv->groups == conv->in_channels && conv->groups == conv->out_channels && conv->dilation_height == 1 && conv->dilation_width == 1;
+    };
+    
+    int layer_index = 0;
+    while (layer_index < (int)layers.size()) {
+        FusedChain chain;
+        int last = layer_index;
+        
+        if (is_pointwise(layer_index)) {
+            last = match_stage(layer_index, consumer_count, chain.stages[0]);
+            
+            int depthwise = next_layer(last, consumer_count);
+            if (is_depthwise(depthwise)) {
+                last = match_stage(depthwise, consumer_count, chain.stages[1]);
+                
+                int project = next_layer(last, consumer_count);
+                if (is_pointwise(project)) {
+                    last = match_stage(project, consumer_count, chain.stages[2]);
+                    
+                    chain.bottom_blob = layers[layer_index]->bottoms[0];
+                    chain.top_blob = layers[last]->tops[0];
+                    fused_chain_end[last] = (int)fused_chains.size();
+                    fused_chains.push_back(chain);
+                    
+                    layer_index = last + 1;
+                    continue;
+                }
+            }
+        }
+        
+        layer_index++;
+    }
+}
+
+void Net::plan_int8_stages() {
+    int8_stages.clear();
+    int8_stage_end.assign(layers.size(), -1);
+    
+    std::vector<int> consumer_count = count_consumers();
+    
+    auto is_int8_convolution = [&](int layer_index) {
+        return is_layer_type(layer_index, "Convolution") && static_cast<const ConvolutionLayer*>(layers[layer_index])->int8_scale_term;
+    };
+    
+    std::vector<int> stage_last;
+    for (const auto i : otter::irange(layers.size())) {
+        if (!is_int8_convolution((int)i))
+            continue;
+        
+        FusedStage stage;
+        int last = match_stage((int)i, consumer_count, stage);
+        int8_stage_end[last] = (int)int8_stages.size();
+        int8_stages.push_back(stage);
+        stage_last.push_back(last);
+    }
+    
+    // Keep the top blob in int8 when it only feeds the next int8 convolution
+    for (const auto i : otter::irange(int8_stages.size())) {
+        ConvolutionLayer* conv = static_cast<ConvolutionLayer*>(layers[int8_stages[i].convolution]);
+        conv->top_blob_int8_scale = 0;
+        
+        int top_blob_index = layers[stage_last[i]]->tops[0];
+        int consumer_index = blobs[top_blob_index].consumer;
+        if (consumer_count[top_blob_index] == 1 && !blob_is_view[top_blob_index] && is_int8_convolution(consumer_index)) {
+            conv->top_blob_int8_scale = static_cast<const ConvolutionLayer*>(layers[consumer_index])->bottom_blob_int8_scale;
+        }
+    }
+}
+
+int Net::load_int8_scales(const char* table_path) {
+    std::map<std::string, std::vector<float>> table;
+    if (otter::read_int8_scale_table(table_path, table) != 0)
+        return -1;
+    
+    return load_int8_scales(table);
+}
+
+int Net::load_int8_scales(const std::map<std::string, std::vector<float>>& table) {
+    if (in_use()) {
+        fprintf(stderr, "[Net] The network is read-only after the Extractor is created!\n");
+        return -1;
+    }
+    
+    for (const auto i : otter::irange(layers.size())) {
+        if (!is_layer_type((int)i, "Convolution"))
+            continue;
+        
+        ConvolutionLayer* conv = static_cast<ConvolutionLayer*>(layers[i]);
+        auto bottom_scale = table.find(conv->name);
+        if (conv->int8_scale_term || bottom_scale == table.end() || bottom_scale->second.size() != 1)
+            continue;
+        
+        Tensor weight_scale;
+        auto weight_scale_line = table.find(conv->name + "_param_0");
+        if (weight_scale_line != table.end()) {
+            const std::vector<float>& scales = weight_scale_line->second;
+            if ((int)scales.size() != conv->out_channels) {
+                fprintf(stderr, "[Net] layer %s expect %d weight scales but get %d!\n", conv->name.c_str(), conv->out_channels, (int)scales.size());
+                return -1;
+            }
+            weight_scale = otter::empty({(int64_t)scales.size()}, ScalarType::Float);
+            std::copy(scales.begin(), scales.end(), weight_scale.data_ptr<float>());
+        }
+        
+        // The unsupported convolution stays in float
+        conv->quantize_int8(bottom_scale->second[0], weight_scale);
+    }
+    
+    this->plan_int8_stages();
+    this->plan_fused_chains();
+    
+    return 0;
+}
+
+// The blob consumed by the next layer is read while it is still in cache, narrowing it only adds the conversion
+// The blob consumed later (e.g. the route and shortcut of darknet) stays in memory for a while, half of it is saved
+void Net::plan_fp16_storage() {
+    blob_fp16_storage.assign(blobs.size(), false);
+    
+    auto consumer_count = count_consumers();
+    for (const auto i : otter::irange(blobs.size())) {
+        const Blob& blob = blobs[i];
+        if (blob.producer == -1 || blob.consumer == -1 || blob_is_view[i])
+            continue;
+        // The input is given by the user
+        if (is_layer_type(blob.producer, "Input"))
+            continue;
+        
+        blob_fp16_storage[i] = consumer_count[i] > 1 || blob.consumer > blob.producer + 1;
+    }
+}
+
+bool Net::match_static_shape(const Layer* layer, const std::vector<Tensor>& blob_tensors) const {
+    for (const auto bottom_blob_index : layer->bottoms) {
+        const Tensor& bottom_blob = blob_tensors[bottom_blob_index];
+        const Tensor& shape = blobs[bottom_blob_index].shape;
+        
+        if (!shape.defined() || bottom_blob.scalar_type() != ScalarType::Float || bottom_blob.dim() != shape.numel())
+            return false;
+        
+        auto shape_a = shape.accessor<int, 1>();
+        for (const auto d : otter::irange(bottom_blob.dim())) {
+            if (bottom_blob.size(d) != shape_a[d])
+                return false;
+        }
+    }
+    
+    return true;
 }
 
 int Net::find_blob_index_by_name(std::string name) const {
@@ -334,23 +765,35 @@ void Net::summary() {
     printf("=============================================================\n");
     for (const auto i : otter::irange(blobs.size())) {
         auto shape_a = blobs[i].shape.accessor<int, 1>();
-        int n = shape_a[0];
-        int c = shape_a[1];
-        int h = shape_a[2];
-        int w = shape_a[3];
-        printf("Blob %-2d name: %-10s producer: %-2d consumer: %-2d shape: (%d, %d, %d, %d)\n", (int)i, blobs[i].name.c_str(), blobs[i].producer, blobs[i].consumer, n, c, h, w);
+        std::string shape_str;
+        for (const auto d : otter::irange(blobs[i].shape.size(0))) {
+            if (d > 0)
+                shape_str += ", ";
+            shape_str += std::to_string(shape_a[d]);
+        }
+        printf("Blob %-2d name: %-10s producer: %-2d consumer: %-2d shape: (%s)\n", (int)i, blobs[i].name.c_str(), blobs[i].producer, blobs[i].consumer, shape_str.c_str());
     }
     printf("=============================================================\n");
 }
 
-int Net::forward_layer(int layer_index, std::vector<Tensor>& blob_tensors, const NetOption& opt) const {
+int Net::forward_layer(int layer_index, std::vector<Tensor>& blob_tensors, std::vector<Tensor>& blob_views, const NetOption& opt) const {
+    // The int8 convolution runs with its batchnorm and activation in the epilogue
+    if (int8_stage_end[layer_index] != -1) {
+        return forward_int8_stage(int8_stage_end[layer_index], blob_tensors, blob_views, opt);
+    }
+    
+    // The whole chain is computed from its bottom blob at once
+    if (opt.use_fused_tiling && !opt.use_packing_layout && !opt.use_channels_last && fused_chain_end[layer_index] != -1) {
+        return forward_fused_chain(fused_chain_end[layer_index], blob_tensors, blob_views, opt);
+    }
+    
     const Layer* layer = layers[layer_index];
     
     if (layer->one_blob_only) {
         int bottom_blob_index = layer->bottoms[0];
         
         if (!blob_tensors[bottom_blob_index].defined()) {
-            int ret = forward_layer(blobs[bottom_blob_index].producer, blob_tensors, opt);
+            int ret = forward_layer(blobs[bottom_blob_index].producer, blob_tensors, blob_views, opt);
             if (ret != 0)
                 return ret;
         }
@@ -359,21 +802,181 @@ int Net::forward_layer(int layer_index, std::vector<Tensor>& blob_tensors, const
             int bottom_blob_index = layer->bottoms[i];
 
             if (!blob_tensors[bottom_blob_index].defined()) {
-                int ret = forward_layer(blobs[bottom_blob_index].producer, blob_tensors, opt);
+                int ret = forward_layer(blobs[bottom_blob_index].producer, blob_tensors, blob_views, opt);
                 if (ret != 0)
                     return ret;
             }
         }
     }
     
-    int ret = do_forward_layer(layer, blob_tensors, opt);
+    // The layer reuses its own iterator of the Extractor
+    NetOption layer_opt = opt;
+    layer_opt.prepared_iterator = (opt.prepared_iterators) ? &opt.prepared_iterators[layer_index] : nullptr;
+    
+    int ret = do_forward_layer(layer, blob_tensors, blob_views, layer_opt);
     if (ret != 0)
             return ret;
     
+    for (const auto top_blob_index : layer->tops) {
+        store_fp16_blob(top_blob_index, blob_tensors, opt);
+    }
+    
+    // Release the views of the producers which are not written into the output
+    for (const auto& view : concat_views[layer_index]) {
+        blob_views[view.blob].reset();
+    }
+    
+    return 0;
+}
+
+int Net::forward_fused_chain(int chain_index, std::vector<Tensor>& blob_tensors, std::vector<Tensor>& blob_views, const NetOption& opt) const {
+    const FusedChain& chain = fused_chains[chain_index];
+    
+    if (!blob_tensors[chain.bottom_blob].defined()) {
+        int ret = forward_layer(blobs[chain.bottom_blob].producer, blob_tensors, blob_views, opt);
+        if (ret != 0)
+            return ret;
+    }
+    
+    ConvolutionFusedStage stages[3];
+    for (const auto i : otter::irange(3)) {
+        const FusedStage& fused = chain.stages[i];
+        const ConvolutionLayer* conv = static_cast<const ConvolutionLayer*>(layers[fused.convolution]);
+        stages[i].weight = conv->weight_data;
+        stages[i].bias = conv->bias_data;
+        
+        if (fused.batchnorm != -1) {
+            const BatchNormalizationLayer* batchnorm = static_cast<const BatchNormalizationLayer*>(layers[fused.batchnorm]);
+            stages[i].alpha = batchnorm->alpha;
+            stages[i].beta = batchnorm->beta;
+        }
+        if (fused.activation != -1) {
+            stages[i].activation = true;
+            stages[i].neg_slope = static_cast<const LReluLayer*>(layers[fused.activation])->neg_slope;
+        }
+    }
+    
+    const ConvolutionLayer* depthwise = static_cast<const ConvolutionLayer*>(layers[chain.stages[1].convolution]);
+    const Layer* first_layer = layers[chain.stages[0].convolution];
+    Tensor bottom_blob = blob_tensors[chain.bottom_blob];
+    if (bottom_blob.scalar_type() == ScalarType::Half) {
+        bottom_blob = bottom_blob.to(ScalarType::Float);
+    }
+    Tensor top_blob;
+    
+    // Write into the slice of Concat output directly
+    if (blob_views[chain.top_blob].defined()) {
+        if (match_static_shape(first_layer, blob_tensors)) {
+            top_blob = blob_views[chain.top_blob];
+            otter::depthwise_separable_convolution_fused_out(bottom_blob, stages[0], stages[1], {depthwise->kernel_height, depthwise->kernel_width}, {depthwise->stride_height, depthwise->stride_width}, {depthwise->padding_height, depthwise->padding_width}, stages[2], top_blob);
+        }
+        blob_views[chain.top_blob].reset();
+    }
+    
+    if (!top_blob.defined()) {
+        top_blob = otter::depthwise_separable_convolution_fused(bottom_blob, stages[0], stages[1], {depthwise->kernel_height, depthwise->kernel_width}, {depthwise->stride_height, depthwise->stride_width}, {depthwise->padding_height, depthwise->padding_width}, stages[2]);
+    }
+    
+    blob_tensors[chain.top_blob] = top_blob;
+    store_fp16_blob(chain.top_blob, blob_tensors, opt);
+    
+    if (opt.lightmode) {
+        blob_tensors[chain.bottom_blob].reset();
+    }
+    
+    return 0;
+}
+
+int Net::forward_int8_stage(int stage_index, std::vector<Tensor>& blob_tensors, std::vector<Tensor>& blob_views, const NetOption& opt) const {
+    const FusedStage& stage = int8_stages[stage_index];
+    const ConvolutionLayer* conv = static_cast<const ConvolutionLayer*>(layers[stage.convolution]);
+    const int last = (stage.activation != -1) ? stage.activation : (stage.batchnorm != -1) ? stage.batchnorm : stage.convolution;
+    const int bottom_blob_index = conv->bottoms[0];
+    const int top_blob_index = layers[last]->tops[0];
+    
+    if (!blob_tensors[bottom_blob_index].defined()) {
+        int ret = forward_layer(blobs[bottom_blob_index].producer, blob_tensors, blob_views, opt);
+        if (ret != 0)
+            return ret;
+    }
+    
+    ConvolutionInt8Epilogue epilogue;
+    if (stage.batchnorm != -1) {
+        const BatchNormalizationLayer* batchnorm = static_cast<const BatchNormalizationLayer*>(layers[stage.batchnorm]);
+        epilogue.alpha = batchnorm->alpha;
+        epilogue.beta = batchnorm->beta;
+    }
+    if (stage.activation != -1) {
+        epilogue.activation = true;
+        epilogue.neg_slope = static_cast<const LReluLayer*>(layers[stage.activation])->neg_slope;
+    }
+    epilogue.output_scale = conv->top_blob_int8_scale;
+    
+    Tensor bottom_blob = blob_tensors[bottom_blob_index];
+    if (bottom_blob.scalar_type() == ScalarType::Half) {
+        bottom_blob = bottom_blob.to(ScalarType::Float);
+    } else if (opt.use_channels_last && bottom_blob.dim() == 4) {
+        bottom_blob = bottom_blob.contiguous();
+    }
+    
+    Tensor top_blob;
+    int ret = conv->forward_int8(bottom_blob, top_blob, epilogue);
+    if (ret != 0)
+        return ret;
+    
+    // The Concat copies the top blob instead
+    blob_views[top_blob_index].reset();
+    blob_tensors[top_blob_index] = top_blob;
+    store_fp16_blob(top_blob_index, blob_tensors, opt);
+    
+    if (opt.lightmode) {
+        blob_tensors[bottom_blob_index].reset();
+    }
+    
     return 0;
 }
 
-int Net::do_forward_layer(const Layer* layer, std::vector<Tensor>& blob_tensors, const NetOption& opt) const {
+// The in place layer can only write into the blob when nobody else can observe it
+// Split shares the tensor between its tops, and a view (e.g. reshape) shares the memory with another tensor
+static bool is_exclusive_blob(const Tensor& blob) {
+    if (blob.use_count() != 1)
+        return false;
+    
+    return !blob.has_memory() || blob.memory().use_count() == 1;
+}
+
+bool Net::is_packed_blob(int blob_index, const Tensor& blob) const {
+    const Tensor& shape = blobs[blob_index].shape;
+    
+    return otter::is_packed(blob) && shape.defined() && shape.numel() == 4;
+}
+
+void Net::store_fp16_blob(int blob_index, std::vector<Tensor>& blob_tensors, const NetOption& opt) const {
+    if (!opt.use_fp16_storage || opt.use_packing_layout || opt.use_channels_last || !blob_fp16_storage[blob_index])
+        return;
+    
+    Tensor& blob = blob_tensors[blob_index];
+    if (blob.defined() && blob.scalar_type() == ScalarType::Float) {
+        blob = blob.to(ScalarType::Half);
+    }
+}
+
+void Net::convert_layout(Tensor& bottom_blob, int bottom_blob_index, const Layer* layer, const NetOption& opt) const {
+    if (opt.use_packing_layout) {
+        if (layer->support_packing) {
+            int64_t elempack = otter::packing_elempack();
+            if (otter::can_pack(bottom_blob, elempack)) {
+                bottom_blob = otter::to_packed(bottom_blob, elempack);
+            }
+        } else if (is_packed_blob(bottom_blob_index, bottom_blob)) {
+            bottom_blob = otter::from_packed(bottom_blob);
+        }
+    } else if (opt.use_channels_last && bottom_blob.dim() == 4) {
+        bottom_blob = bottom_blob.contiguous((layer->support_channels_last) ? MemoryFormat::ChannelsLast : MemoryFormat::Contiguous);
+    }
+}
+
+int Net::do_forward_layer(const Layer* layer, std::vector<Tensor>& blob_tensors, std::vector<Tensor>& blob_views, const NetOption& opt) const {
     if (layer->one_blob_only) {
         int bottom_blob_index = layer->bottoms[0];
         int top_blob_index = layer->tops[0];
@@ -381,8 +984,11 @@ int Net::do_forward_layer(const Layer* layer, std::vector<Tensor>& blob_tensors,
         Tensor& bottom_blob_ref = blob_tensors[bottom_blob_index];
         Tensor bottom_blob;
         
-        if (opt.lightmode) {
-            if (layer->support_inplace && bottom_blob_ref.use_count() != 1) {
+        // The widened blob is exclusive, it can be written in place
+        if (bottom_blob_ref.scalar_type() == ScalarType::Half) {
+            bottom_blob = bottom_blob_ref.to(ScalarType::Float);
+        } else if (opt.lightmode) {
+            if (layer->support_inplace && (!is_exclusive_blob(bottom_blob_ref) || blob_is_view[bottom_blob_index])) {
                 bottom_blob = bottom_blob_ref.clone();
             }
         }
@@ -390,8 +996,8 @@ int Net::do_forward_layer(const Layer* layer, std::vector<Tensor>& blob_tensors,
             bottom_blob = bottom_blob_ref;
         }
         
-        // TODO: Support quantinzation
-        // convert_layout(bottom_blob, layer, opt);
+        // The int8 layer quantizes the float bottom itself
+        convert_layout(bottom_blob, bottom_blob_index, layer, opt);
         
         if (opt.lightmode && layer->support_inplace) {
             Tensor& bottom_top_blob = bottom_blob;
@@ -403,9 +1009,24 @@ int Net::do_forward_layer(const Layer* layer, std::vector<Tensor>& blob_tensors,
             blob_tensors[top_blob_index] = bottom_top_blob;
         } else {
             Tensor top_blob;
-            int ret = layer->forward(bottom_blob, top_blob, opt);
-            if (ret != 0)
-                return ret;
+            int ret = -1;
+            
+            // Write into the slice of Concat output directly
+            if (blob_views[top_blob_index].defined()) {
+                if (match_static_shape(layer, blob_tensors)) {
+                    top_blob = blob_views[top_blob_index];
+                    ret = layer->forward_into(bottom_blob, top_blob, opt);
+                    if (ret != 0)
+                        top_blob.reset();
+                }
+                blob_views[top_blob_index].reset();
+            }
+            
+            if (ret != 0) {
+                ret = layer->forward(bottom_blob, top_blob, opt);
+                if (ret != 0)
+                    return ret;
+            }
             
             blob_tensors[top_blob_index] = top_blob;
         }
@@ -415,25 +1036,45 @@ int Net::do_forward_layer(const Layer* layer, std::vector<Tensor>& blob_tensors,
         }
     } else {
         std::vector<Tensor> bottom_blobs(layer->bottoms.size());
+        // The in-place layer writes its tops into the leading bottoms, instead of cloning them
+        // it runs out of place when one of them is still shared or it can write into the Concat output
+        bool inplace = opt.lightmode && layer->support_inplace;
+        if (inplace && layer->tops.size() == 1 && blob_views[layer->tops[0]].defined()) {
+            inplace = false;
+        }
         for (const auto i : otter::irange(layer->bottoms.size())) {
             int bottom_blob_index = layer->bottoms[i];
             Tensor& bottom_blob_ref = blob_tensors[bottom_blob_index];
             bottom_blobs[i].reset();
             
-            if (opt.lightmode) {
-                if (layer->support_inplace && bottom_blob_ref.use_count() != 1) {
-                    bottom_blobs[i] = bottom_blob_ref.clone();
-                }
+            if (bottom_blob_ref.scalar_type() == ScalarType::Half) {
+                bottom_blobs[i] = bottom_blob_ref.to(ScalarType::Float);
+            } else if (inplace && i < layer->tops.size()) {
+                inplace = is_exclusive_blob(bottom_blob_ref) && !blob_is_view[bottom_blob_index];
             }
             if (!bottom_blobs[i].defined()) {
                 bottom_blobs[i] = bottom_blob_ref;
             }
             
-            // TODO: Support quantinzation
-            // convert_layout(bottom_blobs[i], layer, opt);
+            // The int8 layer quantizes the float bottom itself
+            convert_layout(bottom_blobs[i], bottom_blob_index, layer, opt);
         }
         
-        if (opt.lightmode && layer->support_inplace) {
+        // The bottoms of the packing layer should share the same layout
+        if (opt.use_packing_layout && layer->support_packing) {
+            bool all_packed = true;
+            for (const auto i : otter::irange(layer->bottoms.size())) {
+                all_packed = all_packed && is_packed_blob(layer->bottoms[i], bottom_blobs[i]);
+            }
+            if (!all_packed) {
+                for (const auto i : otter::irange(layer->bottoms.size())) {
+                    if (is_packed_blob(layer->bottoms[i], bottom_blobs[i]))
+                        bottom_blobs[i] = otter::from_packed(bottom_blobs[i]);
+                }
+            }
+        }
+        
+        if (inplace) {
             std::vector<Tensor>& bottom_top_blobs = bottom_blobs;
             int ret = layer->forward_inplace(bottom_top_blobs, opt);
             if (ret != 0)
@@ -446,9 +1087,24 @@ int Net::do_forward_layer(const Layer* layer, std::vector<Tensor>& blob_tensors,
             }
         } else {
             std::vector<Tensor> top_blobs(layer->tops.size());
-            int ret = layer->forward(bottom_blobs, top_blobs, opt);
-            if (ret != 0)
-                return ret;
+            int ret = -1;
+            
+            // Write into the slice of Concat output directly
+            if (top_blobs.size() == 1 && blob_views[layer->tops[0]].defined()) {
+                if (match_static_shape(layer, blob_tensors)) {
+                    top_blobs[0] = blob_views[layer->tops[0]];
+                    ret = layer->forward_into(bottom_blobs, top_blobs, opt);
+                    if (ret != 0)
+                        top_blobs[0].reset();
+                }
+                blob_views[layer->tops[0]].reset();
+            }
+            
+            if (ret != 0) {
+                ret = layer->forward(bottom_blobs, top_blobs, opt);
+                if (ret != 0)
+                    return ret;
+            }
             
             for (const auto i : otter::irange(layer->tops.size())) {
                 int top_blob_index = layer->tops[i];
@@ -477,7 +1133,7 @@ int Net::checkVerison(const DataReader &dr) {
     
     printf("Model: v%d.%d\n", check_major, check_minor);
     
-    return 0;
+    return check_major;
 }
 
 int Net::load_weight(const DataReader& dr) {
@@ -486,11 +1142,16 @@ int Net::load_weight(const DataReader& dr) {
         return -1;
     }
     
-    checkVerison(dr);
+    if (in_use()) {
+        fprintf(stderr, "[Net] The network is read-only after the Extractor is created!\n");
+        return -1;
+    }
+    
+    const int major = checkVerison(dr);
     
     int layer_count = (int)layers.size();
     
-    InitializerFromDataReader initializer(dr);
+    InitializerFromDataReader initializer(dr, (major == WEIGHT_FP16_MAJOR) ? ScalarType::Half : ScalarType::Float);
     
     for (const auto i : otter::irange(layer_count)) {
         Layer* layer = layers[i];
@@ -529,22 +1190,58 @@ int Net::load_weight(const char *weight_path) {
 }
 
 Extractor Net::create_extractor() const {
+    in_use_.store(true);
+    
     return Extractor(this, blobs.size());
 }
 
 Extractor::Extractor(const Net* net, size_t blob_count) {
     net_ = net;
+    // The options of the network are the defaults, the set_* calls override them
+    option = net->option;
     blob_tensors_.resize(blob_count);
+    blob_views_.resize(blob_count);
+    prepared_iterators_.resize(net->layers.size());
+    workspace_ = WorkspaceAllocator::create();
 }
 
 void Extractor::clear() {
-    blob_tensors_.clear();
+    for (auto& blob_tensor : blob_tensors_) {
+        blob_tensor.reset();
+    }
+    for (auto& blob_view : blob_views_) {
+        blob_view.reset();
+    }
+}
+
+void Extractor::trim_workspace() {
+    workspace_->trim();
+}
+
+void Extractor::set_option(const NetOption& net_option) {
+    option = net_option;
 }
 
 void Extractor::set_lightmode(bool lightmode) {
     option.lightmode = lightmode;
 }
 
+void Extractor::set_packing_layout(bool packing_layout) {
+    option.use_packing_layout = packing_layout;
+}
+
+void Extractor::set_channels_last(bool channels_last) {
+    option.use_channels_last = channels_last;
+}
+
+void Extractor::set_fused_tiling(bool fused_tiling) {
+    option.use_fused_tiling = fused_tiling;
+}
+
+void Extractor::set_fp16_storage(bool fp16_storage) {
+    option.use_fp16_storage = fp16_storage;
+}
+
 int Extractor::input(std::string blob_name, const Tensor &in) {
     int blob_index = net_->find_blob_index_by_name(blob_name);
     if (blob_index == -1) {
@@ -579,13 +1276,67 @@ int Extractor::extract(int blob_index, Tensor &feat, int type) {
     int ret = 0;
     
     if (!blob_tensors_[blob_index].defined()) {
+        ThreadAllocatorGuard workspace_guard(workspace_.get());
+        
+        NetOption opt = option;
+        opt.prepared_iterators = prepared_iterators_.data();
+        
         int layer_index = net_->blobs[blob_index].producer;
-        ret = net_->forward_layer(layer_index, blob_tensors_, option);
+        // The Concat slice is neither channel blocked nor channels last
+        if (!opt.use_packing_layout && !opt.use_channels_last) {
+            net_->prepare_concat_views(layer_index, blob_tensors_, blob_views_);
+        }
+        ret = net_->forward_layer(layer_index, blob_tensors_, blob_views_, opt);
     }
     
     feat = blob_tensors_[blob_index];
+    if (option.use_packing_layout && net_->is_packed_blob(blob_index, feat)) {
+        feat = otter::from_packed(feat);
+    } else if (option.use_channels_last) {
+        feat = feat.contiguous();
+    } else if (feat.defined() && feat.scalar_type() == ScalarType::Half) {
+        feat = feat.to(ScalarType::Float);
+    }
     
     return ret;
 }
 
+ExtractorPool::ExtractorPool(const Net& net, size_t max_cached) : net_(net), max_cached_(max_cached) {}
+
+Extractor ExtractorPool::acquire() {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!idle_.empty()) {
+            Extractor extractor = std::move(idle_.back());
+            idle_.pop_back();
+            
+            return extractor;
+        }
+    }
+    
+    return net_.create_extractor();
+}
+
+void ExtractorPool::release(Extractor&& extractor) {
+    // Called from ~PooledExtractor, drop the foreign Extractor instead of throwing
+    if (extractor.net() != &net_) {
+        fprintf(stderr, "[ExtractorPool] Extractor is not created from the same network, dropped\n");
+        return;
+    }
+    
+    // Drop the last frame but keep the workspace warm
+    extractor.clear();
+    extractor.trim_workspace();
+    
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (max_cached_ == 0 || idle_.size() < max_cached_) {
+        idle_.push_back(std::move(extractor));
+    }
+}
+
+size_t ExtractorPool::idle_count() const {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return idle_.size();
 }
+
+}   // end namespace otter
@@ -8,19 +8,32 @@
 #ifndef Net_hpp
 #define Net_hpp
 
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+
 #include "Config.hpp"
 #include "Tensor.hpp"
 #include "Layer.hpp"
 #include "Blob.hpp"
 #include "NetOption.hpp"
 #include "DataReader.hpp"
+#include "TensorIterator.hpp"
 
 namespace otter {
 
 class Extractor;
+class BatchScheduler;
+class Int8Calibrator;
 
+// The network is read-only once the first Extractor is created,
+// all the const methods are safe to be called from multiple threads,
+// so one copy of the weights can serve many Extractors concurrently
 class Net {
     friend Extractor;
+    friend BatchScheduler;
+    friend Int8Calibrator;
 public:
     Net();
     ~Net();
@@ -34,22 +47,48 @@ public:
     void compile(CompileMode comopile_mode = CompileMode::Initial);
     void summary();
     
+    // Return the major version, the weights are stored in half for WEIGHT_FP16_MAJOR (see Initializer.hpp)
     int checkVerison(const DataReader& dr);
     int load_weight(const DataReader& dr);
     int load_weight(const char *weight_path);
     int load_weight(FILE *f);
     
+    // Switch the convolutions listed in the table written by Int8Calibrator to int8, call it after load_weight
+    // The blob which only feeds the next int8 convolution is kept in int8 (Char) and extracted as it is
+    int load_int8_scales(const char* table_path);
+    int load_int8_scales(const std::map<std::string, std::vector<float>>& table);
+    
     int find_blob_index_by_name(std::string name) const;
     void update_input_output_indexes();
     void update_input_output_names();
-
+    
+    bool in_use() const { return in_use_.load(); }
     
 public:
+    // The default options of the Extractors created from the network
     NetOption option;
     
 private:
-    int forward_layer(int layer_index, std::vector<Tensor>& blob_tensors, const NetOption& opt) const;
-    int do_forward_layer(const Layer* layer, std::vector<Tensor>& blob_mats, const NetOption& opt) const;
+    void fuse_spp_cascade();
+    void plan_concat_views();
+    void plan_fused_chains();
+    void plan_int8_stages();
+    void plan_fp16_storage();
+    void prepare_concat_views(int layer_end, const std::vector<Tensor>& blob_tensors, std::vector<Tensor>& blob_views) const;
+    bool match_static_shape(const Layer* layer, const std::vector<Tensor>& blob_tensors) const;
+    
+    // Pack the bottom blob for the packing layer, unpack it for the others
+    // or restride it to channels last for the channels last layer, contiguous for the others
+    void convert_layout(Tensor& bottom_blob, int bottom_blob_index, const Layer* layer, const NetOption& opt) const;
+    bool is_packed_blob(int blob_index, const Tensor& blob) const;
+    
+    // Narrow the planned top blob to half after it is produced
+    void store_fp16_blob(int blob_index, std::vector<Tensor>& blob_tensors, const NetOption& opt) const;
+    
+    int forward_layer(int layer_index, std::vector<Tensor>& blob_tensors, std::vector<Tensor>& blob_views, const NetOption& opt) const;
+    int do_forward_layer(const Layer* layer, std::vector<Tensor>& blob_tensors, std::vector<Tensor>& blob_views, const NetOption& opt) const;
+    int forward_fused_chain(int chain_index, std::vector<Tensor>& blob_tensors, std::vector<Tensor>& blob_views, const NetOption& opt) const;
+    int forward_int8_stage(int stage_index, std::vector<Tensor>& blob_tensors, std::vector<Tensor>& blob_views, const NetOption& opt) const;
 private:
     std::vector<Layer*> layers;
     std::vector<Blob> blobs;
@@ -61,17 +100,80 @@ private:
     std::vector<int> output_blob_indexes;
     std::vector<const char*> input_blob_names;
     std::vector<const char*> output_blob_names;
+    
+    // Zero-copy concat, the producer writes its top blob into the channel slice of the Concat output
+    struct ConcatView {
+        int blob;           // the blob written by the producer directly
+        int64_t offset;     // channel offset in the Concat output
+    };
+    // Indexed by layer, empty if the layer is not a planned Concat
+    std::vector<std::vector<ConcatView>> concat_views;
+    // Indexed by blob, the blob lives in the memory of a Concat output
+    std::vector<bool> blob_is_view;
+    
+    // Depth-first tiling, the 1x1 -> depthwise -> 1x1 chain is computed as one layer
+    // and the intermediate blobs are never materialized
+    struct FusedStage {
+        int convolution;    // layer index
+        int batchnorm;      // layer index, -1 for none
+        int activation;     // LRelu layer index, -1 for none
+    };
+    struct FusedChain {
+        FusedStage stages[3];   // expand, depthwise, project
+        int bottom_blob;
+        int top_blob;
+    };
+    std::vector<FusedChain> fused_chains;
+    // Indexed by layer, the chain which ends at the layer, -1 if none
+    std::vector<int> fused_chain_end;
+    
+    // The int8 convolution with its batchnorm and activation folded into the epilogue
+    std::vector<FusedStage> int8_stages;
+    // Indexed by layer, the int8 stage which ends at the layer, -1 if none
+    std::vector<int> int8_stage_end;
+    
+    // Indexed by blob, the blob waits for a later layer and is kept in half by use_fp16_storage
+    std::vector<bool> blob_fp16_storage;
+    
+    std::vector<int> count_consumers() const;
+    int next_layer(int layer_index, const std::vector<int>& consumer_count) const;
+    bool is_layer_type(int layer_index, const char* type) const;
+    int match_stage(int layer_index, const std::vector<int>& consumer_count, FusedStage& stage) const;
+    
+    mutable std::atomic<bool> in_use_{false};
 };
 
+// Not thread safe, use one Extractor per thread
+// All the intermediate tensors are allocated from its own workspace
+// The options start from Net::option, the set_* calls override them
 class Extractor {
     friend Net;
 public:
-    // Clean up the all intermeidate tensors
+    // Clean up the all intermeidate tensors, the workspace is kept for the next frame
     void clear();
     
+    // Release the workspace blocks which are not used since the last call, e.g. after the input size changed
+    void trim_workspace();
+    
+    // Replace all the options at once
+    void set_option(const NetOption& net_option);
+    
     // Intermeidate tensor will be recycled immediately after calculation
     void set_lightmode(bool lightmode);
     
+    // Run on the channel blocked layout, the extracted blob is always unpacked
+    void set_packing_layout(bool packing_layout);
+    
+    // Run on NHWC, the extracted blob is always contiguous
+    void set_channels_last(bool channels_last);
+    
+    // Run the 1x1 -> depthwise -> 1x1 chains tile by tile, the intermediate blobs of the chain are recomputed when extracted
+    void set_fused_tiling(bool fused_tiling);
+    
+    // Keep the blobs waiting for a later layer in half to save memory, the extracted blob is always float
+    // The blob is widened before the layer runs, it does not reduce the memory traffic (see NetOption)
+    void set_fp16_storage(bool fp16_storage);
+    
     int input(int blob_index, const Tensor& in);
     
     int input(std::string blob_name, const Tensor& in);
@@ -80,15 +182,66 @@ public:
     
     int extract(std::string blob_name, Tensor& feat, int type);
     
+    const Net* net() const { return net_; }
+    
 protected:
     Extractor(const Net* net, size_t blob_count);
 private:
     const Net* net_;
     std::vector<Tensor> blob_tensors_;
+    std::vector<Tensor> blob_views_;
+    std::shared_ptr<WorkspaceAllocator> workspace_;
+    // Indexed by layer
+    std::vector<PreparedTensorIterator> prepared_iterators_;
     
     NetOption option;
 };
 
+// Hand out the warm Extractors to the worker threads
+class ExtractorPool {
+public:
+    // max_cached = 0 for unlimited idle Extractors
+    ExtractorPool(const Net& net, size_t max_cached = 0);
+    
+    ExtractorPool(const ExtractorPool&) = delete;
+    ExtractorPool& operator=(const ExtractorPool&) = delete;
+    
+    // Thread safe
+    Extractor acquire();
+    // Never throws, the Extractor created from another network is dropped
+    // The workspace of the Extractor is trimmed to the blocks used by its last frame
+    void release(Extractor&& extractor);
+    
+    size_t idle_count() const;
+    
+private:
+    const Net& net_;
+    size_t max_cached_;
+    
+    mutable std::mutex mutex_;
+    std::vector<Extractor> idle_;
+};
+
+// Return the Extractor to the pool at the end of scope
+class PooledExtractor {
+public:
+    PooledExtractor(ExtractorPool& pool) : pool_(pool), extractor_(pool.acquire()) {}
+    
+    ~PooledExtractor() {
+        pool_.release(std::move(extractor_));
+    }
+    
+    PooledExtractor(const PooledExtractor&) = delete;
+    PooledExtractor& operator=(const PooledExtractor&) = delete;
+    
+    Extractor* operator->() { return &extractor_; }
+    Extractor& operator*() { return extractor_; }
+    
+private:
+    ExtractorPool& pool_;
+    Extractor extractor_;
+};
+
 #define EARSE_CHARACTER(str, c) str.erase(std::remove_if(str.begin(), str.end(), [](unsigned char x) { return x == c; }), str.end());
 
 #define EARSE_SPACE(str) EARSE_CHARACTER(str, ' ')
@@ -13,6 +13,12 @@ NetOption::NetOption() {
     lightmode = true;
     train = false;
     use_non_lib_optimize = false;
+    use_packing_layout = false;
+    use_channels_last = false;
+    use_fused_tiling = false;
+    use_fp16_storage = false;
+    prepared_iterators = nullptr;
+    prepared_iterator = nullptr;
 }
 
 }
@@ -10,6 +10,8 @@
 
 namespace otter {
 
+class PreparedTensorIterator;
+
 class NetOption {
 public:
     NetOption();
@@ -18,6 +20,21 @@ public:
     bool lightmode;
     bool train;
     bool use_non_lib_optimize;
+    // Run the layers which support packing on the channel blocked layout
+    bool use_packing_layout;
+    // Run the layers which support channels last on NHWC, ignored when use_packing_layout is set
+    bool use_channels_last;
+    // Run the 1x1 -> depthwise -> 1x1 convolution chains tile by tile, ignored when the layout is packed or channels last
+    bool use_fused_tiling;
+    // Keep the blobs waiting for a later layer in half, ignored when the layout is packed or channels last, off by default
+    // It only saves memory: no kernel reads half, the consumer widens the whole blob to float first,
+    // which costs one more pass over the blob than the float storage
+    bool use_fp16_storage;
+    
+    // Set by the Extractor, one iterator per layer reused across the frames (see PreparedTensorIterator)
+    PreparedTensorIterator* prepared_iterators;
+    // Set by the Net, the iterator of the running layer, nullptr if none
+    PreparedTensorIterator* prepared_iterator;
 };
 
 enum class CompileMode {
@@ -0,0 +1,475 @@
+//
+//  NonMaximumSuppression.cpp
+//  Tensor
+//
+//  Created by 陳均豪 on 2022/3/20.
+//
+
+#include "NonMaximumSuppression.hpp"
+#include "Tensor.hpp"
+#include "TensorFactory.hpp"
+#include "Parallel.hpp"
+#include "Vec.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <float.h>
+
+namespace otter {
+namespace cv {
+
+using Vec = vec::Vectorized<float>;
+
+// Switch from brute force (SIMD over the kept boxes) to spatial grid bucketing
+constexpr int64_t kNmsGridThreshold = 1024;
+constexpr int kNmsMaxGridSize = 64;
+
+struct BoxView {
+    const float* x1;
+    const float* y1;
+    const float* x2;
+    const float* y2;
+    const float* score;
+    const int* label;   // nullptr for class agnostic
+    int64_t n;
+};
+
+struct Candidate {
+    float x1;
+    float y1;
+    float x2;
+    float y2;
+    float area;
+    float label;
+};
+
+static inline Candidate make_candidate(const BoxView& b, int64_t index) {
+    Candidate c;
+    c.x1 = b.x1[index];
+    c.y1 = b.y1[index];
+    c.x2 = b.x2[index];
+    c.y2 = b.y2[index];
+    c.area = (c.x2 - c.x1) * (c.y2 - c.y1);
+    c.label = (b.label) ? static_cast<float>(b.label[index]) : 0.f;
+
+    return c;
+}
+
+static inline float intersection_area(const Candidate& a, const Candidate& b) {
+    float inter_width = std::min(a.x2, b.x2) - std::max(a.x1, b.x1);
+    float inter_height = std::min(a.y2, b.y2) - std::max(a.y1, b.y1);
+
+    if (inter_width <= 0 || inter_height <= 0)
+        return 0.f;
+
+    return inter_width * inter_height;
+}
+
+static inline bool is_overlapped(const Candidate& a, const Candidate& b, float threshold) {
+    float inter_area = intersection_area(a, b);
+    float union_area = a.area + b.area - inter_area;
+    // float IoU = inter_area / union_area
+    return inter_area > threshold * union_area;
+}
+
+static inline Vec intersection_area(const Vec& x1, const Vec& y1, const Vec& x2, const Vec& y2, const Candidate& c) {
+    const Vec zero(0.f);
+    Vec inter_width  = vec::maximum(vec::minimum(x2, Vec(c.x2)) - vec::maximum(x1, Vec(c.x1)), zero);
+    Vec inter_height = vec::maximum(vec::minimum(y2, Vec(c.y2)) - vec::maximum(y1, Vec(c.y1)), zero);
+
+    return inter_width * inter_height;
+}
+
+// Pop the candidates in descending score order without sorting all of them,
+// so that the early termination by max_output only pays for what it uses
+class ScoreHeap {
+public:
+    ScoreHeap(const float* score, int64_t n) : order_(n), compare_{score} {
+        std::iota(order_.begin(), order_.end(), 0);
+        std::make_heap(order_.begin(), order_.end(), compare_);
+    }
+
+    bool empty() const { return order_.empty(); }
+
+    int64_t pop() {
+        std::pop_heap(order_.begin(), order_.end(), compare_);
+        int64_t index = order_.back();
+        order_.pop_back();
+
+        return index;
+    }
+
+private:
+    struct Compare {
+        // Ties are broken by index to keep the result deterministic
+        bool operator()(int64_t a, int64_t b) const {
+            return (score[a] < score[b]) || (score[a] == score[b] && a > b);
+        }
+        const float* score;
+    };
+
+    std::vector<int64_t> order_;
+    Compare compare_;
+};
+
+// SoA storage of the kept boxes, the area is precomputed
+class KeptBoxes {
+public:
+    void reserve(int64_t n) {
+        x1_.reserve(n); y1_.reserve(n); x2_.reserve(n); y2_.reserve(n);
+        area_.reserve(n); label_.reserve(n);
+    }
+
+    int64_t size() const { return static_cast<int64_t>(x1_.size()); }
+
+    void push_back(const Candidate& c) {
+        x1_.push_back(c.x1); y1_.push_back(c.y1); x2_.push_back(c.x2); y2_.push_back(c.y2);
+        area_.push_back(c.area); label_.push_back(c.label);
+    }
+
+    Candidate operator[](int64_t i) const {
+        return {x1_[i], y1_[i], x2_[i], y2_[i], area_[i], label_[i]};
+    }
+
+    // Check the candidate against all the kept boxes with SIMD
+    bool overlap_any(const Candidate& c, float threshold, bool class_aware) const {
+        const int64_t n = size();
+        const Vec c_area(c.area);
+        const Vec c_label(c.label);
+        const Vec thres(threshold);
+
+        int64_t i = 0;
+        for (; i + Vec::size() <= n; i += Vec::size()) {
+            Vec x1 = Vec::loadu(x1_.data() + i);
+            Vec y1 = Vec::loadu(y1_.data() + i);
+            Vec x2 = Vec::loadu(x2_.data() + i);
+            Vec y2 = Vec::loadu(y2_.data() + i);
+            Vec area = Vec::loadu(area_.data() + i);
+
+            Vec inter_area = intersection_area(x1, y1, x2, y2, c);
+            Vec union_area = area + c_area - inter_area;
+            Vec mask = inter_area > thres * union_area;
+            if (class_aware) {
+                mask = mask & (Vec::loadu(label_.data() + i) == c_label);
+            }
+
+            if (mask.zero_mask() != (1 << Vec::size()) - 1)
+                return true;
+        }
+        for (; i < n; ++i) {
+            if (class_aware && label_[i] != c.label)
+                continue;
+            if (is_overlapped(c, (*this)[i], threshold))
+                return true;
+        }
+
+        return false;
+    }
+
+private:
+    std::vector<float> x1_, y1_, x2_, y2_, area_, label_;
+};
+
+// Bucket the kept boxes by the cells they cover, a candidate only needs to
+// check the kept boxes sharing at least one cell with it
+class SpatialGrid {
+public:
+    SpatialGrid(const BoxView& b) {
+        float min_x = FLT_MAX, min_y = FLT_MAX, max_x = -FLT_MAX, max_y = -FLT_MAX;
+        double sum_w = 0, sum_h = 0;
+        for (const auto i : otter::irange(b.n)) {
+            min_x = std::min(min_x, std::min(b.x1[i], b.x2[i]));
+            min_y = std::min(min_y, std::min(b.y1[i], b.y2[i]));
+            max_x = std::max(max_x, std::max(b.x1[i], b.x2[i]));
+            max_y = std::max(max_y, std::max(b.y1[i], b.y2[i]));
+            sum_w += std::abs(b.x2[i] - b.x1[i]);
+            sum_h += std::abs(b.y2[i] - b.y1[i]);
+        }
+
+        origin_x_ = min_x;
+        origin_y_ = min_y;
+
+        // The cell is about the size of the average box
+        float extent_x = max_x - min_x;
+        float extent_y = max_y - min_y;
+        cell_w_ = std::max({static_cast<float>(sum_w / b.n), extent_x / kNmsMaxGridSize, FLT_MIN});
+        cell_h_ = std::max({static_cast<float>(sum_h / b.n), extent_y / kNmsMaxGridSize, FLT_MIN});
+        grid_w_ = std::min(std::max(1, static_cast<int>(std::ceil(extent_x / cell_w_))), kNmsMaxGridSize);
+        grid_h_ = std::min(std::max(1, static_cast<int>(std::ceil(extent_y / cell_h_))), kNmsMaxGridSize);
+
+        cells_.resize(grid_w_ * grid_h_);
+    }
+
+    void insert(int32_t kept_index, const Candidate& c) {
+        int x_begin, x_end, y_begin, y_end;
+        cell_range(c, x_begin, x_end, y_begin, y_end);
+
+        for (int y = y_begin; y <= y_end; ++y) {
+            for (int x = x_begin; x <= x_end; ++x) {
+                cells_[y * grid_w_ + x].push_back(kept_index);
+            }
+        }
+    }
+
+    bool overlap_any(const KeptBoxes& kept, const Candidate& c, float threshold, bool class_aware) const {
+        int x_begin, x_end, y_begin, y_end;
+        cell_range(c, x_begin, x_end, y_begin, y_end);
+
+        for (int y = y_begin; y <= y_end; ++y) {
+            for (int x = x_begin; x <= x_end; ++x) {
+                for (const auto kept_index : cells_[y * grid_w_ + x]) {
+                    Candidate k = kept[kept_index];
+                    if (class_aware && k.label != c.label)
+                        continue;
+                    if (is_overlapped(c, k, threshold))
+                        return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
+private:
+    int cell_x(float x) const {
+        return std::min(std::max(static_cast<int>((x - origin_x_) / cell_w_), 0), grid_w_ - 1);
+    }
+
+    int cell_y(float y) const {
+        return std::min(std::max(static_cast<int>((y - origin_y_) / cell_h_), 0), grid_h_ - 1);
+    }
+
+    void cell_range(const Candidate& c, int& x_begin, int& x_end, int& y_begin, int& y_end) const {
+        x_begin = cell_x(std::min(c.x1, c.x2));
+        x_end   = cell_x(std::max(c.x1, c.x2));
+        y_begin = cell_y(std::min(c.y1, c.y2));
+        y_end   = cell_y(std::max(c.y1, c.y2));
+    }
+
+    float origin_x_, origin_y_;
+    float cell_w_, cell_h_;
+    int grid_w_, grid_h_;
+    std::vector<std::vector<int32_t>> cells_;
+};
+
+static std::vector<int64_t> greedy_nms(const BoxView& b, float threshold, int64_t max_output) {
+    std::vector<int64_t> keep;
+
+    const int64_t limit = (max_output < 0) ? b.n : std::min(max_output, b.n);
+    if (limit == 0)
+        return keep;
+
+    const bool class_aware = (b.label != nullptr);
+
+    keep.reserve(limit);
+    KeptBoxes kept;
+    kept.reserve(limit);
+
+    ScoreHeap heap(b.score, b.n);
+
+    if (b.n < kNmsGridThreshold) {
+        while (!heap.empty() && (int64_t)keep.size() < limit) {
+            int64_t index = heap.pop();
+            Candidate c = make_candidate(b, index);
+
+            if (!kept.overlap_any(c, threshold, class_aware)) {
+                kept.push_back(c);
+                keep.push_back(index);
+            }
+        }
+    } else {
+        SpatialGrid grid(b);
+
+        while (!heap.empty() && (int64_t)keep.size() < limit) {
+            int64_t index = heap.pop();
+            Candidate c = make_candidate(b, index);
+
+            if (!grid.overlap_any(kept, c, threshold, class_aware)) {
+                grid.insert(static_cast<int32_t>(kept.size()), c);
+                kept.push_back(c);
+                keep.push_back(index);
+            }
+        }
+    }
+
+    return keep;
+}
+
+static void soft_nms_impl(const BoxView& b, SoftNmsMethod method, float sigma, float iou_threshold, float score_threshold, int64_t max_output, std::vector<int64_t>& keep, std::vector<float>& keep_score) {
+    const int64_t limit = (max_output < 0) ? b.n : std::min(max_output, b.n);
+    const bool class_aware = (b.label != nullptr);
+
+    // The active boxes are compacted after every round
+    std::vector<float> x1(b.x1, b.x1 + b.n);
+    std::vector<float> y1(b.y1, b.y1 + b.n);
+    std::vector<float> x2(b.x2, b.x2 + b.n);
+    std::vector<float> y2(b.y2, b.y2 + b.n);
+    std::vector<float> score(b.score, b.score + b.n);
+    std::vector<float> area(b.n);
+    std::vector<float> label(b.n, 0.f);
+    std::vector<int64_t> index(b.n);
+    std::iota(index.begin(), index.end(), 0);
+    for (const auto i : otter::irange(b.n)) {
+        area[i] = (x2[i] - x1[i]) * (y2[i] - y1[i]);
+        if (class_aware)
+            label[i] = static_cast<float>(b.label[i]);
+    }
+
+    std::vector<float> iou(b.n);
+
+    auto move_slot = [&](int64_t from, int64_t to) {
+        x1[to] = x1[from]; y1[to] = y1[from]; x2[to] = x2[from]; y2[to] = y2[from];
+        score[to] = score[from]; area[to] = area[from]; label[to] = label[from]; index[to] = index[from];
+    };
+
+    int64_t active = b.n;
+    while (active > 0 && (int64_t)keep.size() < limit) {
+        int64_t best = std::max_element(score.begin(), score.begin() + active) - score.begin();
+        if (score[best] < score_threshold)
+            break;
+
+        keep.push_back(index[best]);
+        keep_score.push_back(score[best]);
+
+        Candidate c = {x1[best], y1[best], x2[best], y2[best], area[best], label[best]};
+
+        --active;
+        move_slot(active, best);
+
+        const Vec c_area(c.area);
+        const Vec eps(FLT_MIN);
+        int64_t i = 0;
+        for (; i + Vec::size() <= active; i += Vec::size()) {
+            Vec inter_area = intersection_area(Vec::loadu(x1.data() + i), Vec::loadu(y1.data() + i), Vec::loadu(x2.data() + i), Vec::loadu(y2.data() + i), c);
+            Vec union_area = Vec::loadu(area.data() + i) + c_area - inter_area;
+            (inter_area / vec::maximum(union_area, eps)).store(iou.data() + i);
+        }
+        for (; i < active; ++i) {
+            Candidate k = {x1[i], y1[i], x2[i], y2[i], area[i], label[i]};
+            float inter_area = intersection_area(c, k);
+            iou[i] = inter_area / std::max(c.area + k.area - inter_area, FLT_MIN);
+        }
+
+        int64_t remain = 0;
+        for (const auto j : otter::irange(active)) {
+            float weight = 1.f;
+            if (!class_aware || label[j] == c.label) {
+                if (method == SoftNmsMethod::Linear) {
+                    weight = (iou[j] > iou_threshold) ? 1.f - iou[j] : 1.f;
+                } else {
+                    weight = std::exp(-(iou[j] * iou[j]) / sigma);
+                }
+            }
+
+            float decayed = score[j] * weight;
+            if (decayed >= score_threshold) {
+                move_slot(j, remain);
+                score[remain] = decayed;
+                ++remain;
+            }
+        }
+        active = remain;
+    }
+}
+
+static BoxView make_box_view(const Tensor& boxes, const Tensor& scores, const Tensor& labels) {
+    OTTER_CHECK(boxes.dim() == 2 && boxes.size(0) == 4, "Expect boxes with shape {4, N} but get ", boxes.sizes());
+    OTTER_CHECK(boxes.scalar_type() == ScalarType::Float && scores.scalar_type() == ScalarType::Float, "Expect boxes and scores are Float");
+    OTTER_CHECK(boxes.is_contiguous() && scores.is_contiguous(), "Expect boxes and scores are contiguous");
+
+    const int64_t n = boxes.size(1);
+    OTTER_CHECK(scores.dim() == 1 && scores.size(0) == n, "Expect scores with shape {", n, "} but get ", scores.sizes());
+
+    BoxView b;
+    const float* boxes_data = boxes.data_ptr<float>();
+    b.x1 = boxes_data;
+    b.y1 = boxes_data + n;
+    b.x2 = boxes_data + n * 2;
+    b.y2 = boxes_data + n * 3;
+    b.score = scores.data_ptr<float>();
+    b.label = nullptr;
+    b.n = n;
+
+    if (labels.defined()) {
+        OTTER_CHECK(labels.dim() == 1 && labels.size(0) == n, "Expect labels with shape {", n, "} but get ", labels.sizes());
+        OTTER_CHECK(labels.scalar_type() == ScalarType::Int && labels.is_contiguous(), "Expect labels are contiguous Int");
+        b.label = labels.data_ptr<int>();
+    }
+
+    return b;
+}
+
+static Tensor make_index_tensor(const std::vector<int64_t>& keep) {
+    Tensor indices = otter::empty({static_cast<int64_t>(keep.size())}, ScalarType::Long);
+    if (!keep.empty())
+        std::memcpy(indices.data_ptr<int64_t>(), keep.data(), keep.size() * sizeof(int64_t));
+
+    return indices;
+}
+
+Tensor nms(const Tensor& boxes, const Tensor& scores, float iou_threshold, int64_t max_output) {
+    return multiclass_nms(boxes, scores, Tensor(), iou_threshold, max_output);
+}
+
+Tensor multiclass_nms(const Tensor& boxes, const Tensor& scores, const Tensor& labels, float iou_threshold, int64_t max_output) {
+    Tensor boxes_ = boxes.contiguous();
+    Tensor scores_ = scores.contiguous();
+    Tensor labels_ = (labels.defined()) ? labels.contiguous() : Tensor();
+
+    BoxView b = make_box_view(boxes_, scores_, labels_);
+
+    return make_index_tensor(greedy_nms(b, iou_threshold, max_output));
+}
+
+std::vector<Tensor> batched_nms(const Tensor& boxes, const Tensor& scores, const Tensor& labels, float iou_threshold, int64_t max_output) {
+    OTTER_CHECK(boxes.dim() == 3 && boxes.size(1) == 4, "Expect boxes with shape {B, 4, N} but get ", boxes.sizes());
+    OTTER_CHECK(scores.dim() == 2 && scores.size(0) == boxes.size(0), "Expect scores with shape {B, N} but get ", scores.sizes());
+
+    const int64_t batch_size = boxes.size(0);
+
+    Tensor boxes_ = boxes.contiguous();
+    Tensor scores_ = scores.contiguous();
+    Tensor labels_ = (labels.defined()) ? labels.contiguous() : Tensor();
+
+    std::vector<BoxView> views(batch_size);
+    for (const auto i : otter::irange(batch_size)) {
+        views[i] = make_box_view(boxes_[i], scores_[i], (labels_.defined()) ? labels_[i] : Tensor());
+    }
+
+    std::vector<std::vector<int64_t>> keeps(batch_size);
+    otter::parallel_for(0, batch_size, 0, [&](int64_t begin, int64_t end) {
+        for (const auto i : otter::irange(begin, end)) {
+            keeps[i] = greedy_nms(views[i], iou_threshold, max_output);
+        }
+    });
+
+    std::vector<Tensor> indices(batch_size);
+    for (const auto i : otter::irange(batch_size)) {
+        indices[i] = make_index_tensor(keeps[i]);
+    }
+
+    return indices;
+}
+
+std::tuple<Tensor, Tensor> soft_nms(const Tensor& boxes, const Tensor& scores, const Tensor& labels, SoftNmsMethod method, float sigma, float iou_threshold, float score_threshold, int64_t max_output) {
+    OTTER_CHECK(method == SoftNmsMethod::Linear || sigma > 0, "Expect sigma > 0 for gaussian soft nms but get ", sigma);
+
+    Tensor boxes_ = boxes.contiguous();
+    Tensor scores_ = scores.contiguous();
+    Tensor labels_ = (labels.defined()) ? labels.contiguous() : Tensor();
+
+    BoxView b = make_box_view(boxes_, scores_, labels_);
+
+    std::vector<int64_t> keep;
+    std::vector<float> keep_score;
+    soft_nms_impl(b, method, sigma, iou_threshold, score_threshold, max_output, keep, keep_score);
+
+    Tensor decayed_scores = otter::empty({static_cast<int64_t>(keep_score.size())}, ScalarType::Float);
+    if (!keep_score.empty())
+        std::memcpy(decayed_scores.data_ptr<float>(), keep_score.data(), keep_score.size() * sizeof(float));
+
+    return std::make_tuple(make_index_tensor(keep), decayed_scores);
+}
+
+}   // end namespace cv
+}   // end namespace otter
@@ -0,0 +1,46 @@
+//
+//  NonMaximumSuppression.hpp
+//  Tensor
+//
+//  Created by 陳均豪 on 2022/3/20.
+//
+
+#ifndef NonMaximumSuppression_hpp
+#define NonMaximumSuppression_hpp
+
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+namespace otter {
+class Tensor;
+
+namespace cv {
+
+// All the boxes are stored as SoA tensor with shape {4, N}
+// row 0: xmin, row 1: ymin, row 2: xmax, row 3: ymax
+// scores is Float {N}, labels is Int {N}
+// The returned indices (Long) are ordered by descending score
+
+enum class SoftNmsMethod {
+    Linear,
+    Gaussian
+};
+
+// Class agnostic, every box can suppress every other box
+Tensor nms(const Tensor& boxes, const Tensor& scores, float iou_threshold, int64_t max_output = -1);
+
+// Class aware, only the boxes with the same label suppress each other
+Tensor multiclass_nms(const Tensor& boxes, const Tensor& scores, const Tensor& labels, float iou_threshold, int64_t max_output = -1);
+
+// Independent nms for each image, boxes {B, 4, N}, scores {B, N}, labels {B, N} or undefined for class agnostic
+std::vector<Tensor> batched_nms(const Tensor& boxes, const Tensor& scores, const Tensor& labels, float iou_threshold, int64_t max_output = -1);
+
+// Return (indices, decayed scores of the kept boxes)
+// labels can be undefined for class agnostic
+std::tuple<Tensor, Tensor> soft_nms(const Tensor& boxes, const Tensor& scores, const Tensor& labels, SoftNmsMethod method, float sigma, float iou_threshold, float score_threshold, int64_t max_output = -1);
+
+}   // end namespace cv
+}   // end namespace otter
+
+#endif /* NonMaximumSuppression_hpp */
@@ -14,6 +14,9 @@
 #include "BatchNormalization.hpp"
 #include "TensorOperator.hpp"
 #include "ScalarOps.hpp"
+#include "TensorPacking.hpp"
+#include "Parallel.hpp"
+#include "Vec.hpp"
 
 namespace otter {
 
@@ -93,10 +96,82 @@ Tensor batchnorm(const Tensor& self, const Tensor& weight, const Tensor& bias, c
     return std::get<0>(batchnorm_cpu(self, weight, bias, running_mean, running_var, train, momentum, eps));
 }
 
+static void batchnorm_alpha_beta_impl(Tensor& output, const Tensor& self, const Tensor& alpha, const Tensor& beta) {
+    if (is_contiguous(self) && output.is_contiguous(self.suggest_memory_format()) && alpha.is_contiguous() && beta.is_contiguous()) {
+        batchnorm_cpu_alpha_beta_stub(Device::CPU, output, self, alpha, beta);
+        return;
+    }
+    
+    const int64_t ndim = self.dim();
+    DimVector sizes(ndim, 1);
+    DimVector strides(ndim, 0);
+    
+    auto as_nd = [&](const Tensor& t) {
+        sizes[1] = t.sizes()[0];
+        strides[1] = t.strides()[0];
+        return t.as_strided(sizes, strides);
+    };
+    
+    // output may be self, the iterator rejects the partial overlap only
+    auto iter = TensorIteratorConfig()
+                .add_output(output)
+                .add_input(self)
+                .add_input(as_nd(alpha))
+                .add_input(as_nd(beta))
+                .build();
+    
+    OTTER_DISPATCH_FLOATING_TYPES(self.scalar_type(), "batchnorm_alpha_beta", [&] {
+        cpu_kernel(iter, [=](scalar_t input, scalar_t alpha, scalar_t beta) {
+            return input * alpha + beta;
+        });
+    });
+}
+
 Tensor batchnorm_alpha_beta(const Tensor& self, const Tensor& alpha, const Tensor& beta) {
     Tensor out = otter::empty_like(self, self.options());
-    batchnorm_cpu_alpha_beta_stub(Device::CPU, out, self, alpha, beta);
+    batchnorm_alpha_beta_impl(out, self, alpha, beta);
     return out;
 }
 
+Tensor& batchnorm_alpha_beta_(Tensor& self, const Tensor& alpha, const Tensor& beta) {
+    OTTER_CHECK(self.dim() >= 2 && alpha.dim() == 1 && beta.dim() == 1 && alpha.size(0) == self.size(1) && beta.size(0) == self.size(1), "batchnorm_alpha_beta_: Expect alpha and beta {", self.size(1), "} but get ", alpha.sizes(), " and ", beta.sizes());
+    
+    batchnorm_alpha_beta_impl(self, self, alpha, beta);
+    return self;
+}
+
+Tensor& batchnorm_alpha_beta_packed_(Tensor& self, const Tensor& alpha, const Tensor& beta) {
+    using Vec = vec::Vectorized<float>;
+    
+    OTTER_CHECK(otter::is_packed(self) && self.is_contiguous() && self.size(4) == Vec::size() && self.scalar_type() == ScalarType::Float, "batchnorm_alpha_beta_packed_: Expect contiguous packed float tensor but get ", self.sizes());
+    
+    const int64_t channel_blocks = self.size(1);
+    const int64_t planes = self.size(0) * channel_blocks;
+    const int64_t image_size = self.size(2) * self.size(3);
+    OTTER_CHECK(alpha.numel() == channel_blocks * Vec::size() && beta.numel() == channel_blocks * Vec::size(), "batchnorm_alpha_beta_packed_: Expect alpha and beta {", channel_blocks * Vec::size(), "}");
+    
+    Tensor alpha_contiguous = alpha.to(ScalarType::Float).contiguous();
+    Tensor beta_contiguous = beta.to(ScalarType::Float).contiguous();
+    
+    const float* alpha_data = alpha_contiguous.data_ptr<float>();
+    const float* beta_data = beta_contiguous.data_ptr<float>();
+    float* self_data = self.data_ptr<float>();
+    
+    otter::parallel_for(0, planes, 0, [&](int64_t begin, int64_t end) {
+        for (const auto plane : otter::irange(begin, end)) {
+            const int64_t cb = plane % channel_blocks;
+            const Vec alpha_vec = Vec::loadu(alpha_data + cb * Vec::size());
+            const Vec beta_vec = Vec::loadu(beta_data + cb * Vec::size());
+            float* ptr = self_data + plane * image_size * Vec::size();
+            
+            for (const auto i : otter::irange(image_size)) {
+                Vec data_vec = Vec::loadu(ptr + i * Vec::size());
+                (data_vec * alpha_vec + beta_vec).store(ptr + i * Vec::size());
+            }
+        }
+    });
+    
+    return self;
+}
+
 }   // end namespace otter
@@ -20,6 +20,12 @@ Tensor batchnorm(const Tensor& self, const Tensor& weight, const Tensor& bias, c
 
 Tensor batchnorm_alpha_beta(const Tensor& self, const Tensor& alpha, const Tensor& beta);
 
+// self = self * alpha + beta, alpha and beta are {C}
+Tensor& batchnorm_alpha_beta_(Tensor& self, const Tensor& alpha, const Tensor& beta);
+
+// Same as above on the channel blocked self {N, C / elempack, H, W, elempack}
+Tensor& batchnorm_alpha_beta_packed_(Tensor& self, const Tensor& alpha, const Tensor& beta);
+
 }
 
 #endif /* Normalization_hpp */
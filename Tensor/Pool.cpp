@@ -6,11 +6,16 @@
 //
 
 #include "TensorFunction.hpp"
+#include "TensorFactory.hpp"
+#include "TensorResize.hpp"
 #include "Pool.hpp"
 
 namespace otter {
 
 DEFINE_DISPATCH(max_pool2d_stub);
+DEFINE_DISPATCH(max_pool2d_implicit_pad_stub);
+DEFINE_DISPATCH(avg_pool2d_stub);
+DEFINE_DISPATCH(global_avg_pool2d_stub);
 
 DEFINE_META_FUNCTION(max_pool2d_with_indices) (const Tensor& input, IntArrayRef kernel_size, IntArrayRef stride, IntArrayRef padding, IntArrayRef dilation, bool ceil_mode) {
     OTTER_CHECK(kernel_size.size() == 1 || kernel_size.size() == 2, "max_pool2d: kernel_size must either be a single int, or a tuple of two ints")
@@ -88,4 +93,130 @@ Tensor max_pool2d(const Tensor& self, IntArrayRef kernel_size, IntArrayRef strid
     return std::get<0>(output_and_indices);
 }
 
+Tensor max_pool2d_implicit_pad(const Tensor& self, IntArrayRef kernel_size, IntArrayRef stride, IntArrayRef padding) {
+    Tensor output = otter::empty({0}, self.options());
+    
+    return max_pool2d_implicit_pad_out(output, self, kernel_size, stride, padding);
+}
+
+Tensor& max_pool2d_implicit_pad_out(Tensor& output, const Tensor& self, IntArrayRef kernel_size, IntArrayRef stride, IntArrayRef padding) {
+    OTTER_CHECK(kernel_size.size() == 2 && stride.size() == 2 && padding.size() == 4, "max_pool2d_implicit_pad: Expect kernel {h, w}, stride {h, w} and padding {top, bottom, left, right}");
+    // 5D is the channel blocked layout {N, C / elempack, H, W, elempack} (see TensorPacking.hpp)
+    const bool packed = self.dim() == 5;
+    const int64_t height_dim = packed ? 2 : self.dim() - 2;
+    OTTER_CHECK((self.dim() == 3 || self.dim() == 4 || packed) && self.size(height_dim) != 0 && self.size(height_dim + 1) != 0, "max_pool2d_implicit_pad: Expect non-empty 3D, 4D or packed 5D tensor but get ", self.sizes());
+    
+    const int kH = safe_downcast<int, int64_t>(kernel_size[0]);
+    const int kW = safe_downcast<int, int64_t>(kernel_size[1]);
+    const int dH = safe_downcast<int, int64_t>(stride[0]);
+    const int dW = safe_downcast<int, int64_t>(stride[1]);
+    const int padT = safe_downcast<int, int64_t>(padding[0]);
+    const int padB = safe_downcast<int, int64_t>(padding[1]);
+    const int padL = safe_downcast<int, int64_t>(padding[2]);
+    const int padR = safe_downcast<int, int64_t>(padding[3]);
+    
+    OTTER_CHECK(kH > 0 && kW > 0 && dH > 0 && dW > 0, "max_pool2d_implicit_pad: kernel size and stride should be greater than zero");
+    // Every window should cover at least one input element
+    OTTER_CHECK(padT >= 0 && padL >= 0 && padT < kH && padL < kW && padB < kH && padR < kW, "max_pool2d_implicit_pad: pad should be smaller than kernel size, but got ", padding, " with kernel ", kernel_size);
+    
+    const int64_t inputHeight = self.size(height_dim);
+    const int64_t inputWidth = self.size(height_dim + 1);
+    const int64_t outputHeight = (inputHeight + padT + padB - kH) / dH + 1;
+    const int64_t outputWidth = (inputWidth + padL + padR - kW) / dW + 1;
+    OTTER_CHECK(outputHeight >= 1 && outputWidth >= 1, "max_pool2d_implicit_pad: Output size is too small");
+    
+    if (packed) {
+        otter::native::resize_output(output, {self.size(0), self.size(1), outputHeight, outputWidth, self.size(4)});
+    } else if (self.dim() == 3) {
+        otter::native::resize_output(output, {self.size(0), outputHeight, outputWidth});
+    } else if (otter::native::resize_output(output, {self.size(0), self.size(1), outputHeight, outputWidth}) && self.suggest_memory_format() == MemoryFormat::ChannelsLast) {
+        output.unsafeGetTensorNucleus()->empty_tensor_restride(MemoryFormat::ChannelsLast);
+    }
+    
+    if (output.numel() == 0)
+        return output;
+    
+    max_pool2d_implicit_pad_stub(Device::CPU, output, self, kW, kH, dW, dH, padL, padT);
+    
+    return output;
+}
+
+DEFINE_META_FUNCTION(avg_pool2d) (const Tensor& input, IntArrayRef kernel_size, IntArrayRef stride, IntArrayRef padding, bool ceil_mode, bool count_include_pad, int64_t divisor_override) {
+    OTTER_CHECK(kernel_size.size() == 1 || kernel_size.size() == 2, "avg_pool2d: kernel_size must either be a single int, or a tuple of two ints");
+    const int64_t kH = kernel_size[0];
+    const int64_t kW = kernel_size.size() == 1 ? kH : kernel_size[1];
+    
+    OTTER_CHECK(stride.empty() || stride.size() == 1 || stride.size() == 2, "avg_pool2d: stride must either be omitted, a single int, or a tuple of two ints");
+    const int64_t dH = stride.empty() ? kH : stride[0];
+    const int64_t dW = stride.empty() ? kW : stride.size() == 1 ? dH : stride[1];
+    
+    OTTER_CHECK(padding.size() == 1 || padding.size() == 2, "avg_pool2d: padding must either be a single int, or a tuple of two ints");
+    const int64_t padH = padding[0];
+    const int64_t padW = padding.size() == 1 ? padH : padding[1];
+    
+    OTTER_CHECK(divisor_override >= 0, "divisor must be not zero");
+    
+    const int64_t nbatch = input.dim() == 4 ? input.size(-4) : 1;
+    const int64_t nInputPlane = input.size(-3);
+    const int64_t inputHeight = input.size(-2);
+    const int64_t inputWidth = input.size(-1);
+    
+    const int64_t outputHeight = pooling_output_shape<int64_t>(inputHeight, kH, padH, dH, 1, ceil_mode);
+    const int64_t outputWidth = pooling_output_shape<int64_t>(inputWidth, kW, padW, dW, 1, ceil_mode);
+    
+    auto memory_format = input.suggest_memory_format();
+    pool2d_shape_check(
+                       input,
+                       (int)kH, (int)kW, (int)dH, (int)dW, (int)padH, (int)padW, 1, 1,
+                       nInputPlane,
+                       inputHeight, inputWidth,
+                       outputHeight, outputWidth, memory_format);
+    
+    if (input.dim() == 3) {
+        set_output(0, {nInputPlane, outputHeight, outputWidth}, {}, input.options());
+    } else {
+        set_output(0, {nbatch, nInputPlane, outputHeight, outputWidth}, {}, input.options().memory_format(memory_format));
+    }
+}
+
+DEFINE_IMPL_FUNCTION(avg_pool2d_out_cpu) (const Tensor& input, IntArrayRef kernel_size, IntArrayRef stride, IntArrayRef padding, bool ceil_mode, bool count_include_pad, int64_t divisor_override, const Tensor& output) {
+    const int64_t kH = kernel_size[0];
+    const int64_t kW = kernel_size.size() == 1 ? kH : kernel_size[1];
+    
+    const int64_t dH = stride.empty() ? kH : stride[0];
+    const int64_t dW = stride.empty() ? kW : stride.size() == 1 ? dH : stride[1];
+    
+    const int64_t padH = padding[0];
+    const int64_t padW = padding.size() == 1 ? padH : padding[1];
+    
+    avg_pool2d_stub(Device::CPU, output, input, kW, kH, dW, dH, padW, padH, count_include_pad, divisor_override);
+}
+
+Tensor avg_pool2d(const Tensor& self, IntArrayRef kernel_size, IntArrayRef stride, IntArrayRef padding, bool ceil_mode, bool count_include_pad, int64_t divisor_override) {
+    return otter::native::avg_pool2d(self, kernel_size, stride, padding, ceil_mode, count_include_pad, divisor_override);
+}
+
+Tensor global_avg_pool2d(const Tensor& self) {
+    Tensor output = otter::empty({0}, self.options());
+    
+    return global_avg_pool2d_out(output, self);
+}
+
+Tensor& global_avg_pool2d_out(Tensor& output, const Tensor& self) {
+    OTTER_CHECK((self.dim() == 3 || self.dim() == 4) && self.size(-1) != 0 && self.size(-2) != 0, "global_avg_pool2d: Expect non-empty 3D or 4D tensor but get ", self.sizes());
+    
+    if (self.dim() == 3) {
+        otter::native::resize_output(output, {self.size(0), 1, 1});
+    } else {
+        otter::native::resize_output(output, {self.size(0), self.size(1), 1, 1});
+    }
+    
+    if (output.numel() == 0)
+        return output;
+    
+    global_avg_pool2d_stub(Device::CPU, output, self);
+    
+    return output;
+}
+
 }   // end namespace otter
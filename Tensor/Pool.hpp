@@ -17,11 +17,31 @@ namespace otter {
 using max_pool2d_fn = void(*)(const Tensor& output, const Tensor& indices, const Tensor& input, int kW, int kH, int dW, int dH, int padW, int padH, int dilationW, int dilationH);
 DECLARE_DISPATCH(max_pool2d_fn, max_pool2d_stub);
 
+// Max pooling without indices, padW / padH are only the left / top padding
+// The right / bottom padding is implied by the output size, the padded elements are never read
+using max_pool2d_implicit_pad_fn = void(*)(const Tensor& output, const Tensor& input, int kW, int kH, int dW, int dH, int padW, int padH);
+DECLARE_DISPATCH(max_pool2d_implicit_pad_fn, max_pool2d_implicit_pad_stub);
+
+// divisor_override = 0 means no override
 using avg_pool2d_fn = void(*)(const Tensor& output, const Tensor& input, int64_t kW, int64_t kH, int64_t dW, int64_t dH, int64_t padW, int64_t padH, bool count_include_pad, int64_t divisor_override);
-DECLARE_DISPATCH(avg_pool2d_fn, avg_pool2d_kernel);
+DECLARE_DISPATCH(avg_pool2d_fn, avg_pool2d_stub);
+
+// output {N, C, 1, 1} or {C, 1, 1}
+using global_avg_pool2d_fn = void(*)(const Tensor& output, const Tensor& input);
+DECLARE_DISPATCH(global_avg_pool2d_fn, global_avg_pool2d_stub);
 
 Tensor max_pool2d(const Tensor& self, IntArrayRef kernel_size, IntArrayRef stride, IntArrayRef padding, IntArrayRef dilation, bool ceil_mode);
 
+// padding is {top, bottom, left, right} and can be asymmetric (e.g. darknet mode), no padded copy is made
+// output size is (input + top + bottom - kernel) / stride + 1
+Tensor max_pool2d_implicit_pad(const Tensor& self, IntArrayRef kernel_size, IntArrayRef stride, IntArrayRef padding);
+Tensor& max_pool2d_implicit_pad_out(Tensor& output, const Tensor& self, IntArrayRef kernel_size, IntArrayRef stride, IntArrayRef padding);
+
+Tensor avg_pool2d(const Tensor& self, IntArrayRef kernel_size, IntArrayRef stride, IntArrayRef padding, bool ceil_mode, bool count_include_pad, int64_t divisor_override = 0);
+
+Tensor global_avg_pool2d(const Tensor& self);
+Tensor& global_avg_pool2d_out(Tensor& output, const Tensor& self);
+
 template <typename dest_t, typename src_t>
 static inline dest_t
 safe_downcast(src_t v) {
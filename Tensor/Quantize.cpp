@@ -0,0 +1,143 @@
+//
+//  Quantize.cpp
+//  Tensor
+//
+//  Created by 陳均豪 on 2022/3/22.
+//
+
+#include "Quantize.hpp"
+#include "Tensor.hpp"
+#include "TensorFactory.hpp"
+#include "Parallel.hpp"
+#include "Vec.hpp"
+#include "VecIntrinsic.hpp"
+#include "Config.hpp"
+
+#include <cmath>
+
+namespace otter {
+
+// Elements per parallel chunk
+static constexpr int64_t QUANTIZE_GRAIN = 32768;
+
+static inline int8_t quantize_value(float x, float inv_scale) {
+    // Round half to even as the vector conversion does
+    float q = std::nearbyint(x * inv_scale);
+    q = std::min(127.f, std::max(-127.f, q));
+    return static_cast<int8_t>(q);
+}
+
+static void quantize_int8_kernel(int8_t* output, const float* input, int64_t size, float inv_scale) {
+    int64_t i = 0;
+#if CPU_CAPABILITY_AVX2
+    const __m256 inv_scale_vec = _mm256_set1_ps(inv_scale);
+    const __m256 lower = _mm256_set1_ps(-127.f);
+    const __m256 upper = _mm256_set1_ps(127.f);
+    const __m256i permute = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    auto convert = [&](const float* ptr) {
+        return _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(ptr), inv_scale_vec), lower), upper));
+    };
+    for (; i + 32 <= size; i += 32) {
+        __m256i a = convert(input + i);
+        __m256i b = convert(input + i + 8);
+        __m256i c = convert(input + i + 16);
+        __m256i d = convert(input + i + 24);
+        // The packs work on the 128 bit lanes, permute the dwords back to the order
+        __m256i packed = _mm256_packs_epi16(_mm256_packs_epi32(a, b), _mm256_packs_epi32(c, d));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i), _mm256_permutevar8x32_epi32(packed, permute));
+    }
+#endif
+    for (; i < size; ++i) {
+        output[i] = quantize_value(input[i], inv_scale);
+    }
+}
+
+Tensor quantize_int8(const Tensor& input, float scale) {
+    OTTER_CHECK(input.scalar_type() == ScalarType::Float, "quantize_int8: Expect float input but get ", toString(input.scalar_type()));
+    OTTER_CHECK(scale > 0, "quantize_int8: Expect positive scale but get ", scale);
+
+    Tensor input_contiguous = input.contiguous();
+    Tensor output = otter::empty(input.sizes(), ScalarType::Char);
+
+    const float* input_data = input_contiguous.data_ptr<float>();
+    int8_t* output_data = output.data_ptr<int8_t>();
+    const float inv_scale = 1.f / scale;
+
+    otter::parallel_for(0, input.numel(), QUANTIZE_GRAIN, [&](int64_t begin, int64_t end) {
+        quantize_int8_kernel(output_data + begin, input_data + begin, end - begin, inv_scale);
+    });
+
+    return output;
+}
+
+Tensor dequantize_int8(const Tensor& input, float scale) {
+    OTTER_CHECK(input.scalar_type() == ScalarType::Char, "dequantize_int8: Expect Char input but get ", toString(input.scalar_type()));
+
+    Tensor input_contiguous = input.contiguous();
+    Tensor output = otter::empty(input.sizes(), ScalarType::Float);
+
+    const int8_t* input_data = input_contiguous.data_ptr<int8_t>();
+    float* output_data = output.data_ptr<float>();
+
+    otter::parallel_for(0, input.numel(), QUANTIZE_GRAIN, [&](int64_t begin, int64_t end) {
+        int64_t i = begin;
+#if CPU_CAPABILITY_AVX2
+        const __m256 scale_vec = _mm256_set1_ps(scale);
+        for (; i + 8 <= end; i += 8) {
+            __m256i q = _mm256_cvtepi8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(input_data + i)));
+            _mm256_storeu_ps(output_data + i, _mm256_mul_ps(_mm256_cvtepi32_ps(q), scale_vec));
+        }
+#endif
+        for (; i < end; ++i) {
+            output_data[i] = input_data[i] * scale;
+        }
+    });
+
+    return output;
+}
+
+Tensor int8_weight_scale(const Tensor& weight) {
+    OTTER_CHECK(weight.dim() >= 1, "int8_weight_scale: Expect the weight {out_channels, ...}");
+
+    const int64_t out_channels = weight.size(0);
+    Tensor weight_contiguous = weight.to(ScalarType::Float).contiguous();
+    const int64_t channel_size = (out_channels == 0) ? 0 : weight.numel() / out_channels;
+    Tensor scale = otter::empty({out_channels}, ScalarType::Float);
+
+    const float* weight_data = weight_contiguous.data_ptr<float>();
+    float* scale_data = scale.data_ptr<float>();
+
+    for (const auto o : otter::irange(out_channels)) {
+        const float* src = weight_data + o * channel_size;
+
+        float absmax = 0.f;
+        for (const auto k : otter::irange(channel_size)) {
+            absmax = std::max(absmax, std::fabs(src[k]));
+        }
+        scale_data[o] = (absmax == 0.f) ? 1.f : absmax / 127.f;
+    }
+
+    return scale;
+}
+
+Tensor quantize_int8_per_channel(const Tensor& weight, const Tensor& scale) {
+    OTTER_CHECK(weight.dim() >= 1 && scale.dim() == 1 && scale.size(0) == weight.size(0), "quantize_int8_per_channel: Expect scale {", weight.size(0), "} but get ", scale.sizes());
+
+    const int64_t out_channels = weight.size(0);
+    Tensor weight_contiguous = weight.to(ScalarType::Float).contiguous();
+    Tensor scale_contiguous = scale.to(ScalarType::Float).contiguous();
+    const int64_t channel_size = (out_channels == 0) ? 0 : weight.numel() / out_channels;
+    Tensor output = otter::empty(weight.sizes(), ScalarType::Char);
+
+    const float* weight_data = weight_contiguous.data_ptr<float>();
+    const float* scale_data = scale_contiguous.data_ptr<float>();
+    int8_t* output_data = output.data_ptr<int8_t>();
+
+    for (const auto o : otter::irange(out_channels)) {
+        quantize_int8_kernel(output_data + o * channel_size, weight_data + o * channel_size, channel_size, 1.f / scale_data[o]);
+    }
+
+    return output;
+}
+
+}   // end namespace otter
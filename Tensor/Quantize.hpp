@@ -0,0 +1,33 @@
+//
+//  Quantize.hpp
+//  Tensor
+//
+//  Created by 陳均豪 on 2022/3/22.
+//
+
+#ifndef Quantize_hpp
+#define Quantize_hpp
+
+#include <tuple>
+
+namespace otter {
+
+class Tensor;
+
+// Symmetric int8 quantization, real = q * scale with q in [-127, 127]
+
+// float -> Char with the same shape, the output is contiguous
+Tensor quantize_int8(const Tensor& input, float scale);
+
+// Char -> float with the same shape, the output is contiguous
+Tensor dequantize_int8(const Tensor& input, float scale);
+
+// Per output channel scale of the weight {out_channels, ...}, absmax / 127
+Tensor int8_weight_scale(const Tensor& weight);
+
+// Quantize the weight {out_channels, ...} with the per output channel scale
+Tensor quantize_int8_per_channel(const Tensor& weight, const Tensor& scale);
+
+}   // end namespace otter
+
+#endif /* Quantize_hpp */
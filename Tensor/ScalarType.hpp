@@ -13,6 +13,8 @@
 #include <cmath>
 
 #include "TypeCast.hpp"
+#include "Half.hpp"
+#include "BFloat16.hpp"
 
 namespace otter {
 
@@ -23,7 +25,9 @@ _(int16_t, Short)                                              \
 _(int, Int)                                                    \
 _(int64_t, Long)                                               \
 _(float, Float)                                                \
-_(double, Double)
+_(double, Double)                                              \
+_(otter::Half, Half)                                           \
+_(otter::BFloat16, BFloat16)
 
 #define OTTER_ALL_SCALAR_TYPES(_)       \
 _(uint8_t, Byte)      /* 0 */       \
@@ -33,7 +37,9 @@ _(int, Int)           /* 3 */       \
 _(int64_t, Long)      /* 4 */       \
 _(float, Float)       /* 5 */       \
 _(double, Double)     /* 6 */       \
-_(bool, Bool)         /* 7 */
+_(bool, Bool)         /* 7 */       \
+_(otter::Half, Half)  /* 8 */       \
+_(otter::BFloat16, BFloat16) /* 9 */
 
 enum class ScalarType : int8_t {
 #define DEFINE_ENUM(_1, n) n,
@@ -75,7 +81,7 @@ static inline bool isIntegralType(ScalarType t, bool includeBool) {
 
 static inline bool isFloatingType(ScalarType t) {
   return (
-      t == ScalarType::Double || t == ScalarType::Float);
+      t == ScalarType::Double || t == ScalarType::Float || t == ScalarType::Half || t == ScalarType::BFloat16);
 }
 
 template <ScalarType N>
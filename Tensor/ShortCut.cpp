@@ -0,0 +1,198 @@
+//
+//  ShortCut.cpp
+//  Tensor
+//
+//  Created by 陳均豪 on 2022/3/22.
+//
+
+#include "ShortCut.hpp"
+#include "Tensor.hpp"
+#include "TensorFactory.hpp"
+#include "TensorPacking.hpp"
+#include "TensorIterator.hpp"
+#include "Parallel.hpp"
+#include "Vec.hpp"
+
+#include <algorithm>
+
+namespace otter {
+
+using Vec = vec::Vectorized<float>;
+
+// Each row holds the channels of one image (NCHW and packed) or of one pixel (channels last),
+// the overlapped channels of every input are the head of its row
+struct ShortCutGeometry {
+    int64_t rows;
+    int64_t channels;
+    int64_t inner;
+};
+
+static ShortCutGeometry shortcut_geometry(const Tensor& t, bool channels_last) {
+    if (channels_last) {
+        return {t.size(0) * t.size(2) * t.size(3), t.size(1), 1};
+    }
+    return {t.size(0), t.size(1), t.numel() / std::max<int64_t>(t.size(0) * t.size(1), 1)};
+}
+
+// The distance between the output rows, -1 when the rows are not dense
+static int64_t shortcut_output_row_stride(const Tensor& output, bool channels_last) {
+    if (channels_last) {
+        const bool dense = (output.stride(1) == 1 || output.size(1) == 1) &&
+            output.stride(3) >= output.size(1) &&
+            (output.size(2) == 1 || output.stride(2) == output.size(3) * output.stride(3)) &&
+            (output.size(0) == 1 || output.stride(0) == output.size(2) * output.size(3) * output.stride(3));
+        return dense ? output.stride(3) : -1;
+    }
+    int64_t expected = 1;
+    for (int64_t d = output.dim() - 1; d >= 1; --d) {
+        if (output.size(d) != 1 && output.stride(d) != expected)
+            return -1;
+        expected *= output.size(d);
+    }
+    return (output.size(0) == 1) ? expected : output.stride(0);
+}
+
+struct ShortCutSegment {
+    int64_t end;
+    int64_t active;     // the leading inputs (in the order of the descending span) covering the segment
+};
+
+static inline Vec shortcut_activation(Vec acc, ShortCutActivation activation, float activation_param) {
+    switch (activation) {
+        case ShortCutActivation::Relu:
+            return vec::maximum(acc, Vec(0.f));
+        case ShortCutActivation::LeakyRelu:
+            return acc * Vec::blendv(Vec(activation_param), Vec(1.f), acc > Vec(0.f));
+        default:
+            return acc;
+    }
+}
+
+// out[0, size) = activation(sum of weights[j] * inputs[j][0, size)) over the active inputs, the first is inputs[0]
+static inline void shortcut_segment(float* out, const float* const* inputs, const float* weights, int64_t active, int64_t size, ShortCutActivation activation, float activation_param) {
+    int64_t d = 0;
+    for (; d < size; d += Vec::size()) {
+        const int count = static_cast<int>(std::min<int64_t>(Vec::size(), size - d));
+        Vec acc = Vec::loadu(inputs[0] + d, count);
+        if (weights) {
+            acc = acc * Vec(weights[0]);
+            for (const auto j : otter::irange(1, active)) {
+                acc = acc + Vec::loadu(inputs[j] + d, count) * Vec(weights[j]);
+            }
+        } else {
+            for (const auto j : otter::irange(1, active)) {
+                acc = acc + Vec::loadu(inputs[j] + d, count);
+            }
+        }
+        acc = shortcut_activation(acc, activation, activation_param);
+        if (count == Vec::size()) {
+            acc.store(out + d);
+        } else {
+            acc.store(out + d, count);
+        }
+    }
+}
+
+Tensor& shortcut_out(Tensor& output, TensorList inputs, ArrayRef<float> weights, ShortCutActivation activation, float activation_param) {
+    OTTER_CHECK(inputs.size() > 0, "[ShortCut] Expect at least one input");
+    OTTER_CHECK(weights.empty() || weights.size() == inputs.size(), "[ShortCut] Expect ", inputs.size(), " weights but get ", weights.size());
+
+    const Tensor& first = inputs[0];
+    OTTER_CHECK(first.scalar_type() == ScalarType::Float, "[ShortCut] Expect Float input but get ", toString(first.scalar_type()));
+    OTTER_CHECK(first.dim() >= 2, "[ShortCut] Expect the input with channels but get ", first.sizes());
+
+    const bool channels_last = !otter::is_packed(first) && first.dim() == 4 && first.suggest_memory_format() == MemoryFormat::ChannelsLast;
+    const MemoryFormat memory_format = channels_last ? MemoryFormat::ChannelsLast : MemoryFormat::Contiguous;
+
+    const int64_t ninputs = inputs.size();
+    std::vector<Tensor> contiguous_inputs(ninputs);
+    for (const auto i : otter::irange(ninputs)) {
+        const Tensor& input = inputs[i];
+        OTTER_CHECK(input.scalar_type() == ScalarType::Float, "[ShortCut] Expect Float input but get ", toString(input.scalar_type()), " for input ", i);
+        OTTER_CHECK(input.dim() == first.dim(), "[ShortCut] Expect ", first.dim(), "D input but get ", input.sizes(), " for input ", i);
+        for (const auto d : otter::irange(first.dim())) {
+            OTTER_CHECK(d == 1 || input.size(d) == first.size(d), "[ShortCut] Sizes of the inputs must match except the channels, expect ", first.sizes(), " but get ", input.sizes(), " for input ", i);
+        }
+        contiguous_inputs[i] = input.contiguous(memory_format);
+    }
+
+    if (!output.defined() || output.sizes() != first.sizes()) {
+        output = otter::empty(first.sizes(), first.options().memory_format(memory_format));
+    }
+    if (first.numel() == 0) {
+        return output;
+    }
+
+    // Write the dense result back when the output rows are strided
+    const int64_t output_row_stride = shortcut_output_row_stride(output, channels_last);
+    if (output_row_stride < 0) {
+        Tensor result = otter::empty(first.sizes(), first.options().memory_format(memory_format));
+        shortcut_out(result, inputs, weights, activation, activation_param);
+        output.copy_(result);
+        return output;
+    }
+
+    const ShortCutGeometry geometry = shortcut_geometry(first, channels_last);
+    const int64_t row_size = geometry.channels * geometry.inner;
+
+    // Sort the other inputs by the overlapped span so that the inputs covering a segment are the leading ones
+    std::vector<int64_t> order(ninputs - 1);
+    for (const auto i : otter::irange(1, ninputs)) {
+        order[i - 1] = i;
+    }
+    std::vector<int64_t> spans(ninputs);
+    for (const auto i : otter::irange(ninputs)) {
+        spans[i] = std::min(contiguous_inputs[i].size(1), geometry.channels) * geometry.inner;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](int64_t a, int64_t b) { return spans[a] > spans[b]; });
+    order.insert(order.begin(), 0);
+
+    std::vector<ShortCutSegment> segments;
+    for (int64_t active = ninputs; active > 0; --active) {
+        const int64_t end = spans[order[active - 1]];
+        if (end > 0 && (segments.empty() || end > segments.back().end)) {
+            segments.push_back({end, active});
+        }
+    }
+
+    std::vector<const float*> input_data(ninputs);
+    std::vector<int64_t> input_row_size(ninputs);
+    std::vector<float> sorted_weights;
+    for (const auto j : otter::irange(ninputs)) {
+        input_data[j] = contiguous_inputs[order[j]].data_ptr<float>();
+        input_row_size[j] = contiguous_inputs[order[j]].size(1) * geometry.inner;
+        if (!weights.empty()) {
+            sorted_weights.push_back(weights[order[j]]);
+        }
+    }
+    const float* weight_data = sorted_weights.empty() ? nullptr : sorted_weights.data();
+    float* output_data = output.data_ptr<float>();
+
+    otter::parallel_for(0, geometry.rows, otter::GRAIN_SIZE / row_size + 1, [&](int64_t begin, int64_t end) {
+        std::vector<const float*> rows(ninputs);
+        for (const auto r : otter::irange(begin, end)) {
+            for (const auto j : otter::irange(ninputs)) {
+                rows[j] = input_data[j] + r * input_row_size[j];
+            }
+            float* out = output_data + r * output_row_stride;
+
+            int64_t start = 0;
+            for (const auto& segment : segments) {
+                shortcut_segment(out + start, rows.data(), weight_data, segment.active, segment.end - start, activation, activation_param);
+                for (const auto j : otter::irange(segment.active)) {
+                    rows[j] += segment.end - start;
+                }
+                start = segment.end;
+            }
+        }
+    });
+
+    return output;
+}
+
+Tensor shortcut(TensorList inputs, ArrayRef<float> weights, ShortCutActivation activation, float activation_param) {
+    Tensor output;
+    return shortcut_out(output, inputs, weights, activation, activation_param);
+}
+
+}   // end namespace otter
@@ -0,0 +1,34 @@
+//
+//  ShortCut.hpp
+//  Tensor
+//
+//  Created by 陳均豪 on 2022/3/22.
+//
+
+#ifndef ShortCut_hpp
+#define ShortCut_hpp
+
+#include "ArrayRef.hpp"
+
+namespace otter {
+
+class Tensor;
+
+enum class ShortCutActivation : int {
+    None,
+    Relu,
+    LeakyRelu
+};
+
+// Darknet shortcut, output = activation(weights[0] * inputs[0] + ... + weights[n - 1] * inputs[n - 1]) in one pass
+// The output has the size of inputs[0], inputs[i] only contributes to the first min(C_0, C_i) channels
+// All the inputs share the layout of inputs[0] (NCHW, channels last or packed) and the size except the channels
+// Empty weights mean all ones
+// The output can be inputs[0] itself or a slice whose images are dense (e.g. the output of Concat)
+Tensor& shortcut_out(Tensor& output, TensorList inputs, ArrayRef<float> weights, ShortCutActivation activation, float activation_param);
+
+Tensor shortcut(TensorList inputs, ArrayRef<float> weights, ShortCutActivation activation, float activation_param);
+
+}   // end namespace otter
+
+#endif /* ShortCut_hpp */
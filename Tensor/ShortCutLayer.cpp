@@ -7,24 +7,69 @@
 
 #include "ShortCutLayer.hpp"
 #include "LayerRegistry.hpp"
-#include "TensorOperator.hpp"
 #include "TensorFactory.hpp"
+#include "ShortCut.hpp"
+
+#include <algorithm>
+#include <sstream>
 
 namespace otter {
 
 ShortCutLayer::ShortCutLayer() {
     one_blob_only = false;
-    support_inplace = false;
+    support_inplace = true;
+    support_packing = true;
+    support_channels_last = true;
+    support_view_output = true;
 }
 
 int ShortCutLayer::parse_param(LayerOption& option, ParamDict &pd) {
-    // alpha beta
+    pd.clear();
+    
+    // One weight per input, all ones by default
+    if (opt_find(option, "weights")) {
+        int num_weights = (int)std::count(option["weights"].begin(), option["weights"].end(), ',') + 1;
+        Tensor weights = otter::empty({num_weights}, otter::ScalarType::Float);
+        auto weights_a = weights.accessor<float, 1>();
+        
+        std::stringstream ss;
+        ss << option["weights"];
+        float weight;
+        char c;
+        for (const auto i : otter::irange(num_weights)) {
+            ss >> weight >> c;
+            weights_a[i] = weight;
+        }
+        pd.set((int)ShortCutParam::Weights, weights);
+    }
+    
+    // The activation is fused into the sum, see Net::addLayer()
+    int activation_type = (int)ShortCutActivation::None;
+    float activation_param = 0.f;
+    if (opt_find(option, "activation")) {
+        if (option["activation"] == "Relu") {
+            activation_type = (int)ShortCutActivation::Relu;
+        } else if (option["activation"] == "LRelu") {
+            activation_type = (int)ShortCutActivation::LeakyRelu;
+            activation_param = opt_find_float(option, "alpha", 0.1f);
+        }
+    }
+    
+    pd.set((int)ShortCutParam::Activation_type, activation_type);
+    pd.set((int)ShortCutParam::Activation_param, activation_param);
     
     return 0;
 }
 
 int ShortCutLayer::load_param(const ParamDict &pd) {
-    // alpha beta
+    Tensor weights_tensor = pd.get((int)ShortCutParam::Weights, Tensor());
+    weights.clear();
+    if (weights_tensor.defined()) {
+        const float* weights_ptr = weights_tensor.data_ptr<float>();
+        weights.assign(weights_ptr, weights_ptr + weights_tensor.numel());
+    }
+    activation_type = pd.get((int)ShortCutParam::Activation_type, 0);
+    activation_param = pd.get((int)ShortCutParam::Activation_param, 0.f);
     
     return 0;
 }
@@ -35,45 +80,20 @@ int ShortCutLayer::compute_output_shape(ParamDict &pd) {
     return 0;
 }
 
-ShortCutBackend shortcut_check_and_select_backend(const Tensor& self, const Tensor& other) {
-    OTTER_CHECK(self.size(0) == self.size(0), "[Shortcut] Batch size should be the same, but get ", self.size(0), " != ", other.size(0));
-    OTTER_CHECK(self.size(2) == self.size(2), "[Shortcut] Height should be the same, but get ", self.size(0), " != ", other.size(0));
-    OTTER_CHECK(self.size(3) == self.size(3), "[Shortcut] Width size should be the same, but get ", self.size(0), " != ", other.size(0));
+int ShortCutLayer::forward(const std::vector<Tensor>& bottom_blobs, std::vector<Tensor>& top_blobs, const NetOption& opt) const {
+    top_blobs[0] = otter::shortcut(bottom_blobs, weights, (ShortCutActivation)activation_type, activation_param);
     
-    return (self.size(1) != other.size(1)) ? ShortCutBackend::Darknet_shortcut : ShortCutBackend::Eltwise_add;
+    return 0;
 }
 
-int ShortCutLayer::forward(const std::vector<Tensor>& bottom_blobs, std::vector<Tensor>& top_blobs, const NetOption& opt) const {
-    const Tensor& bottom_blob = bottom_blobs[0];
-    const Tensor& bottom_blob_next = bottom_blobs[1];
-    Tensor output = bottom_blob.clone();
-    
-    ShortCutBackend backend = shortcut_check_and_select_backend(bottom_blob, bottom_blob_next);
-    switch (backend) {
-        case ShortCutBackend::Darknet_shortcut: break;
-        case ShortCutBackend::Eltwise_add: output = bottom_blob + bottom_blob_next; break;
-    }
-    
-    for (size_t i = 2; i < bottom_blobs.size(); ++i) {
-        const Tensor& bottom_blob_next = bottom_blobs[i];
-        ShortCutBackend backend = shortcut_check_and_select_backend(bottom_blob, bottom_blob_next);
-        switch (backend) {
-            case ShortCutBackend::Darknet_shortcut: {
-                // TODO: darknet version shortcut
-                break;
-            }
-            case ShortCutBackend::Eltwise_add: {
-                if (opt.use_non_lib_optimize) {
-                    // TODO: shortcut enhancement
-                } else {
-                    output = output + bottom_blob_next;
-                }
-                break;
-            }
-        }
-    }
+int ShortCutLayer::forward_inplace(std::vector<Tensor>& bottom_blobs, const NetOption& opt) const {
+    otter::shortcut_out(bottom_blobs[0], bottom_blobs, weights, (ShortCutActivation)activation_type, activation_param);
     
-    top_blobs[0] = output;
+    return 0;
+}
+
+int ShortCutLayer::forward_into(const std::vector<Tensor>& bottom_blobs, std::vector<Tensor>& top_blobs, const NetOption& opt) const {
+    otter::shortcut_out(top_blobs[0], bottom_blobs, weights, (ShortCutActivation)activation_type, activation_param);
     
     return 0;
 }
@@ -24,12 +24,22 @@ public:
     
     virtual int forward(const std::vector<Tensor>& bottom_blobs, std::vector<Tensor>& top_blobs, const NetOption& opt) const;
     
+    virtual int forward_inplace(std::vector<Tensor>& bottom_blobs, const NetOption& opt) const;
+    
+    virtual int forward_into(const std::vector<Tensor>& bottom_blobs, std::vector<Tensor>& top_blobs, const NetOption& opt) const;
+    
     virtual std::string type() const { return "ShortCut"; }
+    
+private:
+    std::vector<float> weights;
+    int activation_type;
+    float activation_param;
 };
 
-enum class ShortCutBackend {
-    Eltwise_add,
-    Darknet_shortcut
+enum class ShortCutParam {
+    Weights,
+    Activation_type,
+    Activation_param
 };
 
 }   // end namespace otter
@@ -13,6 +13,8 @@ namespace otter {
 SplitLayer::SplitLayer() {
     one_blob_only = false;
     support_inplace = false;
+    support_packing = true;
+    support_channels_last = true;
 }
 
 int SplitLayer::compute_output_shape(ParamDict &pd) {
@@ -9,6 +9,7 @@
 #include "Fill.hpp"
 #include "UnaryOps.hpp"
 #include "BinaryOps.hpp"
+#include "TernaryOps.hpp"
 #include "ScalarOps.hpp"
 #include "TensorFunction.hpp"
 #include "TensorConversion.hpp"
@@ -17,6 +18,7 @@
 #include "TensorFactory.hpp"
 #include "TensorShape.hpp"
 #include "TensorBlas.hpp"
+#include "TensorLinearAlgebra.hpp"
 #include "TensorProperties.hpp"
 #include "TensorScalar.hpp"
 
@@ -39,7 +41,7 @@ Tensor Tensor::clone(MemoryFormat memory_format) const {
 }
 
 Tensor Tensor::contiguous(MemoryFormat memory_format) const {
-    if (is_contiguous()) {
+    if (is_contiguous(memory_format)) {
         return *this;
     } else {
         return otter::contiguous(*this, memory_format);
@@ -350,6 +352,42 @@ Tensor Tensor::sqrt() const {
     return otter::native::sqrt(*this);
 }
 
+Tensor Tensor::clamp(const Scalar& min, const Scalar& max) const {
+    return otter::native::clamp(*this, min, max);
+}
+
+Tensor& Tensor::clamp_(const Scalar& min, const Scalar& max) const {
+    return otter::native::clamp_(const_cast<Tensor&>(*this), min, max);
+}
+
+Tensor Tensor::where(const Tensor& condition, const Tensor& other) const {
+    return otter::native::where(condition, *this, other);
+}
+
+Tensor Tensor::addcmul(const Tensor& tensor1, const Tensor& tensor2, const Scalar& value) const {
+    return otter::native::addcmul(*this, tensor1, tensor2, value);
+}
+
+Tensor& Tensor::addcmul_(const Tensor& tensor1, const Tensor& tensor2, const Scalar& value) const {
+    return otter::native::addcmul_(const_cast<Tensor&>(*this), tensor1, tensor2, value);
+}
+
+Tensor Tensor::lerp(const Tensor& end, const Scalar& weight) const {
+    return otter::native::lerp(*this, end, weight);
+}
+
+Tensor& Tensor::lerp_(const Tensor& end, const Scalar& weight) const {
+    return otter::native::lerp_(const_cast<Tensor&>(*this), end, weight);
+}
+
+Tensor Tensor::lerp(const Tensor& end, const Tensor& weight) const {
+    return otter::native::lerp(*this, end, weight);
+}
+
+Tensor& Tensor::lerp_(const Tensor& end, const Tensor& weight) const {
+    return otter::native::lerp_(const_cast<Tensor&>(*this), end, weight);
+}
+
 Tensor Tensor::dot(const Tensor& other) const {
     return otter::dot(*this, other);
 }
@@ -366,6 +404,14 @@ Tensor Tensor::mm(const Tensor &other) const {
     return otter::native::mm(*this, other);
 }
 
+Tensor Tensor::bmm(const Tensor &other) const {
+    return otter::bmm(*this, other);
+}
+
+Tensor Tensor::matmul(const Tensor &other) const {
+    return otter::matmul(*this, other);
+}
+
 #define DEFINE_ITEM(T, name)      \
     template <>                         \
     T Tensor::item() const {            \
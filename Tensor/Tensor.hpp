@@ -240,6 +240,19 @@ public:
     Tensor& sqrt_() const;
     Tensor sqrt() const;
     
+    Tensor clamp(const Scalar& min, const Scalar& max) const;
+    Tensor& clamp_(const Scalar& min, const Scalar& max) const;
+    
+    Tensor where(const Tensor& condition, const Tensor& other) const;
+    
+    Tensor addcmul(const Tensor& tensor1, const Tensor& tensor2, const Scalar& value = 1) const;
+    Tensor& addcmul_(const Tensor& tensor1, const Tensor& tensor2, const Scalar& value = 1) const;
+    
+    Tensor lerp(const Tensor& end, const Scalar& weight) const;
+    Tensor& lerp_(const Tensor& end, const Scalar& weight) const;
+    Tensor lerp(const Tensor& end, const Tensor& weight) const;
+    Tensor& lerp_(const Tensor& end, const Tensor& weight) const;
+    
     Tensor dot(const Tensor& other) const;
     
     Tensor addmm(const Tensor& mat1, const Tensor& mat2, const Scalar& beta = 1, const Scalar& alpha = 1) const;
@@ -247,6 +260,10 @@ public:
     
     Tensor mm(const Tensor& other) const;
     
+    Tensor bmm(const Tensor& other) const;
+    
+    Tensor matmul(const Tensor& other) const;
+    
 };
 
 template <typename T, typename... Args>
@@ -247,7 +247,12 @@ public:
                 break;
             }
             case MemoryFormat::ChannelsLast: {
-                NOT_IMPLEMENTED;
+                OTTER_CHECK(dim() == 4, "required rank 4 tensor to use channels_last format");
+                const auto strides = get_channels_last_strides_2d(sizes());
+                for (const auto i : otter::irange(dim())) {
+                    perspective_view_.stride_at(i) = strides[i];
+                }
+                break;
             }
             case MemoryFormat::ChannelsLast3d: {
                 NOT_IMPLEMENTED;
@@ -14,6 +14,7 @@
 namespace otter {
 
 DEFINE_DISPATCH(gemm_stub);
+DEFINE_DISPATCH(bmm_stub);
 
 #define INSTANTIATE_GEMM(T, S)                                          \
 template <>                                                             \
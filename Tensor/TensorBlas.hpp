@@ -43,6 +43,12 @@ using gemm_fn = void(*)(
 
 DECLARE_DISPATCH(gemm_fn, gemm_stub);
 
+// result {B, M, N} should be contiguous, self {B, M, K} and other {B, K, N} can be any strides,
+// the batch stride 0 (expanded) operand is shared by all the batch items
+using bmm_fn = void(*)(const Tensor& result, const Tensor& self, const Tensor& other);
+
+DECLARE_DISPATCH(bmm_fn, bmm_stub);
+
 template <typename scalar_t>
 void gemm(
     TransposeType transa, TransposeType transb,
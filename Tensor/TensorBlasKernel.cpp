@@ -10,6 +10,10 @@
 #include "Dispatch.hpp"
 #include "TensorBlas.hpp"
 #include "TensorBlasKernel.hpp"
+#include "Tensor.hpp"
+#include "TensorFactory.hpp"
+#include "Parallel.hpp"
+#include "Vec.hpp"
 
 namespace otter {
 
@@ -194,6 +198,295 @@ void cpublas_gemm_impl(
 
 REGISTER_DISPATCH(gemm_stub, &cpublas_gemm_impl);
 
+struct BmmProblem {
+    int64_t batch, m, n, k;
+    // strides of self (batch, m, k), other (batch, k, n)
+    int64_t a_stride_b, a_stride_m, a_stride_k;
+    int64_t b_stride_b, b_stride_k, b_stride_n;
+};
+
+template <typename scalar_t>
+void bmm_kernel_generic(scalar_t* c, const scalar_t* a, const scalar_t* b, const BmmProblem& p) {
+    otter::parallel_for(0, p.batch * p.m, 0, [&](int64_t begin, int64_t end) {
+        for (const auto index : otter::irange(begin, end)) {
+            const int64_t bs = index / p.m;
+            const int64_t i  = index % p.m;
+            
+            const scalar_t* a_row = a + bs * p.a_stride_b + i * p.a_stride_m;
+            const scalar_t* b_mat = b + bs * p.b_stride_b;
+            scalar_t* c_row = c + index * p.n;
+            
+            for (const auto j : otter::irange(p.n)) {
+                scalar_t sum = 0;
+                for (const auto l : otter::irange(p.k)) {
+                    sum += a_row[l * p.a_stride_k] * b_mat[l * p.b_stride_k + j * p.b_stride_n];
+                }
+                c_row[j] = sum;
+            }
+        }
+    });
+}
+
+using Vec = vec::Vectorized<float>;
+
+// The register block of the packed kernel: BMM_MR rows x BMM_NR columns of c
+constexpr int64_t BMM_MR = 4;
+constexpr int64_t BMM_NR = 2 * Vec::size();
+// The row block shared by one task, and the bytes of the packed b visited by one task
+constexpr int64_t BMM_MC = 64;
+constexpr int64_t BMM_PANEL_BYTES = 256 * 1024;
+
+// Pack b {k, n} into the panels {n / BMM_NR, k, BMM_NR}, the tail panel is padded with zero
+static void bmm_pack_panel(float* packed, const float* b, int64_t k, int64_t n, int64_t stride_k, int64_t stride_n) {
+    for (const auto l : otter::irange(k)) {
+        const float* b_row = b + l * stride_k;
+        float* packed_row = packed + l * BMM_NR;
+        
+        if (stride_n == 1 && n == BMM_NR) {
+            Vec::loadu(b_row).store(packed_row);
+            Vec::loadu(b_row + Vec::size()).store(packed_row + Vec::size());
+        } else {
+            int64_t j = 0;
+            for (; j < n; ++j) {
+                packed_row[j] = b_row[j * stride_n];
+            }
+            for (; j < BMM_NR; ++j) {
+                packed_row[j] = 0;
+            }
+        }
+    }
+}
+
+template <int64_t ROWS>
+static inline void bmm_micro_kernel(float* c, int64_t ldc, int64_t cols, const float* a, int64_t a_stride_m, int64_t a_stride_k, const float* panel, int64_t k) {
+    Vec acc0[ROWS];
+    Vec acc1[ROWS];
+    for (const auto r : otter::irange(ROWS)) {
+        acc0[r] = Vec(0.f);
+        acc1[r] = Vec(0.f);
+    }
+    
+    for (const auto l : otter::irange(k)) {
+        const Vec b0 = Vec::loadu(panel + l * BMM_NR);
+        const Vec b1 = Vec::loadu(panel + l * BMM_NR + Vec::size());
+        const float* a_col = a + l * a_stride_k;
+        
+        for (const auto r : otter::irange(ROWS)) {
+            const Vec a_value(a_col[r * a_stride_m]);
+            acc0[r] = vec::fmadd(a_value, b0, acc0[r]);
+            acc1[r] = vec::fmadd(a_value, b1, acc1[r]);
+        }
+    }
+    
+    for (const auto r : otter::irange(ROWS)) {
+        float* c_row = c + r * ldc;
+        if (cols == BMM_NR) {
+            acc0[r].store(c_row);
+            acc1[r].store(c_row + Vec::size());
+        } else if (cols > Vec::size()) {
+            acc0[r].store(c_row);
+            acc1[r].store(c_row + Vec::size(), cols - Vec::size());
+        } else {
+            acc0[r].store(c_row, cols);
+        }
+    }
+}
+
+static void bmm_tile(float* c, int64_t ldc, int64_t rows, int64_t cols, const float* a, int64_t a_stride_m, int64_t a_stride_k, const float* panel, int64_t k) {
+    switch (rows) {
+        case 4: bmm_micro_kernel<4>(c, ldc, cols, a, a_stride_m, a_stride_k, panel, k); break;
+        case 3: bmm_micro_kernel<3>(c, ldc, cols, a, a_stride_m, a_stride_k, panel, k); break;
+        case 2: bmm_micro_kernel<2>(c, ldc, cols, a, a_stride_m, a_stride_k, panel, k); break;
+        case 1: bmm_micro_kernel<1>(c, ldc, cols, a, a_stride_m, a_stride_k, panel, k); break;
+    }
+}
+
+// c {m = 1, n} = a {1, k} @ b {k, n}
+static void bmm_gemv_row(float* c, const float* a, const float* b, const BmmProblem& p) {
+    const int64_t n_block = BMM_NR * 16;
+    const int64_t n_blocks = divup(p.n, n_block);
+    
+    otter::parallel_for(0, p.batch * n_blocks, 0, [&](int64_t begin, int64_t end) {
+        for (const auto index : otter::irange(begin, end)) {
+            const int64_t bs = index / n_blocks;
+            const int64_t n_begin = (index % n_blocks) * n_block;
+            const int64_t n_end = std::min(p.n, n_begin + n_block);
+            
+            const float* a_row = a + bs * p.a_stride_b;
+            const float* b_mat = b + bs * p.b_stride_b;
+            float* c_row = c + bs * p.n;
+            
+            std::fill(c_row + n_begin, c_row + n_end, 0.f);
+            
+            // Four rows of b per pass to cut the load / store of c
+            int64_t l = 0;
+            if (p.b_stride_n == 1) {
+                for (; l + 4 <= p.k; l += 4) {
+                    const Vec a0(a_row[l * p.a_stride_k]);
+                    const Vec a1(a_row[(l + 1) * p.a_stride_k]);
+                    const Vec a2(a_row[(l + 2) * p.a_stride_k]);
+                    const Vec a3(a_row[(l + 3) * p.a_stride_k]);
+                    const float* b0 = b_mat + l * p.b_stride_k;
+                    const float* b1 = b0 + p.b_stride_k;
+                    const float* b2 = b1 + p.b_stride_k;
+                    const float* b3 = b2 + p.b_stride_k;
+                    
+                    int64_t j = n_begin;
+                    for (; j + Vec::size() <= n_end; j += Vec::size()) {
+                        Vec sum = vec::fmadd(a0, Vec::loadu(b0 + j), Vec::loadu(c_row + j));
+                        sum = vec::fmadd(a1, Vec::loadu(b1 + j), sum);
+                        sum = vec::fmadd(a2, Vec::loadu(b2 + j), sum);
+                        sum = vec::fmadd(a3, Vec::loadu(b3 + j), sum);
+                        sum.store(c_row + j);
+                    }
+                    for (; j < n_end; ++j) {
+                        c_row[j] += a_row[l * p.a_stride_k] * b0[j] + a_row[(l + 1) * p.a_stride_k] * b1[j] + a_row[(l + 2) * p.a_stride_k] * b2[j] + a_row[(l + 3) * p.a_stride_k] * b3[j];
+                    }
+                }
+            }
+            
+            for (; l < p.k; ++l) {
+                const float a_value = a_row[l * p.a_stride_k];
+                const float* b_row = b_mat + l * p.b_stride_k;
+                
+                int64_t j = n_begin;
+                if (p.b_stride_n == 1) {
+                    const Vec a_vec(a_value);
+                    for (; j + Vec::size() <= n_end; j += Vec::size()) {
+                        vec::fmadd(a_vec, Vec::loadu(b_row + j), Vec::loadu(c_row + j)).store(c_row + j);
+                    }
+                }
+                for (; j < n_end; ++j) {
+                    c_row[j] += a_value * b_row[j * p.b_stride_n];
+                }
+            }
+        }
+    });
+}
+
+// c {m, n = 1} = a {m, k} @ b {k, 1}
+static void bmm_gemv_col(float* c, const float* a, const float* b, const BmmProblem& p) {
+    otter::parallel_for(0, p.batch * p.m, 0, [&](int64_t begin, int64_t end) {
+        for (const auto index : otter::irange(begin, end)) {
+            const int64_t bs = index / p.m;
+            const int64_t i  = index % p.m;
+            
+            const float* a_row = a + bs * p.a_stride_b + i * p.a_stride_m;
+            const float* b_col = b + bs * p.b_stride_b;
+            
+            int64_t l = 0;
+            float sum = 0;
+            if (p.a_stride_k == 1 && p.b_stride_k == 1) {
+                Vec acc(0.f);
+                for (; l + Vec::size() <= p.k; l += Vec::size()) {
+                    acc = vec::fmadd(Vec::loadu(a_row + l), Vec::loadu(b_col + l), acc);
+                }
+                float partial[Vec::size()];
+                acc.store(partial);
+                for (const auto v : otter::irange(Vec::size())) {
+                    sum += partial[v];
+                }
+            }
+            for (; l < p.k; ++l) {
+                sum += a_row[l * p.a_stride_k] * b_col[l * p.b_stride_k];
+            }
+            c[index] = sum;
+        }
+    });
+}
+
+static void bmm_kernel_float(float* c, const float* a, const float* b, const BmmProblem& p) {
+    if (p.m == 1) {
+        bmm_gemv_row(c, a, b, p);
+        return;
+    }
+    if (p.n == 1) {
+        bmm_gemv_col(c, a, b, p);
+        return;
+    }
+    
+    // The expanded b is packed once and shared by all the batch items
+    const bool shared_b = (p.batch == 1 || p.b_stride_b == 0);
+    const int64_t packed_batch = shared_b ? 1 : p.batch;
+    const int64_t panels = divup(p.n, BMM_NR);
+    const int64_t panel_size = p.k * BMM_NR;
+    
+    Tensor packed_tensor = otter::empty({packed_batch * panels * panel_size}, ScalarType::Float);
+    float* packed = packed_tensor.data_ptr<float>();
+    
+    otter::parallel_for(0, packed_batch * panels, 0, [&](int64_t begin, int64_t end) {
+        for (const auto index : otter::irange(begin, end)) {
+            const int64_t bs = index / panels;
+            const int64_t panel = index % panels;
+            const int64_t n_begin = panel * BMM_NR;
+            
+            bmm_pack_panel(
+                packed + index * panel_size,
+                b + bs * p.b_stride_b + n_begin * p.b_stride_n,
+                p.k, std::min(BMM_NR, p.n - n_begin),
+                p.b_stride_k, p.b_stride_n);
+        }
+    });
+    
+    // Split the work into (batch, row block, panel block), the panel block fits in L2
+    const int64_t panels_per_block = std::max(int64_t(1), BMM_PANEL_BYTES / (panel_size * (int64_t)sizeof(float)));
+    const int64_t panel_blocks = divup(panels, panels_per_block);
+    const int64_t row_blocks = divup(p.m, BMM_MC);
+    
+    otter::parallel_for(0, p.batch * row_blocks * panel_blocks, 0, [&](int64_t begin, int64_t end) {
+        for (const auto index : otter::irange(begin, end)) {
+            const int64_t bs = index / (row_blocks * panel_blocks);
+            const int64_t row_block = (index / panel_blocks) % row_blocks;
+            const int64_t panel_block = index % panel_blocks;
+            
+            const int64_t m_begin = row_block * BMM_MC;
+            const int64_t m_end = std::min(p.m, m_begin + BMM_MC);
+            const int64_t panel_begin = panel_block * panels_per_block;
+            const int64_t panel_end = std::min(panels, panel_begin + panels_per_block);
+            
+            const float* a_mat = a + bs * p.a_stride_b;
+            const float* packed_b = packed + (shared_b ? 0 : bs) * panels * panel_size;
+            float* c_mat = c + bs * p.m * p.n;
+            
+            for (int64_t i = m_begin; i < m_end; i += BMM_MR) {
+                const int64_t rows = std::min(BMM_MR, m_end - i);
+                for (const auto panel : otter::irange(panel_begin, panel_end)) {
+                    const int64_t j = panel * BMM_NR;
+                    bmm_tile(
+                        c_mat + i * p.n + j, p.n, rows, std::min(BMM_NR, p.n - j),
+                        a_mat + i * p.a_stride_m, p.a_stride_m, p.a_stride_k,
+                        packed_b + panel * panel_size, p.k);
+                }
+            }
+        }
+    });
+}
+
+void bmm_kernel(const Tensor& result, const Tensor& self, const Tensor& other) {
+    BmmProblem p;
+    p.batch = result.size(0);
+    p.m = result.size(1);
+    p.n = result.size(2);
+    p.k = self.size(2);
+    p.a_stride_b = self.stride(0);
+    p.a_stride_m = self.stride(1);
+    p.a_stride_k = self.stride(2);
+    p.b_stride_b = other.stride(0);
+    p.b_stride_k = other.stride(1);
+    p.b_stride_n = other.stride(2);
+    
+    if (result.scalar_type() == ScalarType::Float) {
+        bmm_kernel_float(result.data_ptr<float>(), self.data_ptr<float>(), other.data_ptr<float>(), p);
+        return;
+    }
+    
+    OTTER_DISPATCH_ALL_TYPES(result.scalar_type(), "bmm_kernel", [&] {
+        bmm_kernel_generic<scalar_t>(result.data_ptr<scalar_t>(), self.data_ptr<scalar_t>(), other.data_ptr<scalar_t>(), p);
+    });
+}
+
+REGISTER_DISPATCH(bmm_stub, &bmm_kernel);
+
 
 template <typename scalar_t, typename Functor>
 scalar_t dot_naive(
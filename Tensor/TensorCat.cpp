@@ -9,6 +9,6 @@
 
 namespace otter {
 
-DEFINE_DISPATCH(cat_serial_stub);
+DEFINE_DISPATCH(cat_contiguous_stub);
 
 }
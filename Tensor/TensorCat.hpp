@@ -10,11 +10,13 @@
 
 #include "DispatchStub.hpp"
 #include "ArrayRef.hpp"
+#include "MemoryFormat.hpp"
 
 namespace otter {
 
-using cat_serial_fn = void(*)(Tensor &, TensorList, int64_t);
-DECLARE_DISPATCH(cat_serial_fn, cat_serial_stub);
+// Inputs and result are all contiguous in memory_format and share the same dtype
+using cat_contiguous_fn = void(*)(Tensor &, TensorList, int64_t, MemoryFormat);
+DECLARE_DISPATCH(cat_contiguous_fn, cat_contiguous_stub);
 
 }
 
@@ -7,59 +7,124 @@
 
 #include "TensorCat.hpp"
 #include "TensorCatKernel.hpp"
-#include "Dispatch.hpp"
 #include "Tensor.hpp"
-#include "Vec.hpp"
+#include "Parallel.hpp"
+#include "VecIntrinsic.hpp"
+
+#include <cstring>
 
 namespace otter {
 
+// Each input contributes one chunk of bytes to every outer slice of the result
 struct InputMeta {
-    void* data_ptr;
-    int64_t inner_size;
+    const char* data_ptr;
+    int64_t inner_bytes;
 
-    InputMeta(const Tensor& t, int64_t dim, int64_t inner) : data_ptr(t.data_ptr()) , inner_size(t.sizes()[dim] * inner) {}
+    InputMeta(const Tensor& t, int64_t dim, int64_t inner_bytes_) : data_ptr(static_cast<const char*>(t.data_ptr())), inner_bytes(t.sizes()[dim] * inner_bytes_) {}
 };
 
-template <typename scalar_t>
-void cat_serial_kernel_impl(Tensor& result, TensorList tensors, int64_t dim) {
-    assert(dim >= 0 && dim < result.dim()); // "dim out of range in cat_serial_kernel_impl");
-    int64_t outer = result.numel() / (result.sizes()[dim] * result.strides()[dim]);
-    scalar_t* result_data = result.data_ptr<scalar_t>();
-    int64_t ninputs = tensors.size();
-    std::vector<InputMeta> inputs;
-    inputs.reserve(ninputs);
-    for (auto const &tensor : tensors) {
-        inputs.emplace_back(tensor, dim, result.strides()[dim]);
+// Minimum bytes copied by one thread
+static constexpr int64_t CAT_GRAIN_BYTES = 1 << 16;
+// Results larger than this no longer fit in the last level cache, write them around it
+static constexpr int64_t CAT_STREAMING_BYTES = 1 << 25;
+
+// Number of elements between two consecutive positions of dim in the given memory format
+static int64_t cat_inner_size(const Tensor& result, int64_t dim, MemoryFormat memory_format) {
+    std::vector<int64_t> order(result.dim());
+    for (const auto d : otter::irange(result.dim())) {
+        order[d] = d;
     }
-    
-    using Vec = vec::Vectorized<scalar_t>;
-    scalar_t* result_ptr = result_data;
-    for (const auto i : otter::irange(outer)) {
-        for (const auto j : otter::irange(ninputs)) {
-            int64_t local_inner = inputs[j].inner_size;
-            scalar_t* input_ptr = (scalar_t*)(inputs[j].data_ptr) + i * local_inner;
-            int64_t d = 0;
-            for (; d < local_inner - (local_inner % Vec::size()); d += Vec::size()) {
-                Vec in_vec = Vec::loadu(input_ptr + d);
-                in_vec.store(result_ptr + d);
-            }
-        #if !defined(_MSC_VER) && !defined(COMPILING_FOR_MIN_SIZE)
-        # pragma unroll
-        #endif
-            for (; d < local_inner; d++) {
-                result_ptr[d] = input_ptr[d];
-            }
-            result_ptr += local_inner;
+    if (memory_format == MemoryFormat::ChannelsLast && result.dim() == 4) {
+        order = {0, 2, 3, 1};
+    }
+    int64_t inner = 1;
+    for (int64_t i = result.dim() - 1; i >= 0 && order[i] != dim; --i) {
+        inner *= result.sizes()[order[i]];
+    }
+    return inner;
+}
+
+static inline void cat_copy(char* dst, const char* src, int64_t n, bool streaming) {
+#if CPU_CAPABILITY_AVX2
+    if (streaming) {
+        int64_t head = std::min<int64_t>((32 - reinterpret_cast<uintptr_t>(dst) % 32) % 32, n);
+        std::memcpy(dst, src, head);
+        int64_t d = head;
+        for (; d + 128 <= n; d += 128) {
+            __m256i v0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + d));
+            __m256i v1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + d + 32));
+            __m256i v2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + d + 64));
+            __m256i v3 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + d + 96));
+            _mm256_stream_si256(reinterpret_cast<__m256i*>(dst + d), v0);
+            _mm256_stream_si256(reinterpret_cast<__m256i*>(dst + d + 32), v1);
+            _mm256_stream_si256(reinterpret_cast<__m256i*>(dst + d + 64), v2);
+            _mm256_stream_si256(reinterpret_cast<__m256i*>(dst + d + 96), v3);
+        }
+        for (; d + 32 <= n; d += 32) {
+            _mm256_stream_si256(reinterpret_cast<__m256i*>(dst + d), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + d)));
         }
+        std::memcpy(dst + d, src + d, n - d);
+        return;
     }
+#else
+    (void)streaming;
+#endif
+    std::memcpy(dst, src, n);
 }
 
-void cat_serial_kernel(Tensor& result, TensorList tensors, int64_t dim) {
-    OTTER_DISPATCH_FLOATING_TYPES(result.scalar_type(), "cat_serial_kernel", [&]() {
-        cat_serial_kernel_impl<scalar_t>(result, tensors, dim);
+void cat_contiguous_kernel(Tensor& result, TensorList tensors, int64_t dim, MemoryFormat memory_format) {
+    assert(dim >= 0 && dim < result.dim()); // "dim out of range in cat_contiguous_kernel");
+    const int64_t inner_bytes = cat_inner_size(result, dim, memory_format) * result.itemsize();
+    const int64_t row_bytes = result.sizes()[dim] * inner_bytes;
+    const int64_t total_bytes = result.numel() * result.itemsize();
+    char* result_data = static_cast<char*>(result.data_ptr());
+
+    std::vector<InputMeta> inputs;
+    inputs.reserve(tensors.size());
+    for (auto const &tensor : tensors) {
+        if (tensor.numel() > 0) {
+            inputs.emplace_back(tensor, dim, inner_bytes);
+        }
+    }
+    const int64_t ninputs = inputs.size();
+
+#if CPU_CAPABILITY_AVX2
+    const bool streaming = total_bytes >= CAT_STREAMING_BYTES;
+#else
+    const bool streaming = false;
+#endif
+
+    // The result is a sequence of (outer, input) chunks, split it by bytes so that
+    // a single large input is shared by threads as well as many small ones
+    otter::parallel_for(0, total_bytes, CAT_GRAIN_BYTES, [&](int64_t begin, int64_t end) {
+        int64_t i = begin / row_bytes;
+        int64_t offset = begin % row_bytes;
+        int64_t j = 0;
+        while (offset >= inputs[j].inner_bytes) {
+            offset -= inputs[j].inner_bytes;
+            ++j;
+        }
+
+        int64_t pos = begin;
+        while (pos < end) {
+            const InputMeta& input = inputs[j];
+            const int64_t n = std::min(input.inner_bytes - offset, end - pos);
+            cat_copy(result_data + pos, input.data_ptr + i * input.inner_bytes + offset, n, streaming);
+            pos += n;
+            offset = 0;
+            if (++j == ninputs) {
+                j = 0;
+                ++i;
+            }
+        }
+#if CPU_CAPABILITY_AVX2
+        if (streaming) {
+            _mm_sfence();
+        }
+#endif
     });
 }
 
-REGISTER_DISPATCH(cat_serial_stub, &cat_serial_kernel);
+REGISTER_DISPATCH(cat_contiguous_stub, &cat_contiguous_kernel);
 
 }   // end namespace otter
@@ -10,7 +10,7 @@
 
 namespace otter {
 
-void cat_serial_kernel(Tensor& result, TensorList tensors, int64_t dim);
+void cat_contiguous_kernel(Tensor& result, TensorList tensors, int64_t dim, MemoryFormat memory_format);
 
 }
 
@@ -11,33 +11,105 @@
 #include "Loop.hpp"
 #include "Parallel.hpp"
 #include "TypeCast.hpp"
+#include "Vec.hpp"
+
+#include <cstring>
 
 namespace otter {
 
-void direct_copy_kernel(TensorIterator& iter) {
-    OTTER_DISPATCH_ALL_TYPES(iter.dtype(), "copy_kernel", [&]() {
-        cpu_kernel(iter, [=](scalar_t a) -> scalar_t {
-            return a;
-        });
+// Tile of the blocked transpose, a tile of 4 byte elements stays in L1
+static constexpr int64_t COPY_TRANSPOSE_TILE = 32;
+
+// Same dtype copy keyed by the element size, the values are moved as raw bits
+template <typename bits_t>
+static void copy_same_dtype_kernel(TensorIterator& iter) {
+    constexpr int64_t element_size = sizeof(bits_t);
+    
+    iter.for_each([](char** data, const int64_t* strides, int64_t size0, int64_t size1) {
+        char* dst = data[0];
+        const char* src = data[1];
+        const int64_t dst_inner = strides[0], src_inner = strides[1];
+        const int64_t dst_outer = strides[2], src_outer = strides[3];
+        
+        if (dst_inner == element_size && src_inner == element_size) {
+            for (const auto j : otter::irange(size1)) {
+                std::memcpy(dst + j * dst_outer, src + j * src_outer, size0 * element_size);
+            }
+            return;
+        }
+        
+        // The output is contiguous along the inner dim but the input along the outer one (permute + contiguous)
+        // Walk the tiles so that the reads and the writes both stay in cache
+        if (dst_inner == element_size && src_outer == element_size && size1 > 1) {
+            for (int64_t j0 = 0; j0 < size1; j0 += COPY_TRANSPOSE_TILE) {
+                const int64_t j1 = std::min(size1, j0 + COPY_TRANSPOSE_TILE);
+                for (int64_t i0 = 0; i0 < size0; i0 += COPY_TRANSPOSE_TILE) {
+                    const int64_t i1 = std::min(size0, i0 + COPY_TRANSPOSE_TILE);
+                    for (int64_t j = j0; j < j1; ++j) {
+                        bits_t* dst_row = reinterpret_cast<bits_t*>(dst + j * dst_outer);
+                        const char* src_column = src + j * src_outer;
+                        for (int64_t i = i0; i < i1; ++i) {
+                            dst_row[i] = *reinterpret_cast<const bits_t*>(src_column + i * src_inner);
+                        }
+                    }
+                }
+            }
+            return;
+        }
+        
+        for (const auto j : otter::irange(size1)) {
+            char* dst_row = dst + j * dst_outer;
+            const char* src_row = src + j * src_outer;
+            for (const auto i : otter::irange(size0)) {
+                *reinterpret_cast<bits_t*>(dst_row + i * dst_inner) = *reinterpret_cast<const bits_t*>(src_row + i * src_inner);
+            }
+        }
     });
 }
 
+void direct_copy_kernel(TensorIterator& iter) {
+    switch (elementSize(iter.dtype())) {
+        case 1: copy_same_dtype_kernel<uint8_t>(iter); break;
+        case 2: copy_same_dtype_kernel<uint16_t>(iter); break;
+        case 4: copy_same_dtype_kernel<uint32_t>(iter); break;
+        case 8: copy_same_dtype_kernel<uint64_t>(iter); break;
+        default:
+            OTTER_DISPATCH_ALL_TYPES_AND2(ScalarType::Half, ScalarType::BFloat16, iter.dtype(), "copy_kernel", [&]() {
+                cpu_kernel(iter, [=](scalar_t a) -> scalar_t {
+                    return a;
+                });
+            });
+    }
+}
+
 void copy_same_dtype(TensorIterator& iter) {
     direct_copy_kernel(iter);
 }
 
+// Dtype conversion, the contiguous inner loop goes through vec::convert which is vectorized for the common pairs
+template <typename dest_t, typename src_t>
+static void copy_convert_kernel(TensorIterator& iter) {
+    iter.for_each([](char** data, const int64_t* strides, int64_t size) {
+        if (strides[0] == sizeof(dest_t) && strides[1] == sizeof(src_t)) {
+            vec::convert(reinterpret_cast<const src_t*>(data[1]), reinterpret_cast<dest_t*>(data[0]), size);
+            return;
+        }
+        for (const auto i : otter::irange(size)) {
+            *reinterpret_cast<dest_t*>(data[0] + i * strides[0]) = otter::static_cast_with_inter_type<dest_t, src_t>::apply(*reinterpret_cast<const src_t*>(data[1] + i * strides[1]));
+        }
+    });
+}
+
 void copy_kernel(TensorIterator& iter, bool non_blocking) {
     ScalarType dtype = iter.dtype(0);
     
     if (dtype == iter.dtype(1)) {
         copy_same_dtype(iter);
     } else {
-        OTTER_DISPATCH_ALL_TYPES(dtype, "copy_", [&]() {
+        OTTER_DISPATCH_ALL_TYPES_AND2(ScalarType::Half, ScalarType::BFloat16, dtype, "copy_", [&]() {
             using dest_t = scalar_t;
-            OTTER_DISPATCH_ALL_TYPES(iter.dtype(1), "copy_", [&]() {
-                cpu_kernel(iter, [=](scalar_t src) -> dest_t {
-                    return otter::static_cast_with_inter_type<dest_t, scalar_t>::apply(src);;
-                });
+            OTTER_DISPATCH_ALL_TYPES_AND2(ScalarType::Half, ScalarType::BFloat16, iter.dtype(1), "copy_", [&]() {
+                copy_convert_kernel<dest_t, scalar_t>(iter);
             });
         });
     }
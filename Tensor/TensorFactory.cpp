@@ -48,7 +48,7 @@ Tensor empty_like(const Tensor& self, ScalarType dtype) {
 Tensor clone(const Tensor& src, MemoryFormat memory_format) {
     Tensor self;
     if (memory_format == MemoryFormat::Preserve) {
-        if (self.is_non_overlapping_and_dense()) {
+        if (src.is_non_overlapping_and_dense()) {
             self = empty_strided(src.sizes(), src.strides(), src.options());
         } else {
             self = empty_like(src);
@@ -591,6 +591,48 @@ std::tuple<Tensor &, Tensor &> wrapper_max_pool2d_with_indices_out_out(const Ten
 
 // end max_pool2d
 
+// avg_pool2d
+struct structured_avg_pool2d_out_cpu_functional final : public structured_avg_pool2d_out_cpu {
+
+    void set_output(int64_t output_idx, IntArrayRef sizes, IntArrayRef strides, TensorOptions options) override {
+        outputs_[output_idx] = create_out(sizes, strides, options);
+    }
+    const Tensor& maybe_get_output(int64_t output_idx) override {
+        return *outputs_[output_idx];
+    }
+    std::array<ExclusivelyOwned<Tensor>, 1> outputs_;
+};
+
+Tensor wrapper_avg_pool2d(const Tensor & self, IntArrayRef kernel_size, IntArrayRef stride, IntArrayRef padding, bool ceil_mode, bool count_include_pad, int64_t divisor_override) {
+    structured_avg_pool2d_out_cpu_functional op;
+    op.meta(self, kernel_size, stride, padding, ceil_mode, count_include_pad, divisor_override);
+    op.impl(self, kernel_size, stride, padding, ceil_mode, count_include_pad, divisor_override, *op.outputs_[0]);
+    return std::move(op.outputs_[0]).take();
+}
+
+struct structured_avg_pool2d_out_cpu_out final : public structured_avg_pool2d_out_cpu {
+    structured_avg_pool2d_out_cpu_out(Tensor& out0) : outputs_{ std::ref(out0) } {}
+
+    void set_output(int64_t output_idx, IntArrayRef sizes, IntArrayRef strides, TensorOptions options) override {
+        const auto& out = outputs_[output_idx].get();
+        resize_out(out, sizes, strides, options);
+    }
+
+    const Tensor& maybe_get_output(int64_t output_idx) override {
+        return outputs_[output_idx];
+    }
+    std::array<std::reference_wrapper<Tensor>, 1> outputs_;
+};
+
+Tensor & wrapper_avg_pool2d_out_out(const Tensor & self, IntArrayRef kernel_size, IntArrayRef stride, IntArrayRef padding, bool ceil_mode, bool count_include_pad, int64_t divisor_override, Tensor & out) {
+    structured_avg_pool2d_out_cpu_out op(out);
+    op.meta(self, kernel_size, stride, padding, ceil_mode, count_include_pad, divisor_override);
+    op.impl(self, kernel_size, stride, padding, ceil_mode, count_include_pad, divisor_override, op.outputs_[0]);
+    return out;
+}
+
+// end avg_pool2d
+
 // leaky_relu cpu
 DEFINE_FINAL_OP_AFTER(leaky_relu_out)
 Tensor wrapper_leaky_relu(const Tensor & self, const Scalar & negative_slope) {
@@ -904,6 +946,14 @@ std::tuple<Tensor &, Tensor &> max_pool2d_with_indices_out(Tensor & out, Tensor
     return wrapper_max_pool2d_with_indices_out_out(self, kernel_size, stride, padding, dilation, ceil_mode, out, indices);
 }
 
+Tensor avg_pool2d(const Tensor & self, IntArrayRef kernel_size, IntArrayRef stride, IntArrayRef padding, bool ceil_mode, bool count_include_pad, int64_t divisor_override) {
+    return wrapper_avg_pool2d(self, kernel_size, stride, padding, ceil_mode, count_include_pad, divisor_override);
+}
+
+Tensor & avg_pool2d_out(Tensor & out, const Tensor & self, IntArrayRef kernel_size, IntArrayRef stride, IntArrayRef padding, bool ceil_mode, bool count_include_pad, int64_t divisor_override) {
+    return wrapper_avg_pool2d_out_out(self, kernel_size, stride, padding, ceil_mode, count_include_pad, divisor_override, out);
+}
+
 Tensor upsample_nearest2d(const Tensor & self, IntArrayRef output_size, double scales_h, double scales_w) {
     return wrapper_upsample_nearest2d(self, output_size, scales_h, scales_w);
 }
@@ -83,6 +83,10 @@ struct structured_max_pool2d_with_indices : public TensorIterator {
     void meta(const Tensor & self, IntArrayRef kernel_size, IntArrayRef stride, IntArrayRef padding, IntArrayRef dilation, bool ceil_mode);
 };
 
+struct structured_avg_pool2d : public TensorIterator {
+    void meta(const Tensor & self, IntArrayRef kernel_size, IntArrayRef stride, IntArrayRef padding, bool ceil_mode, bool count_include_pad, int64_t divisor_override);
+};
+
 struct structured_upsample_nearest2d : public TensorIterator {
     void meta(const Tensor & self, IntArrayRef output_size, double scales_h, double scales_w);
 };
@@ -207,6 +211,10 @@ struct structured_max_pool2d_with_indices_out_cpu : public structured_max_pool2d
     void impl(const Tensor & self, IntArrayRef kernel_size, IntArrayRef stride, IntArrayRef padding, IntArrayRef dilation, bool ceil_mode, const Tensor & out, const Tensor & indices);
 };
 
+struct structured_avg_pool2d_out_cpu : public structured_avg_pool2d {
+    void impl(const Tensor & self, IntArrayRef kernel_size, IntArrayRef stride, IntArrayRef padding, bool ceil_mode, bool count_include_pad, int64_t divisor_override, const Tensor & out);
+};
+
 struct structured_upsample_nearest2d_out_cpu : public structured_upsample_nearest2d {
     void impl(const Tensor & self, IntArrayRef output_size, double scales_h, double scales_w, const Tensor & out);
 };
@@ -296,6 +304,9 @@ Tensor & leaky_relu_(Tensor & self, const Scalar & negative_slope);
 std::tuple<Tensor, Tensor> max_pool2d_with_indices(const Tensor & self, IntArrayRef kernel_size, IntArrayRef stride, IntArrayRef padding, IntArrayRef dilation, bool ceil_mode);
 std::tuple<Tensor&, Tensor&> max_pool2d_with_indices_out(Tensor & out, Tensor & indices, const Tensor & self, IntArrayRef kernel_size, IntArrayRef stride, IntArrayRef padding, IntArrayRef dilation, bool ceil_mode);
 
+Tensor avg_pool2d(const Tensor & self, IntArrayRef kernel_size, IntArrayRef stride, IntArrayRef padding, bool ceil_mode, bool count_include_pad, int64_t divisor_override);
+Tensor & avg_pool2d_out(Tensor & out, const Tensor & self, IntArrayRef kernel_size, IntArrayRef stride, IntArrayRef padding, bool ceil_mode, bool count_include_pad, int64_t divisor_override);
+
 Tensor upsample_nearest2d(const Tensor & self, IntArrayRef output_size, double scales_h, double scales_w);
 Tensor & upsample_nearest2d_out(Tensor & out, const Tensor & self, IntArrayRef output_size, double scales_h, double scales_w);
 
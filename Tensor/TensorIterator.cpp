@@ -89,6 +89,12 @@ void TensorIterator::unsafe_replace_operand(int arg, void* data) {
     operands_[arg].data = data;
 }
 
+void TensorIterator::release_tensors() {
+    for (auto& op : operands_) {
+        op.tensor(MaybeOwned<TensorBase>::owned(otter::in_place));
+    }
+}
+
 void TensorIterator::initialize_operands(TensorIteratorConfig &config) {
     for (auto& tensor : config.tensors_) {
         operands_.emplace_back(std::move(tensor));
@@ -423,6 +429,48 @@ void TensorIterator::allocate_or_resize_outputs() {
     }
 }
 
+bool TensorIterator::fast_set_up() {
+    if (!all_ops_same_shape_) {
+        return false;
+    }
+    
+    for (const auto& op : operands_) {
+        if (!op.tensor_base().defined()) {
+            if (op.is_output)
+                continue;
+            return false;
+        }
+        if (op.will_resize)
+            continue;
+        if (!op.tensor_base().is_contiguous()) {
+            return false;
+        }
+    }
+    
+    for (const auto i : otter::irange(num_outputs_)) {
+        auto& op = operands_[i];
+        if (!op.tensor_base().defined() || op.will_resize) {
+            set_output(i, shape_, {}, original_options(op));
+            op.current_dtype = op.target_dtype;
+        } else {
+            set_output(i, op.tensor_base().sizes(), {}, original_options(op));
+        }
+    }
+    
+    // The operands are walked as one flat dimension
+    const int64_t numel = this->numel();
+    shape_.resize(1);
+    shape_[0] = numel;
+    permutation_.resize(1);
+    permutation_[0] = 0;
+    for (auto& op : operands_) {
+        op.stride_bytes.resize(1);
+        op.stride_bytes[0] = op.tensor_base().itemsize();
+    }
+    
+    return true;
+}
+
 TensorIterator::StrideVector TensorIterator::compatible_stride(int element_size) const {
     auto stride = StrideVector();
     int64_t next_stride = element_size;
@@ -493,12 +541,16 @@ void TensorIterator::build(TensorIteratorConfig &config) {
     this->mark_resize_outputs(config);
     
     this->compute_types(config);
-    // Compute the proper output strides
-    this->compute_strides(config);
-    
-    this->reorder_dimensions();
     
-    this->allocate_or_resize_outputs();
+    // All contiguous with the same shape, skip the strides and the dimension reordering
+    if (!this->fast_set_up()) {
+        // Compute the proper output strides
+        this->compute_strides(config);
+        
+        this->reorder_dimensions();
+        
+        this->allocate_or_resize_outputs();
+    }
     
     for (auto& op : operands_) {
         assert(op.tensor_base().defined());
@@ -674,6 +726,37 @@ TensorIteratorConfig& TensorIteratorConfig::declare_static_device(Device device)
     return *this;
 }
 
+bool PreparedTensorIterator::matches(ArrayRef<TensorBase> operands) const {
+    if (metas_.empty() || metas_.size() != operands.size())
+        return false;
+    
+    for (const auto i : otter::irange(operands.size())) {
+        const auto& operand = operands[i];
+        if (!operand.defined() || operand.scalar_type() != metas_[i].dtype || !operand.sizes().equals(metas_[i].sizes) || !operand.strides().equals(metas_[i].strides)) {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+bool PreparedTensorIterator::record(ArrayRef<TensorBase> operands) {
+    metas_.clear();
+    
+    // A cast replaces the operand with a temporary, the data pointer cannot be rebound
+    for (const auto i : otter::irange(operands.size())) {
+        if (iter_.dtype(static_cast<int>(i)) != operands[i].scalar_type())
+            return false;
+    }
+    
+    for (const auto& operand : operands) {
+        metas_.push_back({DimVector(operand.sizes()), DimVector(operand.strides()), operand.scalar_type()});
+    }
+    iter_.release_tensors();
+    
+    return true;
+}
+
 DimCounter::DimCounter(IntArrayRef shape, Range range) : shape_(shape), range_(range), values_(shape.size()), offset_(range.begin) {
     
     std::fill(values_.begin(), values_.end(), 0);
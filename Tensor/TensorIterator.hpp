@@ -172,6 +172,7 @@ public:
     void reorder_dimensions();
     void permute_dimensions(IntArrayRef permutation);
     void allocate_or_resize_outputs();
+    bool fast_set_up();
     StrideVector compatible_stride(int element_size) const;
     DimVector invert_permutation(IntArrayRef input) const;
     void cast_outputs();
@@ -200,6 +201,9 @@ public:
     
     void unsafe_replace_operand(int arg, void* data);
     
+    // Drop the references to the operands, only the shape, the strides and the dtypes are kept
+    void release_tensors();
+    
     template <typename loop1d_t, std::enable_if_t<std::is_convertible<loop1d_t, otter::FunctionRef<void(char**, const int64_t* strides, int64_t size)>>::value, int> = 0>
     void for_each(loop1d_t loop, int64_t grain_size = otter::GRAIN_SIZE) {
         for_each(loop_2d_from_1d(loop), grain_size);
@@ -365,6 +369,41 @@ private:
     bool promote_integer_inputs_to_float_ = false;
 };
 
+// TensorIterator built once and rebound to the data of the next operands with the same sizes, strides and dtypes
+// The Extractor keeps one per layer across the frames to skip the broadcasting, the type computation and the stride permutation
+// The outputs have to be allocated, not thread safe
+class PreparedTensorIterator {
+public:
+    // Operands are the outputs followed by the inputs, build is called to rebuild the iterator when they changed
+    // Return nullptr when the iterator would need a cast, run the op the regular way then
+    template <typename build_fn>
+    TensorIterator* prepare(ArrayRef<TensorBase> operands, const build_fn& build) {
+        if (!matches(operands)) {
+            iter_ = TensorIterator();
+            build(iter_);
+            if (!record(operands))
+                return nullptr;
+        }
+        for (const auto i : otter::irange(operands.size())) {
+            iter_.unsafe_replace_operand(static_cast<int>(i), operands[i].raw_data());
+        }
+        return &iter_;
+    }
+    
+private:
+    bool matches(ArrayRef<TensorBase> operands) const;
+    bool record(ArrayRef<TensorBase> operands);
+    
+    struct OperandMeta {
+        DimVector sizes;
+        DimVector strides;
+        ScalarType dtype;
+    };
+    
+    TensorIterator iter_;
+    SmallVector<OperandMeta, 4> metas_;
+};
+
 struct DimCounter {
     DimCounter(IntArrayRef shape, Range range);
     
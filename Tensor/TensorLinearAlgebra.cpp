@@ -12,6 +12,7 @@
 #include "Formatting.hpp"
 #include "TensorFunction.hpp"
 #include "ExpandUtils.hpp"
+#include "TensorFactory.hpp"
 
 namespace otter {
 
@@ -135,9 +136,124 @@ void addmm_impl_cpu_(Tensor &result, const Tensor &self, Tensor m1, Tensor m2, c
     }
 }
 
-Tensor matmul(Tensor& output, const Tensor& tensor1, const Tensor& tensor2) {
-    auto dim_tensor1 = tensor1.dim();
-    auto dim_tensor2 = tensor2.dim();
+Tensor& bmm_out(Tensor& result, const Tensor& self, const Tensor& mat2) {
+    OTTER_CHECK(self.dim() == 3 && mat2.dim() == 3, "bmm: Expect 3D tensors but get ", self.dim(), "D and ", mat2.dim(), "D");
+    OTTER_CHECK(self.size(0) == mat2.size(0), "bmm: Expect the same batch size but get ", self.size(0), " and ", mat2.size(0));
+    OTTER_CHECK(self.size(2) == mat2.size(1), "bmm: Shape ", self.sizes(), " and ", mat2.sizes(), " cannot be multiplied");
+    OTTER_CHECK(self.scalar_type() == mat2.scalar_type(), "bmm: Expect the same dtype");
+    
+    otter::native::resize_output(result, {self.size(0), self.size(1), mat2.size(2)});
+    
+    if (result.numel() == 0) {
+        return result;
+    }
+    if (self.size(2) == 0) {
+        return result.zero_();
+    }
+    
+    Tensor output = (result.is_contiguous()) ? result : otter::empty(result.sizes(), result.options());
+    
+    bmm_stub(Device::CPU, output, self, mat2);
+    
+    if (!output.is_same(result)) {
+        result.copy_(output);
+    }
+    
+    return result;
+}
+
+Tensor bmm(const Tensor& self, const Tensor& mat2) {
+    Tensor result = otter::empty({0}, self.options());
+    otter::bmm_out(result, self, mat2);
+    
+    return result;
+}
+
+Tensor& matmul_out(Tensor& output, const Tensor& tensor1, const Tensor& tensor2) {
+    const int64_t dim_tensor1 = tensor1.dim();
+    const int64_t dim_tensor2 = tensor2.dim();
+    
+    OTTER_CHECK(dim_tensor1 > 0 && dim_tensor2 > 0, "matmul: Both arguments need to be at least 1D, but get ", dim_tensor1, "D and ", dim_tensor2, "D");
+    
+    if (dim_tensor1 == 1 && dim_tensor2 == 1) {
+        return otter::dot_out(tensor1, tensor2, output);
+    }
+    
+    // Treat the vector as {1, K} or {K, 1} matrix, the extra dimension is removed from the output
+    const Tensor mat1 = (dim_tensor1 == 1) ? tensor1.unsqueeze(0) : tensor1;
+    const Tensor mat2 = (dim_tensor2 == 1) ? tensor2.unsqueeze(1) : tensor2;
+    
+    const int64_t m = mat1.size(-2);
+    const int64_t k = mat1.size(-1);
+    const int64_t n = mat2.size(-1);
+    OTTER_CHECK(k == mat2.size(-2), "matmul: Shape ", tensor1.sizes(), " and ", tensor2.sizes(), " cannot be multiplied");
+    
+    IntArrayRef batch_tensor1 = mat1.sizes().slice(0, mat1.dim() - 2);
+    IntArrayRef batch_tensor2 = mat2.sizes().slice(0, mat2.dim() - 2);
+    DimVector batch_sizes = infer_size_dimvector(batch_tensor1, batch_tensor2);
+    
+    int64_t batch = 1;
+    for (const auto size : batch_sizes) {
+        batch *= size;
+    }
+    
+    DimVector output_sizes(batch_sizes);
+    if (dim_tensor1 > 1)
+        output_sizes.push_back(m);
+    if (dim_tensor2 > 1)
+        output_sizes.push_back(n);
+    
+    otter::native::resize_output(output, output_sizes);
+    
+    if (output.numel() == 0) {
+        return output;
+    }
+    
+    Tensor batch_mat1;
+    Tensor batch_mat2;
+    int64_t fold_batch = batch;
+    
+    if (batch_tensor2.empty() && !batch_tensor1.empty()) {
+        // {..., M, K} @ {K, N}: fold the batch into M, one large matrix multiplication
+        batch_mat1 = mat1.reshape({1, batch * m, k});
+        batch_mat2 = mat2.unsqueeze(0);
+        fold_batch = 1;
+    } else {
+        // The operand without batch is expanded with stride 0, it will be shared by the kernel
+        if (batch_tensor1.empty()) {
+            batch_mat1 = mat1.unsqueeze(0).expand({batch, m, k});
+        } else {
+            DimVector expand_sizes(batch_sizes);
+            expand_sizes.push_back(m);
+            expand_sizes.push_back(k);
+            batch_mat1 = mat1.expand(expand_sizes).reshape({batch, m, k});
+        }
+        
+        if (batch_tensor2.empty()) {
+            batch_mat2 = mat2.unsqueeze(0).expand({batch, k, n});
+        } else {
+            DimVector expand_sizes(batch_sizes);
+            expand_sizes.push_back(k);
+            expand_sizes.push_back(n);
+            batch_mat2 = mat2.expand(expand_sizes).reshape({batch, k, n});
+        }
+    }
+    
+    const int64_t fold_m = (fold_batch == 1) ? batch * m : m;
+    
+    if (output.is_contiguous()) {
+        Tensor output_view = output.view({fold_batch, fold_m, n});
+        otter::bmm_out(output_view, batch_mat1, batch_mat2);
+    } else {
+        output.copy_(otter::bmm(batch_mat1, batch_mat2).view(output_sizes));
+    }
+    
+    return output;
+}
+
+Tensor matmul(const Tensor& tensor1, const Tensor& tensor2) {
+    Tensor output = otter::empty({0}, tensor1.options());
+    otter::matmul_out(output, tensor1, tensor2);
     
     return output;
 }
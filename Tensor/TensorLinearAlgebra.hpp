@@ -10,9 +10,18 @@
 
 namespace otter {
 
+class Tensor;
+class Scalar;
+
 void addmm_impl_cpu_(Tensor &result, const Tensor &self, Tensor m1, Tensor m2, const Scalar& beta, const Scalar& alpha);
 
-Tensor matmul(Tensor& output, const Tensor& tensor1, const Tensor& tensor2);
+// self {B, M, K} @ mat2 {B, K, N} -> {B, M, N}
+Tensor bmm(const Tensor& self, const Tensor& mat2);
+Tensor& bmm_out(Tensor& result, const Tensor& self, const Tensor& mat2);
+
+// Support 1D, 2D and batched ND operands with broadcasting on the batch dimensions
+Tensor matmul(const Tensor& tensor1, const Tensor& tensor2);
+Tensor& matmul_out(Tensor& output, const Tensor& tensor1, const Tensor& tensor2);
 
 }
 
@@ -15,7 +15,7 @@
 namespace otter {
 
 struct TensorOptions {
-    TensorOptions() : has_device_(false), has_data_type_(false), has_required_grad_(false) {}
+    TensorOptions() : has_device_(false), has_data_type_(false), has_required_grad_(false), has_memory_format_(false) {}
     
     TensorOptions(ScalarType dtype) : TensorOptions() {
         this->set_dtype(dtype);
@@ -41,6 +41,14 @@ struct TensorOptions {
         return has_required_grad_ ? required_grad_ : false;
     }
     
+    MemoryFormat memory_format() const noexcept {
+        return has_memory_format_ ? memory_format_ : MemoryFormat::Contiguous;
+    }
+    
+    bool has_memory_format() const noexcept {
+        return has_memory_format_;
+    }
+    
     TensorOptions device(Device device) const noexcept {
         TensorOptions t = *this;
         t.set_device(device);
@@ -0,0 +1,92 @@
+//
+//  TensorPacking.cpp
+//  Tensor
+//
+//  Created by 陳均豪 on 2022/3/22.
+//
+
+#include "TensorPacking.hpp"
+#include "Tensor.hpp"
+#include "TensorFactory.hpp"
+#include "Parallel.hpp"
+#include "Vec.hpp"
+
+namespace otter {
+
+int64_t packing_elempack() {
+    return vec::Vectorized<float>::size();
+}
+
+bool can_pack(const Tensor& self, int64_t elempack) {
+    return self.dim() == 4 && self.scalar_type() == ScalarType::Float && elempack > 1 && self.size(1) % elempack == 0;
+}
+
+bool is_packed(const Tensor& self) {
+    return self.defined() && self.dim() == 5;
+}
+
+Tensor to_packed(const Tensor& self, int64_t elempack) {
+    OTTER_CHECK(can_pack(self, elempack), "to_packed: Expect 4D float tensor with channels divisible by ", elempack, " but get ", self.sizes());
+    
+    const int64_t batch = self.size(0);
+    const int64_t channels = self.size(1);
+    const int64_t height = self.size(2);
+    const int64_t width = self.size(3);
+    const int64_t image_size = height * width;
+    const int64_t channel_blocks = channels / elempack;
+    
+    Tensor input = self.contiguous();
+    Tensor output = otter::empty({batch, channel_blocks, height, width, elempack}, ScalarType::Float);
+    
+    const float* input_data = input.data_ptr<float>();
+    float* output_data = output.data_ptr<float>();
+    
+    otter::parallel_for(0, batch * channel_blocks, 0, [&](int64_t begin, int64_t end) {
+        for (const auto b : otter::irange(begin, end)) {
+            const float* src = input_data + b * elempack * image_size;
+            float* dst = output_data + b * elempack * image_size;
+            
+            for (const auto i : otter::irange(image_size)) {
+                for (const auto l : otter::irange(elempack)) {
+                    dst[i * elempack + l] = src[l * image_size + i];
+                }
+            }
+        }
+    });
+    
+    return output;
+}
+
+Tensor from_packed(const Tensor& self) {
+    OTTER_CHECK(is_packed(self) && self.scalar_type() == ScalarType::Float, "from_packed: Expect packed float tensor but get ", self.sizes());
+    
+    const int64_t batch = self.size(0);
+    const int64_t channel_blocks = self.size(1);
+    const int64_t height = self.size(2);
+    const int64_t width = self.size(3);
+    const int64_t elempack = self.size(4);
+    const int64_t image_size = height * width;
+    
+    Tensor input = self.contiguous();
+    Tensor output = otter::empty({batch, channel_blocks * elempack, height, width}, ScalarType::Float);
+    
+    const float* input_data = input.data_ptr<float>();
+    float* output_data = output.data_ptr<float>();
+    
+    otter::parallel_for(0, batch * channel_blocks, 0, [&](int64_t begin, int64_t end) {
+        for (const auto b : otter::irange(begin, end)) {
+            const float* src = input_data + b * elempack * image_size;
+            float* dst = output_data + b * elempack * image_size;
+            
+            for (const auto l : otter::irange(elempack)) {
+                for (const auto i : otter::irange(image_size)) {
+                    dst[l * image_size + i] = src[i * elempack + l];
+                }
+            }
+        }
+    });
+    
+    return output;
+}
+
+}   // end namespace otter
@@ -0,0 +1,39 @@
+//
+//  TensorPacking.hpp
+//  Tensor
+//
+//  Created by 陳均豪 on 2022/3/22.
+//
+
+#ifndef TensorPacking_hpp
+#define TensorPacking_hpp
+
+#include <cstdint>
+
+namespace otter {
+
+class Tensor;
+
+// Channel blocked layout (NCHWc), the activation {N, C, H, W} is stored as {N, C / elempack, H, W, elempack}
+// so one Vectorized<float> holds the same pixel of elempack channels
+// elempack = Vectorized<float>::size(), which is always 8 (NCHW8c) since every Vectorized is 256 bits wide,
+// NEON holds one as a pair of float32x4_t
+
+// The elempack of the current cpu capability, always 8 for now
+int64_t packing_elempack();
+
+// Only the 4D float tensor whose channels are the multiple of elempack can be packed
+bool can_pack(const Tensor& self, int64_t elempack);
+
+// The activation is packed when it is 5D, the caller should know the unpacked tensor is 4D
+bool is_packed(const Tensor& self);
+
+// {N, C, H, W} -> {N, C / elempack, H, W, elempack}
+Tensor to_packed(const Tensor& self, int64_t elempack);
+
+// {N, C / elempack, H, W, elempack} -> contiguous {N, C, H, W}
+Tensor from_packed(const Tensor& self);
+
+}   // end namespace otter
+
+#endif /* TensorPacking_hpp */
@@ -8,6 +8,8 @@
 #include "Tensor.hpp"
 #include "TensorPixel.hpp"
 #include "TensorFactory.hpp"
+#include "Parallel.hpp"
+#include "Vec.hpp"
 
 #if __ARM_NEON__
 #include <arm_neon.h>
@@ -127,5 +129,224 @@ Tensor from_rgb(const unsigned char* rgb, int h, int w, int stride) {
     return result;
 }
 
+static inline int pixel_channels(PixelType type) {
+    switch (type) {
+        case PixelType::RGB:
+        case PixelType::BGR:
+            return 3;
+        case PixelType::RGBA:
+        case PixelType::BGRA:
+            return 4;
+        case PixelType::GRAY:
+            return 1;
+    }
+    return 0;
+}
+
+// The source channel of each output channel, the output is RGB (or BGR with swap_rb)
+static inline int pixel_channel_order(PixelType type, bool swap_rb, int* order) {
+    if (type == PixelType::GRAY) {
+        order[0] = 0;
+        return 1;
+    }
+    
+    bool is_bgr = (type == PixelType::BGR || type == PixelType::BGRA);
+    if (is_bgr != swap_rb) {
+        order[0] = 2; order[1] = 1; order[2] = 0;
+    } else {
+        order[0] = 0; order[1] = 1; order[2] = 2;
+    }
+    return 3;
+}
+
+// Same as the upsample_bilinear2d with align_corners = false
+static void compute_linear_coefficients(int input_size, int output_size, std::vector<int>& index0, std::vector<int>& index1, std::vector<float>& lambda) {
+    index0.resize(output_size);
+    index1.resize(output_size);
+    lambda.resize(output_size);
+    
+    const float scale = static_cast<float>(input_size) / output_size;
+    for (const auto i : otter::irange(output_size)) {
+        float real_index = std::max(scale * (i + 0.5f) - 0.5f, 0.f);
+        int i0 = std::min(static_cast<int>(real_index), input_size - 1);
+        index0[i] = i0;
+        index1[i] = std::min(i0 + 1, input_size - 1);
+        lambda[i] = (i0 < input_size - 1) ? real_index - i0 : 0.f;
+    }
+}
+
+void from_pixels_resize_normalize_out(Tensor& output, const unsigned char* pixels, PixelType type, int w, int h, int stride, const float* mean_vals, const float* norm_vals, bool swap_rb, bool letterbox, float pad_value, LetterboxInfo* info) {
+    OTTER_CHECK(pixels, "Expect valid pixels");
+    OTTER_CHECK(w > 0 && h > 0, "Expect positive image size but get ", w, "x", h);
+    OTTER_CHECK(output.scalar_type() == ScalarType::Float && output.is_contiguous(), "Expect contiguous Float output");
+    OTTER_CHECK(output.dim() == 3 || (output.dim() == 4 && output.size(0) == 1), "Expect output with shape {C, H, W} or {1, C, H, W} but get ", output.sizes());
+    
+    int order[3];
+    const int in_channels = pixel_channels(type);
+    const int out_channels = pixel_channel_order(type, swap_rb, order);
+    
+    const int64_t channel_dim = output.dim() - 3;
+    OTTER_CHECK(output.size(channel_dim) == out_channels, "Expect output channel ", out_channels, " but get ", output.size(channel_dim));
+    
+    const int target_h = (int)output.size(channel_dim + 1);
+    const int target_w = (int)output.size(channel_dim + 2);
+    
+    OTTER_CHECK(stride >= w * in_channels, "Expect stride >= ", w * in_channels, " but get ", stride);
+    
+    int resized_w = target_w;
+    int resized_h = target_h;
+    if (letterbox) {
+        float scale = std::min(static_cast<float>(target_w) / w, static_cast<float>(target_h) / h);
+        resized_w = std::min(std::max(static_cast<int>(std::round(w * scale)), 1), target_w);
+        resized_h = std::min(std::max(static_cast<int>(std::round(h * scale)), 1), target_h);
+    }
+    const int pad_left = (target_w - resized_w) / 2;
+    const int pad_top  = (target_h - resized_h) / 2;
+    
+    if (info) {
+        info->scale_x = static_cast<float>(resized_w) / w;
+        info->scale_y = static_cast<float>(resized_h) / h;
+        info->pad_left = pad_left;
+        info->pad_top = pad_top;
+        info->resized_w = resized_w;
+        info->resized_h = resized_h;
+    }
+    
+    // (x - mean) * norm = x * norm + bias
+    float norm[3];
+    float bias[3];
+    float pad_out[3];
+    for (const auto c : otter::irange(out_channels)) {
+        float mean = (mean_vals) ? mean_vals[c] : 0.f;
+        norm[c] = (norm_vals) ? norm_vals[c] : 1.f;
+        bias[c] = -mean * norm[c];
+        pad_out[c] = (pad_value - mean) * norm[c];
+    }
+    
+    std::vector<int> xindex0, xindex1, yindex0, yindex1;
+    std::vector<float> xlambda, ylambda;
+    compute_linear_coefficients(w, resized_w, xindex0, xindex1, xlambda);
+    compute_linear_coefficients(h, resized_h, yindex0, yindex1, ylambda);
+    // Index into the interleaved source row, and the weight of the left pixel
+    std::vector<float> xlambda0(resized_w);
+    for (const auto x : otter::irange(resized_w)) {
+        xindex0[x] *= in_channels;
+        xindex1[x] *= in_channels;
+        xlambda0[x] = 1.f - xlambda[x];
+    }
+    const bool identity_x = (resized_w == w);
+    
+    float* output_data = output.data_ptr<float>();
+    const int64_t plane = (int64_t)target_h * target_w;
+    
+    using Vec = vec::Vectorized<float>;
+    
+    otter::parallel_for(0, target_h, 0, [&](int64_t begin, int64_t end) {
+        // Horizontally resized source rows, two are enough for bilinear
+        // and they are reused by the consecutive output rows
+        std::vector<float> row_buffer_a(out_channels * resized_w);
+        std::vector<float> row_buffer_b(out_channels * resized_w);
+        float* rows[2] = {row_buffer_a.data(), row_buffer_b.data()};
+        int cached[2] = {-1, -1};
+        // The source row widened to float, still interleaved
+        std::vector<float> src_row(w * in_channels);
+        
+        auto resize_row = [&](int sy, float* row) {
+            vec::convert(pixels + (int64_t)sy * stride, src_row.data(), w * in_channels);
+            for (const auto c : otter::irange(out_channels)) {
+                const float* src_c = src_row.data() + order[c];
+                float* row_c = row + c * resized_w;
+                int64_t x = 0;
+#if CPU_CAPABILITY_AVX2
+                for (; x + Vec::size() <= resized_w; x += Vec::size()) {
+                    Vec value0 = _mm256_i32gather_ps(src_c, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(xindex0.data() + x)), 4);
+                    if (identity_x) {
+                        value0.store(row_c + x);
+                    } else {
+                        Vec value1 = _mm256_i32gather_ps(src_c, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(xindex1.data() + x)), 4);
+                        (value0 * Vec::loadu(xlambda0.data() + x) + value1 * Vec::loadu(xlambda.data() + x)).store(row_c + x);
+                    }
+                }
+#endif
+                if (identity_x) {
+                    for (; x < resized_w; ++x) {
+                        row_c[x] = src_c[xindex0[x]];
+                    }
+                } else {
+                    for (; x < resized_w; ++x) {
+                        row_c[x] = src_c[xindex0[x]] * xlambda0[x] + src_c[xindex1[x]] * xlambda[x];
+                    }
+                }
+            }
+        };
+        
+        for (const auto y : otter::irange(begin, end)) {
+            const int yy = (int)y - pad_top;
+            
+            if (yy < 0 || yy >= resized_h) {
+                for (const auto c : otter::irange(out_channels)) {
+                    std::fill_n(output_data + c * plane + y * target_w, target_w, pad_out[c]);
+                }
+                continue;
+            }
+            
+            const int sy0 = yindex0[yy];
+            const int sy1 = yindex1[yy];
+            
+            if (cached[0] != sy0) {
+                if (cached[1] == sy0) {
+                    std::swap(rows[0], rows[1]);
+                    std::swap(cached[0], cached[1]);
+                } else {
+                    resize_row(sy0, rows[0]);
+                    cached[0] = sy0;
+                }
+            }
+            if (cached[1] != sy1) {
+                resize_row(sy1, rows[1]);
+                cached[1] = sy1;
+            }
+            
+            const float b = ylambda[yy];
+            for (const auto c : otter::irange(out_channels)) {
+                float* dst = output_data + c * plane + y * target_w;
+                std::fill_n(dst, pad_left, pad_out[c]);
+                std::fill_n(dst + pad_left + resized_w, target_w - pad_left - resized_w, pad_out[c]);
+                dst += pad_left;
+                
+                const float* row0 = rows[0] + c * resized_w;
+                const float* row1 = rows[1] + c * resized_w;
+                
+                const Vec w0_vec(1.f - b);
+                const Vec w1_vec(b);
+                const Vec norm_vec(norm[c]);
+                const Vec bias_vec(bias[c]);
+                
+                int64_t x = 0;
+                for (; x + Vec::size() <= resized_w; x += Vec::size()) {
+                    Vec value = Vec::loadu(row0 + x) * w0_vec + Vec::loadu(row1 + x) * w1_vec;
+                    vec::fmadd(value, norm_vec, bias_vec).store(dst + x);
+                }
+                if (x < resized_w) {
+                    int64_t count = resized_w - x;
+                    Vec value = Vec::loadu(row0 + x, count) * w0_vec + Vec::loadu(row1 + x, count) * w1_vec;
+                    vec::fmadd(value, norm_vec, bias_vec).store(dst + x, (int)count);
+                }
+            }
+        }
+    });
+}
+
+Tensor from_pixels_resize_normalize(const unsigned char* pixels, PixelType type, int w, int h, int stride, int target_w, int target_h, const float* mean_vals, const float* norm_vals, bool swap_rb, bool letterbox, float pad_value, LetterboxInfo* info) {
+    const int out_channels = (type == PixelType::GRAY) ? 1 : 3;
+    
+    auto result = empty({1, out_channels, target_h, target_w}, otter::ScalarType::Float);
+    OTTER_CHECK(result.defined(), "Tensor create failed!");
+    
+    from_pixels_resize_normalize_out(result, pixels, type, w, h, stride, mean_vals, norm_vals, swap_rb, letterbox, pad_value, info);
+    
+    return result;
+}
+
 }   // end namespace cv
 }   // end namespace otter
@@ -15,6 +15,35 @@ namespace cv {
 
 Tensor from_rgb(const unsigned char* rgb, int h, int w, int stride);
 
+enum class PixelType {
+    RGB,
+    BGR,
+    RGBA,
+    BGRA,
+    GRAY
+};
+
+// The geometry used to map the network coordinate back to the source image
+// x_src = (x_net - pad_left) / scale, y_src = (y_net - pad_top) / scale
+struct LetterboxInfo {
+    float scale_x;
+    float scale_y;
+    int pad_left;
+    int pad_top;
+    int resized_w;
+    int resized_h;
+};
+
+// Fused image ingest, HWC uint8 -> (letterbox) bilinear resize -> (x - mean) * norm -> NCHW Float
+// The pixels are read in place with stride (bytes per row), no copy is made
+// The output is {1, 3, target_h, target_w} in RGB order (or {1, 1, target_h, target_w} for GRAY)
+// unless swap_rb is set, mean_vals and norm_vals can be nullptr (0 and 1)
+// With letterbox the aspect ratio is kept and the border is filled with pad_value (before normalization)
+Tensor from_pixels_resize_normalize(const unsigned char* pixels, PixelType type, int w, int h, int stride, int target_w, int target_h, const float* mean_vals, const float* norm_vals, bool swap_rb = false, bool letterbox = false, float pad_value = 0, LetterboxInfo* info = nullptr);
+
+// Write into the given output {C, target_h, target_w} or {1, C, target_h, target_w} (e.g. a slice of a batch)
+void from_pixels_resize_normalize_out(Tensor& output, const unsigned char* pixels, PixelType type, int w, int h, int stride, const float* mean_vals, const float* norm_vals, bool swap_rb = false, bool letterbox = false, float pad_value = 0, LetterboxInfo* info = nullptr);
+
 }   // end namesapce cv
 }   // end namespace otter
 
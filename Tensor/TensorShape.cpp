@@ -404,13 +404,11 @@ Tensor& cat_out(TensorList tensors, int64_t dim, Tensor& out) {
         return out;
     }
     
-    // fast path for single thread when both inputs and result are contiguous and not empty
+    // fast path when both inputs and result are contiguous in the same memory format and share the dtype,
+    // only strided inputs or type promotion go through TensorIterator
     allContiguous = allContiguous && out.is_contiguous(first_tensor_mem_format);
-    bool use_serial_kernel = out.numel() < otter::GRAIN_SIZE || otter::get_num_threads() == 1;
-    ScalarType dtype = notSkippedTensor.scalar_type();
-    bool serial_dtype = (dtype == ScalarType::Double || dtype == ScalarType::Float);
-    if (use_serial_kernel && allContiguous && no_type_promotion && serial_dtype) {
-        cat_serial_stub(Device::CPU, out, tensors, dim);
+    if (allContiguous && no_type_promotion) {
+        cat_contiguous_stub(Device::CPU, out, tensors, dim, first_tensor_mem_format);
         return out;
     }
     
@@ -0,0 +1,180 @@
+//
+//  TernaryOps.cpp
+//  Tensor
+//
+//  Created by 陳均豪 on 2022/3/22.
+//
+
+#include "Tensor.hpp"
+#include "TensorIterator.hpp"
+#include "TensorFactory.hpp"
+#include "TensorResize.hpp"
+#include "ExpandUtils.hpp"
+#include "TernaryOps.hpp"
+
+namespace otter {
+
+DEFINE_DISPATCH(clamp_scalar_stub);
+DEFINE_DISPATCH(where_stub);
+DEFINE_DISPATCH(addcmul_stub);
+DEFINE_DISPATCH(lerp_scalar_stub);
+DEFINE_DISPATCH(lerp_tensor_stub);
+DEFINE_DISPATCH(fma_stub);
+
+namespace native {
+
+static DimVector broadcast_shape(const Tensor& a, const Tensor& b, const Tensor& c) {
+    return infer_size_dimvector(infer_size_dimvector(a.sizes(), b.sizes()), c.sizes());
+}
+
+static void check_same_dtype(const Tensor& self, const Tensor& other, const char* name) {
+    OTTER_CHECK(self.scalar_type() == other.scalar_type(), name, " expected ", toString(other.scalar_type()), " to be ", toString(self.scalar_type()));
+}
+
+// The plain TensorIterator does not allocate or resize the outputs, the ops below size them up front
+// In-place the result has to fit in self, broadcasting only applies to the other operands
+static void prepare_out(Tensor& out, IntArrayRef shape, const Tensor& self, const char* name) {
+    if (out.is_same(self)) {
+        OTTER_CHECK(self.sizes().equals(shape), name, " in-place output with shape ", self.sizes(), " doesn't match the broadcast shape ", shape);
+        return;
+    }
+    check_same_dtype(self, out, name);
+    resize_output(out, shape);
+}
+
+static TensorIterator build_ternary_op(const Tensor& out, const Tensor& a, const Tensor& b, const Tensor& c) {
+    return TensorIteratorConfig()
+        .add_output(out)
+        .add_input(a)
+        .add_input(b)
+        .add_input(c)
+        .build();
+}
+
+Tensor& clamp_out(Tensor& out, const Tensor& self, const Scalar& min, const Scalar& max) {
+    prepare_out(out, self.sizes(), self, "clamp");
+    auto iter = TensorIteratorConfig()
+        .add_output(out)
+        .add_input(self)
+        .build();
+    clamp_scalar_stub(Device::CPU, iter, min, max);
+
+    return out;
+}
+
+Tensor clamp(const Tensor& self, const Scalar& min, const Scalar& max) {
+    Tensor out = otter::empty(self.sizes(), self.scalar_type());
+    return clamp_out(out, self, min, max);
+}
+
+Tensor& clamp_(Tensor& self, const Scalar& min, const Scalar& max) {
+    return clamp_out(self, self, min, max);
+}
+
+Tensor& where_out(Tensor& out, const Tensor& condition, const Tensor& self, const Tensor& other) {
+    OTTER_CHECK(condition.scalar_type() == ScalarType::Bool || condition.scalar_type() == ScalarType::Byte, "where expected condition to be a bool or byte tensor, but got ", toString(condition.scalar_type()));
+    check_same_dtype(self, other, "where");
+    prepare_out(out, broadcast_shape(condition, self, other), self, "where");
+
+    auto iter = TensorIteratorConfig()
+        .check_all_same_dtype(false)
+        .add_output(out)
+        .add_input(condition)
+        .add_input(self)
+        .add_input(other)
+        .build();
+    where_stub(Device::CPU, iter);
+
+    return out;
+}
+
+Tensor where(const Tensor& condition, const Tensor& self, const Tensor& other) {
+    Tensor out = otter::empty(broadcast_shape(condition, self, other), self.scalar_type());
+    return where_out(out, condition, self, other);
+}
+
+Tensor& addcmul_out(Tensor& out, const Tensor& self, const Tensor& tensor1, const Tensor& tensor2, const Scalar& value) {
+    check_same_dtype(self, tensor1, "addcmul");
+    check_same_dtype(self, tensor2, "addcmul");
+    prepare_out(out, broadcast_shape(self, tensor1, tensor2), self, "addcmul");
+
+    auto iter = build_ternary_op(out, self, tensor1, tensor2);
+    addcmul_stub(Device::CPU, iter, value);
+
+    return out;
+}
+
+Tensor addcmul(const Tensor& self, const Tensor& tensor1, const Tensor& tensor2, const Scalar& value) {
+    Tensor out = otter::empty(broadcast_shape(self, tensor1, tensor2), self.scalar_type());
+    return addcmul_out(out, self, tensor1, tensor2, value);
+}
+
+Tensor& addcmul_(Tensor& self, const Tensor& tensor1, const Tensor& tensor2, const Scalar& value) {
+    return addcmul_out(self, self, tensor1, tensor2, value);
+}
+
+Tensor& lerp_out(Tensor& out, const Tensor& self, const Tensor& end, const Scalar& weight) {
+    check_same_dtype(self, end, "lerp");
+    prepare_out(out, infer_size_dimvector(self.sizes(), end.sizes()), self, "lerp");
+
+    auto iter = TensorIteratorConfig()
+        .add_output(out)
+        .add_input(self)
+        .add_input(end)
+        .build();
+    lerp_scalar_stub(Device::CPU, iter, weight);
+
+    return out;
+}
+
+Tensor lerp(const Tensor& self, const Tensor& end, const Scalar& weight) {
+    Tensor out = otter::empty(infer_size_dimvector(self.sizes(), end.sizes()), self.scalar_type());
+    return lerp_out(out, self, end, weight);
+}
+
+Tensor& lerp_(Tensor& self, const Tensor& end, const Scalar& weight) {
+    return lerp_out(self, self, end, weight);
+}
+
+Tensor& lerp_out(Tensor& out, const Tensor& self, const Tensor& end, const Tensor& weight) {
+    check_same_dtype(self, end, "lerp");
+    check_same_dtype(self, weight, "lerp");
+    prepare_out(out, broadcast_shape(self, end, weight), self, "lerp");
+
+    auto iter = build_ternary_op(out, self, end, weight);
+    lerp_tensor_stub(Device::CPU, iter);
+
+    return out;
+}
+
+Tensor lerp(const Tensor& self, const Tensor& end, const Tensor& weight) {
+    Tensor out = otter::empty(broadcast_shape(self, end, weight), self.scalar_type());
+    return lerp_out(out, self, end, weight);
+}
+
+Tensor& lerp_(Tensor& self, const Tensor& end, const Tensor& weight) {
+    return lerp_out(self, self, end, weight);
+}
+
+Tensor& fma_out(Tensor& out, const Tensor& self, const Tensor& tensor1, const Tensor& tensor2) {
+    check_same_dtype(self, tensor1, "fma");
+    check_same_dtype(self, tensor2, "fma");
+    prepare_out(out, broadcast_shape(self, tensor1, tensor2), self, "fma");
+
+    auto iter = build_ternary_op(out, self, tensor1, tensor2);
+    fma_stub(Device::CPU, iter);
+
+    return out;
+}
+
+Tensor fma(const Tensor& self, const Tensor& tensor1, const Tensor& tensor2) {
+    Tensor out = otter::empty(broadcast_shape(self, tensor1, tensor2), self.scalar_type());
+    return fma_out(out, self, tensor1, tensor2);
+}
+
+Tensor& fma_(Tensor& self, const Tensor& tensor1, const Tensor& tensor2) {
+    return fma_out(self, self, tensor1, tensor2);
+}
+
+}   // end namespace native
+}   // end namespace otter
@@ -0,0 +1,63 @@
+//
+//  TernaryOps.hpp
+//  Tensor
+//
+//  Created by 陳均豪 on 2022/3/22.
+//
+
+#ifndef TernaryOps_hpp
+#define TernaryOps_hpp
+
+#include "DispatchStub.hpp"
+
+namespace otter {
+
+class Tensor;
+class Scalar;
+class TensorIterator;
+
+using clamp_scalar_fn = void(*)(TensorIterator&, const Scalar& min, const Scalar& max);
+using where_fn = void(*)(TensorIterator&);
+using addcmul_fn = void(*)(TensorIterator&, const Scalar& value);
+using lerp_scalar_fn = void(*)(TensorIterator&, const Scalar& weight);
+using lerp_tensor_fn = void(*)(TensorIterator&);
+using fma_fn = void(*)(TensorIterator&);
+
+DECLARE_DISPATCH(clamp_scalar_fn, clamp_scalar_stub);
+DECLARE_DISPATCH(where_fn, where_stub);
+DECLARE_DISPATCH(addcmul_fn, addcmul_stub);
+DECLARE_DISPATCH(lerp_scalar_fn, lerp_scalar_stub);
+DECLARE_DISPATCH(lerp_tensor_fn, lerp_tensor_stub);
+DECLARE_DISPATCH(fma_fn, fma_stub);
+
+namespace native {
+// min(max(self, min), max)
+Tensor clamp(const Tensor& self, const Scalar& min, const Scalar& max);
+Tensor& clamp_out(Tensor& out, const Tensor& self, const Scalar& min, const Scalar& max);
+Tensor& clamp_(Tensor& self, const Scalar& min, const Scalar& max);
+
+// condition ? self : other, the condition is a Bool or Byte tensor
+Tensor where(const Tensor& condition, const Tensor& self, const Tensor& other);
+Tensor& where_out(Tensor& out, const Tensor& condition, const Tensor& self, const Tensor& other);
+
+// self + value * tensor1 * tensor2
+Tensor addcmul(const Tensor& self, const Tensor& tensor1, const Tensor& tensor2, const Scalar& value);
+Tensor& addcmul_out(Tensor& out, const Tensor& self, const Tensor& tensor1, const Tensor& tensor2, const Scalar& value);
+Tensor& addcmul_(Tensor& self, const Tensor& tensor1, const Tensor& tensor2, const Scalar& value);
+
+// self + weight * (end - self)
+Tensor lerp(const Tensor& self, const Tensor& end, const Scalar& weight);
+Tensor& lerp_out(Tensor& out, const Tensor& self, const Tensor& end, const Scalar& weight);
+Tensor& lerp_(Tensor& self, const Tensor& end, const Scalar& weight);
+Tensor lerp(const Tensor& self, const Tensor& end, const Tensor& weight);
+Tensor& lerp_out(Tensor& out, const Tensor& self, const Tensor& end, const Tensor& weight);
+Tensor& lerp_(Tensor& self, const Tensor& end, const Tensor& weight);
+
+// self * tensor1 + tensor2
+Tensor fma(const Tensor& self, const Tensor& tensor1, const Tensor& tensor2);
+Tensor& fma_out(Tensor& out, const Tensor& self, const Tensor& tensor1, const Tensor& tensor2);
+Tensor& fma_(Tensor& self, const Tensor& tensor1, const Tensor& tensor2);
+}   // end namespace native
+}   // end namespace otter
+
+#endif /* TernaryOps_hpp */
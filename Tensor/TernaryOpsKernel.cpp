@@ -0,0 +1,171 @@
+//
+//  TernaryOpsKernel.cpp
+//  Tensor
+//
+//  Created by 陳均豪 on 2022/3/22.
+//
+
+#include "TernaryOps.hpp"
+#include "TernaryOpsKernel.hpp"
+#include "TensorIterator.hpp"
+#include "Dispatch.hpp"
+#include "Loop.hpp"
+#include "VecIntrinsic.hpp"
+
+namespace otter {
+
+void clamp_scalar_kernel(TensorIterator& iter, const Scalar& min_, const Scalar& max_) {
+    OTTER_DISPATCH_ALL_TYPES(iter.dtype(), "clamp_scalar_cpu", [&] {
+        using Vec = vec::Vectorized<scalar_t>;
+        scalar_t min = min_.to<scalar_t>();
+        scalar_t max = max_.to<scalar_t>();
+        Vec min_vec(min);
+        Vec max_vec(max);
+        cpu_kernel_vec(iter,
+            [=](scalar_t a) -> scalar_t {
+                return std::min(std::max(a, min), max);
+            },
+            [=](Vec a) -> Vec {
+                return vec::minimum(vec::maximum(a, min_vec), max_vec);
+            }
+        );
+    });
+}
+
+// Expand 1 byte conditions into an all-ones or all-zeros lane of scalar_t for blendv
+template <typename scalar_t>
+static inline vec::Vectorized<scalar_t> condition_mask(const uint8_t* condition) {
+    using Vec = vec::Vectorized<scalar_t>;
+    using mask_t = vec::int_same_size_t<scalar_t>;
+    __otter_align__ mask_t buffer[Vec::size()];
+    for (const auto i : otter::irange(Vec::size())) {
+        buffer[i] = condition[i] ? mask_t(-1) : mask_t(0);
+    }
+    return Vec::loadu(buffer);
+}
+
+#if CPU_CAPABILITY_AVX2
+template <>
+inline vec::Vectorized<float> condition_mask<float>(const uint8_t* condition) {
+    __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(condition));
+    __m256i lanes = _mm256_cmpgt_epi32(_mm256_cvtepu8_epi32(bytes), _mm256_setzero_si256());
+    return _mm256_castsi256_ps(lanes);
+}
+#endif
+
+void where_kernel(TensorIterator& iter) {
+    OTTER_DISPATCH_ALL_TYPES(iter.dtype(), "where_cpu", [&] {
+        using Vec = vec::Vectorized<scalar_t>;
+        // The condition is Bool or Byte, cpu_kernel_vec loads every input as scalar_t so the loop is written out here
+        iter.for_each([&](char** base, const int64_t* strides, int64_t size0, int64_t size1) {
+            char* data[4] = {base[0], base[1], base[2], base[3]};
+            const int64_t* outer_strides = &strides[4];
+            const bool contiguous =
+                strides[0] == sizeof(scalar_t) &&
+                strides[1] == sizeof(uint8_t) &&
+                strides[2] == sizeof(scalar_t) &&
+                strides[3] == sizeof(scalar_t);
+
+            for (const auto j : otter::irange(size1)) {
+                (void)j;
+                int64_t i = 0;
+                if (contiguous) {
+                    scalar_t* out = reinterpret_cast<scalar_t*>(data[0]);
+                    const uint8_t* condition = reinterpret_cast<const uint8_t*>(data[1]);
+                    const scalar_t* self = reinterpret_cast<const scalar_t*>(data[2]);
+                    const scalar_t* other = reinterpret_cast<const scalar_t*>(data[3]);
+                    for (; i <= size0 - Vec::size(); i += Vec::size()) {
+                        Vec::blendv(Vec::loadu(other + i), Vec::loadu(self + i), condition_mask<scalar_t>(condition + i)).store(out + i);
+                    }
+                }
+                for (; i < size0; ++i) {
+                    const bool condition = *reinterpret_cast<const uint8_t*>(data[1] + i * strides[1]);
+                    *reinterpret_cast<scalar_t*>(data[0] + i * strides[0]) = condition ?
+                        *reinterpret_cast<const scalar_t*>(data[2] + i * strides[2]) :
+                        *reinterpret_cast<const scalar_t*>(data[3] + i * strides[3]);
+                }
+                for (const auto arg : otter::irange(4)) {
+                    data[arg] += outer_strides[arg];
+                }
+            }
+        });
+    });
+}
+
+void addcmul_kernel(TensorIterator& iter, const Scalar& value_) {
+    OTTER_DISPATCH_ALL_TYPES(iter.dtype(), "addcmul_cpu", [&] {
+        using Vec = vec::Vectorized<scalar_t>;
+        scalar_t value = value_.to<scalar_t>();
+        Vec value_vec(value);
+        cpu_kernel_vec(iter,
+            [=](scalar_t self, scalar_t t1, scalar_t t2) -> scalar_t {
+                return self + value * t1 * t2;
+            },
+            [=](Vec self, Vec t1, Vec t2) -> Vec {
+                return vec::fmadd(t1 * value_vec, t2, self);
+            }
+        );
+    });
+}
+
+// Like PyTorch, interpolate from the nearer end so that weight 0 gives self and weight 1 gives end exactly
+void lerp_scalar_kernel(TensorIterator& iter, const Scalar& weight_) {
+    OTTER_DISPATCH_FLOATING_TYPES(iter.dtype(), "lerp_scalar_cpu", [&] {
+        using Vec = vec::Vectorized<scalar_t>;
+        scalar_t weight = weight_.to<scalar_t>();
+        const bool from_self = std::abs(weight) < scalar_t(0.5);
+        Vec weight_vec(weight);
+        Vec weight_minus_one_vec(weight - scalar_t(1));
+        cpu_kernel_vec(iter,
+            [=](scalar_t self, scalar_t end) -> scalar_t {
+                return from_self ? self + weight * (end - self) : end - (end - self) * (scalar_t(1) - weight);
+            },
+            [=](Vec self, Vec end) -> Vec {
+                Vec diff = end - self;
+                return from_self ? vec::fmadd(weight_vec, diff, self) : vec::fmadd(diff, weight_minus_one_vec, end);
+            }
+        );
+    });
+}
+
+void lerp_tensor_kernel(TensorIterator& iter) {
+    OTTER_DISPATCH_FLOATING_TYPES(iter.dtype(), "lerp_tensor_cpu", [&] {
+        using Vec = vec::Vectorized<scalar_t>;
+        const Vec half_vec(scalar_t(0.5));
+        const Vec one_vec(scalar_t(1));
+        cpu_kernel_vec(iter,
+            [=](scalar_t self, scalar_t end, scalar_t weight) -> scalar_t {
+                return std::abs(weight) < scalar_t(0.5) ? self + weight * (end - self) : end - (end - self) * (scalar_t(1) - weight);
+            },
+            [=](Vec self, Vec end, Vec weight) -> Vec {
+                Vec diff = end - self;
+                Vec from_self = vec::fmadd(weight, diff, self);
+                Vec from_end = vec::fmadd(diff, weight - one_vec, end);
+                return Vec::blendv(from_end, from_self, weight.abs() < half_vec);
+            }
+        );
+    });
+}
+
+void fma_kernel(TensorIterator& iter) {
+    OTTER_DISPATCH_ALL_TYPES(iter.dtype(), "fma_cpu", [&] {
+        using Vec = vec::Vectorized<scalar_t>;
+        cpu_kernel_vec(iter,
+            [=](scalar_t self, scalar_t t1, scalar_t t2) -> scalar_t {
+                return self * t1 + t2;
+            },
+            [=](Vec self, Vec t1, Vec t2) -> Vec {
+                return vec::fmadd(self, t1, t2);
+            }
+        );
+    });
+}
+
+REGISTER_DISPATCH(clamp_scalar_stub, &clamp_scalar_kernel);
+REGISTER_DISPATCH(where_stub, &where_kernel);
+REGISTER_DISPATCH(addcmul_stub, &addcmul_kernel);
+REGISTER_DISPATCH(lerp_scalar_stub, &lerp_scalar_kernel);
+REGISTER_DISPATCH(lerp_tensor_stub, &lerp_tensor_kernel);
+REGISTER_DISPATCH(fma_stub, &fma_kernel);
+
+}   // end namespace otter
@@ -0,0 +1,25 @@
+//
+//  TernaryOpsKernel.hpp
+//  Tensor
+//
+//  Created by 陳均豪 on 2022/3/22.
+//
+
+#ifndef TernaryOpsKernel_hpp
+#define TernaryOpsKernel_hpp
+
+namespace otter {
+
+class Scalar;
+class TensorIterator;
+
+void clamp_scalar_kernel(TensorIterator& iter, const Scalar& min, const Scalar& max);
+void where_kernel(TensorIterator& iter);
+void addcmul_kernel(TensorIterator& iter, const Scalar& value);
+void lerp_scalar_kernel(TensorIterator& iter, const Scalar& weight);
+void lerp_tensor_kernel(TensorIterator& iter);
+void fma_kernel(TensorIterator& iter);
+
+}   // end namespace otter
+
+#endif /* TernaryOpsKernel_hpp */
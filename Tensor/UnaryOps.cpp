@@ -15,9 +15,15 @@ DEFINE_META_FUNCTION_OVERLOAD(name, overload) (const Tensor& self) { \
     build_borrowing_unary_float_op(maybe_get_output(), self); \
 }
 
-DEFINE_UNARY_META_FUNCTION_SELF(bitwise_not, Tensor);
-DEFINE_UNARY_META_FUNCTION_SELF(neg, Tensor);
-DEFINE_UNARY_META_FUNCTION_SELF(abs, Tensor);
+// Keep the dtype of self, the integer types run on their own vectorized kernels
+#define DEFINE_UNARY_META_FUNCTION_SELF_SAME_DTYPE(name, overload) \
+DEFINE_META_FUNCTION_OVERLOAD(name, overload) (const Tensor& self) { \
+    build_borrowing_unary_op(maybe_get_output(), self); \
+}
+
+DEFINE_UNARY_META_FUNCTION_SELF_SAME_DTYPE(bitwise_not, Tensor);
+DEFINE_UNARY_META_FUNCTION_SELF_SAME_DTYPE(neg, Tensor);
+DEFINE_UNARY_META_FUNCTION_SELF_SAME_DTYPE(abs, Tensor);
 DEFINE_UNARY_META_FUNCTION_SELF(sin, Tensor);
 DEFINE_UNARY_META_FUNCTION_SELF(cos, Tensor);
 DEFINE_UNARY_META_FUNCTION_SELF(tan, Tensor);
@@ -21,9 +21,10 @@ void bitwise_not_kernel(TensorIterator& iter) {
         });
     } else {
         OTTER_DISPATCH_INTEGRAL_TYPES(iter.dtype(), "bitwise_not_cpu", [&]() {
-            cpu_kernel(iter, [=](scalar_t a) -> scalar_t {
-                return ~a;
-            });
+            cpu_kernel_vec(iter,
+                [=](scalar_t a) -> scalar_t { return ~a; },
+                [=](vec::Vectorized<scalar_t> a) { return ~a; }
+            );
         });
     }
 }
@@ -8,6 +8,10 @@
 #include "UpSample.hpp"
 #include "TensorFunction.hpp"
 #include "Accumulator.hpp"
+#include "TensorFactory.hpp"
+#include "TensorPacking.hpp"
+#include "Parallel.hpp"
+#include "Vec.hpp"
 
 namespace otter {
 
@@ -57,4 +61,48 @@ DEFINE_IMPL_FUNCTION(upsample_bilinear2d_out_cpu) (
 
 
 
+Tensor upsample_nearest2d_packed(const Tensor& self, IntArrayRef output_size, double scales_h, double scales_w) {
+    using Vec = vec::Vectorized<float>;
+    
+    OTTER_CHECK(otter::is_packed(self) && self.size(4) == Vec::size() && self.scalar_type() == ScalarType::Float, "upsample_nearest2d_packed: Expect packed float input but get ", self.sizes());
+    OTTER_CHECK(output_size.size() == 2, "upsample_nearest2d_packed: Expect output size {height, width}");
+    
+    const int64_t planes = self.size(0) * self.size(1);
+    const int64_t input_height = self.size(2);
+    const int64_t input_width = self.size(3);
+    const int64_t output_height = output_size[0];
+    const int64_t output_width = output_size[1];
+    
+    Tensor input = self.contiguous();
+    Tensor output = otter::empty({self.size(0), self.size(1), output_height, output_width, Vec::size()}, ScalarType::Float);
+    
+    const float height_scale = compute_scales_value<float>(scales_h, input_height, output_height);
+    const float width_scale = compute_scales_value<float>(scales_w, input_width, output_width);
+    
+    std::vector<int64_t> input_index_w(output_width);
+    for (const auto ow : otter::irange(output_width)) {
+        input_index_w[ow] = nearest_neighbor_compute_source_index(width_scale, ow, input_width);
+    }
+    
+    const float* input_data = input.data_ptr<float>();
+    float* output_data = output.data_ptr<float>();
+    
+    otter::parallel_for(0, planes * output_height, 0, [&](int64_t begin, int64_t end) {
+        for (const auto i : otter::irange(begin, end)) {
+            const int64_t plane = i / output_height;
+            const int64_t oh = i % output_height;
+            const int64_t ih = nearest_neighbor_compute_source_index(height_scale, oh, input_height);
+            
+            const float* input_row = input_data + (plane * input_height + ih) * input_width * Vec::size();
+            float* output_row = output_data + i * output_width * Vec::size();
+            
+            for (const auto ow : otter::irange(output_width)) {
+                Vec::loadu(input_row + input_index_w[ow] * Vec::size()).store(output_row + ow * Vec::size());
+            }
+        }
+    });
+    
+    return output;
+}
+
 }   // end namespace otter
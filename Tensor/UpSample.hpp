@@ -157,6 +157,9 @@ static inline void compute_source_index_and_lambda(
     }
 }
 
+// Nearest upsampling on the channel blocked input {N, C / elempack, H, W, elempack}, the output is packed too
+Tensor upsample_nearest2d_packed(const Tensor& self, IntArrayRef output_size, double scales_h, double scales_w);
+
 }   // end namespace otter
 
 #endif /* UpSample_hpp */
@@ -14,6 +14,8 @@
 #include "Parallel.hpp"
 #include "Vec.hpp"
 
+#include <cstring>
+
 namespace otter {
 
 namespace {
@@ -810,12 +812,329 @@ struct HelperInterpLinear : public HelperInterpBase {
     }
 };
 
+// Integer factor fast paths, the source index of output o is o / factor for nearest, and for
+// 2x bilinear without align_corners the weights are fixed at 0.25 and 0.75
+
+// Returns the factor when output index o maps exactly to input index o / factor, 0 otherwise
+static inline int64_t upsample_integer_factor(int64_t input_size, int64_t output_size, double scale) {
+    for (const int64_t factor : {1, 2, 4}) {
+        if (output_size == input_size * factor && (scale <= 0 || scale == factor)) {
+            return factor;
+        }
+    }
+    return 0;
+}
+
+// The output may be a slice of a larger buffer (e.g. the output of Concat), only the
+// layout inside one image needs to be dense
+static inline bool is_dense_plane_nchw(const Tensor& t) {
+    return t.stride(3) == 1 && t.stride(2) == t.size(3) && t.stride(1) == t.size(2) * t.size(3);
+}
+
+static inline bool is_dense_pixel_nhwc(const Tensor& t) {
+    return (t.stride(1) == 1 || t.size(1) == 1) && t.stride(3) >= t.size(1) && t.stride(2) == t.size(3) * t.stride(3);
+}
+
+template <typename scalar_t, int factor>
+static inline void upsample_nearest_row(scalar_t* out, const scalar_t* in, int64_t input_width) {
+    for (const auto iw : otter::irange(input_width)) {
+        for (const auto k : otter::irange(factor)) {
+            out[iw * factor + k] = in[iw];
+        }
+    }
+}
+
+#if CPU_CAPABILITY_AVX2
+template <>
+inline void upsample_nearest_row<float, 2>(float* out, const float* in, int64_t input_width) {
+    int64_t iw = 0;
+    for (; iw + 8 <= input_width; iw += 8) {
+        __m256 x = _mm256_loadu_ps(in + iw);
+        __m256 lo = _mm256_unpacklo_ps(x, x);
+        __m256 hi = _mm256_unpackhi_ps(x, x);
+        _mm256_storeu_ps(out + iw * 2, _mm256_permute2f128_ps(lo, hi, 0x20));
+        _mm256_storeu_ps(out + iw * 2 + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+    }
+    for (; iw < input_width; ++iw) {
+        out[iw * 2] = in[iw];
+        out[iw * 2 + 1] = in[iw];
+    }
+}
+
+template <>
+inline void upsample_nearest_row<float, 4>(float* out, const float* in, int64_t input_width) {
+    const __m256i index0 = _mm256_setr_epi32(0, 0, 0, 0, 1, 1, 1, 1);
+    const __m256i index_step = _mm256_set1_epi32(2);
+    int64_t iw = 0;
+    for (; iw + 8 <= input_width; iw += 8) {
+        __m256 x = _mm256_loadu_ps(in + iw);
+        __m256i index = index0;
+        for (const auto k : otter::irange(4)) {
+            _mm256_storeu_ps(out + iw * 4 + k * 8, _mm256_permutevar8x32_ps(x, index));
+            index = _mm256_add_epi32(index, index_step);
+        }
+    }
+    for (; iw < input_width; ++iw) {
+        _mm_storeu_ps(out + iw * 4, _mm_set1_ps(in[iw]));
+    }
+}
+#endif
+
+template <typename scalar_t, int factor_w>
+static void cpu_upsample_nearest2d_integer_factor_nchw(const Tensor& output, const Tensor& input, int64_t factor_h) {
+    const int64_t channels = input.size(1);
+    const int64_t input_height = input.size(2);
+    const int64_t input_width = input.size(3);
+    const int64_t output_width = output.size(3);
+    const int64_t output_plane_size = output.size(2) * output_width;
+    const int64_t output_batch_stride = output.stride(0);
+
+    const scalar_t* input_data = input.data_ptr<scalar_t>();
+    scalar_t* output_data = output.data_ptr<scalar_t>();
+
+    // parallel on dim of N * C, H of the input, each input row fills factor_h output rows
+    otter::parallel_for(0, input.size(0) * channels * input_height, otter::GRAIN_SIZE / (output_width * factor_h) + 1, [&](int64_t begin, int64_t end) {
+        int64_t n = 0;
+        int64_t c = 0;
+        int64_t ih = 0;
+        data_index_init(begin, n, input.size(0), c, channels, ih, input_height);
+
+        for (const auto i : otter::irange(begin, end)) {
+            scalar_t* out = output_data + n * output_batch_stride + c * output_plane_size + ih * factor_h * output_width;
+            upsample_nearest_row<scalar_t, factor_w>(out, input_data + i * input_width, input_width);
+            for (const auto k : otter::irange(1, factor_h)) {
+                std::memcpy(out + k * output_width, out, output_width * sizeof(scalar_t));
+            }
+            data_index_step(n, input.size(0), c, channels, ih, input_height);
+        }
+    });
+}
+
+template <typename scalar_t>
+static void cpu_upsample_nearest2d_integer_factor_nhwc(const Tensor& output, const Tensor& input, int64_t factor_h, int64_t factor_w) {
+    using Vec = vec::Vectorized<scalar_t>;
+
+    const int64_t channels = input.size(1);
+    const int64_t input_height = input.size(2);
+    const int64_t input_width = input.size(3);
+    const int64_t output_pixel_stride = output.stride(3);
+    const int64_t output_row_stride = output.stride(2);
+    const int64_t output_batch_stride = output.stride(0);
+
+    const scalar_t* input_data = input.data_ptr<scalar_t>();
+    scalar_t* output_data = output.data_ptr<scalar_t>();
+
+    const int64_t output_width = output.size(3);
+
+    // parallel on dim of N, H of the input, each input pixel is stored to factor_w adjacent output pixels
+    // and the output row is then repeated factor_h times
+    otter::parallel_for(0, input.size(0) * input_height, otter::GRAIN_SIZE / (input_width * channels * factor_h * factor_w) + 1, [&](int64_t begin, int64_t end) {
+        for (const auto i : otter::irange(begin, end)) {
+            const int64_t n = i / input_height;
+            const int64_t ih = i % input_height;
+            const scalar_t* in = input_data + i * input_width * channels;
+            scalar_t* out = output_data + n * output_batch_stride + ih * factor_h * output_row_stride;
+            for (const auto iw : otter::irange(input_width)) {
+                for (int64_t d = 0; d < channels; d += Vec::size()) {
+                    const int64_t count = std::min<int64_t>(Vec::size(), channels - d);
+                    Vec value = Vec::loadu(in + iw * channels + d, count);
+                    for (const auto kw : otter::irange(factor_w)) {
+                        value.store(out + (iw * factor_w + kw) * output_pixel_stride + d, count);
+                    }
+                }
+            }
+            for (const auto kh : otter::irange(1, factor_h)) {
+                scalar_t* out_row = out + kh * output_row_stride;
+                if (output_pixel_stride == channels) {
+                    std::memcpy(out_row, out, output_width * channels * sizeof(scalar_t));
+                } else {
+                    for (const auto ow : otter::irange(output_width)) {
+                        std::memcpy(out_row + ow * output_pixel_stride, out + ow * output_pixel_stride, channels * sizeof(scalar_t));
+                    }
+                }
+            }
+        }
+    });
+}
+
+static bool upsample_nearest2d_integer_factor(const Tensor& output, const Tensor& input, double scales_h, double scales_w) {
+    const int64_t factor_h = upsample_integer_factor(input.size(2), output.size(2), scales_h);
+    const int64_t factor_w = upsample_integer_factor(input.size(3), output.size(3), scales_w);
+    if (!factor_h || !factor_w || input.scalar_type() != output.scalar_type()) {
+        return false;
+    }
+
+    if (input.is_contiguous(MemoryFormat::ChannelsLast) && is_dense_pixel_nhwc(output)) {
+        OTTER_DISPATCH_FLOATING_TYPES_AND(ScalarType::Byte, input.scalar_type(), "upsample_nearest2d_integer_factor_nhwc", [&] {
+            cpu_upsample_nearest2d_integer_factor_nhwc<scalar_t>(output, input, factor_h, factor_w);
+        });
+        return true;
+    }
+    if (input.is_contiguous() && is_dense_plane_nchw(output)) {
+        OTTER_DISPATCH_FLOATING_TYPES_AND(ScalarType::Byte, input.scalar_type(), "upsample_nearest2d_integer_factor_nchw", [&] {
+            switch (factor_w) {
+                case 1: cpu_upsample_nearest2d_integer_factor_nchw<scalar_t, 1>(output, input, factor_h); break;
+                case 2: cpu_upsample_nearest2d_integer_factor_nchw<scalar_t, 2>(output, input, factor_h); break;
+                default: cpu_upsample_nearest2d_integer_factor_nchw<scalar_t, 4>(output, input, factor_h); break;
+            }
+        });
+        return true;
+    }
+    return false;
+}
+
+// out = a * weight_a + b * weight_b, the same evaluation order as the generic linear kernel
+template <typename scalar_t>
+static inline void linear_combine(scalar_t* out, const scalar_t* a, scalar_t weight_a, const scalar_t* b, scalar_t weight_b, int64_t size) {
+    using Vec = vec::Vectorized<scalar_t>;
+    const Vec weight_a_vec(weight_a);
+    const Vec weight_b_vec(weight_b);
+    int64_t d = 0;
+    for (; d < size - (size % Vec::size()); d += Vec::size()) {
+        (Vec::loadu(a + d) * weight_a_vec + Vec::loadu(b + d) * weight_b_vec).store(out + d);
+    }
+    for (; d < size; ++d) {
+        out[d] = a[d] * weight_a + b[d] * weight_b;
+    }
+}
+
+// Doubles the width of a row of width pixels with channels elements each
+//   out[0]      = in[0]
+//   out[2i]     = in[i - 1] * 0.25 + in[i] * 0.75
+//   out[2i + 1] = in[i] * 0.75 + in[min(i + 1, width - 1)] * 0.25
+template <typename scalar_t>
+static inline void upsample_bilinear2x_row(scalar_t* out, const scalar_t* in, int64_t width, int64_t channels) {
+    const scalar_t quarter = scalar_t(0.25);
+    const scalar_t three_quarters = scalar_t(0.75);
+    std::memcpy(out, in, channels * sizeof(scalar_t));
+    for (const auto i : otter::irange(width)) {
+        const scalar_t* cur = in + i * channels;
+        if (i > 0) {
+            linear_combine(out + 2 * i * channels, cur - channels, quarter, cur, three_quarters, channels);
+        }
+        const scalar_t* next = (i + 1 < width) ? cur + channels : cur;
+        linear_combine(out + (2 * i + 1) * channels, cur, three_quarters, next, quarter, channels);
+    }
+}
+
+#if CPU_CAPABILITY_AVX2
+static inline void upsample_bilinear2x_row(float* out, const float* in, int64_t width, int64_t channels) {
+    if (channels != 1 || width < 2) {
+        upsample_bilinear2x_row<float>(out, in, width, channels);
+        return;
+    }
+    const __m256 quarter = _mm256_set1_ps(0.25f);
+    const __m256 three_quarters = _mm256_set1_ps(0.75f);
+    out[0] = in[0];
+    out[1] = in[0] * 0.75f + in[1] * 0.25f;
+    int64_t i = 1;
+    for (; i + 9 <= width; i += 8) {
+        __m256 prev = _mm256_loadu_ps(in + i - 1);
+        __m256 cur = _mm256_loadu_ps(in + i);
+        __m256 next = _mm256_loadu_ps(in + i + 1);
+        __m256 even = _mm256_add_ps(_mm256_mul_ps(prev, quarter), _mm256_mul_ps(cur, three_quarters));
+        __m256 odd = _mm256_add_ps(_mm256_mul_ps(cur, three_quarters), _mm256_mul_ps(next, quarter));
+        __m256 lo = _mm256_unpacklo_ps(even, odd);
+        __m256 hi = _mm256_unpackhi_ps(even, odd);
+        _mm256_storeu_ps(out + 2 * i, _mm256_permute2f128_ps(lo, hi, 0x20));
+        _mm256_storeu_ps(out + 2 * i + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+    }
+    for (; i < width; ++i) {
+        out[2 * i] = in[i - 1] * 0.25f + in[i] * 0.75f;
+        out[2 * i + 1] = in[i] * 0.75f + in[std::min(i + 1, width - 1)] * 0.25f;
+    }
+}
+#endif
+
+// A plane is one channel of an NCHW image or a whole NHWC image, channels is 1 for NCHW and
+// the NHWC output pixels are output_pixel_stride apart
+template <typename scalar_t>
+static void cpu_upsample_bilinear2x(const Tensor& output, const Tensor& input, int64_t planes_per_batch, int64_t channels, int64_t output_pixel_stride, int64_t output_plane_stride) {
+    const int64_t planes = input.size(0) * planes_per_batch;
+    const int64_t input_height = input.size(2);
+    const int64_t input_width = input.size(3);
+    const int64_t output_width = output.size(3);
+    const int64_t output_row_size = output_width * channels;
+    const int64_t output_row_stride = output_width * output_pixel_stride;
+    const int64_t input_plane_size = input_height * input_width * channels;
+
+    const scalar_t* input_data = input.data_ptr<scalar_t>();
+    scalar_t* output_data = output.data_ptr<scalar_t>();
+
+    // Store the rows of the vertical pass, dense or pixel by pixel
+    auto store_row = [&](scalar_t* out, const scalar_t* a, scalar_t weight_a, const scalar_t* b, scalar_t weight_b) {
+        if (output_pixel_stride == channels) {
+            linear_combine(out, a, weight_a, b, weight_b, output_row_size);
+            return;
+        }
+        for (const auto ow : otter::irange(output_width)) {
+            linear_combine(out + ow * output_pixel_stride, a + ow * channels, weight_a, b + ow * channels, weight_b, channels);
+        }
+    };
+
+    // parallel on dim of planes, H of the input, each input row fills two output rows
+    otter::parallel_for(0, planes * input_height, otter::GRAIN_SIZE / (output_row_size * 2) + 1, [&](int64_t begin, int64_t end) {
+        // Horizontally upsampled rows i - 1, i and i + 1, row r lives in slot r % 3
+        std::vector<scalar_t> buffer(3 * output_row_size);
+        int64_t cached[3] = {-1, -1, -1};
+        auto horizontal_row = [&](int64_t plane, int64_t r) -> const scalar_t* {
+            const int64_t slot = r % 3;
+            scalar_t* row = buffer.data() + slot * output_row_size;
+            if (cached[slot] != plane * input_height + r) {
+                upsample_bilinear2x_row(row, input_data + plane * input_plane_size + r * input_width * channels, input_width, channels);
+                cached[slot] = plane * input_height + r;
+            }
+            return row;
+        };
+
+        for (const auto i : otter::irange(begin, end)) {
+            const int64_t plane = i / input_height;
+            const int64_t ih = i % input_height;
+            const scalar_t* cur = horizontal_row(plane, ih);
+            const scalar_t* next = horizontal_row(plane, std::min(ih + 1, input_height - 1));
+            scalar_t* out = output_data + (plane / planes_per_batch) * output.stride(0) + (plane % planes_per_batch) * output_plane_stride + 2 * ih * output_row_stride;
+            if (ih == 0) {
+                store_row(out, cur, scalar_t(1), cur, scalar_t(0));
+            } else {
+                store_row(out, horizontal_row(plane, ih - 1), scalar_t(0.25), cur, scalar_t(0.75));
+            }
+            store_row(out + output_row_stride, cur, scalar_t(0.75), next, scalar_t(0.25));
+        }
+    });
+}
+
+static bool upsample_bilinear2d_integer_factor(const Tensor& output, const Tensor& input, bool align_corners, double scales_h, double scales_w) {
+    if (align_corners || input.scalar_type() != output.scalar_type() ||
+        upsample_integer_factor(input.size(2), output.size(2), scales_h) != 2 ||
+        upsample_integer_factor(input.size(3), output.size(3), scales_w) != 2) {
+        return false;
+    }
+
+    if (input.is_contiguous(MemoryFormat::ChannelsLast) && is_dense_pixel_nhwc(output)) {
+        OTTER_DISPATCH_FLOATING_TYPES(input.scalar_type(), "upsample_bilinear2d_integer_factor_nhwc", [&] {
+            cpu_upsample_bilinear2x<scalar_t>(output, input, 1, input.size(1), output.stride(3), 0);
+        });
+        return true;
+    }
+    if (input.is_contiguous() && is_dense_plane_nchw(output)) {
+        OTTER_DISPATCH_FLOATING_TYPES(input.scalar_type(), "upsample_bilinear2d_integer_factor_nchw", [&] {
+            cpu_upsample_bilinear2x<scalar_t>(output, input, input.size(1), 1, 1, output.stride(1));
+        });
+        return true;
+    }
+    return false;
+}
+
 void upsample_nearest2d_kernel_impl(
     const Tensor& output,
     const Tensor& input,
     double scales_h,
     double scales_w) {
     
+    if (upsample_nearest2d_integer_factor(output, input, scales_h, scales_w)) {
+        return;
+    }
+    
     bool check;
     
     if ((check = input.is_contiguous(MemoryFormat::ChannelsLast))) {
@@ -834,6 +1153,10 @@ void upsample_bilinear2d_kernel_impl(
     double scales_h,
     double scales_w) {
 
+    if (upsample_bilinear2d_integer_factor(output, input, align_corners, scales_h, scales_w)) {
+        return;
+    }
+
     // Temporarily dispatch to original channels last implementation
     if (input.is_contiguous(MemoryFormat::ChannelsLast)) {
         OTTER_DISPATCH_FLOATING_TYPES(input.scalar_type(), "upsample_bilinear2d_channels_last", [&] {
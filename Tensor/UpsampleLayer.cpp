@@ -8,12 +8,17 @@
 #include "UpsampleLayer.hpp"
 #include "TensorFunction.hpp"
 #include "LayerRegistry.hpp"
+#include "UpSample.hpp"
+#include "TensorPacking.hpp"
 
 namespace otter {
 
 UpsampleLayer::UpsampleLayer() {
     one_blob_only = true;
     support_inplace = false;
+    support_view_output = true;
+    support_packing = true;
+    support_channels_last = true;
 }
 
 int UpsampleLayer::parse_param(LayerOption& option, ParamDict& pd) {
@@ -22,11 +27,14 @@ int UpsampleLayer::parse_param(LayerOption& option, ParamDict& pd) {
     std::string upsample_mode = opt_find_string(option, "upsample_mode", "nearest");
     if (upsample_mode == "nearest") {
         mode = 0;
+    } else if (upsample_mode == "bilinear") {
+        mode = 1;
     }
     int output_height = opt_find_int(option, "output_height", 0);
     int output_width = opt_find_int(option, "output_width", 0);
     float scale_height = opt_find_float(option, "scale_height", 0.f);
     float scale_width = opt_find_float(option, "scale_width", 0.f);
+    int align_corners = opt_find_int(option, "align_corners", 0);
     
     int stride = -1;
     if (opt_check_string(option, "darknet_mode")) {
@@ -41,6 +49,7 @@ int UpsampleLayer::parse_param(LayerOption& option, ParamDict& pd) {
     pd.set((int)UpsampleParam::Height_scale, scale_height);
     pd.set((int)UpsampleParam::Width_scale, scale_width);
     pd.set((int)UpsampleParam::Stride, stride);
+    pd.set((int)UpsampleParam::Align_corners, align_corners);
     
     
     return 0;
@@ -53,6 +62,7 @@ int UpsampleLayer::load_param(const ParamDict &pd) {
     scale_height = pd.get((int)UpsampleParam::Height_scale, 0.f);
     scale_width = pd.get((int)UpsampleParam::Width_scale, 0.f);
     stride = pd.get((int)UpsampleParam::Stride, -1);
+    align_corners = pd.get((int)UpsampleParam::Align_corners, 0);
     
     return 0;
 }
@@ -80,13 +90,39 @@ int UpsampleLayer::compute_output_shape(ParamDict& pd) {
 }
 
 int UpsampleLayer::forward(const Tensor& bottom_blob, Tensor& top_blob, const NetOption& opt) const {
+    if (otter::is_packed(bottom_blob)) {
+        if (mode == 0) {
+            top_blob = otter::upsample_nearest2d_packed(bottom_blob, {output_height, output_width}, scale_height, scale_width);
+            
+            return 0;
+        }
+        
+        return forward(otter::from_packed(bottom_blob), top_blob, opt);
+    }
+    
     if (mode == 0) {
         top_blob = otter::native::upsample_nearest2d(bottom_blob, {output_height, output_width}, scale_height, scale_width);
+    } else if (mode == 1) {
+        top_blob = otter::native::upsample_bilinear2d(bottom_blob, {output_height, output_width}, align_corners, scale_height, scale_width);
     }
     
     return 0;
 }
 
+int UpsampleLayer::forward_into(const Tensor& bottom_blob, Tensor& top_blob, const NetOption& opt) const {
+    if (mode == 0) {
+        otter::native::upsample_nearest2d_out(top_blob, bottom_blob, {output_height, output_width}, scale_height, scale_width);
+        
+        return 0;
+    } else if (mode == 1) {
+        otter::native::upsample_bilinear2d_out(top_blob, bottom_blob, {output_height, output_width}, align_corners, scale_height, scale_width);
+        
+        return 0;
+    }
+    
+    return -1;
+}
+
 REGISTER_LAYER_CLASS(Upsample);
 
 
@@ -24,6 +24,8 @@ public:
     
     virtual int forward(const Tensor& bottom_blob, Tensor& top_blob, const NetOption& opt) const;
     
+    virtual int forward_into(const Tensor& bottom_blob, Tensor& top_blob, const NetOption& opt) const;
+    
     virtual std::string type() const { return "Upsample"; }
 private:
     int mode;
@@ -32,6 +34,7 @@ private:
     float scale_height;
     float scale_width;
     int stride;
+    int align_corners;
 };
 
 enum class UpsampleParam {
@@ -40,7 +43,8 @@ enum class UpsampleParam {
     Output_width,
     Height_scale,
     Width_scale,
-    Stride
+    Stride,
+    Align_corners
 };
 
 }   // end namespace otter
@@ -11,7 +11,12 @@
 #include "VecIntrinsic.hpp"
 #include "VecBase.hpp"
 #include "Vec256_float.hpp"
+#include "Vec256_double.hpp"
+#include "Vec256_int.hpp"
 #include "Vec256_float_neon.hpp"
+#include "Vec256_half.hpp"
+#include "Vec256_bfloat16.hpp"
+#include "Vec256_convert.hpp"
 
 namespace otter {
 namespace vec{
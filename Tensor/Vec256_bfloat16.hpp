@@ -0,0 +1,90 @@
+//
+//  Vec256_bfloat16.hpp
+//  Tensor
+//
+//  Created by 陳均豪 on 2022/3/22.
+//
+
+#ifndef Vec256_bfloat16_h
+#define Vec256_bfloat16_h
+
+#include "VecIntrinsic.hpp"
+#include "VecBase.hpp"
+#include "Vec256_float.hpp"
+#include "Vec256_float_neon.hpp"
+
+#include "Config.hpp"
+#include "BFloat16.hpp"
+
+namespace otter {
+namespace vec {
+
+// BFloat16 is only the storage, load Vectorized<float>::size() values widened to float and narrow them back on store
+// The narrowing rounds to nearest even and keeps NaN quiet as the scalar conversion does
+#if CPU_CAPABILITY_AVX2
+
+inline Vectorized<float> load_bfloat16(const BFloat16* ptr) {
+    const __m256i values = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr)));
+    return _mm256_castsi256_ps(_mm256_slli_epi32(values, 16));
+}
+
+inline void store_bfloat16(BFloat16* ptr, const Vectorized<float>& value) {
+#if defined(__AVX512BF16__) && defined(__AVX512VL__)
+    const __m128bh packed = _mm256_cvtneps_pbh(value);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(ptr), reinterpret_cast<const __m128i&>(packed));
+#else
+    const __m256i w = _mm256_castps_si256(value);
+    const __m256i lsb = _mm256_and_si256(_mm256_srli_epi32(w, 16), _mm256_set1_epi32(1));
+    __m256i rounded = _mm256_srli_epi32(_mm256_add_epi32(_mm256_add_epi32(w, _mm256_set1_epi32(0x7FFF)), lsb), 16);
+    // Compare the bits, the float compare is folded away by -ffast-math
+    const __m256i nan = _mm256_cmpgt_epi32(_mm256_and_si256(w, _mm256_set1_epi32(0x7FFFFFFF)), _mm256_set1_epi32(0x7F800000));
+    rounded = _mm256_blendv_epi8(rounded, _mm256_or_si256(_mm256_srli_epi32(w, 16), _mm256_set1_epi32(0x0040)), nan);
+    const __m128i packed = _mm_packus_epi32(_mm256_castsi256_si128(rounded), _mm256_extracti128_si256(rounded, 1));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(ptr), packed);
+#endif
+}
+
+#elif defined(__aarch64__)
+
+inline Vectorized<float> load_bfloat16(const BFloat16* ptr) {
+    const uint16_t* src = reinterpret_cast<const uint16_t*>(ptr);
+    return Vectorized<float>(vreinterpretq_f32_u32(vshll_n_u16(vld1_u16(src), 16)), vreinterpretq_f32_u32(vshll_n_u16(vld1_u16(src + 4), 16)));
+}
+
+inline void store_bfloat16(BFloat16* ptr, const Vectorized<float>& value) {
+    float32x4x2_t values = value;
+    uint16_t* dst = reinterpret_cast<uint16_t*>(ptr);
+    for (const auto i : otter::irange(2)) {
+        const uint32x4_t w = vreinterpretq_u32_f32(values.val[i]);
+        const uint32x4_t lsb = vandq_u32(vshrq_n_u32(w, 16), vdupq_n_u32(1));
+        uint32x4_t rounded = vshrq_n_u32(vaddq_u32(vaddq_u32(w, vdupq_n_u32(0x7FFF)), lsb), 16);
+        const uint32x4_t nan = vcgtq_u32(vandq_u32(w, vdupq_n_u32(0x7FFFFFFF)), vdupq_n_u32(0x7F800000));
+        rounded = vbslq_u32(nan, vorrq_u32(vshrq_n_u32(w, 16), vdupq_n_u32(0x0040)), rounded);
+        vst1_u16(dst + i * 4, vmovn_u32(rounded));
+    }
+}
+
+#else
+
+inline Vectorized<float> load_bfloat16(const BFloat16* ptr) {
+    __otter_align__ float values[Vectorized<float>::size()];
+    for (const auto i : otter::irange(Vectorized<float>::size())) {
+        values[i] = static_cast<float>(ptr[i]);
+    }
+    return Vectorized<float>::loadu(values);
+}
+
+inline void store_bfloat16(BFloat16* ptr, const Vectorized<float>& value) {
+    __otter_align__ float values[Vectorized<float>::size()];
+    value.store(values);
+    for (const auto i : otter::irange(Vectorized<float>::size())) {
+        ptr[i] = values[i];
+    }
+}
+
+#endif
+
+}   // end namespace vec
+}   // end namespace otter
+
+#endif /* Vec256_bfloat16_h */
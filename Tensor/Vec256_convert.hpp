@@ -0,0 +1,180 @@
+//
+//  Vec256_convert.hpp
+//  Tensor
+//
+//  Created by 陳均豪 on 2022/3/22.
+//
+
+#ifndef Vec256_convert_h
+#define Vec256_convert_h
+
+#include "VecIntrinsic.hpp"
+#include "VecBase.hpp"
+#include "Vec256_float.hpp"
+#include "Vec256_int.hpp"
+
+#include "Config.hpp"
+#include "Half.hpp"
+#include "BFloat16.hpp"
+
+namespace otter {
+namespace vec {
+
+// Load Vectorized<int32_t>::size() narrow integers widened to int32 or float lanes
+template <typename T>
+inline Vectorized<int32_t> convert_to_int32(const T* ptr) {
+    __otter_align__ int32_t buffer[Vectorized<int32_t>::size()];
+    for (const auto i : otter::irange(Vectorized<int32_t>::size())) {
+        buffer[i] = static_cast<int32_t>(ptr[i]);
+    }
+    return Vectorized<int32_t>::loadu(buffer);
+}
+
+template <typename T>
+inline Vectorized<float> convert_to_float(const T* ptr) {
+    __otter_align__ float buffer[Vectorized<float>::size()];
+    for (const auto i : otter::irange(Vectorized<float>::size())) {
+        buffer[i] = static_cast<float>(ptr[i]);
+    }
+    return Vectorized<float>::loadu(buffer);
+}
+
+// Contiguous dtype conversions used by the copy kernel, the rounding follows static_cast_with_inter_type
+// float -> integer truncates toward zero, float -> uint8 keeps the low byte of the int
+#if CPU_CAPABILITY_AVX2
+
+template <>
+inline void convert(const uint8_t* src, float* dst, int64_t n) {
+    int64_t i = 0;
+    for (; i <= n - 8; i += 8) {
+        __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i));
+        _mm256_storeu_ps(dst + i, _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(bytes)));
+    }
+    for (; i < n; ++i) {
+        dst[i] = static_cast<float>(src[i]);
+    }
+}
+
+template <>
+inline void convert(const float* src, uint8_t* dst, int64_t n) {
+    const __m256i low_byte = _mm256_set1_epi32(0xFF);
+    int64_t i = 0;
+    for (; i <= n - 16; i += 16) {
+        __m256i a = _mm256_and_si256(_mm256_cvttps_epi32(_mm256_loadu_ps(src + i)), low_byte);
+        __m256i b = _mm256_and_si256(_mm256_cvttps_epi32(_mm256_loadu_ps(src + i + 8)), low_byte);
+        // The values are in [0, 255], the packs do not saturate, only the lanes need to be put back in order
+        __m256i words = _mm256_permute4x64_epi64(_mm256_packus_epi32(a, b), 0xD8);
+        __m128i bytes = _mm_packus_epi16(_mm256_castsi256_si128(words), _mm256_extracti128_si256(words, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), bytes);
+    }
+    for (; i < n; ++i) {
+        dst[i] = static_cast_with_inter_type<uint8_t, float>::apply(src[i]);
+    }
+}
+
+template <>
+inline void convert(const int* src, float* dst, int64_t n) {
+    int64_t i = 0;
+    for (; i <= n - 8; i += 8) {
+        _mm256_storeu_ps(dst + i, _mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i))));
+    }
+    for (; i < n; ++i) {
+        dst[i] = static_cast<float>(src[i]);
+    }
+}
+
+template <>
+inline void convert(const float* src, int* dst, int64_t n) {
+    int64_t i = 0;
+    for (; i <= n - 8; i += 8) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_cvttps_epi32(_mm256_loadu_ps(src + i)));
+    }
+    for (; i < n; ++i) {
+        dst[i] = static_cast<int>(src[i]);
+    }
+}
+
+template <>
+inline void convert(const float* src, double* dst, int64_t n) {
+    int64_t i = 0;
+    for (; i <= n - 4; i += 4) {
+        _mm256_storeu_pd(dst + i, _mm256_cvtps_pd(_mm_loadu_ps(src + i)));
+    }
+    for (; i < n; ++i) {
+        dst[i] = static_cast<double>(src[i]);
+    }
+}
+
+template <>
+inline void convert(const double* src, float* dst, int64_t n) {
+    int64_t i = 0;
+    for (; i <= n - 4; i += 4) {
+        _mm_storeu_ps(dst + i, _mm256_cvtpd_ps(_mm256_loadu_pd(src + i)));
+    }
+    for (; i < n; ++i) {
+        dst[i] = static_cast<float>(src[i]);
+    }
+}
+
+template <>
+inline Vectorized<int32_t> convert_to_int32<uint8_t>(const uint8_t* ptr) {
+    return _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(ptr)));
+}
+
+template <>
+inline Vectorized<int32_t> convert_to_int32<int8_t>(const int8_t* ptr) {
+    return _mm256_cvtepi8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(ptr)));
+}
+
+template <>
+inline Vectorized<int32_t> convert_to_int32<int16_t>(const int16_t* ptr) {
+    return _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr)));
+}
+
+template <>
+inline Vectorized<float> convert_to_float<uint8_t>(const uint8_t* ptr) {
+    return _mm256_cvtepi32_ps(convert_to_int32<uint8_t>(ptr));
+}
+
+template <>
+inline Vectorized<float> convert_to_float<int8_t>(const int8_t* ptr) {
+    return _mm256_cvtepi32_ps(convert_to_int32<int8_t>(ptr));
+}
+
+template <>
+inline Vectorized<float> convert_to_float<int16_t>(const int16_t* ptr) {
+    return _mm256_cvtepi32_ps(convert_to_int32<int16_t>(ptr));
+}
+
+template <>
+inline Vectorized<float> convert_to_float<int32_t>(const int32_t* ptr) {
+    return _mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr)));
+}
+
+#endif
+
+// The 16 bit floats go through the bulk conversions of Half.cpp and BFloat16.cpp on every platform
+template <>
+inline void convert(const float* src, Half* dst, int64_t n) {
+    otter::float_to_half(src, dst, n);
+}
+
+template <>
+inline void convert(const Half* src, float* dst, int64_t n) {
+    otter::half_to_float(src, dst, n);
+}
+
+template <>
+inline void convert(const float* src, BFloat16* dst, int64_t n) {
+    otter::float_to_bfloat16(src, dst, n);
+}
+
+template <>
+inline void convert(const BFloat16* src, float* dst, int64_t n) {
+    otter::bfloat16_to_float(src, dst, n);
+}
+
+}   // end namespace vec
+}   // end namespace otter
+
+#endif /* Vec256_convert_h */
@@ -0,0 +1,208 @@
+//
+//  Vec256_double.hpp
+//  Tensor
+//
+//  Created by 陳均豪 on 2022/3/22.
+//
+
+#ifndef Vec256_double_h
+#define Vec256_double_h
+
+#include "VecIntrinsic.hpp"
+#include "VecBase.hpp"
+
+#include "Config.hpp"
+#include "Utils.hpp"
+
+namespace otter {
+namespace vec {
+
+#if CPU_CAPABILITY_AVX2
+
+template <>
+class Vectorized<double> {
+private:
+    __m256d values;
+public:
+    using value_type = double;
+    using size_type = int;
+    static constexpr size_type size() {
+        return 4;
+    }
+    Vectorized() {}
+    Vectorized(__m256d v) : values(v) {}
+    Vectorized(double val) {
+        values = _mm256_set1_pd(val);
+    }
+    Vectorized(double val1, double val2, double val3, double val4) {
+        values = _mm256_setr_pd(val1, val2, val3, val4);
+    }
+    operator __m256d() const {
+        return values;
+    }
+
+    template <int64_t mask>
+    static Vectorized<double> blend(const Vectorized<double>& a, const Vectorized<double>& b) {
+        return _mm256_blend_pd(a.values, b.values, mask);
+    }
+    static Vectorized<double> blendv(const Vectorized<double>& a, const Vectorized<double>& b, const Vectorized<double>& mask) {
+        return _mm256_blendv_pd(a.values, b.values, mask.values);
+    }
+
+    static Vectorized<double> loadu(const void* ptr, int64_t count = size()) {
+        if (count == size())
+            return _mm256_loadu_pd(reinterpret_cast<const double*>(ptr));
+        __otter_align__ double tmp_values[size()];
+        for (const auto i : otter::irange(size())) {
+            tmp_values[i] = 0.0;
+        }
+        std::memcpy(tmp_values, reinterpret_cast<const double*>(ptr), count * sizeof(double));
+        return _mm256_load_pd(tmp_values);
+    }
+    void store(void* ptr, int64_t count = size()) const {
+        if (count == size()) {
+            _mm256_storeu_pd(reinterpret_cast<double*>(ptr), values);
+        } else if (count > 0) {
+            double tmp_values[size()];
+            _mm256_storeu_pd(reinterpret_cast<double*>(tmp_values), values);
+            std::memcpy(ptr, tmp_values, count * sizeof(double));
+        }
+    }
+    const double& operator[](int idx) const  = delete;
+    double& operator[](int idx) = delete;
+
+    Vectorized<double> map(double (*const f)(double)) const {
+        __otter_align__ double tmp[size()];
+        store(tmp);
+        for (const auto i : otter::irange(size())) {
+            tmp[i] = f(tmp[i]);
+        }
+        return loadu(tmp);
+    }
+
+    int zero_mask() const {
+        // The i-th bit will be set if the i-th element is zero
+        __m256d cmp = _mm256_cmp_pd(values, _mm256_set1_pd(0.0), _CMP_EQ_OQ);
+        return _mm256_movemask_pd(cmp);
+    }
+
+    Vectorized<double> isnan() const {
+        return _mm256_cmp_pd(values, _mm256_set1_pd(0.0), _CMP_UNORD_Q);
+    }
+
+    Vectorized<double> abs() const {
+        auto mask = _mm256_set1_pd(-0.0);
+        return _mm256_andnot_pd(mask, values);
+    }
+
+    Vectorized<double> neg() const {
+        return _mm256_xor_pd(_mm256_set1_pd(-0.0), values);
+    }
+
+    Vectorized<double> sqrt() const {
+        return _mm256_sqrt_pd(values);
+    }
+
+    Vectorized<double> reciprocal() const {
+        return _mm256_div_pd(_mm256_set1_pd(1.0), values);
+    }
+
+    Vectorized<double> rsqrt() const {
+        return _mm256_div_pd(_mm256_set1_pd(1.0), _mm256_sqrt_pd(values));
+    }
+
+    Vectorized<double> exp() const {
+        return map(std::exp);
+    }
+
+    Vectorized<double> log() const {
+        return map(std::log);
+    }
+
+    Vectorized<double> tanh() const {
+        return map(std::tanh);
+    }
+
+    Vectorized<double> operator==(const Vectorized<double>& other) const {
+        return _mm256_cmp_pd(values, other.values, _CMP_EQ_OQ);
+    }
+
+    Vectorized<double> operator!=(const Vectorized<double>& other) const {
+        return _mm256_cmp_pd(values, other.values, _CMP_NEQ_UQ);
+    }
+
+    Vectorized<double> operator<(const Vectorized<double>& other) const {
+        return _mm256_cmp_pd(values, other.values, _CMP_LT_OQ);
+    }
+
+    Vectorized<double> operator<=(const Vectorized<double>& other) const {
+        return _mm256_cmp_pd(values, other.values, _CMP_LE_OQ);
+    }
+
+    Vectorized<double> operator>(const Vectorized<double>& other) const {
+        return _mm256_cmp_pd(values, other.values, _CMP_GT_OQ);
+    }
+
+    Vectorized<double> operator>=(const Vectorized<double>& other) const {
+        return _mm256_cmp_pd(values, other.values, _CMP_GE_OQ);
+    }
+};
+
+template <>
+Vectorized<double> inline operator+(const Vectorized<double>& a, const Vectorized<double>& b) {
+    return _mm256_add_pd(a, b);
+}
+
+template <>
+Vectorized<double> inline operator-(const Vectorized<double>& a, const Vectorized<double>& b) {
+    return _mm256_sub_pd(a, b);
+}
+
+template <>
+Vectorized<double> inline operator*(const Vectorized<double>& a, const Vectorized<double>& b) {
+    return _mm256_mul_pd(a, b);
+}
+
+template <>
+Vectorized<double> inline operator/(const Vectorized<double>& a, const Vectorized<double>& b) {
+    return _mm256_div_pd(a, b);
+}
+
+template <>
+Vectorized<double> inline maximum(const Vectorized<double>& a, const Vectorized<double>& b) {
+    return _mm256_max_pd(a, b);
+}
+
+template <>
+Vectorized<double> inline minimum(const Vectorized<double>& a, const Vectorized<double>& b) {
+    return _mm256_min_pd(a, b);
+}
+
+#ifdef __FMA__
+template <>
+Vectorized<double> inline fmadd(const Vectorized<double>& a, const Vectorized<double>& b, const Vectorized<double>& c) {
+    return _mm256_fmadd_pd(a, b, c);
+}
+#endif
+
+template <>
+Vectorized<double> inline operator&(const Vectorized<double>& a, const Vectorized<double>& b) {
+    return _mm256_and_pd(a, b);
+}
+
+template <>
+Vectorized<double> inline operator|(const Vectorized<double>& a, const Vectorized<double>& b) {
+    return _mm256_or_pd(a, b);
+}
+
+template <>
+Vectorized<double> inline operator^(const Vectorized<double>& a, const Vectorized<double>& b) {
+    return _mm256_xor_pd(a, b);
+}
+
+#endif
+
+}   // end namespace vec
+}   // end namespace otter
+
+#endif /* Vec256_double_h */
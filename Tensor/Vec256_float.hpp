@@ -83,6 +83,12 @@ public:
         return loadu(tmp);
     }
     
+    int zero_mask() const {
+        // The i-th bit will be set if the i-th element is zero
+        __m256 cmp = _mm256_cmp_ps(values, _mm256_set1_ps(0.0f), _CMP_EQ_OQ);
+        return _mm256_movemask_ps(cmp);
+    }
+    
     Vectorized<float> isnan() const {
         return _mm256_cmp_ps(values, _mm256_set1_ps(0.0f), _CMP_UNORD_Q);
     }
@@ -96,6 +102,48 @@ public:
         return _mm256_xor_ps(_mm256_set1_ps(-0.f), values);
     }
     
+    Vectorized<float> sqrt() const {
+        return _mm256_sqrt_ps(values);
+    }
+    
+    Vectorized<float> reciprocal() const {
+        return _mm256_div_ps(_mm256_set1_ps(1.f), values);
+    }
+    
+    Vectorized<float> rsqrt() const {
+        return _mm256_div_ps(_mm256_set1_ps(1.f), _mm256_sqrt_ps(values));
+    }
+    
+    // Cephes polynomial, exp(x) = 2^n * exp(r) with |r| <= ln2 / 2
+    Vectorized<float> exp() const {
+        const __m256 one = _mm256_set1_ps(1.f);
+        __m256 x = _mm256_min_ps(values, _mm256_set1_ps(88.3762626647949f));
+        x = _mm256_max_ps(x, _mm256_set1_ps(-88.3762626647949f));
+        
+        __m256 n = _mm256_floor_ps(_mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(1.44269504088896341f)), _mm256_set1_ps(0.5f)));
+        x = _mm256_sub_ps(x, _mm256_mul_ps(n, _mm256_set1_ps(0.693359375f)));
+        x = _mm256_sub_ps(x, _mm256_mul_ps(n, _mm256_set1_ps(-2.12194440e-4f)));
+        
+        __m256 y = _mm256_set1_ps(1.9875691500E-4f);
+        y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(1.3981999507E-3f));
+        y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(8.3334519073E-3f));
+        y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(4.1665795894E-2f));
+        y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(1.6666665459E-1f));
+        y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(5.0000001201E-1f));
+        y = _mm256_add_ps(_mm256_mul_ps(y, _mm256_mul_ps(x, x)), _mm256_add_ps(x, one));
+        
+        __m256i exponent = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvttps_epi32(n), _mm256_set1_epi32(127)), 23);
+        return _mm256_mul_ps(y, _mm256_castsi256_ps(exponent));
+    }
+    
+    Vectorized<float> log() const {
+        return map(std::log);
+    }
+    
+    Vectorized<float> tanh() const {
+        return map(std::tanh);
+    }
+    
     Vectorized<float> operator==(const Vectorized<float>& other) const {
         return _mm256_cmp_ps(values, other.values, _CMP_EQ_OQ);
     }
@@ -141,6 +189,23 @@ Vectorized<float> inline operator/(const Vectorized<float>& a, const Vectorized<
     return _mm256_div_ps(a, b);
 }
 
+template <>
+Vectorized<float> inline maximum(const Vectorized<float>& a, const Vectorized<float>& b) {
+    return _mm256_max_ps(a, b);
+}
+
+template <>
+Vectorized<float> inline minimum(const Vectorized<float>& a, const Vectorized<float>& b) {
+    return _mm256_min_ps(a, b);
+}
+
+#ifdef __FMA__
+template <>
+Vectorized<float> inline fmadd(const Vectorized<float>& a, const Vectorized<float>& b, const Vectorized<float>& c) {
+    return _mm256_fmadd_ps(a, b, c);
+}
+#endif
+
 template <>
 Vectorized<float> inline operator&(const Vectorized<float>& a, const Vectorized<float>& b) {
   return _mm256_and_ps(a, b);
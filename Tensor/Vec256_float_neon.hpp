@@ -248,6 +248,18 @@ public:
         store(tmp);
         return tmp[idx];
     }
+    int zero_mask() const {
+        __otter_align__ float tmp[size()];
+        store(tmp);
+        int mask = 0;
+        for (const auto i : otter::irange(size())) {
+            if (tmp[i] == 0.f) {
+                mask |= (1 << i);
+            }
+        }
+        return mask;
+    }
+    
     Vectorized<float> isnan() const {
         __otter_align__ float tmp[size()];
         __otter_align__ float res[size()];
@@ -276,6 +288,25 @@ public:
     Vectorized<float> neg() const {
         return Vectorized<float>(vnegq_f32(values.val[0]), vnegq_f32(values.val[1]));
     }
+    Vectorized<float> sqrt() const {
+        return Vectorized<float>(vsqrtq_f32(values.val[0]), vsqrtq_f32(values.val[1]));
+    }
+    Vectorized<float> reciprocal() const {
+        float32x4_t one = vdupq_n_f32(1.f);
+        return Vectorized<float>(vdivq_f32(one, values.val[0]), vdivq_f32(one, values.val[1]));
+    }
+    Vectorized<float> rsqrt() const {
+        return sqrt().reciprocal();
+    }
+    Vectorized<float> exp() const {
+        return map(std::exp);
+    }
+    Vectorized<float> log() const {
+        return map(std::log);
+    }
+    Vectorized<float> tanh() const {
+        return map(std::tanh);
+    }
     Vectorized<float> operator==(const Vectorized<float>& other) const {
         float32x4_t r0 =
         vreinterpretq_f32_u32(vceqq_f32(values.val[0], other.values.val[0]));
@@ -354,6 +385,20 @@ Vectorized<float> inline operator/(const Vectorized<float>& a, const Vectorized<
     return Vectorized<float>(r0, r1);
 }
 
+template <>
+Vectorized<float> inline maximum(const Vectorized<float>& a, const Vectorized<float>& b) {
+    float32x4_t r0 = vmaxq_f32(a.get_low(), b.get_low());
+    float32x4_t r1 = vmaxq_f32(a.get_high(), b.get_high());
+    return Vectorized<float>(r0, r1);
+}
+
+template <>
+Vectorized<float> inline minimum(const Vectorized<float>& a, const Vectorized<float>& b) {
+    float32x4_t r0 = vminq_f32(a.get_low(), b.get_low());
+    float32x4_t r1 = vminq_f32(a.get_high(), b.get_high());
+    return Vectorized<float>(r0, r1);
+}
+
 template <>
 Vectorized<float> inline operator&(const Vectorized<float>& a, const Vectorized<float>& b) {
     float32x4_t r0 = vreinterpretq_f32_u32(vandq_u32(
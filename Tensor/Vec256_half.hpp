@@ -0,0 +1,68 @@
+//
+//  Vec256_half.hpp
+//  Tensor
+//
+//  Created by 陳均豪 on 2022/3/22.
+//
+
+#ifndef Vec256_half_h
+#define Vec256_half_h
+
+#include "VecIntrinsic.hpp"
+#include "VecBase.hpp"
+#include "Vec256_float.hpp"
+#include "Vec256_float_neon.hpp"
+
+#include "Config.hpp"
+#include "Half.hpp"
+
+namespace otter {
+namespace vec {
+
+// Half is only the storage, load Vectorized<float>::size() halfs widened to float and narrow them back on store
+#if CPU_CAPABILITY_AVX2 && defined(__F16C__)
+
+inline Vectorized<float> load_half(const Half* ptr) {
+    return _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr)));
+}
+
+inline void store_half(Half* ptr, const Vectorized<float>& value) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(ptr), _mm256_cvtps_ph(value, _MM_FROUND_TO_NEAREST_INT));
+}
+
+#elif defined(__aarch64__)
+
+inline Vectorized<float> load_half(const Half* ptr) {
+    return Vectorized<float>(vcvt_f32_f16(vld1_f16(reinterpret_cast<const __fp16*>(ptr))), vcvt_f32_f16(vld1_f16(reinterpret_cast<const __fp16*>(ptr) + 4)));
+}
+
+inline void store_half(Half* ptr, const Vectorized<float>& value) {
+    float32x4x2_t values = value;
+    vst1_f16(reinterpret_cast<__fp16*>(ptr), vcvt_f16_f32(values.val[0]));
+    vst1_f16(reinterpret_cast<__fp16*>(ptr) + 4, vcvt_f16_f32(values.val[1]));
+}
+
+#else
+
+inline Vectorized<float> load_half(const Half* ptr) {
+    __otter_align__ float values[Vectorized<float>::size()];
+    for (const auto i : otter::irange(Vectorized<float>::size())) {
+        values[i] = static_cast<float>(ptr[i]);
+    }
+    return Vectorized<float>::loadu(values);
+}
+
+inline void store_half(Half* ptr, const Vectorized<float>& value) {
+    __otter_align__ float values[Vectorized<float>::size()];
+    value.store(values);
+    for (const auto i : otter::irange(Vectorized<float>::size())) {
+        ptr[i] = values[i];
+    }
+}
+
+#endif
+
+}   // end namespace vec
+}   // end namespace otter
+
+#endif /* Vec256_half_h */
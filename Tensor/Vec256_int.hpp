@@ -0,0 +1,723 @@
+//
+//  Vec256_int.hpp
+//  Tensor
+//
+//  Created by 陳均豪 on 2022/3/22.
+//
+
+#ifndef Vec256_int_h
+#define Vec256_int_h
+
+#include "VecIntrinsic.hpp"
+#include "VecBase.hpp"
+#include "Vec256_float.hpp"
+#include "Vec256_double.hpp"
+
+#include "Config.hpp"
+#include "Utils.hpp"
+
+namespace otter {
+namespace vec {
+
+#if CPU_CAPABILITY_AVX2
+
+// From PyTorch https://github.com/pytorch/pytorch/blob/master/aten/src/ATen/cpu/vec/vec256/vec256_int.h
+// Shared storage of the integer vectors, the bitwise operators below are defined once for all of them
+struct Vectorizedi {
+protected:
+    __m256i values;
+
+    static inline __m256i invert(const __m256i& v) {
+        const auto ones = _mm256_set1_epi64x(-1);
+        return _mm256_xor_si256(ones, v);
+    }
+public:
+    Vectorizedi() {}
+    Vectorizedi(__m256i v) : values(v) {}
+    operator __m256i() const {
+        return values;
+    }
+};
+
+template <typename T>
+static inline Vectorized<T> int_loadu(const void* ptr, int64_t count) {
+    if (count == Vectorized<T>::size())
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr));
+    __otter_align__ T tmp_values[Vectorized<T>::size()];
+    // Ensure uninitialized memory does not change the output value
+    for (const auto i : otter::irange(Vectorized<T>::size())) {
+        tmp_values[i] = 0;
+    }
+    std::memcpy(tmp_values, ptr, count * sizeof(T));
+    return _mm256_load_si256(reinterpret_cast<const __m256i*>(tmp_values));
+}
+
+template <typename T>
+static inline void int_store(const __m256i& values, void* ptr, int64_t count) {
+    if (count == Vectorized<T>::size()) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(ptr), values);
+    } else if (count > 0) {
+        __otter_align__ T tmp_values[Vectorized<T>::size()];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(tmp_values), values);
+        std::memcpy(ptr, tmp_values, count * sizeof(T));
+    }
+}
+
+template <typename T>
+static inline Vectorized<T> int_blend(const Vectorized<T>& a, const Vectorized<T>& b, int64_t mask) {
+    __otter_align__ T tmp_values[Vectorized<T>::size()];
+    for (const auto i : otter::irange(Vectorized<T>::size())) {
+        tmp_values[i] = (mask & (int64_t(1) << i)) ? T(-1) : T(0);
+    }
+    return _mm256_blendv_epi8(a, b, _mm256_load_si256(reinterpret_cast<const __m256i*>(tmp_values)));
+}
+
+template <>
+class Vectorized<int64_t> : public Vectorizedi {
+public:
+    using value_type = int64_t;
+    using size_type = int;
+    static constexpr size_type size() {
+        return 4;
+    }
+    using Vectorizedi::Vectorizedi;
+    Vectorized() {}
+    Vectorized(int64_t v) {
+        values = _mm256_set1_epi64x(v);
+    }
+    Vectorized(int64_t val1, int64_t val2, int64_t val3, int64_t val4) {
+        values = _mm256_setr_epi64x(val1, val2, val3, val4);
+    }
+
+    template <int64_t mask>
+    static Vectorized<int64_t> blend(const Vectorized<int64_t>& a, const Vectorized<int64_t>& b) {
+        return int_blend(a, b, mask);
+    }
+    static Vectorized<int64_t> blendv(const Vectorized<int64_t>& a, const Vectorized<int64_t>& b, const Vectorized<int64_t>& mask) {
+        return _mm256_blendv_epi8(a.values, b.values, mask.values);
+    }
+
+    static Vectorized<int64_t> loadu(const void* ptr, int64_t count = size()) {
+        return int_loadu<int64_t>(ptr, count);
+    }
+    void store(void* ptr, int64_t count = size()) const {
+        int_store<int64_t>(values, ptr, count);
+    }
+    const int64_t& operator[](int idx) const  = delete;
+    int64_t& operator[](int idx) = delete;
+
+    int zero_mask() const {
+        // The i-th bit will be set if the i-th element is zero
+        __m256i cmp = _mm256_cmpeq_epi64(values, _mm256_setzero_si256());
+        return _mm256_movemask_pd(_mm256_castsi256_pd(cmp));
+    }
+
+    Vectorized<int64_t> abs() const {
+        auto is_negative = _mm256_cmpgt_epi64(_mm256_setzero_si256(), values);
+        auto inverse = _mm256_xor_si256(values, is_negative);
+        return _mm256_sub_epi64(inverse, is_negative);
+    }
+
+    Vectorized<int64_t> neg() const {
+        return _mm256_sub_epi64(_mm256_setzero_si256(), values);
+    }
+
+    Vectorized<int64_t> operator==(const Vectorized<int64_t>& other) const {
+        return _mm256_cmpeq_epi64(values, other.values);
+    }
+
+    Vectorized<int64_t> operator!=(const Vectorized<int64_t>& other) const {
+        return invert(_mm256_cmpeq_epi64(values, other.values));
+    }
+
+    Vectorized<int64_t> operator<(const Vectorized<int64_t>& other) const {
+        return _mm256_cmpgt_epi64(other.values, values);
+    }
+
+    Vectorized<int64_t> operator<=(const Vectorized<int64_t>& other) const {
+        return invert(_mm256_cmpgt_epi64(values, other.values));
+    }
+
+    Vectorized<int64_t> operator>(const Vectorized<int64_t>& other) const {
+        return _mm256_cmpgt_epi64(values, other.values);
+    }
+
+    Vectorized<int64_t> operator>=(const Vectorized<int64_t>& other) const {
+        return invert(_mm256_cmpgt_epi64(other.values, values));
+    }
+};
+
+template <>
+class Vectorized<int32_t> : public Vectorizedi {
+public:
+    using value_type = int32_t;
+    using size_type = int;
+    static constexpr size_type size() {
+        return 8;
+    }
+    using Vectorizedi::Vectorizedi;
+    Vectorized() {}
+    Vectorized(int32_t v) {
+        values = _mm256_set1_epi32(v);
+    }
+    Vectorized(int32_t val1, int32_t val2, int32_t val3, int32_t val4, int32_t val5, int32_t val6, int32_t val7, int32_t val8) {
+        values = _mm256_setr_epi32(val1, val2, val3, val4, val5, val6, val7, val8);
+    }
+
+    template <int64_t mask>
+    static Vectorized<int32_t> blend(const Vectorized<int32_t>& a, const Vectorized<int32_t>& b) {
+        return _mm256_blend_epi32(a, b, mask);
+    }
+    static Vectorized<int32_t> blendv(const Vectorized<int32_t>& a, const Vectorized<int32_t>& b, const Vectorized<int32_t>& mask) {
+        return _mm256_blendv_epi8(a.values, b.values, mask.values);
+    }
+
+    static Vectorized<int32_t> loadu(const void* ptr, int64_t count = size()) {
+        return int_loadu<int32_t>(ptr, count);
+    }
+    void store(void* ptr, int64_t count = size()) const {
+        int_store<int32_t>(values, ptr, count);
+    }
+    const int32_t& operator[](int idx) const  = delete;
+    int32_t& operator[](int idx) = delete;
+
+    int zero_mask() const {
+        // The i-th bit will be set if the i-th element is zero
+        __m256i cmp = _mm256_cmpeq_epi32(values, _mm256_setzero_si256());
+        return _mm256_movemask_ps(_mm256_castsi256_ps(cmp));
+    }
+
+    Vectorized<int32_t> abs() const {
+        return _mm256_abs_epi32(values);
+    }
+
+    Vectorized<int32_t> neg() const {
+        return _mm256_sub_epi32(_mm256_setzero_si256(), values);
+    }
+
+    Vectorized<int32_t> operator==(const Vectorized<int32_t>& other) const {
+        return _mm256_cmpeq_epi32(values, other.values);
+    }
+
+    Vectorized<int32_t> operator!=(const Vectorized<int32_t>& other) const {
+        return invert(_mm256_cmpeq_epi32(values, other.values));
+    }
+
+    Vectorized<int32_t> operator<(const Vectorized<int32_t>& other) const {
+        return _mm256_cmpgt_epi32(other.values, values);
+    }
+
+    Vectorized<int32_t> operator<=(const Vectorized<int32_t>& other) const {
+        return invert(_mm256_cmpgt_epi32(values, other.values));
+    }
+
+    Vectorized<int32_t> operator>(const Vectorized<int32_t>& other) const {
+        return _mm256_cmpgt_epi32(values, other.values);
+    }
+
+    Vectorized<int32_t> operator>=(const Vectorized<int32_t>& other) const {
+        return invert(_mm256_cmpgt_epi32(other.values, values));
+    }
+};
+
+template <>
+class Vectorized<int16_t> : public Vectorizedi {
+public:
+    using value_type = int16_t;
+    using size_type = int;
+    static constexpr size_type size() {
+        return 16;
+    }
+    using Vectorizedi::Vectorizedi;
+    Vectorized() {}
+    Vectorized(int16_t v) {
+        values = _mm256_set1_epi16(v);
+    }
+    Vectorized(int16_t val1, int16_t val2, int16_t val3, int16_t val4,
+               int16_t val5, int16_t val6, int16_t val7, int16_t val8,
+               int16_t val9, int16_t val10, int16_t val11, int16_t val12,
+               int16_t val13, int16_t val14, int16_t val15, int16_t val16) {
+        values = _mm256_setr_epi16(val1, val2, val3, val4, val5, val6, val7, val8,
+                                   val9, val10, val11, val12, val13, val14, val15, val16);
+    }
+
+    template <int64_t mask>
+    static Vectorized<int16_t> blend(const Vectorized<int16_t>& a, const Vectorized<int16_t>& b) {
+        return int_blend(a, b, mask);
+    }
+    static Vectorized<int16_t> blendv(const Vectorized<int16_t>& a, const Vectorized<int16_t>& b, const Vectorized<int16_t>& mask) {
+        return _mm256_blendv_epi8(a.values, b.values, mask.values);
+    }
+
+    static Vectorized<int16_t> loadu(const void* ptr, int64_t count = size()) {
+        return int_loadu<int16_t>(ptr, count);
+    }
+    void store(void* ptr, int64_t count = size()) const {
+        int_store<int16_t>(values, ptr, count);
+    }
+    const int16_t& operator[](int idx) const  = delete;
+    int16_t& operator[](int idx) = delete;
+
+    int zero_mask() const {
+        // The i-th bit will be set if the i-th element is zero, take one bit of each byte pair
+        __m256i cmp = _mm256_cmpeq_epi16(values, _mm256_setzero_si256());
+        uint32_t byte_mask = _mm256_movemask_epi8(cmp);
+        int mask = 0;
+        for (const auto i : otter::irange(size())) {
+            mask |= ((byte_mask >> (2 * i)) & 1) << i;
+        }
+        return mask;
+    }
+
+    Vectorized<int16_t> abs() const {
+        return _mm256_abs_epi16(values);
+    }
+
+    Vectorized<int16_t> neg() const {
+        return _mm256_sub_epi16(_mm256_setzero_si256(), values);
+    }
+
+    Vectorized<int16_t> operator==(const Vectorized<int16_t>& other) const {
+        return _mm256_cmpeq_epi16(values, other.values);
+    }
+
+    Vectorized<int16_t> operator!=(const Vectorized<int16_t>& other) const {
+        return invert(_mm256_cmpeq_epi16(values, other.values));
+    }
+
+    Vectorized<int16_t> operator<(const Vectorized<int16_t>& other) const {
+        return _mm256_cmpgt_epi16(other.values, values);
+    }
+
+    Vectorized<int16_t> operator<=(const Vectorized<int16_t>& other) const {
+        return invert(_mm256_cmpgt_epi16(values, other.values));
+    }
+
+    Vectorized<int16_t> operator>(const Vectorized<int16_t>& other) const {
+        return _mm256_cmpgt_epi16(values, other.values);
+    }
+
+    Vectorized<int16_t> operator>=(const Vectorized<int16_t>& other) const {
+        return invert(_mm256_cmpgt_epi16(other.values, values));
+    }
+};
+
+// int8_t and uint8_t share everything but the sign of the compares, abs and min / max
+template <typename T>
+class Vectorized8 : public Vectorizedi {
+    static_assert(std::is_same<T, int8_t>::value || std::is_same<T, uint8_t>::value, "Only int8_t/uint8_t are supported");
+public:
+    using value_type = T;
+    using size_type = int;
+    static constexpr size_type size() {
+        return 32;
+    }
+    using Vectorizedi::Vectorizedi;
+    Vectorized8() {}
+    Vectorized8(T v) {
+        values = _mm256_set1_epi8(v);
+    }
+
+    static Vectorized<T> loadu(const void* ptr, int64_t count = size()) {
+        return int_loadu<T>(ptr, count);
+    }
+    void store(void* ptr, int64_t count = size()) const {
+        int_store<T>(values, ptr, count);
+    }
+    const T& operator[](int idx) const  = delete;
+    T& operator[](int idx) = delete;
+
+    int zero_mask() const {
+        // The i-th bit will be set if the i-th element is zero
+        __m256i cmp = _mm256_cmpeq_epi8(values, _mm256_setzero_si256());
+        return _mm256_movemask_epi8(cmp);
+    }
+
+    Vectorized<T> neg() const {
+        return _mm256_sub_epi8(_mm256_setzero_si256(), values);
+    }
+
+    Vectorized<T> operator==(const Vectorized<T>& other) const {
+        return _mm256_cmpeq_epi8(values, other);
+    }
+
+    Vectorized<T> operator!=(const Vectorized<T>& other) const {
+        return invert(_mm256_cmpeq_epi8(values, other));
+    }
+};
+
+template <>
+class Vectorized<int8_t> : public Vectorized8<int8_t> {
+public:
+    using Vectorized8::Vectorized8;
+
+    template <int64_t mask>
+    static Vectorized<int8_t> blend(const Vectorized<int8_t>& a, const Vectorized<int8_t>& b) {
+        return int_blend(a, b, mask);
+    }
+    static Vectorized<int8_t> blendv(const Vectorized<int8_t>& a, const Vectorized<int8_t>& b, const Vectorized<int8_t>& mask) {
+        return _mm256_blendv_epi8(a, b, mask);
+    }
+
+    Vectorized<int8_t> abs() const {
+        return _mm256_abs_epi8(values);
+    }
+
+    Vectorized<int8_t> operator<(const Vectorized<int8_t>& other) const {
+        return _mm256_cmpgt_epi8(other, values);
+    }
+
+    Vectorized<int8_t> operator<=(const Vectorized<int8_t>& other) const {
+        return invert(_mm256_cmpgt_epi8(values, other));
+    }
+
+    Vectorized<int8_t> operator>(const Vectorized<int8_t>& other) const {
+        return _mm256_cmpgt_epi8(values, other);
+    }
+
+    Vectorized<int8_t> operator>=(const Vectorized<int8_t>& other) const {
+        return invert(_mm256_cmpgt_epi8(other, values));
+    }
+};
+
+template <>
+class Vectorized<uint8_t> : public Vectorized8<uint8_t> {
+public:
+    using Vectorized8::Vectorized8;
+
+    template <int64_t mask>
+    static Vectorized<uint8_t> blend(const Vectorized<uint8_t>& a, const Vectorized<uint8_t>& b) {
+        return int_blend(a, b, mask);
+    }
+    static Vectorized<uint8_t> blendv(const Vectorized<uint8_t>& a, const Vectorized<uint8_t>& b, const Vectorized<uint8_t>& mask) {
+        return _mm256_blendv_epi8(a, b, mask);
+    }
+
+    Vectorized<uint8_t> abs() const {
+        return values;
+    }
+
+    // There is no unsigned byte compare, a >= b is max(a, b) == a
+    Vectorized<uint8_t> operator<(const Vectorized<uint8_t>& other) const {
+        return invert(_mm256_cmpeq_epi8(_mm256_max_epu8(values, other), values));
+    }
+
+    Vectorized<uint8_t> operator<=(const Vectorized<uint8_t>& other) const {
+        return _mm256_cmpeq_epi8(_mm256_min_epu8(values, other), values);
+    }
+
+    Vectorized<uint8_t> operator>(const Vectorized<uint8_t>& other) const {
+        return invert(_mm256_cmpeq_epi8(_mm256_min_epu8(values, other), values));
+    }
+
+    Vectorized<uint8_t> operator>=(const Vectorized<uint8_t>& other) const {
+        return _mm256_cmpeq_epi8(_mm256_max_epu8(values, other), values);
+    }
+};
+
+template <>
+Vectorized<int64_t> inline operator+(const Vectorized<int64_t>& a, const Vectorized<int64_t>& b) {
+    return _mm256_add_epi64(a, b);
+}
+
+template <>
+Vectorized<int32_t> inline operator+(const Vectorized<int32_t>& a, const Vectorized<int32_t>& b) {
+    return _mm256_add_epi32(a, b);
+}
+
+template <>
+Vectorized<int16_t> inline operator+(const Vectorized<int16_t>& a, const Vectorized<int16_t>& b) {
+    return _mm256_add_epi16(a, b);
+}
+
+template <>
+Vectorized<int8_t> inline operator+(const Vectorized<int8_t>& a, const Vectorized<int8_t>& b) {
+    return _mm256_add_epi8(a, b);
+}
+
+template <>
+Vectorized<uint8_t> inline operator+(const Vectorized<uint8_t>& a, const Vectorized<uint8_t>& b) {
+    return _mm256_add_epi8(a, b);
+}
+
+template <>
+Vectorized<int64_t> inline operator-(const Vectorized<int64_t>& a, const Vectorized<int64_t>& b) {
+    return _mm256_sub_epi64(a, b);
+}
+
+template <>
+Vectorized<int32_t> inline operator-(const Vectorized<int32_t>& a, const Vectorized<int32_t>& b) {
+    return _mm256_sub_epi32(a, b);
+}
+
+template <>
+Vectorized<int16_t> inline operator-(const Vectorized<int16_t>& a, const Vectorized<int16_t>& b) {
+    return _mm256_sub_epi16(a, b);
+}
+
+template <>
+Vectorized<int8_t> inline operator-(const Vectorized<int8_t>& a, const Vectorized<int8_t>& b) {
+    return _mm256_sub_epi8(a, b);
+}
+
+template <>
+Vectorized<uint8_t> inline operator-(const Vectorized<uint8_t>& a, const Vectorized<uint8_t>& b) {
+    return _mm256_sub_epi8(a, b);
+}
+
+// AVX2 has no 64 bit multiply, do it lane by lane
+template <>
+Vectorized<int64_t> inline operator*(const Vectorized<int64_t>& a, const Vectorized<int64_t>& b) {
+    int64_t a0 = _mm256_extract_epi64(a, 0);
+    int64_t a1 = _mm256_extract_epi64(a, 1);
+    int64_t a2 = _mm256_extract_epi64(a, 2);
+    int64_t a3 = _mm256_extract_epi64(a, 3);
+
+    int64_t b0 = _mm256_extract_epi64(b, 0);
+    int64_t b1 = _mm256_extract_epi64(b, 1);
+    int64_t b2 = _mm256_extract_epi64(b, 2);
+    int64_t b3 = _mm256_extract_epi64(b, 3);
+
+    return _mm256_set_epi64x(a3 * b3, a2 * b2, a1 * b1, a0 * b0);
+}
+
+template <>
+Vectorized<int32_t> inline operator*(const Vectorized<int32_t>& a, const Vectorized<int32_t>& b) {
+    return _mm256_mullo_epi32(a, b);
+}
+
+template <>
+Vectorized<int16_t> inline operator*(const Vectorized<int16_t>& a, const Vectorized<int16_t>& b) {
+    return _mm256_mullo_epi16(a, b);
+}
+
+// The low byte of a 16 bit product only depends on the low bytes, multiply the even and odd bytes as int16 and merge
+static inline __m256i mul_epi8(const __m256i& a, const __m256i& b) {
+    const __m256i low_byte = _mm256_set1_epi16(0x00FF);
+    __m256i even = _mm256_and_si256(_mm256_mullo_epi16(a, b), low_byte);
+    __m256i odd = _mm256_slli_epi16(_mm256_mullo_epi16(_mm256_srli_epi16(a, 8), _mm256_srli_epi16(b, 8)), 8);
+    return _mm256_or_si256(even, odd);
+}
+
+template <>
+Vectorized<int8_t> inline operator*(const Vectorized<int8_t>& a, const Vectorized<int8_t>& b) {
+    return mul_epi8(a, b);
+}
+
+template <>
+Vectorized<uint8_t> inline operator*(const Vectorized<uint8_t>& a, const Vectorized<uint8_t>& b) {
+    return mul_epi8(a, b);
+}
+
+// There is no integer division in AVX2
+template <typename T, typename Op>
+static inline Vectorized<T> int_elementwise_binary_256(const Vectorized<T>& a, const Vectorized<T>& b, Op op) {
+    __otter_align__ T values_a[Vectorized<T>::size()];
+    __otter_align__ T values_b[Vectorized<T>::size()];
+    a.store(values_a);
+    b.store(values_b);
+    for (const auto i : otter::irange(Vectorized<T>::size())) {
+        values_a[i] = op(values_a[i], values_b[i]);
+    }
+    return Vectorized<T>::loadu(values_a);
+}
+
+template <>
+Vectorized<int64_t> inline operator/(const Vectorized<int64_t>& a, const Vectorized<int64_t>& b) {
+    return int_elementwise_binary_256(a, b, std::divides<int64_t>());
+}
+
+template <>
+Vectorized<int32_t> inline operator/(const Vectorized<int32_t>& a, const Vectorized<int32_t>& b) {
+    return int_elementwise_binary_256(a, b, std::divides<int32_t>());
+}
+
+template <>
+Vectorized<int16_t> inline operator/(const Vectorized<int16_t>& a, const Vectorized<int16_t>& b) {
+    return int_elementwise_binary_256(a, b, std::divides<int16_t>());
+}
+
+template <>
+Vectorized<int8_t> inline operator/(const Vectorized<int8_t>& a, const Vectorized<int8_t>& b) {
+    return int_elementwise_binary_256(a, b, std::divides<int8_t>());
+}
+
+template <>
+Vectorized<uint8_t> inline operator/(const Vectorized<uint8_t>& a, const Vectorized<uint8_t>& b) {
+    return int_elementwise_binary_256(a, b, std::divides<uint8_t>());
+}
+
+template <>
+Vectorized<int64_t> inline maximum(const Vectorized<int64_t>& a, const Vectorized<int64_t>& b) {
+    return _mm256_blendv_epi8(b, a, _mm256_cmpgt_epi64(a, b));
+}
+
+template <>
+Vectorized<int32_t> inline maximum(const Vectorized<int32_t>& a, const Vectorized<int32_t>& b) {
+    return _mm256_max_epi32(a, b);
+}
+
+template <>
+Vectorized<int16_t> inline maximum(const Vectorized<int16_t>& a, const Vectorized<int16_t>& b) {
+    return _mm256_max_epi16(a, b);
+}
+
+template <>
+Vectorized<int8_t> inline maximum(const Vectorized<int8_t>& a, const Vectorized<int8_t>& b) {
+    return _mm256_max_epi8(a, b);
+}
+
+template <>
+Vectorized<uint8_t> inline maximum(const Vectorized<uint8_t>& a, const Vectorized<uint8_t>& b) {
+    return _mm256_max_epu8(a, b);
+}
+
+template <>
+Vectorized<int64_t> inline minimum(const Vectorized<int64_t>& a, const Vectorized<int64_t>& b) {
+    return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(a, b));
+}
+
+template <>
+Vectorized<int32_t> inline minimum(const Vectorized<int32_t>& a, const Vectorized<int32_t>& b) {
+    return _mm256_min_epi32(a, b);
+}
+
+template <>
+Vectorized<int16_t> inline minimum(const Vectorized<int16_t>& a, const Vectorized<int16_t>& b) {
+    return _mm256_min_epi16(a, b);
+}
+
+template <>
+Vectorized<int8_t> inline minimum(const Vectorized<int8_t>& a, const Vectorized<int8_t>& b) {
+    return _mm256_min_epi8(a, b);
+}
+
+template <>
+Vectorized<uint8_t> inline minimum(const Vectorized<uint8_t>& a, const Vectorized<uint8_t>& b) {
+    return _mm256_min_epu8(a, b);
+}
+
+template <>
+Vectorized<int8_t> inline saturating_add(const Vectorized<int8_t>& a, const Vectorized<int8_t>& b) {
+    return _mm256_adds_epi8(a, b);
+}
+
+template <>
+Vectorized<uint8_t> inline saturating_add(const Vectorized<uint8_t>& a, const Vectorized<uint8_t>& b) {
+    return _mm256_adds_epu8(a, b);
+}
+
+template <>
+Vectorized<int16_t> inline saturating_add(const Vectorized<int16_t>& a, const Vectorized<int16_t>& b) {
+    return _mm256_adds_epi16(a, b);
+}
+
+// No saturating instruction for int32, the lanes which overflowed get the limit of the sign of a
+template <>
+Vectorized<int32_t> inline saturating_add(const Vectorized<int32_t>& a, const Vectorized<int32_t>& b) {
+    __m256i sum = _mm256_add_epi32(a, b);
+    // The sign bit is set when a and b have the same sign but the sum does not
+    __m256i overflow = _mm256_andnot_si256(_mm256_xor_si256(a, b), _mm256_xor_si256(a, sum));
+    __m256i limit = _mm256_xor_si256(_mm256_srai_epi32(a, 31), _mm256_set1_epi32(std::numeric_limits<int32_t>::max()));
+    return _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(sum), _mm256_castsi256_ps(limit), _mm256_castsi256_ps(overflow)));
+}
+
+template <>
+Vectorized<int8_t> inline saturating_sub(const Vectorized<int8_t>& a, const Vectorized<int8_t>& b) {
+    return _mm256_subs_epi8(a, b);
+}
+
+template <>
+Vectorized<uint8_t> inline saturating_sub(const Vectorized<uint8_t>& a, const Vectorized<uint8_t>& b) {
+    return _mm256_subs_epu8(a, b);
+}
+
+template <>
+Vectorized<int16_t> inline saturating_sub(const Vectorized<int16_t>& a, const Vectorized<int16_t>& b) {
+    return _mm256_subs_epi16(a, b);
+}
+
+template <>
+Vectorized<int32_t> inline saturating_sub(const Vectorized<int32_t>& a, const Vectorized<int32_t>& b) {
+    __m256i diff = _mm256_sub_epi32(a, b);
+    // The sign bit is set when a and b have different signs and the difference does not have the sign of a
+    __m256i overflow = _mm256_and_si256(_mm256_xor_si256(a, b), _mm256_xor_si256(a, diff));
+    __m256i limit = _mm256_xor_si256(_mm256_srai_epi32(a, 31), _mm256_set1_epi32(std::numeric_limits<int32_t>::max()));
+    return _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(diff), _mm256_castsi256_ps(limit), _mm256_castsi256_ps(overflow)));
+}
+
+template<class T, typename std::enable_if_t<std::is_base_of<Vectorizedi, Vectorized<T>>::value, int> = 0>
+inline Vectorized<T> operator&(const Vectorized<T>& a, const Vectorized<T>& b) {
+    return _mm256_and_si256(a, b);
+}
+template<class T, typename std::enable_if_t<std::is_base_of<Vectorizedi, Vectorized<T>>::value, int> = 0>
+inline Vectorized<T> operator|(const Vectorized<T>& a, const Vectorized<T>& b) {
+    return _mm256_or_si256(a, b);
+}
+template<class T, typename std::enable_if_t<std::is_base_of<Vectorizedi, Vectorized<T>>::value, int> = 0>
+inline Vectorized<T> operator^(const Vectorized<T>& a, const Vectorized<T>& b) {
+    return _mm256_xor_si256(a, b);
+}
+template<class T, typename std::enable_if_t<std::is_base_of<Vectorizedi, Vectorized<T>>::value, int> = 0>
+inline Vectorized<T> operator~(const Vectorized<T>& a) {
+    return _mm256_xor_si256(a, _mm256_set1_epi32(-1));
+}
+
+// Bit casts between the float vectors and their same size integer vectors, e.g. comparison masks to index masks
+template<>
+struct CastImpl<int32_t, float> {
+    static inline Vectorized<int32_t> apply(const Vectorized<float>& src) {
+        return _mm256_castps_si256(src);
+    }
+};
+
+template<>
+struct CastImpl<float, int32_t> {
+    static inline Vectorized<float> apply(const Vectorized<int32_t>& src) {
+        return _mm256_castsi256_ps(src);
+    }
+};
+
+template<>
+struct CastImpl<int64_t, double> {
+    static inline Vectorized<int64_t> apply(const Vectorized<double>& src) {
+        return _mm256_castpd_si256(src);
+    }
+};
+
+template<>
+struct CastImpl<double, int64_t> {
+    static inline Vectorized<double> apply(const Vectorized<int64_t>& src) {
+        return _mm256_castsi256_pd(src);
+    }
+};
+
+#elif defined(__aarch64__)
+
+// The integer Vectorized keeps the generic layout on NEON, saturate it as two int32x4_t
+template <>
+Vectorized<int32_t> inline saturating_add(const Vectorized<int32_t>& a, const Vectorized<int32_t>& b) {
+    const int32_t* ptr_a = a;
+    const int32_t* ptr_b = b;
+    __otter_align__ int32_t buffer[Vectorized<int32_t>::size()];
+    vst1q_s32(buffer, vqaddq_s32(vld1q_s32(ptr_a), vld1q_s32(ptr_b)));
+    vst1q_s32(buffer + 4, vqaddq_s32(vld1q_s32(ptr_a + 4), vld1q_s32(ptr_b + 4)));
+    return Vectorized<int32_t>::loadu(buffer);
+}
+
+template <>
+Vectorized<int32_t> inline saturating_sub(const Vectorized<int32_t>& a, const Vectorized<int32_t>& b) {
+    const int32_t* ptr_a = a;
+    const int32_t* ptr_b = b;
+    __otter_align__ int32_t buffer[Vectorized<int32_t>::size()];
+    vst1q_s32(buffer, vqsubq_s32(vld1q_s32(ptr_a), vld1q_s32(ptr_b)));
+    vst1q_s32(buffer + 4, vqsubq_s32(vld1q_s32(ptr_a + 4), vld1q_s32(ptr_b + 4)));
+    return Vectorized<int32_t>::loadu(buffer);
+}
+
+#endif
+
+}   // end namespace vec
+}   // end namespace otter
+
+#endif /* Vec256_int_h */
@@ -13,6 +13,7 @@
 #include <cmath>
 #include <type_traits>
 #include <bitset>
+#include <limits>
 
 #include "Utils.hpp"
 #include "Macro.hpp"
@@ -161,6 +162,17 @@ public:
         return ret;
     }
     
+    int zero_mask() const {
+        // The i-th bit will be set if the i-th element is zero
+        int mask = 0;
+        for (int i = 0; i < size(); ++ i) {
+            if (values[i] == static_cast<T>(0)) {
+                mask |= (1 << i);
+            }
+        }
+        return mask;
+    }
+    
     Vectorized<T> isnan() const {
         Vectorized<T> vector;
         for (int64_t i = 0; i != size(); i++) {
@@ -369,6 +381,54 @@ inline operator/(const Vectorized<T> &a, const Vectorized<T> &b) __ubsan_ignore_
     return c;
 }
 
+template <class T> Vectorized<T>
+inline maximum(const Vectorized<T> &a, const Vectorized<T> &b) {
+    Vectorized<T> c;
+    for (int i = 0; i != Vectorized<T>::size(); i++) {
+        c[i] = (a[i] > b[i]) ? a[i] : b[i];
+    }
+    return c;
+}
+
+template <class T> Vectorized<T>
+inline minimum(const Vectorized<T> &a, const Vectorized<T> &b) {
+    Vectorized<T> c;
+    for (int i = 0; i != Vectorized<T>::size(); i++) {
+        c[i] = (a[i] < b[i]) ? a[i] : b[i];
+    }
+    return c;
+}
+
+// Integer add and sub which clamp to the range of T instead of wrapping, e.g. for uint8 pixels
+// Go through the buffers, the specializations of Vectorized may not have operator[]
+template <class T> Vectorized<T>
+inline saturating_add(const Vectorized<T> &a, const Vectorized<T> &b) {
+    static_assert(std::is_integral<T>::value && sizeof(T) <= 4, "saturating_add only supports up to 32 bit integers");
+    __otter_align__ T buffer_a[Vectorized<T>::size()];
+    __otter_align__ T buffer_b[Vectorized<T>::size()];
+    a.store(buffer_a);
+    b.store(buffer_b);
+    for (int i = 0; i != Vectorized<T>::size(); i++) {
+        int64_t sum = static_cast<int64_t>(buffer_a[i]) + static_cast<int64_t>(buffer_b[i]);
+        buffer_a[i] = static_cast<T>(std::min<int64_t>(std::max<int64_t>(sum, std::numeric_limits<T>::lowest()), std::numeric_limits<T>::max()));
+    }
+    return Vectorized<T>::loadu(buffer_a);
+}
+
+template <class T> Vectorized<T>
+inline saturating_sub(const Vectorized<T> &a, const Vectorized<T> &b) {
+    static_assert(std::is_integral<T>::value && sizeof(T) <= 4, "saturating_sub only supports up to 32 bit integers");
+    __otter_align__ T buffer_a[Vectorized<T>::size()];
+    __otter_align__ T buffer_b[Vectorized<T>::size()];
+    a.store(buffer_a);
+    b.store(buffer_b);
+    for (int i = 0; i != Vectorized<T>::size(); i++) {
+        int64_t diff = static_cast<int64_t>(buffer_a[i]) - static_cast<int64_t>(buffer_b[i]);
+        buffer_a[i] = static_cast<T>(std::min<int64_t>(std::max<int64_t>(diff, std::numeric_limits<T>::lowest()), std::numeric_limits<T>::max()));
+    }
+    return Vectorized<T>::loadu(buffer_a);
+}
+
 template <class T> Vectorized<T>
 inline operator||(const Vectorized<T> &a, const Vectorized<T> &b) {
     Vectorized<T> c;
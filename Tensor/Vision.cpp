@@ -22,6 +22,8 @@
 #include "TensorMaker.hpp"
 #include "TensorPixel.hpp"
 
+#include <memory>
+
 namespace otter {
 namespace cv {
 
@@ -51,6 +53,15 @@ Tensor load_image_rgb(const char* filename) {
     return img;
 }
 
+Tensor load_image_resize_normalize(const char* filename, int target_w, int target_h, const float* mean_vals, const float* norm_vals, bool letterbox, float pad_value, LetterboxInfo* info) {
+    int w, h, c;
+    // Freed even if the resize throws
+    std::unique_ptr<unsigned char, decltype(&stbi_image_free)> data(stbi_load(filename, &w, &h, &c, 3), &stbi_image_free);
+    OTTER_CHECK(data, "Cannot load image ", filename, " STB Reason: ", stbi_failure_reason());
+    
+    return otter::cv::from_pixels_resize_normalize(data.get(), PixelType::RGB, w, h, w * 3, target_w, target_h, mean_vals, norm_vals, false, letterbox, pad_value, info);
+}
+
 Tensor check_save_img_and_try_to_fix(const Tensor& img_) {
     OTTER_CHECK(img_.dim() <= 4, "Expect the dimension of image <= 4, but get ", img_.dim());
     
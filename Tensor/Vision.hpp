@@ -8,6 +8,8 @@
 #ifndef Vision_hpp
 #define Vision_hpp
 
+#include "TensorPixel.hpp"
+
 namespace otter {
 class Tensor;
 
@@ -23,9 +25,14 @@ enum class IMG_TYPE {
 // Recommended!
 Tensor load_image_rgb(const char* filename);
 
-// Raw data
+// Raw data {1, h, w, c}
+// permute({0, 3, 1, 2}) is the channels last input for Extractor::set_channels_last without copy
 Tensor load_image_pixel(const char* filename);
 
+// Decode and feed the network input {1, 3, target_h, target_w} Float in one pass
+// See from_pixels_resize_normalize for the detail
+Tensor load_image_resize_normalize(const char* filename, int target_w, int target_h, const float* mean_vals, const float* norm_vals, bool letterbox = false, float pad_value = 0, LetterboxInfo* info = nullptr);
+
 // Save image
 // Note that the input should be 3-dim and HWC
 void save_image(const Tensor &img, const char *name);
@@ -9,6 +9,7 @@
 #include "LayerRegistry.hpp"
 #include "Parallel.hpp"
 #include "TensorFactory.hpp"
+#include "NonMaximumSuppression.hpp"
 
 #include <float.h>
 
@@ -25,6 +26,8 @@ int Yolov3DetectionOutputLayer::parse_param(LayerOption& option, ParamDict& pd)
     float confidence_threshold = opt_find_float(option, "confidence_threshold", 0.25f);
     float nms_threshold = opt_find_float(option, "nms_threshold", 0.45f);
     float scale_x_y = opt_find_float(option, "scale_x_y", 1);
+    int class_aware_nms = opt_find_int(option, "class_aware_nms", 1);
+    int max_detections = opt_find_int(option, "max_detections", -1);
     
     int input_height = opt_find_int(option, "input_height", 416);
     int input_width = opt_find_int(option, "input_width", 416);
@@ -86,6 +89,8 @@ int Yolov3DetectionOutputLayer::parse_param(LayerOption& option, ParamDict& pd)
     pd.set((int)Yolov3DetectionParam::Scale_x_y, scale_x_y);
     pd.set((int)Yolov3DetectionParam::Input_height, input_height);
     pd.set((int)Yolov3DetectionParam::Input_width, input_width);
+    pd.set((int)Yolov3DetectionParam::Class_aware_nms, class_aware_nms);
+    pd.set((int)Yolov3DetectionParam::Max_detections, max_detections);
     pd.set((int)Yolov3DetectionParam::Biases, biases);
     pd.set((int)Yolov3DetectionParam::Mask, mask);
     pd.set((int)Yolov3DetectionParam::Anchors_scale, anchors_scale);
@@ -102,6 +107,8 @@ int Yolov3DetectionOutputLayer::load_param(const ParamDict &pd) {
     num_box = pd.get((int)Yolov3DetectionParam::Num_box, 90);
     confidence_threshold = pd.get((int)Yolov3DetectionParam::Confidence_threshold, 0.25f);
     nms_threshold = pd.get((int)Yolov3DetectionParam::Nms_threshold, 0.45f);
+    class_aware_nms = pd.get((int)Yolov3DetectionParam::Class_aware_nms, 1);
+    max_detections = pd.get((int)Yolov3DetectionParam::Max_detections, -1);
     
     biases = pd.get((int)Yolov3DetectionParam::Biases, Tensor());
     mask = pd.get((int)Yolov3DetectionParam::Mask, Tensor());
@@ -110,84 +117,11 @@ int Yolov3DetectionOutputLayer::load_param(const ParamDict &pd) {
     return 0;
 }
 
-static inline float intersection_area(const Yolov3DetectionOutputLayer::BBox& a, const Yolov3DetectionOutputLayer::BBox& b) {
-    if (a.xmin > b.xmax || a.xmax < b.xmin || a.ymin > b.ymax || a.ymax < b.ymin) {
-        // no intersection
-        return 0.f;
-    }
-    
-    float inter_width = std::min(a.xmax, b.xmax) - std::max(a.xmin, b.xmin);
-    float inter_height = std::min(a.ymax, b.ymax) - std::max(a.ymin, b.ymin);
-    
-    return inter_width * inter_height;
-}
-
-void Yolov3DetectionOutputLayer::qsort_descent_inplace(std::vector<BBox>& datas, int left, int right) const {
-    int i = left;
-    int j = right;
-    float p = datas[(left + right) / 2].score;
-    
-    while (i <= j) {
-        while (datas[i].score > p)
-            i++;
-        
-        while (datas[j].score < p)
-            j--;
-        
-        if (i <= j) {
-            std::swap(datas[i], datas[j]);
-            
-            i++;
-            j--;
-        }
-    }
-    
-    if (left < j)
-        qsort_descent_inplace(datas, left, j);
-    
-    if (i < right)
-        qsort_descent_inplace(datas, i, right);
-}
-
-void Yolov3DetectionOutputLayer::qsort_descent_inplace(std::vector<BBox>& datas) const {
-    if (datas.empty())
-        return;
-    
-    qsort_descent_inplace(datas, 0, static_cast<int>(datas.size() - 1));
-}
-
-void Yolov3DetectionOutputLayer::nms_sorted_bboxes(std::vector<BBox>& bboxes, std::vector<size_t>& picked, float nms_threshold) const {
-    picked.clear();
-    
-    const size_t n = bboxes.size();
-    
-    for (size_t i = 0; i < n; i++) {
-        const BBox& a = bboxes[i];
-        
-        int keep = 1;
-        for (int j = 0; j < (int)picked.size(); j++) {
-            const BBox& b = bboxes[picked[j]];
-            
-            // intersection over union
-            float inter_area = intersection_area(a, b);
-            float union_area = a.area + b.area - inter_area;
-            // float IoU = inter_area / union_area
-            if (inter_area > nms_threshold * union_area) {
-                keep = 0;
-                break;
-            }
-        }
-        
-        if (keep)
-            picked.push_back(i);
-    }
-}
-
 static inline float sigmoid(float x) {
     return static_cast<float>(1.f / (1.f + exp(-x)));
 }
 
-int Yolov3DetectionOutputLayer::forward(const std::vector<Tensor>& bottom_blobs, std::vector<Tensor>& top_blobs, const NetOption& opt) const {
+int Yolov3DetectionOutputLayer::detect(const std::vector<Tensor>& bottom_blobs, int64_t batch_index, std::vector<BBox>& bbox_selected) const {
     
     std::vector<BBox> all_bbox;
     
@@ -200,7 +134,7 @@ int Yolov3DetectionOutputLayer::forward(const std::vector<Tensor>& bottom_blobs,
         bbox_map.resize(num_box);
         
         const Tensor& bottom = bottom_blobs[i];
-        auto bottom_a = bottom.accessor<float, 4>()[0]; // assume batch_size = 1
+        auto bottom_a = bottom.accessor<float, 4>()[batch_index];
         
         int channels = (int)bottom.size(1);
         int height   = (int)bottom.size(2);
@@ -231,7 +165,7 @@ int Yolov3DetectionOutputLayer::forward(const std::vector<Tensor>& bottom_blobs,
                 
                 const float* box_score_ptr = bottom_a[p + 4].data();
                 
-                Tensor scores = bottom[0].slice(0, p + 5, p + 5 + num_class);
+                Tensor scores = bottom[batch_index].slice(0, p + 5, p + 5 + num_class);
                 auto scores_a = scores.accessor<float, 3>();
                 
                 for (int i = 0; i < height; i++) {
@@ -261,9 +195,7 @@ int Yolov3DetectionOutputLayer::forward(const std::vector<Tensor>& bottom_blobs,
                             float bbox_xmax = bbox_cx + bbox_w * 0.5f;
                             float bbox_ymax = bbox_cy + bbox_h * 0.5f;
                             
-                            float area = bbox_w * bbox_h;
-                            
-                            BBox c = {class_index, confidence, bbox_xmin, bbox_ymin, bbox_xmax, bbox_ymax, area};
+                            BBox c = {class_index, confidence, bbox_xmin, bbox_ymin, bbox_xmax, bbox_ymax};
                             bbox_map[pp].push_back(c);
                         }
                         
@@ -285,45 +217,88 @@ int Yolov3DetectionOutputLayer::forward(const std::vector<Tensor>& bottom_blobs,
         }
     }
     
-    // global sort inplace
-    qsort_descent_inplace(all_bbox);
+    // apply nms on the SoA boxes, the output is already in descending score order
+    const int64_t num_bbox = static_cast<int64_t>(all_bbox.size());
+    if (num_bbox == 0)
+        return 0;
     
-    // apply nms
-    std::vector<size_t> picked;
-    nms_sorted_bboxes(all_bbox, picked, nms_threshold);
+    Tensor boxes = otter::empty({4, num_bbox}, otter::ScalarType::Float);
+    Tensor scores = otter::empty({num_bbox}, otter::ScalarType::Float);
+    Tensor labels = otter::empty({num_bbox}, otter::ScalarType::Int);
+    {
+        float* xmin_ptr = boxes.data_ptr<float>();
+        float* ymin_ptr = xmin_ptr + num_bbox;
+        float* xmax_ptr = ymin_ptr + num_bbox;
+        float* ymax_ptr = xmax_ptr + num_bbox;
+        float* scores_ptr = scores.data_ptr<float>();
+        int* labels_ptr = labels.data_ptr<int>();
+        
+        for (const auto i : otter::irange(num_bbox)) {
+            const BBox& r = all_bbox[i];
+            xmin_ptr[i] = r.xmin;
+            ymin_ptr[i] = r.ymin;
+            xmax_ptr[i] = r.xmax;
+            ymax_ptr[i] = r.ymax;
+            scores_ptr[i] = r.score;
+            labels_ptr[i] = r.label;
+        }
+    }
     
-    // select
-    std::vector<BBox> bbox_selected;
+    Tensor picked = (class_aware_nms) ? otter::cv::multiclass_nms(boxes, scores, labels, nms_threshold, max_detections) : otter::cv::nms(boxes, scores, nms_threshold, max_detections);
     
-    for (size_t i = 0; i < picked.size(); i++)
-    {
-        size_t z = picked[i];
-        bbox_selected.push_back(all_bbox[z]);
+    const int64_t* picked_ptr = picked.data_ptr<int64_t>();
+    
+    bbox_selected.resize(picked.size(0));
+    for (const auto i : otter::irange(picked.size(0))) {
+        bbox_selected[i] = all_bbox[picked_ptr[i]];
+    }
+    
+    return 0;
+}
+
+int Yolov3DetectionOutputLayer::forward(const std::vector<Tensor>& bottom_blobs, std::vector<Tensor>& top_blobs, const NetOption& opt) const {
+    const int64_t batch_size = bottom_blobs[0].size(0);
+    
+    std::vector<std::vector<BBox>> detections(batch_size);
+    int max_detected = 0;
+    for (const auto b : otter::irange(batch_size)) {
+        int ret = detect(bottom_blobs, b, detections[b]);
+        if (ret != 0)
+            return ret;
+        
+        max_detected = std::max(max_detected, static_cast<int>(detections[b].size()));
     }
     
     // fill result
-    int num_detected = static_cast<int>(bbox_selected.size());
-    if (num_detected == 0)
+    if (max_detected == 0)
         return 0;
     
+    // batch 1: {num_detected, 6}
+    // batch n: {n, max_detected, 6}, the tail is padded with label 0 (background)
     Tensor& top_blob = top_blobs[0];
-    top_blob = otter::empty({num_detected, 6}, otter::ScalarType::Float);
+    if (batch_size == 1) {
+        top_blob = otter::empty({max_detected, 6}, otter::ScalarType::Float);
+    } else {
+        top_blob = otter::zeros({batch_size, max_detected, 6}, otter::ScalarType::Float);
+    }
     if (!top_blob.defined())
         return -100;
     
-    auto top_blob_a = top_blob.accessor<float, 2>();
+    float* top_blob_ptr = top_blob.data_ptr<float>();
     
-    for (int i = 0; i < num_detected; i++) {
-        const BBox& r = bbox_selected[i];
-        float score = r.score;
-        float* outptr = top_blob_a[i].data();
+    for (const auto b : otter::irange(batch_size)) {
+        const std::vector<BBox>& bbox_selected = detections[b];
+        float* outptr = top_blob_ptr + b * max_detected * 6;
         
-        outptr[0] = static_cast<float>(r.label + 1); // +1 for prepend background class
-        outptr[1] = score;
-        outptr[2] = r.xmin;
-        outptr[3] = r.ymin;
-        outptr[4] = r.xmax;
-        outptr[5] = r.ymax;
+        for (const auto& r : bbox_selected) {
+            outptr[0] = static_cast<float>(r.label + 1); // +1 for prepend background class
+            outptr[1] = r.score;
+            outptr[2] = r.xmin;
+            outptr[3] = r.ymin;
+            outptr[4] = r.xmax;
+            outptr[5] = r.ymax;
+            outptr += 6;
+        }
     }
     
     return 0;
@@ -34,6 +34,9 @@ public:
     
     float scale_x_y;
     
+    bool class_aware_nms;
+    int max_detections;
+    
     Tensor biases;
     Tensor mask;
     Tensor anchors_scale;
@@ -46,12 +49,10 @@ public:
         float ymin;
         float xmax;
         float ymax;
-        float area;
     };
     
-    void qsort_descent_inplace(std::vector<BBox>& datas, int left, int right) const;
-    void qsort_descent_inplace(std::vector<BBox>& datas) const;
-    void nms_sorted_bboxes(std::vector<BBox>& bboxes, std::vector<size_t>& picked, float nms_threshold) const;
+private:
+    int detect(const std::vector<Tensor>& bottom_blobs, int64_t batch_index, std::vector<BBox>& bbox_selected) const;
 };
 
 enum class Yolov3DetectionParam {
@@ -64,7 +65,9 @@ enum class Yolov3DetectionParam {
     Anchors_scale,
     Scale_x_y,
     Input_height,
-    Input_width
+    Input_width,
+    Class_aware_nms,
+    Max_detections
 };
 
 }
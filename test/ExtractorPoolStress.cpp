@@ -0,0 +1,154 @@
+//
+//  ExtractorPoolStress.cpp
+//  Tensor
+//
+//  Created by 陳均豪 on 2022/3/22.
+//
+
+#include "OTensor.hpp"
+#include "Net.hpp"
+#include "Allocator.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace otter;
+
+// Many threads share one ExtractorPool, every frame has to match the single threaded result
+// and the workspaces have to stay bounded after the input size shrinks
+
+// otter::rand is not random yet
+static Tensor random_tensor(IntArrayRef sizes) {
+    static std::mt19937 generator(7);
+    std::uniform_real_distribution<float> distribution(-1.f, 1.f);
+    
+    Tensor tensor = otter::empty(sizes, ScalarType::Float);
+    float* data = tensor.data_ptr<float>();
+    for (const auto i : otter::irange(tensor.numel())) {
+        data[i] = distribution(generator);
+    }
+    
+    return tensor;
+}
+
+static void build_net(Net& net, int size) {
+    net.addLayer(LayerOption{{"type", "Input"}, {"name", "data"}, {"output", "data"}, {"channel", "3"}, {"height", std::to_string(size)}, {"width", std::to_string(size)}});
+    net.addLayer(LayerOption{{"type", "Convolution"}, {"name", "conv_1"}, {"out_channels", "16"}, {"kernel", "3"}, {"padding", "1"}, {"stride", "2"}, {"batchnorm", "true"}, {"activation", "LRelu"}});
+    net.addLayer(LayerOption{{"type", "Convolution"}, {"name", "conv_2"}, {"out_channels", "16"}, {"kernel", "3"}, {"padding", "1"}, {"stride", "1"}, {"groups", "16"}, {"batchnorm", "true"}, {"activation", "LRelu"}});
+    net.addLayer(LayerOption{{"type", "Convolution"}, {"name", "conv_3"}, {"out_channels", "16"}, {"kernel", "1"}, {"padding", "0"}, {"stride", "1"}, {"batchnorm", "true"}});
+    net.addLayer(LayerOption{{"type", "ShortCut"}, {"name", "sc_1"}, {"input", "bn_conv_3, lr_conv_1"}});
+    net.addLayer(LayerOption{{"type", "MaxPool"}, {"name", "mp_1"}, {"kernel", "3"}, {"padding", "2"}, {"darknet_mode", "true"}});
+    net.addLayer(LayerOption{{"type", "Concat"}, {"name", "concat_1"}, {"input", "mp_1, sc_1"}});
+    net.addLayer(LayerOption{{"type", "Convolution"}, {"name", "conv_4"}, {"out_channels", "16"}, {"kernel", "3"}, {"padding", "1"}, {"stride", "2"}, {"batchnorm", "true"}, {"activation", "LRelu"}});
+    net.addLayer(LayerOption{{"type", "Upsample"}, {"name", "upsample_1"}, {"stride", "2"}, {"darknet_mode", "true"}});
+    net.addLayer(LayerOption{{"type", "Concat"}, {"name", "concat_2"}, {"input", "upsample_1, concat_1"}});
+    net.addLayer(LayerOption{{"type", "Convolution"}, {"name", "conv_5"}, {"out_channels", "8"}, {"kernel", "1"}, {"padding", "0"}, {"stride", "1"}});
+}
+
+static bool same(const Tensor& a, const Tensor& b) {
+    if (a.sizes() != b.sizes())
+        return false;
+    
+    Tensor ac = a.contiguous();
+    Tensor bc = b.contiguous();
+    const float* pa = ac.data_ptr<float>();
+    const float* pb = bc.data_ptr<float>();
+    for (const auto i : otter::irange(ac.numel())) {
+        if (pa[i] != pb[i])
+            return false;
+    }
+    
+    return true;
+}
+
+static int check_pool() {
+    const int kSize = 64;
+    const int kFrames = 4;
+    const int kThreads = 8;
+    const int kRounds = 16;
+    
+    Net net;
+    build_net(net, kSize);
+    net.compile(CompileMode::Initial);
+    
+    std::vector<Tensor> inputs;
+    std::vector<Tensor> references;
+    for (const auto i : otter::irange(kFrames)) {
+        (void)i;
+        inputs.push_back(random_tensor({1, 3, kSize, kSize}));
+        
+        Extractor extractor = net.create_extractor();
+        extractor.input("data", inputs.back());
+        Tensor out;
+        extractor.extract("conv_5", out, 0);
+        references.push_back(out.clone());
+    }
+    
+    ExtractorPool pool(net, kThreads / 2);
+    std::atomic<int> mismatch{0};
+    
+    std::vector<std::thread> workers;
+    for (const auto t : otter::irange(kThreads)) {
+        workers.emplace_back([&, t]() {
+            for (const auto r : otter::irange(kRounds)) {
+                int frame = (int)(t + r) % kFrames;
+                PooledExtractor extractor(pool);
+                extractor->input("data", inputs[frame]);
+                Tensor out;
+                extractor->extract("conv_5", out, 0);
+                if (!same(out, references[frame]))
+                    ++mismatch;
+            }
+        });
+    }
+    for (auto& worker : workers)
+        worker.join();
+    
+    if (mismatch > 0) {
+        fprintf(stderr, "ExtractorPool: %d frames mismatch the single threaded result\n", mismatch.load());
+        return 1;
+    }
+    if (pool.idle_count() > (size_t)kThreads / 2) {
+        fprintf(stderr, "ExtractorPool: %zu idle Extractors over the limit %d\n", pool.idle_count(), kThreads / 2);
+        return 1;
+    }
+    
+    return 0;
+}
+
+static int check_trim() {
+    auto workspace = WorkspaceAllocator::create();
+    
+    // One large frame followed by small ones
+    {
+        DataPtr large = workspace->allocate(1 << 20);
+    }
+    for (const auto i : otter::irange(3)) {
+        (void)i;
+        {
+            DataPtr small = workspace->allocate(1 << 10);
+        }
+        workspace->trim();
+    }
+    
+    if (workspace->cached_bytes() != (1 << 10)) {
+        fprintf(stderr, "WorkspaceAllocator: %zu bytes cached after trim, expect %d\n", workspace->cached_bytes(), 1 << 10);
+        return 1;
+    }
+    
+    return 0;
+}
+
+int main(int argc, const char * argv[]) {
+    int status = 0;
+    status |= check_pool();
+    status |= check_trim();
+    
+    if (status == 0)
+        printf("ExtractorPoolStress passed\n");
+    
+    return status;
+}
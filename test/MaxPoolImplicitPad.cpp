@@ -0,0 +1,94 @@
+//
+//  MaxPoolImplicitPad.cpp
+//  Tensor
+//
+//  Created by 陳均豪 on 2022/3/22.
+//
+
+#include "OTensor.hpp"
+#include "Pool.hpp"
+#include "Padding.hpp"
+
+#include <cstdio>
+#include <random>
+#include <limits>
+
+using namespace otter;
+
+// The implicit padding max pooling against the baseline kernel on the explicitly padded input
+// The small inputs with the ceil mode like bottom / right padding hit the border columns only
+
+// otter::rand is not random yet
+static Tensor random_tensor(IntArrayRef sizes) {
+    static std::mt19937 generator(7);
+    std::uniform_real_distribution<float> distribution(-1.f, 1.f);
+    
+    Tensor tensor = otter::empty(sizes, ScalarType::Float);
+    float* data = tensor.data_ptr<float>();
+    for (const auto i : otter::irange(tensor.numel())) {
+        data[i] = distribution(generator);
+    }
+    
+    return tensor;
+}
+
+struct PoolCase {
+    int64_t height, width;
+    int kH, kW;
+    int dH, dW;
+    int padT, padB, padL, padR;
+};
+
+static bool check_case(const PoolCase& p, MemoryFormat memory_format) {
+    Tensor input = random_tensor({1, 3, p.height, p.width}).contiguous(memory_format);
+    
+    Tensor padded = otter::constant_pad(input.contiguous(), {p.padL, p.padR, p.padT, p.padB}, std::numeric_limits<float>::lowest());
+    Tensor expect = otter::max_pool2d(padded, {p.kH, p.kW}, {p.dH, p.dW}, {0, 0}, {1, 1}, false).contiguous();
+    
+    Tensor output = otter::max_pool2d_implicit_pad(input, {p.kH, p.kW}, {p.dH, p.dW}, {p.padT, p.padB, p.padL, p.padR}).contiguous();
+    
+    if (output.sizes() != expect.sizes()) {
+        fprintf(stderr, "MaxPool %lldx%lld k%dx%d s%dx%d: size mismatch\n", (long long)p.height, (long long)p.width, p.kH, p.kW, p.dH, p.dW);
+        return false;
+    }
+    
+    const float* po = output.data_ptr<float>();
+    const float* pe = expect.data_ptr<float>();
+    for (const auto i : otter::irange(output.numel())) {
+        if (po[i] != pe[i]) {
+            fprintf(stderr, "MaxPool %lldx%lld k%dx%d s%dx%d pad %d %d %d %d: mismatch at %lld\n", (long long)p.height, (long long)p.width, p.kH, p.kW, p.dH, p.dW, p.padT, p.padB, p.padL, p.padR, (long long)i);
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+int main(int argc, const char * argv[]) {
+    const PoolCase cases[] = {
+        // kernel wider than the input, the ceil mode like padding covers the rest
+        {1, 1, 2, 2, 2, 2, 0, 1, 0, 1},
+        {2, 3, 3, 3, 2, 2, 0, 2, 0, 2},
+        {3, 1, 2, 2, 2, 2, 0, 1, 0, 1},
+        {5, 5, 2, 2, 2, 2, 0, 1, 0, 1},
+        {7, 9, 3, 3, 2, 2, 1, 1, 1, 1},
+        // darknet mode
+        {4, 4, 3, 3, 1, 1, 1, 1, 1, 1},
+        {5, 5, 5, 5, 1, 1, 2, 2, 2, 2},
+        {13, 13, 9, 9, 1, 1, 4, 4, 4, 4},
+        {19, 21, 2, 2, 1, 1, 0, 1, 0, 1},
+    };
+    
+    int status = 0;
+    for (const auto& p : cases) {
+        if (!check_case(p, MemoryFormat::Contiguous))
+            status = 1;
+        if (!check_case(p, MemoryFormat::ChannelsLast))
+            status = 1;
+    }
+    
+    if (status == 0)
+        printf("MaxPoolImplicitPad passed\n");
+    
+    return status;
+}